@@ -1,28 +1,521 @@
-// 
+//
 // This file is part of AT&C project which simulates virtual world of air traffic and ATC.
 // Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
-// 
+//
 
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+#include <espeak-ng/speak_lib.h>
 #include "libspeech.h"
+#include "libSpeechCommon.hpp"
+#include "speechMarkup.hpp"
 
 #define EXPORTED_FUNCTION extern "C" __attribute__((visibility("default")))
 
+using namespace std;
+
+// espeak-ng passes synthesized PCM to the callback in chunks of this duration
+#define CHUNK_DURATION_MS 100
+
+typedef PlatformVoiceDescriptor<string> EspeakVoiceDescriptor;
+
+// where PCM of the current synthesis goes: either to a chunk callback, or into a buffer
+struct SynthesisTarget
+{
+    SpeechChunkCallback onChunk;
+    void *context;
+    vector<char> pcm;
+    bool cancelled;
+};
+
+// espeak-ng keeps a single synthesizer per process, and it is not thread-safe. It is initialized once,
+// by the first thread which calls initSpeechThread(), and stays warm until the last thread cleans up.
+// The voices are loaded once during initialization, and the synthesizer is only reconfigured
+// when a request differs in voice, rate or pitch from the previous one.
+static mutex globalSynthesizerLock;
+static int globalThreadCount = 0;
+static int globalSampleRate = 0;
+static unordered_map<string, EspeakVoiceDescriptor> globalPlatformVoices;
+static vector<string> globalPlatformVoiceOrder;
+static string globalCurrentVoiceId;
+static int globalCurrentRate = 0;
+static int globalCurrentPitch = 0;
+static SynthesisTarget *globalSynthesisTarget = nullptr;
+
+bool discoverPlatformVoices(WriteLogCallback writeLog);
+const EspeakVoiceDescriptor *findPlatformVoice(WriteLogCallback writeLog, const SpeechSynthesisRequest& request, SpeechSynthesisReply& reply);
+const string pickPlatformVoice(WriteLogCallback writeLog, const SpeechSynthesisRequest& request);
+bool selectVoice(WriteLogCallback writeLog, const EspeakVoiceDescriptor& voice, int rate, int pitch);
+bool synthesizePhrases(WriteLogCallback writeLog, const SpeechSynthesisRequest& request, SpeechSynthesisReply& reply, SynthesisTarget& target);
+int getEspeakRate(int rate);
+int getEspeakPitch(int voice);
+int receiveSynthesizedSamples(short *samples, int sampleCount, espeak_EVENT *events);
+bool writeWaveFile(const char *filePath, const vector<char>& pcm, int sampleRate);
+void logEffectivePlatformVoices(WriteLogCallback writeLog);
+void writeLogWithError(WriteLogCallback writeLog, const string& message, int error);
+
 EXPORTED_FUNCTION bool initSpeechThread(WriteLogCallback writeLog)
 {
-    writeLog("libspeechlin::initSpeechThread(): OK");
+    lock_guard<mutex> lock(globalSynthesizerLock);
+
+    if (globalThreadCount > 0)
+    {
+        globalThreadCount++;
+        writeLog("libspeechlin: synthesizer already initialized");
+        return true;
+    }
+
+    // no audio device: PCM is returned through receiveSynthesizedSamples()
+    int sampleRate = espeak_Initialize(AUDIO_OUTPUT_SYNCHRONOUS, CHUNK_DURATION_MS, nullptr, 0);
+    if (sampleRate <= 0)
+    {
+        writeLogWithError(writeLog, "espeak_Initialize FAILED", sampleRate);
+        return false;
+    }
+
+    globalSampleRate = sampleRate;
+    espeak_SetSynthCallback(receiveSynthesizedSamples);
+
+    if (!discoverPlatformVoices(writeLog))
+    {
+        writeLog("libspeechlin: failed to discover platform voices");
+        espeak_Terminate();
+        return false;
+    }
+
+    globalThreadCount = 1;
+    logEffectivePlatformVoices(writeLog);
+    writeLog(("libspeechlin: successfully initialized, sample rate " + to_string(globalSampleRate)).c_str());
     return true;
 }
 
 EXPORTED_FUNCTION void cleanupSpeechThread(WriteLogCallback writeLog)
 {
-    writeLog("libspeechlin::cleanupSpeechThread(): OK");
+    lock_guard<mutex> lock(globalSynthesizerLock);
+
+    if (globalThreadCount == 0 || --globalThreadCount > 0)
+    {
+        return;
+    }
+
+    writeLog("libspeechlin: cleanup");
+    espeak_Terminate();
+    globalPlatformVoices.clear();
+    globalPlatformVoiceOrder.clear();
+    globalCurrentVoiceId.clear();
+    globalSampleRate = 0;
 }
 
 EXPORTED_FUNCTION bool synthesizeSpeech(WriteLogCallback writeLog, const SpeechSynthesisRequest* request, SpeechSynthesisReply *reply)
 {
-    writeLog("libspeechlin::synthesizeSpeech(): not implemented");
-    return false;
+    if (!writeLog || !request || !request->text || !request->outputFilePath || !reply)
+    {
+        if (reply)
+        {
+            reply->errorCode = ERROR_CODE_INPUT;
+        }
+        return false;
+    }
+
+    SynthesisTarget target = { nullptr, nullptr, {}, false };
+    if (!synthesizePhrases(writeLog, *request, *reply, target))
+    {
+        return false;
+    }
+
+    if (!writeWaveFile(request->outputFilePath, target.pcm, globalSampleRate))
+    {
+        reply->errorCode = ERROR_CODE_UNSPECIFIED;
+        writeLog((string("libspeechlin: failed to write ") + request->outputFilePath).c_str());
+        return false;
+    }
+
+    return true;
+}
+
+EXPORTED_FUNCTION bool synthesizeSpeechToBuffer(WriteLogCallback writeLog, const SpeechSynthesisRequest* request, SpeechSynthesisReply *reply, SpeechPcmBuffer *output)
+{
+    if (!writeLog || !request || !request->text || !reply || !output)
+    {
+        if (reply)
+        {
+            reply->errorCode = ERROR_CODE_INPUT;
+        }
+        return false;
+    }
+
+    SynthesisTarget target = { nullptr, nullptr, {}, false };
+    if (!synthesizePhrases(writeLog, *request, *reply, target))
+    {
+        return false;
+    }
+
+    if (!copyToSpeechPcmBuffer(output, target.pcm.data(), target.pcm.size()))
+    {
+        reply->errorCode = ERROR_CODE_UNSPECIFIED;
+        writeLog("libspeechlin: failed to copy synthesized PCM");
+        return false;
+    }
+
+    output->sampleRate = globalSampleRate;
+    output->channelCount = 1;
+    output->bitsPerSample = 16;
+    return true;
+}
+
+EXPORTED_FUNCTION void freeSpeechBuffer(SpeechPcmBuffer *buffer)
+{
+    releaseSpeechPcmBuffer(buffer);
+}
+
+EXPORTED_FUNCTION bool synthesizeSpeechStreaming(WriteLogCallback writeLog, const SpeechSynthesisRequest* request, SpeechSynthesisReply *reply, SpeechChunkCallback onChunk, void *context)
+{
+    if (!writeLog || !request || !request->text || !reply || !onChunk)
+    {
+        if (reply)
+        {
+            reply->errorCode = ERROR_CODE_INPUT;
+        }
+        return false;
+    }
+
+    SynthesisTarget target = { onChunk, context, {}, false };
+    bool result = synthesizePhrases(writeLog, *request, *reply, target);
+    if (target.cancelled)
+    {
+        reply->errorCode = ERROR_CODE_CANCELLED;
+        return false;
+    }
+    return result;
+}
+
+bool synthesizePhrases(WriteLogCallback writeLog, const SpeechSynthesisRequest& request, SpeechSynthesisReply& reply, SynthesisTarget& target)
+{
+    lock_guard<mutex> lock(globalSynthesizerLock);
+
+    if (globalThreadCount == 0)
+    {
+        reply.errorCode = ERROR_CODE_INPUT;
+        writeLog("libspeechlin: initSpeechThread() was not called");
+        return false;
+    }
+
+    const EspeakVoiceDescriptor *voice = findPlatformVoice(writeLog, request, reply);
+    if (!voice)
+    {
+        reply.errorCode = ERROR_CODE_NO_VOICE;
+        return false;
+    }
+
+    if (!selectVoice(writeLog, *voice, getEspeakRate(request.rate), getEspeakPitch(request.voice)))
+    {
+        reply.errorCode = ERROR_CODE_SELECT_VOICE_FAILED;
+        return false;
+    }
+
+    // every phrase is synthesized by a separate call, so that the first one reaches the listener
+    // before the rest is even parsed, and a cancelled synthesis stops at the next phrase at the latest;
+    // espeak-ng doesn't know the SAPI markup of utterances, phrases are passed as SSML
+    vector<string> phrases = SapiToSsmlTranslator::splitIntoPhrases(request.text);
+    globalSynthesisTarget = &target;
+
+    for (const auto& phrase : phrases)
+    {
+        // espeakENDPAUSE keeps the pause of the phrase's punctuation, as if the text was synthesized in one piece
+        espeak_ERROR error = espeak_Synth(
+            phrase.c_str(), phrase.length() + 1, 0, POS_CHARACTER, 0,
+            espeakCHARS_UTF8 | espeakSSML | espeakENDPAUSE, nullptr, nullptr);
+
+        if (target.cancelled)
+        {
+            break;
+        }
+        if (error != EE_OK)
+        {
+            globalSynthesisTarget = nullptr;
+            reply.errorCode = ERROR_CODE_SYNTHESIZER_FAILED;
+            writeLogWithError(writeLog, "espeak_Synth failed", error);
+            return false;
+        }
+    }
+
+    globalSynthesisTarget = nullptr;
+    reply.errorCode = target.cancelled ? ERROR_CODE_CANCELLED : ERROR_CODE_NONE;
+    return !target.cancelled;
+}
+
+int receiveSynthesizedSamples(short *samples, int sampleCount, espeak_EVENT *events)
+{
+    SynthesisTarget *target = globalSynthesisTarget;
+    if (!target || target->cancelled)
+    {
+        return 1;
+    }
+    if (!samples || sampleCount <= 0)
+    {
+        return 0;
+    }
+
+    size_t length = (size_t)sampleCount * sizeof(short);
+    if (!target->onChunk)
+    {
+        const char *bytes = (const char *)samples;
+        target->pcm.insert(target->pcm.end(), bytes, bytes + length);
+        return 0;
+    }
+
+    SpeechPcmBuffer chunk;
+    chunk.size = sizeof(chunk);
+    chunk.data = (char *)samples;
+    chunk.capacity = length;
+    chunk.length = length;
+    chunk.ownedByLibrary = 0;
+    chunk.sampleRate = globalSampleRate;
+    chunk.channelCount = 1;
+    chunk.bitsPerSample = 16;
+
+    if (!target->onChunk(target->context, &chunk))
+    {
+        // non-zero makes espeak-ng abandon the rest of the phrase
+        target->cancelled = true;
+        return 1;
+    }
+    return 0;
+}
+
+bool discoverPlatformVoices(WriteLogCallback writeLog)
+{
+    // espeak-ng voices are variants of one language voice; the variants differ in formants and pitch range
+    static const struct { const char *name; int gender; } variants[] = {
+        { "m1", GENDER_MALE }, { "m2", GENDER_MALE }, { "m3", GENDER_MALE }, { "m4", GENDER_MALE }, { "m7", GENDER_MALE },
+        { "f1", GENDER_FEMALE }, { "f2", GENDER_FEMALE }, { "f3", GENDER_FEMALE }, { "f4", GENDER_FEMALE }
+    };
+
+    string language = "en-us";
+    if (espeak_SetVoiceByName(language.c_str()) != EE_OK)
+    {
+        language = "en";
+        if (espeak_SetVoiceByName(language.c_str()) != EE_OK)
+        {
+            writeLog("libspeechlin: espeak-ng has no English voice");
+            return false;
+        }
+    }
+
+    for (const auto& variant : variants)
+    {
+        // loading every voice once up front leaves no file lookups for the synthesis calls
+        string name = language + "+" + variant.name;
+        espeak_ERROR error = espeak_SetVoiceByName(name.c_str());
+        if (error != EE_OK)
+        {
+            writeLogWithError(writeLog, "voice variant [" + name + "] is not available", error);
+            continue;
+        }
+
+        string platformId = "espeak/" + name;
+        globalPlatformVoices.insert({ platformId, EspeakVoiceDescriptor(name, name, platformId, variant.gender) });
+        globalPlatformVoiceOrder.push_back(platformId);
+    }
+
+    if (globalPlatformVoices.empty())
+    {
+        // the language voice alone still speaks, it just can't vary between speakers
+        string platformId = "espeak/" + language;
+        globalPlatformVoices.insert({ platformId, EspeakVoiceDescriptor(language, language, platformId, GENDER_MALE) });
+        globalPlatformVoiceOrder.push_back(platformId);
+    }
+
+    globalCurrentVoiceId.clear();
+    return true;
+}
+
+const EspeakVoiceDescriptor *findPlatformVoice(
+    WriteLogCallback writeLog,
+    const SpeechSynthesisRequest& request,
+    SpeechSynthesisReply& reply)
+{
+    unordered_map<string, EspeakVoiceDescriptor>::iterator it;
+
+    bool hasAssignedVoice = (
+        request.platformVoiceId &&
+        *request.platformVoiceId != '\0' &&
+        (it = globalPlatformVoices.find(request.platformVoiceId)) != globalPlatformVoices.end());
+
+    if (!hasAssignedVoice)
+    {
+        string newVoicePlatformId = pickPlatformVoice(writeLog, request);
+        it = globalPlatformVoices.find(newVoicePlatformId);
+    }
+
+    if (it == globalPlatformVoices.end())
+    {
+        writeLog("libspeechlin: no voice available for the request");
+        return nullptr;
+    }
+
+    reply.platformVoiceId = it->second.platformVoiceId().c_str();
+    return &(it->second);
+}
+
+const string pickPlatformVoice(WriteLogCallback writeLog, const SpeechSynthesisRequest& request)
+{
+    vector<string> candidates;
+    for (const auto& platformId : globalPlatformVoiceOrder)
+    {
+        if (globalPlatformVoices.at(platformId).gender() == request.gender)
+        {
+            candidates.push_back(platformId);
+        }
+    }
+    if (candidates.empty())
+    {
+        candidates = globalPlatformVoiceOrder;
+    }
+    if (candidates.empty())
+    {
+        return "";
+    }
+
+    // speakers of the same gender get different variants, depending on their voice
+    const string& picked = candidates[(size_t)(request.voice > 0 ? request.voice : 0) % candidates.size()];
+
+    stringstream log;
+    log << "libspeechlin: picked voice [" << picked << "] for params: "
+        << "gender[" << request.gender << "] voice[" << request.voice << "]";
+    writeLog(log.str().c_str());
+
+    return picked;
+}
+
+bool selectVoice(WriteLogCallback writeLog, const EspeakVoiceDescriptor& voice, int rate, int pitch)
+{
+    if (globalCurrentVoiceId != voice.platformVoiceId())
+    {
+        espeak_ERROR error = espeak_SetVoiceByName(voice.token().c_str());
+        if (error != EE_OK)
+        {
+            globalCurrentVoiceId.clear();
+            writeLogWithError(writeLog, "espeak_SetVoiceByName failed (" + voice.description() + ")", error);
+            return false;
+        }
+        globalCurrentVoiceId = voice.platformVoiceId();
+        // a voice variant may come with its own rate and pitch, which the request overrides
+        globalCurrentRate = 0;
+        globalCurrentPitch = 0;
+    }
+
+    if (globalCurrentRate != rate)
+    {
+        espeak_SetParameter(espeakRATE, rate, 0);
+        globalCurrentRate = rate;
+    }
+    if (globalCurrentPitch != pitch)
+    {
+        espeak_SetParameter(espeakPITCH, pitch, 0);
+        globalCurrentPitch = pitch;
+    }
+
+    return true;
+}
+
+int getEspeakRate(int rate)
+{
+    // words per minute; controllers and pilots speak faster than the espeak-ng default of 175
+    switch (rate)
+    {
+    case RATE_FAST:
+        return 220;
+    case RATE_SLOW:
+        return 160;
+    default:
+        return 190;
+    }
+}
+
+int getEspeakPitch(int voice)
+{
+    // 0-100, where 50 is the default of every voice
+    switch (voice)
+    {
+    case VOICE_BASS:
+    case VOICE_CONTRALTO:
+        return 30;
+    case VOICE_BARITONE:
+    case VOICE_MEZZOSOPRANO:
+        return 42;
+    case VOICE_TENOR:
+    case VOICE_SOPRANO:
+        return 56;
+    case VOICE_COUNTERTENOR:
+    case VOICE_TREBLE:
+        return 68;
+    default:
+        return 50;
+    }
+}
+
+bool writeWaveFile(const char *filePath, const vector<char>& pcm, int sampleRate)
+{
+    ofstream file(filePath, ios::binary | ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+
+    auto write32 = [&file](uint32_t value) {
+        char bytes[4] = { (char)(value & 0xFF), (char)((value >> 8) & 0xFF), (char)((value >> 16) & 0xFF), (char)((value >> 24) & 0xFF) };
+        file.write(bytes, 4);
+    };
+    auto write16 = [&file](uint16_t value) {
+        char bytes[2] = { (char)(value & 0xFF), (char)((value >> 8) & 0xFF) };
+        file.write(bytes, 2);
+    };
+
+    const uint16_t channelCount = 1;
+    const uint16_t bitsPerSample = 16;
+    const uint16_t blockAlign = channelCount * bitsPerSample / 8;
+
+    file.write("RIFF", 4);
+    write32(36 + (uint32_t)pcm.size());
+    file.write("WAVE", 4);
+    file.write("fmt ", 4);
+    write32(16);
+    write16(1); // PCM
+    write16(channelCount);
+    write32((uint32_t)sampleRate);
+    write32((uint32_t)sampleRate * blockAlign);
+    write16(blockAlign);
+    write16(bitsPerSample);
+    file.write("data", 4);
+    write32((uint32_t)pcm.size());
+    file.write(pcm.data(), pcm.size());
+
+    return file.good();
+}
+
+void logEffectivePlatformVoices(WriteLogCallback writeLog)
+{
+    writeLog("--- effective platform voices ---");
+    for (const auto& platformId : globalPlatformVoiceOrder)
+    {
+        stringstream entryLog;
+        entryLog << "[id=" << platformId << "] gender[" << globalPlatformVoices.at(platformId).gender() << "] "
+                 << globalPlatformVoices.at(platformId).description();
+        writeLog(entryLog.str().c_str());
+    }
+    writeLog("--- end of platform voices ---");
+}
+
+void writeLogWithError(WriteLogCallback writeLog, const string& message, int error)
+{
+    stringstream str;
+    str << "libspeechlin: " << message << " error=" << error;
+    writeLog(str.str().c_str());
 }
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <sstream>
 #include "libspeech.h"
+#include "libSpeechCommon.hpp"
 #include "synthesizer.h"
 
 using namespace std;
@@ -48,3 +49,28 @@ EXPORTED_FUNCTION bool synthesizeSpeech(WriteLogCallback writeLog, const SpeechS
     
     return (result == 1);
 }
+
+// NSSpeechSynthesizer only renders to a file URL; callers fall back to synthesizeSpeech()
+EXPORTED_FUNCTION bool synthesizeSpeechToBuffer(WriteLogCallback writeLog, const SpeechSynthesisRequest* request, SpeechSynthesisReply *reply, SpeechPcmBuffer *output)
+{
+    if (reply)
+    {
+        reply->errorCode = ERROR_CODE_NOT_SUPPORTED;
+    }
+    return false;
+}
+
+EXPORTED_FUNCTION void freeSpeechBuffer(SpeechPcmBuffer *buffer)
+{
+    releaseSpeechPcmBuffer(buffer);
+}
+
+// callers fall back to synthesizeSpeechToBuffer()
+EXPORTED_FUNCTION bool synthesizeSpeechStreaming(WriteLogCallback writeLog, const SpeechSynthesisRequest* request, SpeechSynthesisReply *reply, SpeechChunkCallback onChunk, void *context)
+{
+    if (reply)
+    {
+        reply->errorCode = ERROR_CODE_NOT_SUPPORTED;
+    }
+    return false;
+}
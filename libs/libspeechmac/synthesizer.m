@@ -15,13 +15,16 @@
 
 int getGenderCode(NSString *genderString);
 
+// speech is synthesized on several threads at once (lookahead workers and the synth thread),
+// so every call keeps the run loop it waits on in its own delegate instance
 @interface FinishDetectorDelegate<NSSpeechSynthesizerDelegate> : NSObject
+{
+  CFRunLoopRef _runLoopRef;
+}
 - (void)speechSynthesizer:(NSSpeechSynthesizer *)sender didFinishSpeaking:(BOOL) finishedSpeaking;
 @end
 
 @implementation FinishDetectorDelegate
-static NSInteger _finishedCount = 0;
-static CFRunLoopRef _runLoopRef;
 - (void)speechSynthesizer:(NSSpeechSynthesizer *)sender didFinishSpeaking:(BOOL) finishedSpeaking {
     CFRunLoopStop(_runLoopRef);
   }
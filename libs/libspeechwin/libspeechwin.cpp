@@ -15,10 +15,12 @@ using namespace std;
 
 typedef PlatformVoiceDescriptor<CComPtr<ISpObjectToken>> SapiVoiceDescriptor;
 
-static ISpVoice *globalVoice = NULL;
-static unordered_map<string, SapiVoiceDescriptor> globalPlatformVoices;
-static wchar_t globalText[GLOBAL_STRING_LENGTH] = { 0 };
-static wchar_t globalFilePath[GLOBAL_STRING_LENGTH] = { 0 };
+// per-thread state: every thread which calls initSpeechThread() gets its own voice,
+// so that several threads can synthesize in parallel
+static thread_local ISpVoice *globalVoice = NULL;
+static thread_local unordered_map<string, SapiVoiceDescriptor> globalPlatformVoices;
+static thread_local wchar_t globalText[GLOBAL_STRING_LENGTH] = { 0 };
+static thread_local wchar_t globalFilePath[GLOBAL_STRING_LENGTH] = { 0 };
 
 bool discoverPlatformVoices(WriteLogCallback writeLog);
 bool addPlatformVoice(CComPtr<ISpObjectToken> token, const string& name, long long lcid, int gender);
@@ -31,6 +33,153 @@ string toNarrow(const wchar_t* s, char dfault = '?', const std::locale& loc = st
 void writeLogWithHResult(WriteLogCallback writeLog, const string& message, HRESULT hr);
 bool copyToGlobalString(const char* source, wchar_t* destination);
 void logSynthesizeSpeechCall(WriteLogCallback writeLog, const SpeechSynthesisRequest* request, SpeechSynthesisReply* reply);
+bool speakToStream(WriteLogCallback writeLog, const SpeechSynthesisRequest& request, SpeechSynthesisReply& reply, ISpStream* outputStream);
+
+// Passes everything SAPI writes to a SpeechChunkCallback, instead of storing it.
+// SAPI writes raw PCM to its base stream sequentially, and only seeks to query the position.
+class ChunkCallbackStream : public IStream
+{
+private:
+    LONG m_refCount;
+    const SpeechChunkCallback m_onChunk;
+    void* const m_context;
+    const WAVEFORMATEX m_format;
+    ULONGLONG m_position;
+    bool m_cancelled;
+public:
+    ChunkCallbackStream(SpeechChunkCallback _onChunk, void* _context, const WAVEFORMATEX& _format) :
+        m_refCount(1),
+        m_onChunk(_onChunk),
+        m_context(_context),
+        m_format(_format),
+        m_position(0),
+        m_cancelled(false)
+    {
+    }
+    virtual ~ChunkCallbackStream()
+    {
+    }
+public:
+    bool cancelled() const { return m_cancelled; }
+public:
+    STDMETHODIMP QueryInterface(REFIID riid, void** ppv) override
+    {
+        if (!ppv)
+        {
+            return E_POINTER;
+        }
+        if (riid == IID_IUnknown || riid == IID_ISequentialStream || riid == IID_IStream)
+        {
+            *ppv = static_cast<IStream*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override
+    {
+        return (ULONG)InterlockedIncrement(&m_refCount);
+    }
+    STDMETHODIMP_(ULONG) Release() override
+    {
+        LONG count = InterlockedDecrement(&m_refCount);
+        if (count == 0)
+        {
+            delete this;
+        }
+        return (ULONG)count;
+    }
+    STDMETHODIMP Read(void* data, ULONG size, ULONG* read) override
+    {
+        if (read)
+        {
+            *read = 0;
+        }
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP Write(const void* data, ULONG size, ULONG* written) override
+    {
+        if (written)
+        {
+            *written = 0;
+        }
+        if (m_cancelled)
+        {
+            return E_ABORT;
+        }
+
+        SpeechPcmBuffer chunk = {
+            sizeof(chunk), (char*)data, size, size, 0,
+            (int)m_format.nSamplesPerSec, (int)m_format.nChannels, (int)m_format.wBitsPerSample
+        };
+        if (size > 0 && !m_onChunk(m_context, &chunk))
+        {
+            // makes ISpVoice::Speak return, without synthesizing the rest
+            m_cancelled = true;
+            return E_ABORT;
+        }
+
+        m_position += size;
+        if (written)
+        {
+            *written = size;
+        }
+        return S_OK;
+    }
+    STDMETHODIMP Seek(LARGE_INTEGER move, DWORD origin, ULARGE_INTEGER* newPosition) override
+    {
+        LONGLONG target = (origin == STREAM_SEEK_SET ? 0 : (LONGLONG)m_position) + move.QuadPart;
+        if (target != (LONGLONG)m_position)
+        {
+            return STG_E_INVALIDFUNCTION;
+        }
+        if (newPosition)
+        {
+            newPosition->QuadPart = m_position;
+        }
+        return S_OK;
+    }
+    STDMETHODIMP SetSize(ULARGE_INTEGER newSize) override
+    {
+        return S_OK;
+    }
+    STDMETHODIMP CopyTo(IStream* target, ULARGE_INTEGER size, ULARGE_INTEGER* read, ULARGE_INTEGER* written) override
+    {
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP Commit(DWORD flags) override
+    {
+        return S_OK;
+    }
+    STDMETHODIMP Revert() override
+    {
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP LockRegion(ULARGE_INTEGER offset, ULARGE_INTEGER size, DWORD lockType) override
+    {
+        return STG_E_INVALIDFUNCTION;
+    }
+    STDMETHODIMP UnlockRegion(ULARGE_INTEGER offset, ULARGE_INTEGER size, DWORD lockType) override
+    {
+        return STG_E_INVALIDFUNCTION;
+    }
+    STDMETHODIMP Stat(STATSTG* stat, DWORD flags) override
+    {
+        if (!stat)
+        {
+            return E_POINTER;
+        }
+        ZeroMemory(stat, sizeof(*stat));
+        stat->type = STGTY_STREAM;
+        stat->cbSize.QuadPart = m_position;
+        return S_OK;
+    }
+    STDMETHODIMP Clone(IStream** clone) override
+    {
+        return E_NOTIMPL;
+    }
+};
 
 bool initSpeechThread(WriteLogCallback writeLog)
 {
@@ -92,36 +241,163 @@ bool synthesizeSpeech(WriteLogCallback writeLog, const SpeechSynthesisRequest *r
         return false;
     }
 
-    const SapiVoiceDescriptor *voice = findPlatformVoice(writeLog, *request, *reply);
-    if (!voice)
+    CSpStreamFormat format;
+    format.AssignFormat(SPSF_16kHz16BitMono); //TODO: vary by request->quality value
+
+    ISpStream* outputStream = nullptr;
+    HRESULT hr = SPBindToFile(globalFilePath, SPFM_CREATE_ALWAYS, &outputStream, &format.FormatId(), format.WaveFormatExPtr());
+    if (FAILED(hr))
     {
-        reply->errorCode = ERROR_CODE_NO_VOICE;
+        reply->errorCode = ERROR_CODE_PREPARE_FAILED;
+        writeLogWithHResult(writeLog, "SPBindToFile failed", hr);
         return false;
     }
 
-    string markup = getSpeechMarkup(*request, *voice);
-    if (!copyToGlobalString(markup.c_str(), globalText))
+    bool result = speakToStream(writeLog, *request, *reply, outputStream);
+
+    outputStream->Close();
+    outputStream->Release();
+    return result;
+}
+
+bool synthesizeSpeechToBuffer(WriteLogCallback writeLog, const SpeechSynthesisRequest *request, SpeechSynthesisReply *reply, SpeechPcmBuffer *output)
+{
+    if (!globalVoice || !writeLog || !request || !request->text || !reply || !output)
     {
-        reply->errorCode = ERROR_CODE_TOO_LONG;
+        if (reply)
+        {
+            reply->errorCode = ERROR_CODE_INPUT;
+        }
         return false;
     }
 
     CSpStreamFormat format;
     format.AssignFormat(SPSF_16kHz16BitMono); //TODO: vary by request->quality value
 
-    ISpStream* outputStream = nullptr;
-    HRESULT hr = SPBindToFile(globalFilePath, SPFM_CREATE_ALWAYS, &outputStream, &format.FormatId(), format.WaveFormatExPtr());
+    // the synthesizer writes raw PCM (no RIFF header) into a growable stream in memory
+    CComPtr<IStream> memoryStream;
+    HRESULT hr = CreateStreamOnHGlobal(NULL, TRUE, &memoryStream);
     if (FAILED(hr))
     {
         reply->errorCode = ERROR_CODE_PREPARE_FAILED;
-        writeLogWithHResult(writeLog, "SPBindToFile failed", hr);
+        writeLogWithHResult(writeLog, "CreateStreamOnHGlobal failed", hr);
         return false;
     }
 
-    hr = globalVoice->SetOutput(outputStream, TRUE);
+    CComPtr<ISpStream> outputStream;
+    hr = outputStream.CoCreateInstance(CLSID_SpStream);
+    if (SUCCEEDED(hr))
+    {
+        hr = outputStream->SetBaseStream(memoryStream, format.FormatId(), format.WaveFormatExPtr());
+    }
+    if (FAILED(hr))
+    {
+        reply->errorCode = ERROR_CODE_PREPARE_FAILED;
+        writeLogWithHResult(writeLog, "ISpStream::SetBaseStream failed", hr);
+        return false;
+    }
+
+    if (!speakToStream(writeLog, *request, *reply, outputStream))
+    {
+        return false;
+    }
+
+    STATSTG stat;
+    HGLOBAL memoryHandle = NULL;
+    hr = memoryStream->Stat(&stat, STATFLAG_NONAME);
+    if (SUCCEEDED(hr))
+    {
+        hr = GetHGlobalFromStream(memoryStream, &memoryHandle);
+    }
+    if (FAILED(hr))
+    {
+        reply->errorCode = ERROR_CODE_SYNTHESIZER_FAILED;
+        writeLogWithHResult(writeLog, "failed to access synthesized stream", hr);
+        return false;
+    }
+
+    const void* pcm = GlobalLock(memoryHandle);
+    bool copied = (pcm != NULL && copyToSpeechPcmBuffer(output, pcm, (size_t)stat.cbSize.QuadPart));
+    GlobalUnlock(memoryHandle);
+
+    if (!copied)
+    {
+        reply->errorCode = ERROR_CODE_UNSPECIFIED;
+        writeLog("libspeechwin: failed to copy synthesized PCM");
+        return false;
+    }
+
+    output->sampleRate = (int)format.WaveFormatExPtr()->nSamplesPerSec;
+    output->channelCount = (int)format.WaveFormatExPtr()->nChannels;
+    output->bitsPerSample = (int)format.WaveFormatExPtr()->wBitsPerSample;
+    return true;
+}
+
+void freeSpeechBuffer(SpeechPcmBuffer *buffer)
+{
+    releaseSpeechPcmBuffer(buffer);
+}
+
+bool synthesizeSpeechStreaming(WriteLogCallback writeLog, const SpeechSynthesisRequest *request, SpeechSynthesisReply *reply, SpeechChunkCallback onChunk, void *context)
+{
+    if (!globalVoice || !writeLog || !request || !request->text || !reply || !onChunk)
+    {
+        if (reply)
+        {
+            reply->errorCode = ERROR_CODE_INPUT;
+        }
+        return false;
+    }
+
+    CSpStreamFormat format;
+    format.AssignFormat(SPSF_16kHz16BitMono); //TODO: vary by request->quality value
+
+    ChunkCallbackStream* chunkStream = new ChunkCallbackStream(onChunk, context, *format.WaveFormatExPtr());
+    CComPtr<IStream> baseStream;
+    baseStream.Attach(chunkStream);
+
+    CComPtr<ISpStream> outputStream;
+    HRESULT hr = outputStream.CoCreateInstance(CLSID_SpStream);
+    if (SUCCEEDED(hr))
+    {
+        hr = outputStream->SetBaseStream(baseStream, format.FormatId(), format.WaveFormatExPtr());
+    }
     if (FAILED(hr))
     {
         reply->errorCode = ERROR_CODE_PREPARE_FAILED;
+        writeLogWithHResult(writeLog, "ISpStream::SetBaseStream failed", hr);
+        return false;
+    }
+
+    bool result = speakToStream(writeLog, *request, *reply, outputStream);
+    if (chunkStream->cancelled())
+    {
+        reply->errorCode = ERROR_CODE_CANCELLED;
+        return false;
+    }
+    return result;
+}
+
+bool speakToStream(WriteLogCallback writeLog, const SpeechSynthesisRequest& request, SpeechSynthesisReply& reply, ISpStream* outputStream)
+{
+    const SapiVoiceDescriptor *voice = findPlatformVoice(writeLog, request, reply);
+    if (!voice)
+    {
+        reply.errorCode = ERROR_CODE_NO_VOICE;
+        return false;
+    }
+
+    string markup = getSpeechMarkup(request, *voice);
+    if (!copyToGlobalString(markup.c_str(), globalText))
+    {
+        reply.errorCode = ERROR_CODE_TOO_LONG;
+        return false;
+    }
+
+    HRESULT hr = globalVoice->SetOutput(outputStream, TRUE);
+    if (FAILED(hr))
+    {
+        reply.errorCode = ERROR_CODE_PREPARE_FAILED;
         writeLogWithHResult(writeLog, "ISpVoice::SetOutput failed", hr);
         return false;
     }
@@ -129,7 +405,7 @@ bool synthesizeSpeech(WriteLogCallback writeLog, const SpeechSynthesisRequest *r
     hr = globalVoice->SetVoice(voice->token());
     if (FAILED(hr))
     {
-        reply->errorCode = ERROR_CODE_SELECT_VOICE_FAILED;
+        reply.errorCode = ERROR_CODE_SELECT_VOICE_FAILED;
         writeLogWithHResult(writeLog, "ISpVoice::SetVoice failed (" + voice->description() + ")", hr);
         return false;
     }
@@ -139,22 +415,18 @@ bool synthesizeSpeech(WriteLogCallback writeLog, const SpeechSynthesisRequest *r
         SPF_PURGEBEFORESPEAK | SPF_IS_XML,
         NULL);
 
-    if (SUCCEEDED(hr))
-    {
-        reply->errorCode = ERROR_CODE_NONE;
-    }
-    else
-    {
-        reply->errorCode = ERROR_CODE_SYNTHESIZER_FAILED;
-        writeLogWithHResult(writeLog, "ISpVoice::Speak failed", hr);
-    }
+    // release the stream, so that it can be closed or read by the caller
+    globalVoice->SetOutput(NULL, TRUE);
 
-    if (outputStream)
+    if (FAILED(hr))
     {
-        outputStream->Close();
+        reply.errorCode = ERROR_CODE_SYNTHESIZER_FAILED;
+        writeLogWithHResult(writeLog, "ISpVoice::Speak failed", hr);
+        return false;
     }
 
-    return SUCCEEDED(hr);
+    reply.errorCode = ERROR_CODE_NONE;
+    return true;
 }
 
 bool discoverPlatformVoices(WriteLogCallback writeLog)
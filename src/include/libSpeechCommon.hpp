@@ -5,10 +5,49 @@
 #pragma once
 
 #include <string>
+#include <cstdlib>
+#include <cstring>
 #include "libspeech.h"
 
 using namespace std;
 
+inline void releaseSpeechPcmBuffer(SpeechPcmBuffer* buffer)
+{
+    if (buffer && buffer->ownedByLibrary && buffer->data)
+    {
+        free(buffer->data);
+        buffer->data = nullptr;
+        buffer->capacity = 0;
+        buffer->length = 0;
+        buffer->ownedByLibrary = 0;
+    }
+}
+
+// copies synthesized PCM into the buffer provided by the caller, or into a new one if it doesn't fit;
+// a too small buffer which the library allocated earlier is freed first
+inline bool copyToSpeechPcmBuffer(SpeechPcmBuffer* output, const void* data, size_t length)
+{
+    if (!output->data || output->capacity < length)
+    {
+        releaseSpeechPcmBuffer(output);
+        char* allocated = (char*)malloc(length > 0 ? length : 1);
+        if (!allocated)
+        {
+            return false;
+        }
+        output->data = allocated;
+        output->capacity = length;
+        output->ownedByLibrary = 1;
+    }
+
+    if (length > 0)
+    {
+        memcpy(output->data, data, length);
+    }
+    output->length = length;
+    return true;
+}
+
 template<typename TToken>
 class PlatformVoiceDescriptor
 {
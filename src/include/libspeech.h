@@ -48,6 +48,8 @@
 #define ERROR_CODE_PREPARE_FAILED 5
 #define ERROR_CODE_SELECT_VOICE_FAILED 6
 #define ERROR_CODE_SYNTHESIZER_FAILED 7
+#define ERROR_CODE_NOT_SUPPORTED 8
+#define ERROR_CODE_CANCELLED 9
 
 typedef struct {
     size_t size;
@@ -66,7 +68,24 @@ typedef struct {
     const char *platformVoiceId;
 } SpeechSynthesisReply;
 
+// PCM output of synthesizeSpeechToBuffer(); samples are signed little-endian, channels interleaved.
+// The caller may provide a buffer in data/capacity; if it is missing or too small,
+// the library allocates one, sets ownedByLibrary to 1, and the caller must release it with freeSpeechBuffer().
+typedef struct {
+    size_t size;
+    char* data;
+    size_t capacity;
+    size_t length;
+    int ownedByLibrary;
+    int sampleRate;
+    int channelCount;
+    int bitsPerSample;
+} SpeechPcmBuffer;
+
 typedef void (*WriteLogCallback)(const char* message);
+// receives PCM of synthesizeSpeechStreaming() as the synthesizer produces it, on the calling thread;
+// chunk->data is only valid during the call. Returning false cancels the synthesis.
+typedef bool (*SpeechChunkCallback)(void* context, const SpeechPcmBuffer* chunk);
 
 #if IBM == 1
     #define DECLSPEC __declspec(dllexport)
@@ -77,3 +96,10 @@ typedef void (*WriteLogCallback)(const char* message);
 extern "C" DECLSPEC bool initSpeechThread(WriteLogCallback writeLog);
 extern "C" DECLSPEC void cleanupSpeechThread(WriteLogCallback writeLog);
 extern "C" DECLSPEC bool synthesizeSpeech(WriteLogCallback writeLog, const SpeechSynthesisRequest *request, SpeechSynthesisReply *reply);
+// same as synthesizeSpeech(), but returns PCM in memory; request->outputFilePath is ignored.
+// Fails with ERROR_CODE_NOT_SUPPORTED where the platform can only synthesize to a file.
+extern "C" DECLSPEC bool synthesizeSpeechToBuffer(WriteLogCallback writeLog, const SpeechSynthesisRequest *request, SpeechSynthesisReply *reply, SpeechPcmBuffer *output);
+extern "C" DECLSPEC void freeSpeechBuffer(SpeechPcmBuffer *buffer);
+// same as synthesizeSpeechToBuffer(), but passes PCM to onChunk while synthesizing, so that playback can start early.
+// Fails with ERROR_CODE_CANCELLED if onChunk returned false, and with ERROR_CODE_NOT_SUPPORTED where the platform can't stream.
+extern "C" DECLSPEC bool synthesizeSpeechStreaming(WriteLogCallback writeLog, const SpeechSynthesisRequest *request, SpeechSynthesisReply *reply, SpeechChunkCallback onChunk, void *context);
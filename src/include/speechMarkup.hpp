@@ -0,0 +1,213 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// Utterances carry SAPI markup: <rate speed='N'>, <pitch middle='N'> (paired, or empty to change the rest
+// of the text) and <silence msec='N'/>. Synthesizers which only understand SSML (espeak-ng) get it translated
+// by SapiToSsmlTranslator; tags it doesn't know are dropped rather than read aloud.
+//
+// The text is split into phrases after punctuation, the same way as plain text, and every phrase becomes
+// a standalone SSML document: prosody which is open at a phrase boundary is closed at the end of the phrase
+// and reopened at the beginning of the next one.
+class SapiToSsmlTranslator
+{
+private:
+    struct OpenProsody
+    {
+        string sapiName;
+        string ssmlStartTag;
+        bool appliesToRest; // opened by an empty SAPI tag, closed only at the end of the text
+    };
+private:
+    vector<OpenProsody> m_openProsody;
+    vector<string> m_phrases;
+    string m_body;
+    bool m_hasSpeech = false;
+public:
+
+    static vector<string> splitIntoPhrases(const char* sapiText)
+    {
+        SapiToSsmlTranslator translator;
+        translator.translate(sapiText);
+        return translator.m_phrases;
+    }
+
+    // one SAPI step of rate is a factor of 3^(1/10), so that 10 is three times faster
+    static int getRatePercent(int speed)
+    {
+        return (int)lround(100.0 * pow(3.0, speed / 10.0));
+    }
+
+private:
+
+    void translate(const char* text)
+    {
+        bool isSplitPending = false;
+        m_body = openAllTags();
+
+        for (const char* p = text ; *p ; p++)
+        {
+            if (*p == '<')
+            {
+                const char* tagEnd = strchr(p, '>');
+                if (!tagEnd)
+                {
+                    break;
+                }
+                translateTag(string(p + 1, tagEnd - p - 1));
+                p = tagEnd;
+                continue;
+            }
+
+            bool isWhitespace = (*p == ' ' || *p == '\t' || *p == '\n');
+            if (isWhitespace && isSplitPending)
+            {
+                finishPhrase();
+            }
+
+            bool isPunctuation = (*p == ',' || *p == '.' || *p == ';' || *p == ':' || *p == '!' || *p == '?');
+            isSplitPending = isPunctuation || (isSplitPending && isWhitespace);
+
+            appendEscaped(*p);
+            m_hasSpeech |= !isWhitespace;
+        }
+
+        // prosody opened by empty tags lasts until here
+        finishPhrase();
+    }
+
+    void translateTag(const string& tag)
+    {
+        if (tag.empty())
+        {
+            return;
+        }
+
+        if (tag[0] == '/')
+        {
+            closeProsody(getTagName(tag.substr(1)));
+            return;
+        }
+
+        const string name = getTagName(tag);
+        const bool isEmpty = (tag[tag.length() - 1] == '/');
+        int value;
+
+        if (name == "silence" && tryGetAttributeValue(tag, "msec", value))
+        {
+            m_body += "<break time=\"" + to_string(value) + "ms\"/>";
+            m_hasSpeech = true;
+        }
+        else if (name == "rate" && tryGetAttributeValue(tag, "speed", value))
+        {
+            openProsody(name, "<prosody rate=\"" + to_string(getRatePercent(value)) + "%\">", isEmpty);
+        }
+        else if (name == "pitch" && tryGetAttributeValue(tag, "middle", value))
+        {
+            // semitones need the sign, otherwise espeak-ng takes them as zero
+            openProsody(name, string("<prosody pitch=\"") + (value < 0 ? "-" : "+") + to_string(abs(value)) + "st\">", isEmpty);
+        }
+    }
+
+    void openProsody(const string& sapiName, const string& ssmlStartTag, bool appliesToRest)
+    {
+        m_openProsody.push_back({ sapiName, ssmlStartTag, appliesToRest });
+        m_body += ssmlStartTag;
+    }
+
+    void closeProsody(const string& sapiName)
+    {
+        int index = (int)m_openProsody.size() - 1;
+        while (index >= 0 && (m_openProsody[index].appliesToRest || m_openProsody[index].sapiName != sapiName))
+        {
+            index--;
+        }
+        if (index < 0)
+        {
+            return;
+        }
+
+        // SSML elements nest strictly: whatever was opened inside for the rest of the text is closed and reopened
+        for (int i = (int)m_openProsody.size() - 1 ; i >= index ; i--)
+        {
+            m_body += "</prosody>";
+        }
+        m_openProsody.erase(m_openProsody.begin() + index);
+        for (int i = index ; i < (int)m_openProsody.size() ; i++)
+        {
+            m_body += m_openProsody[i].ssmlStartTag;
+        }
+    }
+
+    void finishPhrase()
+    {
+        if (m_hasSpeech)
+        {
+            for (size_t i = 0 ; i < m_openProsody.size() ; i++)
+            {
+                m_body += "</prosody>";
+            }
+            m_phrases.push_back("<speak>" + m_body + "</speak>");
+        }
+
+        m_body = openAllTags();
+        m_hasSpeech = false;
+    }
+
+    string openAllTags() const
+    {
+        string tags;
+        for (const auto& prosody : m_openProsody)
+        {
+            tags += prosody.ssmlStartTag;
+        }
+        return tags;
+    }
+
+    void appendEscaped(char c)
+    {
+        switch (c)
+        {
+        case '&': m_body += "&amp;"; break;
+        case '>': m_body += "&gt;"; break;
+        case '"': m_body += "&quot;"; break;
+        default: m_body += c;
+        }
+    }
+
+    static string getTagName(const string& tag)
+    {
+        size_t end = tag.find_first_of(" \t/");
+        return tag.substr(0, end);
+    }
+
+    static bool tryGetAttributeValue(const string& tag, const string& attribute, int& value)
+    {
+        size_t position = tag.find(attribute + "=");
+        if (position == string::npos)
+        {
+            return false;
+        }
+
+        position += attribute.length() + 1;
+        if (position < tag.length() && (tag[position] == '\'' || tag[position] == '"'))
+        {
+            position++;
+        }
+
+        const char* start = tag.c_str() + position;
+        char* end;
+        value = (int)strtol(start, &end, 10);
+        return end != start;
+    }
+};
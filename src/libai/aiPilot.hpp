@@ -29,7 +29,6 @@ namespace ai
         shared_ptr<IntentFactory> m_intentFactory;
         ManeuverFactory& M;
         IntentFactory& I;
-        shared_ptr<Airport> m_departureAirport;
         shared_ptr<FlightPlan> m_flightPlan;
         shared_ptr<AIAircraft> m_aircraft;
         int m_departureTowerKhz = 0;
@@ -63,7 +62,6 @@ namespace ai
             //_host->writeLog("AIPilot::AIPilot() - enter");
 
             m_flightPlan = _flight->plan();
-            m_departureAirport = _host->getWorld()->getAirport(_flight->plan()->departureAirportIcao());
 
             aircraft()->onCommTransmission([this](shared_ptr<Intent> intent) {
                 handleCommTransmission(intent);
@@ -89,6 +87,11 @@ namespace ai
             return "<twrkhz=" + to_string(m_departureTowerKhz) + ">";
         }
     private:
+        // looked up every time rather than kept, since the airport may be reloaded before the flight starts
+        shared_ptr<Airport> departureAirport()
+        {
+            return m_helper.getDepartureAirport(flight());
+        }
         void handleCommTransmission(shared_ptr<Intent> intent)
         {
             if (intent->direction() == Intent::Direction::ControllerToPilot && intent->subjectFlight() == flight())
@@ -745,7 +748,7 @@ namespace ai
         {
             const auto addLineupEdges = [=](shared_ptr<DepartureTaxiClearance> clearance) {
                 auto taxiPath = clearance->taxiPath();
-                auto runway = m_departureAirport->getRunwayOrThrow(clearance->departureRunway());
+                auto runway = departureAirport()->getRunwayOrThrow(clearance->departureRunway());
                 const auto& runwayEnd = runway->getEndOrThrow(clearance->departureRunway());
 
                 auto centerlinePoint = taxiPath->toNode->location().geo();
@@ -763,11 +766,11 @@ namespace ai
             };
 
             const auto onHoldingShort = [=](shared_ptr<TaxiEdge> holdShortEdge) {
-                auto departureRunway = m_departureAirport->getRunwayOrThrow(m_flightPlan->departureRunway());
+                auto departureRunway = departureAirport()->getRunwayOrThrow(m_flightPlan->departureRunway());
                 bool isHoldingShortDepartureRunway = holdShortEdge->activeZones().departue.has(departureRunway);
                 shared_ptr<Maneuver> holdShortManeuver = isHoldingShortDepartureRunway
                     ? maneuverDepartureAwaitLineup(m_flightPlan->departureRunway(), holdShortEdge)
-                    : maneuverAwaitCrossRunway(m_departureAirport, holdShortEdge);
+                    : maneuverAwaitCrossRunway(departureAirport(), holdShortEdge);
                 return holdShortManeuver;
             };
 
@@ -942,7 +945,7 @@ namespace ai
             return DeferredManeuver::create(Maneuver::Type::DepartureTakeOffRoll, "takeoff", [=]() {
                 auto clearance = flight()->findClearanceOrThrow<TakeoffClearance>(Clearance::Type::TakeoffClearance);
                 auto luaw = flight()->tryFindClearance<LineUpAndWaitApproval>(Clearance::Type::LineUpAndWait);
-                auto runway = m_departureAirport->getRunwayOrThrow(clearance->departureRunway());
+                auto runway = departureAirport()->getRunwayOrThrow(clearance->departureRunway());
                 const auto& runwayEnd = runway->getEndOrThrow(clearance->departureRunway());
                 float runwayHeading = runwayEnd.heading();
 
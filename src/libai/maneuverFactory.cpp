@@ -8,6 +8,7 @@
 #include <sstream>
 #include <iomanip>
 #include "libworld.h"
+#include "asyncLog.hpp"
 #include "basicManeuverTypes.hpp"
 #include "maneuverFactory.hpp"
 #include "clearanceFactory.hpp"
@@ -89,9 +90,9 @@ namespace ai
                 GeoMath::headingToAngleRadians(to->heading()),
                 turnRadius
             };
-            m_host->writeLog("before calculateTurn");
+            ATC_LOG_TRACE(AsyncLog::Category::AI, "before calculateTurn");
             GeoMath::calculateTurn(turnData, turnArc, m_host);
-            m_host->writeLog("after calculateTurn");
+            ATC_LOG_TRACE(AsyncLog::Category::AI, "after calculateTurn");
             return true;
         };
 
@@ -0,0 +1,305 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <cctype>
+#include "libworld.h"
+#include "libdataxp.h"
+
+using namespace std;
+using namespace world;
+
+const char* const Doc8643Index::Magic = "DOC8643";
+
+Doc8643Index::Doc8643Index(const string& indexFilePath) :
+    m_file(new MemoryMappedFile(indexFilePath))
+{
+    const char* data = m_file->data();
+    size_t size = m_file->size();
+
+    if (size < sizeof(FileHeader))
+    {
+        throw runtime_error("Doc8643Index: file is too short: " + indexFilePath);
+    }
+
+    m_header = reinterpret_cast<const FileHeader*>(data);
+    if (strncmp(m_header->magic, Magic, sizeof(m_header->magic)) != 0 || m_header->version != Version)
+    {
+        throw runtime_error("Doc8643Index: unrecognized file format: " + indexFilePath);
+    }
+
+    const size_t typeCount = m_header->typeCount;
+    const size_t slotCount = m_header->slotCount;
+    const size_t expectedSize = sizeof(FileHeader) + typeCount * (sizeof(uint32_t) + 4) + slotCount * sizeof(uint16_t);
+    if (size != expectedSize || slotCount == 0 || (slotCount & (slotCount - 1)) != 0)
+    {
+        throw runtime_error("Doc8643Index: file is corrupt: " + indexFilePath);
+    }
+
+    const char* column = data + sizeof(FileHeader);
+    m_designators = reinterpret_cast<const uint32_t*>(column);
+    column += typeCount * sizeof(uint32_t);
+    m_aircraftClasses = reinterpret_cast<const uint8_t*>(column);
+    column += typeCount;
+    m_engineCounts = reinterpret_cast<const uint8_t*>(column);
+    column += typeCount;
+    m_engineTypes = reinterpret_cast<const uint8_t*>(column);
+    column += typeCount;
+    m_wakeCategories = reinterpret_cast<const uint8_t*>(column);
+    column += typeCount;
+    m_slots = reinterpret_cast<const uint16_t*>(column);
+    m_slotMask = (uint32_t)slotCount - 1;
+}
+
+bool Doc8643Index::tryFind(const string& designator, AircraftTypeInfo& info) const
+{
+    uint32_t packed;
+    if (!tryPackDesignator(designator.c_str(), designator.length(), packed))
+    {
+        return false;
+    }
+
+    for (uint32_t slot = hashDesignator(packed) & m_slotMask ; m_slots[slot] != 0 ; slot = (slot + 1) & m_slotMask)
+    {
+        int index = m_slots[slot] - 1;
+        if (m_designators[index] == packed)
+        {
+            info.aircraftClass = (AircraftTypeInfo::AircraftClass)m_aircraftClasses[index];
+            info.engineCount = m_engineCounts[index];
+            info.engineType = (AircraftTypeInfo::EngineType)m_engineTypes[index];
+            info.wakeCategory = (AircraftTypeInfo::WakeCategory)m_wakeCategories[index];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Doc8643Index::convert(istream& doc8643Text, uint64_t sourceFileSize, ostream& indexOutput)
+{
+    vector<uint32_t> designators;
+    vector<AircraftTypeInfo> types;
+    unordered_set<uint32_t> seenDesignators;
+    string line;
+
+    while (getline(doc8643Text, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        vector<string> columns;
+        stringstream lineStream(line);
+        string column;
+        while (getline(lineStream, column, '\t'))
+        {
+            columns.push_back(column);
+        }
+
+        // manufacturer, model, designator, description, wake category
+        uint32_t packed;
+        if (columns.size() < 5 || !tryPackDesignator(columns[2].c_str(), columns[2].length(), packed))
+        {
+            continue;
+        }
+        // many models share a designator; they have the same description and wake category
+        if (!seenDesignators.insert(packed).second)
+        {
+            continue;
+        }
+
+        AircraftTypeInfo info;
+        parseDescription(columns[3], info);
+        info.wakeCategory = parseWakeCategory(columns[4]);
+
+        designators.push_back(packed);
+        types.push_back(info);
+    }
+
+    if (designators.size() >= 0xFFFF)
+    {
+        throw runtime_error("Doc8643Index: too many aircraft types");
+    }
+
+    uint32_t slotCount = 16;
+    while (slotCount < designators.size() * 2)
+    {
+        slotCount <<= 1;
+    }
+
+    vector<uint16_t> slots(slotCount, 0);
+    for (size_t i = 0 ; i < designators.size() ; i++)
+    {
+        uint32_t slot = hashDesignator(designators[i]) & (slotCount - 1);
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = (uint16_t)(i + 1);
+    }
+
+    FileHeader header = {};
+    strncpy(header.magic, Magic, sizeof(header.magic));
+    header.version = Version;
+    header.typeCount = (uint32_t)designators.size();
+    header.slotCount = slotCount;
+    header.sourceFileSize = sourceFileSize;
+    indexOutput.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    indexOutput.write(reinterpret_cast<const char*>(designators.data()), designators.size() * sizeof(uint32_t));
+
+    vector<uint8_t> column(types.size());
+    const auto writeColumn = [&](const function<uint8_t(const AircraftTypeInfo& info)>& getValue) {
+        for (size_t i = 0 ; i < types.size() ; i++)
+        {
+            column[i] = getValue(types[i]);
+        }
+        indexOutput.write(reinterpret_cast<const char*>(column.data()), column.size());
+    };
+    writeColumn([](const AircraftTypeInfo& info) { return (uint8_t)info.aircraftClass; });
+    writeColumn([](const AircraftTypeInfo& info) { return (uint8_t)info.engineCount; });
+    writeColumn([](const AircraftTypeInfo& info) { return (uint8_t)info.engineType; });
+    writeColumn([](const AircraftTypeInfo& info) { return (uint8_t)info.wakeCategory; });
+
+    indexOutput.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(uint16_t));
+}
+
+shared_ptr<Doc8643Index> Doc8643Index::openOrConvert(const string& textFilePath, const string& indexFilePath)
+{
+    ifstream text(textFilePath, ios::binary | ios::ate);
+    if (!text)
+    {
+        throw runtime_error("Doc8643Index: cannot open file: " + textFilePath);
+    }
+    uint64_t textFileSize = (uint64_t)text.tellg();
+    text.seekg(0);
+
+    try
+    {
+        auto index = make_shared<Doc8643Index>(indexFilePath);
+        if (index->sourceFileSize() == textFileSize)
+        {
+            return index;
+        }
+    }
+    catch (const exception&)
+    {
+        // missing or outdated index file, convert again
+    }
+
+    // write under a temporary name, so that a failed conversion does not leave a broken index behind
+    string tempFilePath = indexFilePath + ".tmp";
+    {
+        ofstream output(tempFilePath, ios::binary | ios::trunc);
+        if (!output)
+        {
+            throw runtime_error("Doc8643Index: cannot create file: " + tempFilePath);
+        }
+        convert(text, textFileSize, output);
+        if (!output)
+        {
+            throw runtime_error("Doc8643Index: failed to write file: " + tempFilePath);
+        }
+    }
+
+    remove(indexFilePath.c_str());
+    if (rename(tempFilePath.c_str(), indexFilePath.c_str()) != 0)
+    {
+        throw runtime_error("Doc8643Index: cannot create file: " + indexFilePath);
+    }
+
+    return make_shared<Doc8643Index>(indexFilePath);
+}
+
+bool Doc8643Index::tryPackDesignator(const char* designator, size_t length, uint32_t& packed)
+{
+    while (length > 0 && designator[length - 1] == ' ')
+    {
+        length--;
+    }
+    if (length == 0 || length > 4 || (length == 1 && designator[0] == '-'))
+    {
+        return false;
+    }
+
+    packed = 0;
+    for (size_t i = 0 ; i < length ; i++)
+    {
+        packed |= (uint32_t)(uint8_t)designator[i] << (8 * i);
+    }
+    return true;
+}
+
+uint32_t Doc8643Index::hashDesignator(uint32_t packed)
+{
+    uint32_t hash = packed * 2654435761u;
+    return hash ^ (hash >> 16);
+}
+
+void Doc8643Index::parseDescription(const string& description, AircraftTypeInfo& info)
+{
+    // e.g. L2J: landplane, 2 engines, jet
+    if (description.length() != 3)
+    {
+        return;
+    }
+
+    switch (description[0])
+    {
+    case 'L': info.aircraftClass = AircraftTypeInfo::AircraftClass::Landplane; break;
+    case 'S': info.aircraftClass = AircraftTypeInfo::AircraftClass::Seaplane; break;
+    case 'A': info.aircraftClass = AircraftTypeInfo::AircraftClass::Amphibian; break;
+    case 'H': info.aircraftClass = AircraftTypeInfo::AircraftClass::Helicopter; break;
+    case 'G': info.aircraftClass = AircraftTypeInfo::AircraftClass::Gyrocopter; break;
+    case 'T': info.aircraftClass = AircraftTypeInfo::AircraftClass::Tiltrotor; break;
+    }
+
+    if (isdigit(description[1]))
+    {
+        info.engineCount = description[1] - '0';
+    }
+    else if (description[1] == 'C')
+    {
+        // two coupled engines driving one propeller
+        info.engineCount = 2;
+    }
+
+    switch (description[2])
+    {
+    case 'P': info.engineType = AircraftTypeInfo::EngineType::Piston; break;
+    case 'T': info.engineType = AircraftTypeInfo::EngineType::Turboprop; break;
+    case 'J': info.engineType = AircraftTypeInfo::EngineType::Jet; break;
+    case 'E': info.engineType = AircraftTypeInfo::EngineType::Electric; break;
+    case 'R': info.engineType = AircraftTypeInfo::EngineType::Rocket; break;
+    }
+}
+
+AircraftTypeInfo::WakeCategory Doc8643Index::parseWakeCategory(const string& wakeCategory)
+{
+    if (wakeCategory == "L")
+    {
+        return AircraftTypeInfo::WakeCategory::Light;
+    }
+    if (wakeCategory == "L/M")
+    {
+        return AircraftTypeInfo::WakeCategory::LightMedium;
+    }
+    if (wakeCategory == "M")
+    {
+        return AircraftTypeInfo::WakeCategory::Medium;
+    }
+    if (wakeCategory == "H")
+    {
+        return AircraftTypeInfo::WakeCategory::Heavy;
+    }
+    if (wakeCategory == "J")
+    {
+        return AircraftTypeInfo::WakeCategory::Super;
+    }
+    return AircraftTypeInfo::WakeCategory::Unknown;
+}
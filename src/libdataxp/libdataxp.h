@@ -6,6 +6,7 @@
 
 #include <string>
 #include <sstream>
+#include <cstring>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -63,6 +64,7 @@ public:
     void readAirport(istream &input);
     bool validate(vector<string> &diagnostics);
     shared_ptr<Airport> getAirport();
+    shared_ptr<Airport::Structure> getAirportStructure();
 private:
     void readAptDatInContext(istream &input, ContextualParser parser);
     bool readAptDatLineInContext(istream &input, ContextualParser parser);
@@ -79,6 +81,7 @@ private:
     bool isControlFrequencyLine(int lineCode);
     bool invokeFilterCallback();
     shared_ptr<Airport> assembleAirportOrThrow();
+    Airport::Header getHeader() const;
     string formatErrorMessage(istream &input, const streampos& position, int extractedLineCode, const char *what);
 public:
     static string readFirstToken(istream &input);
@@ -94,6 +97,7 @@ class XPAptDatReader
 {
 public:
     typedef function<void(shared_ptr<Airport> airport)> AirportLoadedCallback;
+    typedef function<bool(shared_ptr<Airport::Structure> structure)> AirportParsedCallback;
 private:
     const shared_ptr<HostServices> m_host;
 public:
@@ -104,15 +108,38 @@ public:
         const XPAirportReader::QueryAirspaceCallback& onQueryAirspace,
         const XPAirportReader::FilterAirportCallback& onFilterAirport,
         const AirportLoadedCallback& onAirportLoaded);
+    void readAirportStructures(
+        istream &input,
+        const XPAirportReader::FilterAirportCallback& onFilterAirport,
+        const AirportParsedCallback& onAirportParsed);
+    shared_ptr<Airport::Structure> readAirportStructure(istream &input, const string& icao);
 };
 
 class XPFmsxReader
 {
+public:
+    struct BatchResult
+    {
+        vector<shared_ptr<FlightPlan>> flightPlans;
+        int fileCount = 0;
+        int failedFileCount = 0;
+        int duplicateCount = 0;
+        int unresolvedCount = 0;
+    };
 private:
+    // points into the text being parsed; flight plan files are parsed without per-line allocations
+    struct Span
+    {
+        const char* data;
+        size_t length;
+        bool equals(const char* s) const { return strlen(s) == length && strncmp(data, s, length) == 0; }
+        bool startsWith(const char* s) const { return strlen(s) <= length && strncmp(data, s, strlen(s)) == 0; }
+        string str() const { return string(data, length); }
+    };
     struct Line
     {
-        string token;
-        string suffix;
+        Span token;
+        Span suffix;
         char delimiter;
     };
 private:
@@ -121,15 +148,92 @@ public:
     XPFmsxReader(shared_ptr<HostServices> _host);
 public:
     shared_ptr<FlightPlan> readFrom(istream& input);
+    shared_ptr<FlightPlan> readFrom(const char* text, size_t length);
+    BatchResult readDirectory(const vector<string>& relativePathParts, int threadCount = 0);
 private:
-    void parseInputLines(istream& input, vector<Line>& lines);
-    void addValue(shared_ptr<FlightPlan> plan, const string& key, const string& value);
-    bool isFmsFormat(const vector<Line>& lines);
-    bool isFmxFormat(const vector<Line>& lines);
-    void parseFmsFormat(shared_ptr<FlightPlan> plan, const vector<Line>& lines);
-    void parseFmxFormat(shared_ptr<FlightPlan> plan, const vector<Line>& lines);
+    shared_ptr<FlightPlan> readFrom(const char* text, size_t length, time_t departureTime, vector<Line>& lines);
+    void resolveAirports(BatchResult& result);
 private:
-    static int countCharOccurrences(const string& s, char c);
-    static string trimLead(const string& s, const string& prefix);
+    static void parseInputLines(const char* text, size_t length, vector<Line>& lines);
+    static void addValue(shared_ptr<FlightPlan> plan, const Span& key, const Span& value);
+    static bool isFmsFormat(const vector<Line>& lines);
+    static bool isFmxFormat(const vector<Line>& lines);
+    static void parseFmsFormat(shared_ptr<FlightPlan> plan, const vector<Line>& lines);
+    static void parseFmxFormat(shared_ptr<FlightPlan> plan, const vector<Line>& lines);
+    static int countCharOccurrences(const Span& s, char c);
+    static string trimLead(const Span& s, const char* prefix);
     static string getRunwayFromApproachName(const string &approachName);
+    static bool hasFlightPlanFileExtension(const string& fileName);
+    static string getDeduplicationKey(const FlightPlan& plan);
+};
+
+class MemoryMappedFile
+{
+private:
+    const char* m_data;
+    size_t m_size;
+    void* m_fileHandle;
+    void* m_mappingHandle;
+public:
+    explicit MemoryMappedFile(const string& filePath);
+    MemoryMappedFile(const MemoryMappedFile& other) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile& other) = delete;
+    ~MemoryMappedFile();
+public:
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
+
+// Aircraft types from ICAO Doc 8643, converted from the tab-separated text file
+// (manufacturer, model, designator, description, wake category) into a binary
+// columnar file, which is memory-mapped and indexed by designator:
+//
+//   FileHeader
+//   uint32_t designator[typeCount]     4 characters, zero-padded
+//   uint8_t  aircraftClass[typeCount]
+//   uint8_t  engineCount[typeCount]
+//   uint8_t  engineType[typeCount]
+//   uint8_t  wakeCategory[typeCount]
+//   uint16_t slot[slotCount]           open-addressing hash of designator -> type index + 1
+//
+class Doc8643Index
+{
+private:
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t typeCount;
+        uint32_t slotCount;
+        uint32_t reserved;
+        uint64_t sourceFileSize;
+    };
+private:
+    static const char* const Magic;
+    static constexpr uint32_t Version = 1;
+    unique_ptr<MemoryMappedFile> m_file;
+    const FileHeader* m_header;
+    const uint32_t* m_designators;
+    const uint8_t* m_aircraftClasses;
+    const uint8_t* m_engineCounts;
+    const uint8_t* m_engineTypes;
+    const uint8_t* m_wakeCategories;
+    const uint16_t* m_slots;
+    uint32_t m_slotMask;
+public:
+    explicit Doc8643Index(const string& indexFilePath);
+    Doc8643Index(const Doc8643Index& other) = delete;
+public:
+    bool tryFind(const string& designator, AircraftTypeInfo& info) const;
+    int size() const { return (int)m_header->typeCount; }
+    uint64_t sourceFileSize() const { return m_header->sourceFileSize; }
+public:
+    static void convert(istream& doc8643Text, uint64_t sourceFileSize, ostream& indexOutput);
+    // converts the text file if the index file is missing or was converted from a different text file
+    static shared_ptr<Doc8643Index> openOrConvert(const string& textFilePath, const string& indexFilePath);
+private:
+    static bool tryPackDesignator(const char* designator, size_t length, uint32_t& packed);
+    static uint32_t hashDesignator(uint32_t packed);
+    static void parseDescription(const string& description, AircraftTypeInfo& info);
+    static AircraftTypeInfo::WakeCategory parseWakeCategory(const string& wakeCategory);
 };
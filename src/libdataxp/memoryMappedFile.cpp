@@ -0,0 +1,115 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <string>
+#include <stdexcept>
+#include "libdataxp.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+MemoryMappedFile::MemoryMappedFile(const string& filePath) :
+    m_data(nullptr),
+    m_size(0),
+    m_fileHandle(nullptr),
+    m_mappingHandle(nullptr)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(
+        filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw runtime_error("MemoryMappedFile: cannot open file: " + filePath);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        throw runtime_error("MemoryMappedFile: cannot get file size: " + filePath);
+    }
+
+    m_fileHandle = file;
+    m_size = (size_t)fileSize.QuadPart;
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        throw runtime_error("MemoryMappedFile: cannot map file: " + filePath);
+    }
+
+    m_mappingHandle = mapping;
+    m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw runtime_error("MemoryMappedFile: cannot map file: " + filePath);
+    }
+#else
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("MemoryMappedFile: cannot open file: " + filePath);
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        close(fd);
+        throw runtime_error("MemoryMappedFile: cannot get file size: " + filePath);
+    }
+
+    m_size = (size_t)fileStat.st_size;
+    if (m_size > 0)
+    {
+        void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            throw runtime_error("MemoryMappedFile: cannot map file: " + filePath);
+        }
+        m_data = static_cast<const char*>(mapped);
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mappingHandle)
+    {
+        CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+    }
+    if (m_fileHandle)
+    {
+        CloseHandle(static_cast<HANDLE>(m_fileHandle));
+    }
+#else
+    if (m_data)
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+}
@@ -128,13 +128,26 @@ shared_ptr<Airport> XPAirportReader::getAirport()
     return nullptr;
 }
 
-shared_ptr<Airport> XPAirportReader::assembleAirportOrThrow()
+shared_ptr<Airport::Structure> XPAirportReader::getAirportStructure()
 {
-    GeoPoint datum(
-        m_datumLatitude != DATUM_UNSPECIFIED ? m_datumLatitude : 0,
-        m_datumLongitude != DATUM_UNSPECIFIED ? m_datumLongitude : 0);
+    if (m_skippingAirport)
+    {
+        return nullptr;
+    }
 
-    Airport::Header header(m_icao, m_name, datum, m_elevation);
+    return shared_ptr<Airport::Structure>(new Airport::Structure({
+        getHeader(),
+        m_runways,
+        m_parkingStands,
+        m_taxiNodes,
+        m_taxiEdges,
+        m_controllerPositions
+    }));
+}
+
+shared_ptr<Airport> XPAirportReader::assembleAirportOrThrow()
+{
+    Airport::Header header = getHeader();
     m_airspace = m_onQueryAirspace(header);
     
     shared_ptr<ControlFacility> tower = m_airspace
@@ -154,6 +167,15 @@ shared_ptr<Airport> XPAirportReader::assembleAirportOrThrow()
     return airport;
 }
 
+Airport::Header XPAirportReader::getHeader() const
+{
+    GeoPoint datum(
+        m_datumLatitude != DATUM_UNSPECIFIED ? m_datumLatitude : 0,
+        m_datumLongitude != DATUM_UNSPECIFIED ? m_datumLongitude : 0);
+
+    return Airport::Header(m_icao, m_name, datum, m_elevation);
+}
+
 void XPAirportReader::readAptDatInContext(istream& input, ContextualParser parser)
 {   
     while (!input.eof() && !input.bad())
@@ -784,3 +806,58 @@ void XPAptDatReader::readAptDat(
     m_host->writeLog("APTDAT|done loading airports, %d loaded, %d skipped.", loadedCount, skippedCount);
 }
 
+void XPAptDatReader::readAirportStructures(
+    istream &input,
+    const XPAirportReader::FilterAirportCallback& onFilterAirport,
+    const XPAptDatReader::AirportParsedCallback& onAirportParsed)
+{
+    int parsedCount = 0;
+    int skippedCount = 0;
+    int unparsedLineCode = -1;
+
+    do {
+        XPAirportReader airportReader(m_host, unparsedLineCode, XPAirportReader::noopQueryAirspace, onFilterAirport);
+        airportReader.readAirport(input);
+        unparsedLineCode = airportReader.unparsedLineCode();
+
+        auto structure = airportReader.getAirportStructure();
+        if (structure && airportReader.headerWasRead())
+        {
+            parsedCount++;
+            if (!onAirportParsed(structure))
+            {
+                m_host->writeLog("APTDAT|parsing airports cancelled after %d airports.", parsedCount);
+                return;
+            }
+        }
+        else if (airportReader.headerWasRead() && airportReader.isLandAirport())
+        {
+            m_host->writeLog("APTDAT|skipped airport [%s]", airportReader.icao().c_str());
+            skippedCount++;
+        }
+    } while (XPAirportReader::isAirportHeaderLineCode(unparsedLineCode));
+
+    m_host->writeLog("APTDAT|done parsing airports, %d parsed, %d skipped.", parsedCount, skippedCount);
+}
+
+shared_ptr<Airport::Structure> XPAptDatReader::readAirportStructure(istream &input, const string& icao)
+{
+    shared_ptr<Airport::Structure> result;
+
+    readAirportStructures(
+        input,
+        [&icao](const Airport::Header& header) {
+            return header.icao() == icao;
+        },
+        [&result, &icao](shared_ptr<Airport::Structure> structure) {
+            if (structure->header.icao() != icao)
+            {
+                return true;
+            }
+            result = structure;
+            return false;
+        }
+    );
+
+    return result;
+}
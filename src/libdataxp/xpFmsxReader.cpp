@@ -4,6 +4,11 @@
 //
 #include <memory>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstring>
 #include <utility>
 #include <system_error>
 #include "stlhelpers.h"
@@ -20,12 +25,114 @@ XPFmsxReader::XPFmsxReader(shared_ptr<HostServices> _host) :
 
 shared_ptr<FlightPlan> XPFmsxReader::readFrom(istream &input)
 {
+    string text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    return readFrom(text.c_str(), text.length());
+}
+
+shared_ptr<FlightPlan> XPFmsxReader::readFrom(const char* text, size_t length)
+{
+    vector<Line> lines;
     time_t departureTime = m_host->getWorld()->currentTime() + 45 * 60;
+    return readFrom(text, length, departureTime, lines);
+}
+
+XPFmsxReader::BatchResult XPFmsxReader::readDirectory(const vector<string>& relativePathParts, int threadCount)
+{
+    BatchResult result;
+    vector<string> filePaths;
+
+    for (const string& fileName : m_host->findFilesInHostDirectory(relativePathParts))
+    {
+        if (hasFlightPlanFileExtension(fileName))
+        {
+            vector<string> filePathParts = relativePathParts;
+            filePathParts.push_back(fileName);
+            filePaths.push_back(m_host->getHostFilePath(filePathParts));
+        }
+    }
+
+    result.fileCount = (int)filePaths.size();
+    if (filePaths.empty())
+    {
+        return result;
+    }
+
+    if (threadCount <= 0)
+    {
+        threadCount = max(1, (int)thread::hardware_concurrency());
+    }
+    threadCount = min(threadCount, (int)filePaths.size());
+
+    // the world is not accessed from the worker threads
+    time_t departureTime = m_host->getWorld()->currentTime() + 45 * 60;
+    vector<shared_ptr<FlightPlan>> plansByFileIndex(filePaths.size());
+    atomic<int> nextFileIndex(0);
+    atomic<int> failedFileCount(0);
+
+    auto readFiles = [&]() {
+        vector<Line> lines;
+        int fileIndex;
+        while ((fileIndex = nextFileIndex++) < (int)filePaths.size())
+        {
+            const string& filePath = filePaths[fileIndex];
+            try
+            {
+                MemoryMappedFile file(filePath);
+                plansByFileIndex[fileIndex] = readFrom(file.data(), file.size(), departureTime, lines);
+            }
+            catch (const exception& e)
+            {
+                failedFileCount++;
+                m_host->writeLog("FMSXRD|FAILED to read flight plan [%s]: %s", filePath.c_str(), e.what());
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (int i = 1 ; i < threadCount ; i++)
+    {
+        workers.emplace_back(readFiles);
+    }
+    readFiles();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    result.failedFileCount = failedFileCount;
+
+    // deduplicate in file order, so that the result does not depend on thread scheduling
+    unordered_set<string> seenKeys;
+    for (const auto& plan : plansByFileIndex)
+    {
+        if (!plan)
+        {
+            continue;
+        }
+        if (!seenKeys.insert(getDeduplicationKey(*plan)).second)
+        {
+            result.duplicateCount++;
+            continue;
+        }
+        result.flightPlans.push_back(plan);
+    }
+
+    resolveAirports(result);
+
+    m_host->writeLog(
+        "FMSXRD|read [%d] flight plans from [%d] files: [%d] failed, [%d] duplicate, [%d] unresolved airports",
+        (int)result.flightPlans.size(), result.fileCount, result.failedFileCount, result.duplicateCount, result.unresolvedCount);
+
+    return result;
+}
+
+shared_ptr<FlightPlan> XPFmsxReader::readFrom(const char* text, size_t length, time_t departureTime, vector<Line>& lines)
+{
     time_t arrivalTime = departureTime + 180 * 60;
     auto plan = shared_ptr<FlightPlan>(new FlightPlan(departureTime, arrivalTime, "", ""));
 
-    vector<Line> lines;
-    parseInputLines(input, lines);
+    lines.clear();
+    parseInputLines(text, length, lines);
 
     if (isFmsFormat(lines))
     {
@@ -43,47 +150,72 @@ shared_ptr<FlightPlan> XPFmsxReader::readFrom(istream &input)
     return plan;
 }
 
-void XPFmsxReader::parseInputLines(istream &input, vector<Line> &lines)
+void XPFmsxReader::resolveAirports(BatchResult& result)
 {
-    while (!input.eof() && !input.bad())
+    auto world = m_host->getWorld();
+    auto isResolved = [&world](const shared_ptr<FlightPlan>& plan) {
+        return world->tryFindAirport(plan->departureAirportIcao()) && world->tryFindAirport(plan->arrivalAirportIcao());
+    };
+
+    auto resolvedEnd = stable_partition(result.flightPlans.begin(), result.flightPlans.end(), isResolved);
+    for (auto it = resolvedEnd ; it != result.flightPlans.end() ; it++)
     {
-        string text;
+        m_host->writeLog(
+            "FMSXRD|skipping flight plan [%s]->[%s]: airport not found",
+            (*it)->departureAirportIcao().c_str(),
+            (*it)->arrivalAirportIcao().c_str());
+    }
+
+    result.unresolvedCount = (int)(result.flightPlans.end() - resolvedEnd);
+    result.flightPlans.erase(resolvedEnd, result.flightPlans.end());
+}
 
-        try
+void XPFmsxReader::parseInputLines(const char* text, size_t length, vector<Line> &lines)
+{
+    const char *delimiterChars = ",: ";
+    const char *end = text + length;
+    const char *lineStart = text;
+
+    while (lineStart < end)
+    {
+        const char *lineEnd = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+        const char *nextLineStart = lineEnd ? lineEnd + 1 : end;
+        if (!lineEnd)
         {
-            getline(input, text);
+            lineEnd = end;
         }
-        catch(const exception &e)
+        if (lineEnd > lineStart && *(lineEnd - 1) == '\r')
         {
-            break;
+            lineEnd--;
         }
 
-        const char *delimiterChars = ",: ";
-        size_t delimitierIndex = text.find_first_of(delimiterChars);
-        size_t lastNonSpaceIndex = text.length() - 1;
-
-        while (lastNonSpaceIndex >= 0 && strchr(delimiterChars, text.at(lastNonSpaceIndex)))
+        const char *delimiter = lineStart;
+        while (delimiter < lineEnd && !strchr(delimiterChars, *delimiter))
         {
-            lastNonSpaceIndex--;
+            delimiter++;
         }
 
-        if (delimitierIndex != text.npos && delimitierIndex < lastNonSpaceIndex)
+        const char *lastNonSpace = lineEnd - 1;
+        while (lastNonSpace >= lineStart && strchr(delimiterChars, *lastNonSpace))
         {
-            string token = text.substr(0, delimitierIndex);
-            string suffix = text.substr(delimitierIndex + 1, lastNonSpaceIndex - delimitierIndex);
+            lastNonSpace--;
+        }
 
-            if (!token.empty())
-            {
-                lines.push_back({ token, suffix, text.at(delimitierIndex) });
-            }
+        if (delimiter < lineEnd && delimiter < lastNonSpace && delimiter > lineStart)
+        {
+            Span token = { lineStart, (size_t)(delimiter - lineStart) };
+            Span suffix = { delimiter + 1, (size_t)(lastNonSpace - delimiter) };
+            lines.push_back({ token, suffix, *delimiter });
         }
+
+        lineStart = nextLineStart;
     }
 }
 
 bool XPFmsxReader::isFmsFormat(const vector<Line> &lines)
 {
     auto v11it = find_if(lines.begin(), lines.end(), [](const Line& line){
-        return (line.token == "1100" && line.suffix == "Version");
+        return (line.token.equals("1100") && line.suffix.equals("Version"));
     });
     bool foundV11 = (v11it != lines.end());
     return foundV11;
@@ -96,8 +228,7 @@ bool XPFmsxReader::isFmxFormat(const vector<Line> &lines)
         return false;
     }
 
-    const string& firstLineSuffix = lines.at(0).suffix;
-    int commaCount = countCharOccurrences(firstLineSuffix, ',');
+    int commaCount = countCharOccurrences(lines.at(0).suffix, ',');
     return commaCount == 3;
 }
 
@@ -107,7 +238,7 @@ void XPFmsxReader::parseFmsFormat(shared_ptr<FlightPlan> plan, const vector<Line
     {
         const Line& line = lines.at(i);
 
-        if (line.token != "NUMENR")
+        if (!line.token.equals("NUMENR"))
         {
             addValue(plan, line.token, line.suffix);
         }
@@ -131,14 +262,14 @@ void XPFmsxReader::parseFmxFormat(shared_ptr<FlightPlan> plan, const vector<Line
             bool continueEnrouteSection = (countCharOccurrences(line.suffix, ',') == 3);
             if (!continueEnrouteSection && plan->arrivalAirportIcao().empty() && i > 0)
             {
-                plan->setArrivalAirportIcao(lines.at(i - 1).token);
+                plan->setArrivalAirportIcao(lines.at(i - 1).token.str());
             }
             isEnrouteSection = continueEnrouteSection;
         }
 
         if (isEnrouteSection && plan->departureAirportIcao().empty())
         {
-            plan->setDepartureAirportIcao(line.token);
+            plan->setDepartureAirportIcao(line.token.str());
         }
 
         if (!isEnrouteSection)
@@ -148,71 +279,69 @@ void XPFmsxReader::parseFmxFormat(shared_ptr<FlightPlan> plan, const vector<Line
     }
 }
 
-void XPFmsxReader::addValue(shared_ptr<FlightPlan> plan, const string &key, const string &value)
+void XPFmsxReader::addValue(shared_ptr<FlightPlan> plan, const Span &key, const Span &value)
 {
-    if (key == "ADEP")
+    if (key.equals("ADEP"))
     {
-        plan->setDepartureAirportIcao(value);
+        plan->setDepartureAirportIcao(value.str());
     }
-    else if (key == "ADES")
+    else if (key.equals("ADES"))
     {
-        plan->setArrivalAirportIcao(value);
+        plan->setArrivalAirportIcao(value.str());
     }
-    else if (key == "DEPRWY")
+    else if (key.equals("DEPRWY"))
     {
         plan->setDepartureRunway(trimLead(value, "RW"));
     }
-    else if (key == "DESRWY")
+    else if (key.equals("DESRWY"))
     {
         plan->setArrivalRunway(trimLead(value, "RW"));
     }
-    else if (key == "SID")
+    else if (key.equals("SID"))
     {
-        plan->setSid(value);
+        plan->setSid(value.str());
     }
-    else if (key == "SIDTRANS")
+    else if (key.equals("SIDTRANS"))
     {
-        plan->setSidTransition(value);
+        plan->setSidTransition(value.str());
     }
-    else if (key == "STAR")
+    else if (key.equals("STAR"))
     {
-        plan->setStar(value);
+        plan->setStar(value.str());
     }
-    else if (key == "STARTRANS")
+    else if (key.equals("STARTRANS"))
     {
-        plan->setStarTransition(value);
+        plan->setStarTransition(value.str());
     }
-    else if (key == "APP")
+    else if (key.equals("APP"))
     {
-        plan->setApproach(value);
+        plan->setApproach(value.str());
         if (plan->arrivalRunway().empty())
         {
-            plan->setArrivalRunway(getRunwayFromApproachName(value));
+            plan->setArrivalRunway(getRunwayFromApproachName(plan->approachName()));
         }
     }
-    else if (key == "FLIGHT_NUM")
+    else if (key.equals("FLIGHT_NUM"))
     {
-        plan->setFlightNo(value);
+        plan->setFlightNo(value.str());
     }
 }
 
-int XPFmsxReader::countCharOccurrences(const string& s, char c)
+int XPFmsxReader::countCharOccurrences(const Span& s, char c)
 {
-    return count_if(s.begin(), s.end(), [c](char ci){
+    return count_if(s.data, s.data + s.length, [c](char ci){
         return (ci == c);
     });
 }
 
-string XPFmsxReader::trimLead(const string &s, const string& prefix)
+string XPFmsxReader::trimLead(const Span &s, const char* prefix)
 {
-    size_t pos = s.find(prefix);
-    if (pos == 0)
+    if (s.startsWith(prefix))
     {
-        string copy = s;
-        copy.erase(0, prefix.length());
-        return copy;
+        size_t prefixLength = strlen(prefix);
+        return string(s.data + prefixLength, s.length - prefixLength);
     }
-    return s;
+    return s.str();
 }
 
 string XPFmsxReader::getRunwayFromApproachName(const string& approachName)
@@ -241,3 +370,29 @@ string XPFmsxReader::getRunwayFromApproachName(const string& approachName)
 
     return runwayName;
 }
+
+bool XPFmsxReader::hasFlightPlanFileExtension(const string& fileName)
+{
+    if (fileName.length() < 4)
+    {
+        return false;
+    }
+
+    string extension = fileName.substr(fileName.length() - 4);
+    transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return (extension == ".fms" || extension == ".fmx");
+}
+
+string XPFmsxReader::getDeduplicationKey(const FlightPlan& plan)
+{
+    string key;
+    for (const string* field : {
+        &plan.departureAirportIcao(), &plan.departureRunway(), &plan.sidName(), &plan.sidTransition(),
+        &plan.arrivalAirportIcao(), &plan.arrivalRunway(), &plan.starName(), &plan.starTransition(),
+        &plan.approachName(), &plan.flightNo() })
+    {
+        key.append(*field);
+        key.push_back('|');
+    }
+    return key;
+}
@@ -0,0 +1,301 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+
+// Measures apt.dat loading: XPAptDatReader + WorldBuilder over the test inputs,
+// and optionally over a full global apt.dat.
+//
+// usage: libdataxp_bench [--inputs <dir>] [--global <apt.dat>] [--iterations <n>]
+//
+// --inputs      directory with apt_*.dat test inputs (default: ../libdataxp_test/testInputs)
+// --global      path to a full apt.dat; also taken from ATC_GLOBAL_APT_DAT env variable
+// --iterations  how many times each input is loaded; the best run is reported (default: 3)
+//
+// Retained bytes are the whole heap retained by the loaded world, measured once per input;
+// the per-airport figure is that total averaged over airports, taxi nodes and edges included.
+// Bytes per taxi node and per taxi edge are measured separately, as the heap a synthetic grid
+// airport retains for extra nodes and edges; with them, every input's total is split into
+// its taxi net and the rest. (Real inputs alone can't tell the two apart: edges are about
+// 1.2 nodes at every airport.) Peak RSS is process-wide and covers all inputs loaded so far.
+//
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "libworld.h"
+#include "libdataxp.h"
+#include "libworld_test.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace world;
+
+// live heap bytes are tracked by replacing global operator new/delete, so that
+// bytes retained by the loaded world can be measured independently of the allocator
+static atomic<long long> liveHeapBytes(0);
+
+void* operator new(size_t size)
+{
+    size_t* block = static_cast<size_t*>(malloc(size + sizeof(max_align_t)));
+    if (!block)
+    {
+        throw bad_alloc();
+    }
+    *block = size;
+    liveHeapBytes += size;
+    return reinterpret_cast<char*>(block) + sizeof(max_align_t);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr)
+    {
+        size_t* block = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - sizeof(max_align_t));
+        liveHeapBytes -= *block;
+        free(block);
+    }
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+struct LoadResult
+{
+    string inputName;
+    long long fileBytes = 0;
+    int airportCount = 0;
+    long long taxiNodeCount = 0;
+    long long taxiEdgeCount = 0;
+    long long parkingStandCount = 0;
+    double bestSeconds = 0;
+    long long retainedBytes = 0;
+};
+
+static long long getPeakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return (long long)counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (long long)usage.ru_maxrss;
+#else
+    return (long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+static long long getFileSize(const string& filePath)
+{
+    ifstream file(filePath, ios::binary | ios::ate);
+    return file ? (long long)file.tellg() : -1;
+}
+
+struct TaxiNetCost
+{
+    double bytesPerNode = 0;
+    double bytesPerEdge = 0;
+};
+
+// a square grid of taxiways 50 meters apart, with or without edges along columns
+static long long measureGridAirport(int size, bool withNodes, bool withRowEdges, bool withColumnEdges)
+{
+    auto host = TestHostServices::create();
+    long long heapBefore = liveHeapBytes.load();
+
+    vector<shared_ptr<TaxiNode>> nodes;
+    vector<shared_ptr<TaxiEdge>> edges;
+    if (withNodes)
+    {
+        TestGridAirport::buildTaxiNet(host, size, size, 50, nodes, edges, withRowEdges, withColumnEdges);
+    }
+
+    Airport::Header header("GRID", "Grid", GeoPoint(0, 0), 0);
+    auto airport = WorldBuilder::assembleAirport(host, header, {}, {}, nodes, edges);
+    return liveHeapBytes.load() - heapBefore;
+}
+
+static TaxiNetCost measureTaxiNetCost()
+{
+    const int size = 40;
+    const long long emptyBytes = measureGridAirport(size, false, false, false);
+    const long long nodesBytes = measureGridAirport(size, true, false, false);
+    const long long rowEdgesBytes = measureGridAirport(size, true, true, false);
+    const long long allEdgesBytes = measureGridAirport(size, true, true, true);
+
+    TaxiNetCost cost;
+    cost.bytesPerNode = (double)(nodesBytes - emptyBytes) / (size * size);
+    cost.bytesPerEdge = (double)(allEdgesBytes - rowEdgesBytes) / (size * (size - 1));
+    return cost;
+}
+
+static vector<shared_ptr<Airport>> loadAptDat(shared_ptr<HostServices> host, const string& filePath)
+{
+    vector<shared_ptr<Airport>> airports;
+    ifstream input(filePath);
+    XPAptDatReader reader(host);
+
+    reader.readAptDat(
+        input,
+        WorldBuilder::assembleSampleAirportControlZone,
+        XPAirportReader::noopFilterAirport,
+        [&airports](shared_ptr<Airport> airport) {
+            airports.push_back(airport);
+        }
+    );
+
+    return airports;
+}
+
+static LoadResult benchmarkInput(const string& inputName, const string& filePath, int iterations)
+{
+    LoadResult result;
+    result.inputName = inputName;
+    result.fileBytes = getFileSize(filePath);
+
+    for (int i = 0 ; i < iterations ; i++)
+    {
+        auto host = TestHostServices::create();
+        long long heapBefore = liveHeapBytes.load();
+        auto started = chrono::steady_clock::now();
+
+        auto airports = loadAptDat(host, filePath);
+        auto world = WorldBuilder::assembleSampleWorld(host, airports);
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        long long retained = liveHeapBytes.load() - heapBefore;
+
+        if (i == 0 || seconds < result.bestSeconds)
+        {
+            result.bestSeconds = seconds;
+        }
+        if (i == 0)
+        {
+            // later iterations reuse names interned by the first one, so only the first
+            // iteration reflects the memory cost of a cold load
+            result.retainedBytes = retained;
+            result.airportCount = (int)airports.size();
+            for (const auto& airport : airports)
+            {
+                result.taxiNodeCount += airport->taxiNet()->nodes().size();
+                result.taxiEdgeCount += airport->taxiNet()->edges().size();
+                result.parkingStandCount += airport->parkingStands().size();
+            }
+        }
+    }
+
+    return result;
+}
+
+static void printResult(const LoadResult& result, const TaxiNetCost& taxiNetCost)
+{
+    const double megabytes = result.fileBytes / (1024.0 * 1024.0);
+
+    printf("%-16s %9.2f MB %7d apt %8lld nodes %8lld edges %7lld stands\n",
+        result.inputName.c_str(),
+        megabytes,
+        result.airportCount,
+        result.taxiNodeCount,
+        result.taxiEdgeCount,
+        result.parkingStandCount);
+    printf("    time %9.3f ms | %10.1f airports/sec | %8.2f MB/sec\n",
+        result.bestSeconds * 1000,
+        result.bestSeconds > 0 ? result.airportCount / result.bestSeconds : 0.0,
+        result.bestSeconds > 0 ? megabytes / result.bestSeconds : 0.0);
+    printf("    retained %10.2f MB total | %10.0f bytes per airport on average\n",
+        result.retainedBytes / (1024.0 * 1024.0),
+        result.airportCount > 0 ? (double)result.retainedBytes / result.airportCount : 0.0);
+
+    const double taxiNetBytes = result.taxiNodeCount * taxiNetCost.bytesPerNode + result.taxiEdgeCount * taxiNetCost.bytesPerEdge;
+    printf("    of which taxi net %8.2f MB (nodes %.2f MB, edges %.2f MB) | the rest %8.2f MB\n",
+        taxiNetBytes / (1024.0 * 1024.0),
+        result.taxiNodeCount * taxiNetCost.bytesPerNode / (1024.0 * 1024.0),
+        result.taxiEdgeCount * taxiNetCost.bytesPerEdge / (1024.0 * 1024.0),
+        (result.retainedBytes - taxiNetBytes) / (1024.0 * 1024.0));
+}
+
+int main(int argc, char** argv)
+{
+    string inputsDir = "../libdataxp_test/testInputs";
+    string globalAptDatPath;
+    int iterations = 3;
+
+    const char* globalFromEnv = getenv("ATC_GLOBAL_APT_DAT");
+    if (globalFromEnv)
+    {
+        globalAptDatPath = globalFromEnv;
+    }
+
+    for (int i = 1 ; i < argc ; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--inputs" && hasValue)
+        {
+            inputsDir = argv[++i];
+        }
+        else if (arg == "--global" && hasValue)
+        {
+            globalAptDatPath = argv[++i];
+        }
+        else if (arg == "--iterations" && hasValue)
+        {
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--inputs <dir>] [--global <apt.dat>] [--iterations <n>]" << endl;
+            return 1;
+        }
+    }
+
+    vector<pair<string, string>> inputs;
+    for (const string& fileName : { "apt_many.dat", "apt_huen.dat", "apt_kjfk.dat", "apt_kmia.dat", "apt_kord.dat" })
+    {
+        inputs.push_back({ fileName, inputsDir + "/" + fileName });
+    }
+    if (!globalAptDatPath.empty())
+    {
+        inputs.push_back({ "global apt.dat", globalAptDatPath });
+    }
+
+    printf("sizeof: Airport %d, TaxiNode %d, TaxiEdge %d, ParkingStand %d, Runway %d\n",
+        (int)sizeof(Airport), (int)sizeof(TaxiNode), (int)sizeof(TaxiEdge), (int)sizeof(ParkingStand), (int)sizeof(Runway));
+
+    const TaxiNetCost taxiNetCost = measureTaxiNetCost();
+    printf("retained: %.0f bytes per taxi node, %.0f bytes per taxi edge\n", taxiNetCost.bytesPerNode, taxiNetCost.bytesPerEdge);
+
+    for (const auto& input : inputs)
+    {
+        if (getFileSize(input.second) < 0)
+        {
+            cerr << "input not found: " << input.second << endl;
+            return 1;
+        }
+        printResult(benchmarkInput(input.first, input.second, iterations), taxiNetCost);
+    }
+
+    printf("peak RSS of the whole process %.2f MB\n", getPeakRssBytes() / (1024.0 * 1024.0));
+    return 0;
+}
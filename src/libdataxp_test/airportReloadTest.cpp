@@ -0,0 +1,229 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libdataxp.h"
+#include "libworld_test.h"
+#include "libdataxp_test.h"
+
+using namespace world;
+using namespace std;
+
+static shared_ptr<World> loadAptDatWorld(shared_ptr<TestHostServices> host, const string& fileName)
+{
+    ifstream input;
+    openTestInputStream(fileName, input);
+    XPAptDatReader reader(host);
+    vector<shared_ptr<Airport>> airports;
+
+    reader.readAptDat(
+        input,
+        WorldBuilder::assembleSampleAirportControlZone,
+        XPAirportReader::noopFilterAirport,
+        [&](shared_ptr<Airport> airport) { airports.push_back(airport); }
+    );
+
+    auto world = WorldBuilder::assembleSampleWorld(host, airports);
+    host->useWorld(world);
+    return world;
+}
+
+static World::ReloadAirportCallback makeReloadFrom(shared_ptr<HostServices> host, const vector<string>& aptDatLines)
+{
+    return [host, aptDatLines](const string& icao, shared_ptr<ControlledAirspace> airspace) {
+        stringstream aptDat = makeAptDat(aptDatLines);
+        XPAptDatReader reader(host);
+        auto structure = reader.readAirportStructure(aptDat, icao);
+        return structure
+            ? WorldBuilder::assembleAirport(host, *structure, airspace)
+            : nullptr;
+    };
+}
+
+static shared_ptr<Flight> makeAIFlight(
+    shared_ptr<HostServices> host,
+    int id,
+    const string& fromIcao,
+    const string& toIcao,
+    Flight::Phase phase,
+    const Altitude& altitude = Altitude::ground())
+{
+    auto plan = make_shared<FlightPlan>(0, 3600, fromIcao, toIcao);
+    auto flight = make_shared<Flight>(host, id, Flight::RulesType::IFR, "DAL", to_string(id), "DAL " + to_string(id), plan);
+    auto aircraft = host->createAIAircraft("B738", "DAL", "T" + to_string(id), Aircraft::Category::Jet);
+    dynamic_pointer_cast<TestHostServices::TestAIAircraft>(aircraft)->setAltitude(altitude);
+    flight->setAircraft(aircraft);
+    flight->setPilot(host->createAIPilot(flight));
+    flight->setPhase(phase);
+    return flight;
+}
+
+static const vector<string> reloadedEfghLines = {
+    "1  600 0 0 EFGH  The Second Airport Reloaded",
+    "1302 country Second Country",
+    "100 31.00 1 1 0.25 1 2 0    17 46.5555 -076.5555 0 1 1 0 0 1    35  46.6666 -076.6666    0 1 1 0 0 1",
+    "1300 -46.12345 -076.12345 46.00 gate turboprops|props B2",
+};
+
+TEST(XPAptDatReaderTest, readAirportStructure)
+{
+    ifstream input;
+    openTestInputStream("apt_many.dat", input);
+    XPAptDatReader reader(makeHost());
+
+    auto structure = reader.readAirportStructure(input, "IJKL");
+
+    ASSERT_TRUE(structure != nullptr);
+    EXPECT_EQ(structure->header.icao(), "IJKL");
+    ASSERT_EQ(structure->parkingStands.size(), 1);
+    EXPECT_EQ(structure->parkingStands[0]->name(), "C1");
+}
+
+TEST(XPAptDatReaderTest, readAirportStructure_notFound)
+{
+    ifstream input;
+    openTestInputStream("apt_many.dat", input);
+    XPAptDatReader reader(makeHost());
+
+    EXPECT_TRUE(reader.readAirportStructure(input, "ZZZZ") == nullptr);
+}
+
+TEST(AirportReloadTest, airportSwappedBeforeNextTick)
+{
+    auto host = TestHostServices::create();
+    auto world = loadAptDatWorld(host, "apt_many.dat");
+    auto oldAirport = world->getAirport("EFGH");
+    auto oldAirspace = oldAirport->tower()->airspace();
+
+    world->reloadAirport("EFGH", makeReloadFrom(host, reloadedEfghLines));
+
+    EXPECT_EQ(world->getAirport("EFGH"), oldAirport);
+    EXPECT_EQ(oldAirspace->airport(), oldAirport);
+    EXPECT_EQ(oldAirspace->controllingFacility(), oldAirport->tower());
+
+    world->progressTo(chrono::seconds(1));
+
+    auto newAirport = world->getAirport("EFGH");
+    ASSERT_NE(newAirport, oldAirport);
+    EXPECT_EQ(newAirport->header().name(), "The Second Airport Reloaded");
+    EXPECT_TRUE(newAirport->tryFindParkingStand("B2") != nullptr);
+    EXPECT_TRUE(newAirport->tryFindParkingStand("B1") == nullptr);
+
+    ASSERT_TRUE(newAirport->tower() != nullptr);
+    EXPECT_EQ(newAirport->tower()->airspace(), oldAirspace);
+    EXPECT_EQ(oldAirspace->airport(), newAirport);
+    EXPECT_EQ(oldAirspace->controllingFacility(), newAirport->tower());
+
+    EXPECT_EQ(world->airports().size(), 4);
+    EXPECT_EQ(world->airspaces().size(), 4);
+    ASSERT_EQ(world->controlFacilities().size(), 4);
+    EXPECT_TRUE(find(world->controlFacilities().begin(), world->controlFacilities().end(), newAirport->tower()) != world->controlFacilities().end());
+    EXPECT_TRUE(find(world->controlFacilities().begin(), world->controlFacilities().end(), oldAirport->tower()) == world->controlFacilities().end());
+
+    auto nearby = world->findAirportsInRadius(newAirport->header().datum(), 5);
+    EXPECT_EQ(nearby.size(), 4);
+    EXPECT_TRUE(find(nearby.begin(), nearby.end(), newAirport) != nearby.end());
+    EXPECT_TRUE(find(nearby.begin(), nearby.end(), oldAirport) == nearby.end());
+}
+
+TEST(AirportReloadTest, activeFlightsRevalidated)
+{
+    auto host = TestHostServices::create();
+    auto world = loadAptDatWorld(host, "apt_many.dat");
+
+    auto departingFromEfgh = makeAIFlight(host, 101, "EFGH", "ABCD", Flight::Phase::Departure);
+    auto arrivingToOldGate = makeAIFlight(host, 102, "ABCD", "EFGH", Flight::Phase::EnRoute, Altitude::msl(10000));
+    arrivingToOldGate->plan()->setArrivalGate("B1");
+    auto arrivingToEfgh = makeAIFlight(host, 103, "ABCD", "EFGH", Flight::Phase::EnRoute, Altitude::msl(10000));
+    auto departingFromAbcd = makeAIFlight(host, 104, "ABCD", "IJKL", Flight::Phase::Departure);
+    auto approachingEfgh = makeAIFlight(host, 105, "ABCD", "EFGH", Flight::Phase::Arrival, Altitude::agl(1500));
+    auto climbingFromEfgh = makeAIFlight(host, 106, "EFGH", "ABCD", Flight::Phase::Departure, Altitude::msl(3000));
+
+    for (const auto& flight : { departingFromEfgh, arrivingToOldGate, arrivingToEfgh, departingFromAbcd, approachingEfgh, climbingFromEfgh })
+    {
+        world->addFlight(flight);
+    }
+    world->takeChanges();
+
+    world->reloadAirport("EFGH", makeReloadFrom(host, reloadedEfghLines));
+    world->progressTo(chrono::seconds(1));
+
+    ASSERT_EQ(world->flights().size(), 4);
+    EXPECT_EQ(world->flights()[0], arrivingToEfgh);
+    EXPECT_EQ(world->flights()[1], departingFromAbcd);
+    EXPECT_EQ(world->flights()[2], approachingEfgh);
+    EXPECT_EQ(world->flights()[3], climbingFromEfgh);
+
+    auto changes = world->takeChanges();
+    EXPECT_EQ(changes->flights().removed().size(), 2);
+    EXPECT_TRUE(changes->configurationChanged());
+}
+
+TEST(AirportReloadTest, scheduledFlightsRevalidated)
+{
+    auto host = TestHostServices::create();
+    auto world = loadAptDatWorld(host, "apt_many.dat");
+
+    auto toOldGate = makeAIFlight(host, 101, "ABCD", "EFGH", Flight::Phase::Arrival, Altitude::agl(1500));
+    toOldGate->plan()->setArrivalGate("B1");
+    auto toNewGate = makeAIFlight(host, 102, "ABCD", "EFGH", Flight::Phase::Arrival, Altitude::agl(1500));
+    toNewGate->plan()->setArrivalGate("B2");
+
+    vector<shared_ptr<Flight>> addedFlights;
+    for (const auto& flight : { toOldGate, toNewGate })
+    {
+        world->scheduleFlight("arrival", flight, world->startTime() + 10, [&addedFlights, flight] {
+            addedFlights.push_back(flight);
+        });
+    }
+
+    world->reloadAirport("EFGH", makeReloadFrom(host, reloadedEfghLines));
+    world->progressTo(chrono::seconds(1));
+    EXPECT_EQ(world->flights().size(), 0);
+
+    world->progressTo(chrono::seconds(11));
+
+    ASSERT_EQ(world->flights().size(), 1);
+    EXPECT_EQ(world->flights()[0], toNewGate);
+    ASSERT_EQ(addedFlights.size(), 1);
+    EXPECT_EQ(addedFlights[0], toNewGate);
+}
+
+TEST(AirportReloadTest, removedFlightDetached)
+{
+    auto host = TestHostServices::create();
+    auto world = loadAptDatWorld(host, "apt_many.dat");
+    auto flight = makeAIFlight(host, 101, "EFGH", "ABCD", Flight::Phase::Departure);
+    world->addFlight(flight);
+    auto frequency = make_shared<Frequency>(host, 121000, world->getAirport("EFGH")->header().datum(), 10);
+    flight->aircraft()->setFrequency(frequency);
+
+    int flightWorkItemCount = 0;
+    int worldWorkItemCount = 0;
+    world->deferBy("flight", chrono::seconds(1), [&] { flightWorkItemCount++; }, flight->id());
+    world->deferBy("world", chrono::seconds(1), [&] { worldWorkItemCount++; });
+    world->takeChanges();
+
+    world->removeFlight(flight);
+    world->progressTo(chrono::seconds(2));
+
+    EXPECT_EQ(flightWorkItemCount, 0);
+    EXPECT_EQ(worldWorkItemCount, 1);
+    EXPECT_TRUE(flight->aircraft()->frequency() == nullptr);
+    EXPECT_EQ(world->takeChanges()->flights().removed().size(), 1);
+}
+
+TEST(AirportReloadTest, unknownAirportThrows)
+{
+    auto host = TestHostServices::create();
+    auto world = loadAptDatWorld(host, "apt_many.dat");
+
+    EXPECT_THROW(world->reloadAirport("ZZZZ", makeReloadFrom(host, reloadedEfghLines)), runtime_error);
+    EXPECT_THROW(world->reloadAirport("IJKL", makeReloadFrom(host, reloadedEfghLines)), runtime_error);
+}
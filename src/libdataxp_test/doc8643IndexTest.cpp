@@ -0,0 +1,104 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libdataxp.h"
+#include "libdataxp_test.h"
+
+using namespace world;
+using namespace std;
+
+static string writeDoc8643Index(const string& text)
+{
+    string indexFilePath = testing::TempDir() + "doc8643IndexTest.idx";
+    stringstream input(text);
+    ofstream output(indexFilePath, ios::binary | ios::trunc);
+    Doc8643Index::convert(input, text.length(), output);
+    return indexFilePath;
+}
+
+TEST(Doc8643IndexTest, convert_tryFind) {
+    string indexFilePath = writeDoc8643Index(
+        "AIRBUS\tA-380-800\tA388\tL4J\tH\n"
+        "AIRBUS\tA-380-800 Prestige\tA388\tL4J\tH\n"
+        "AVIONES COLOMBIA\t172\tC172\tL1P\tL\n"
+        "BELL-BOEING\tCV-22 Osprey\tV22\tT2T\tM\n"
+        "AGUSTAWESTLAND\tChinook\tH47\tH2T\tM\r\n"
+        "(ANY)\tAirship\tSHIP\t-\t-\n"
+        "BAD LINE\n");
+
+    {
+        Doc8643Index index(indexFilePath);
+        AircraftTypeInfo info;
+
+        EXPECT_EQ(index.size(), 5);
+
+        ASSERT_TRUE(index.tryFind("A388", info));
+        EXPECT_EQ(info.aircraftClass, AircraftTypeInfo::AircraftClass::Landplane);
+        EXPECT_EQ(info.engineCount, 4);
+        EXPECT_EQ(info.engineType, AircraftTypeInfo::EngineType::Jet);
+        EXPECT_EQ(info.wakeCategory, AircraftTypeInfo::WakeCategory::Heavy);
+
+        ASSERT_TRUE(index.tryFind("C172", info));
+        EXPECT_EQ(info.engineCount, 1);
+        EXPECT_EQ(info.engineType, AircraftTypeInfo::EngineType::Piston);
+        EXPECT_EQ(info.wakeCategory, AircraftTypeInfo::WakeCategory::Light);
+
+        ASSERT_TRUE(index.tryFind("V22", info));
+        EXPECT_EQ(info.aircraftClass, AircraftTypeInfo::AircraftClass::Tiltrotor);
+
+        ASSERT_TRUE(index.tryFind("H47", info));
+        EXPECT_EQ(info.aircraftClass, AircraftTypeInfo::AircraftClass::Helicopter);
+        EXPECT_EQ(info.wakeCategory, AircraftTypeInfo::WakeCategory::Medium);
+
+        ASSERT_TRUE(index.tryFind("SHIP", info));
+        EXPECT_EQ(info.engineType, AircraftTypeInfo::EngineType::Unknown);
+        EXPECT_EQ(info.wakeCategory, AircraftTypeInfo::WakeCategory::Unknown);
+
+        EXPECT_FALSE(index.tryFind("B738", info));
+        EXPECT_FALSE(index.tryFind("A38", info));
+        EXPECT_FALSE(index.tryFind("", info));
+        EXPECT_FALSE(index.tryFind("A388X", info));
+    }
+
+    remove(indexFilePath.c_str());
+}
+
+TEST(Doc8643IndexTest, openCorruptFile_throws) {
+    string indexFilePath = testing::TempDir() + "doc8643IndexTest_corrupt.idx";
+    {
+        ofstream output(indexFilePath, ios::binary | ios::trunc);
+        output << "this is not an index file, but it is long enough to hold a header";
+    }
+
+    EXPECT_THROW(Doc8643Index index(indexFilePath), runtime_error);
+
+    remove(indexFilePath.c_str());
+}
+
+TEST(Doc8643IndexTest, openOrConvert_assetFile) {
+    string textFilePath = "../../assets/Resources/Doc8643.txt";
+    string indexFilePath = testing::TempDir() + "doc8643IndexTest_asset.idx";
+    remove(indexFilePath.c_str());
+
+    auto converted = Doc8643Index::openOrConvert(textFilePath, indexFilePath);
+    auto reopened = Doc8643Index::openOrConvert(textFilePath, indexFilePath);
+    AircraftTypeInfo info;
+
+    EXPECT_GT(converted->size(), 2000);
+    EXPECT_EQ(reopened->size(), converted->size());
+    ASSERT_TRUE(reopened->tryFind("B738", info));
+    EXPECT_EQ(info.engineCount, 2);
+    EXPECT_EQ(info.engineType, AircraftTypeInfo::EngineType::Jet);
+    EXPECT_EQ(info.wakeCategory, AircraftTypeInfo::WakeCategory::Medium);
+
+    converted.reset();
+    reopened.reset();
+    remove(indexFilePath.c_str());
+}
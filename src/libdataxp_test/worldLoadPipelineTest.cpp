@@ -0,0 +1,163 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libdataxp.h"
+#include "worldLoadPipeline.hpp"
+#include "libworld_test.h"
+#include "libdataxp_test.h"
+
+using namespace world;
+using namespace std;
+
+static shared_ptr<WorldLoadPipeline> makeAptDatPipeline(
+    shared_ptr<HostServices> host,
+    const string& fileName,
+    int assembleThreadCount = 2,
+    size_t queueCapacity = 256)
+{
+    return make_shared<WorldLoadPipeline>(
+        host,
+        [host, fileName](const WorldLoadPipeline::EmitAirportCallback& emit) {
+            ifstream input;
+            openTestInputStream(fileName, input);
+            XPAptDatReader reader(host);
+            reader.readAirportStructures(input, XPAirportReader::noopFilterAirport, emit);
+        },
+        WorldBuilder::assembleSampleAirportControlZone,
+        assembleThreadCount,
+        queueCapacity);
+}
+
+static void drainUntilFinished(WorldLoadPipeline& pipeline, shared_ptr<World> world)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+
+    while (!pipeline.finished() && chrono::steady_clock::now() < deadline)
+    {
+        pipeline.drainInto(world, 1);
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+TEST(XPAptDatReaderTest, readAirportStructures)
+{
+    ifstream input;
+    openTestInputStream("apt_many.dat", input);
+    XPAptDatReader reader(makeHost());
+    vector<shared_ptr<Airport::Structure>> output;
+
+    reader.readAirportStructures(
+        input,
+        XPAirportReader::noopFilterAirport,
+        [&](shared_ptr<Airport::Structure> structure) {
+            output.push_back(structure);
+            return true;
+        }
+    );
+
+    ASSERT_EQ(output.size(), 4);
+    EXPECT_EQ(output[0]->header.icao(), "ABCD");
+    EXPECT_EQ(output[0]->parkingStands.size(), 1);
+    EXPECT_EQ(output[3]->header.icao(), "MNOP");
+
+    auto airport = WorldBuilder::assembleAirport(makeHost(), *output[0]);
+    EXPECT_EQ(airport->getParkingStandOrThrow("A1")->name(), "A1");
+    EXPECT_TRUE(airport->tower() == nullptr);
+}
+
+TEST(XPAptDatReaderTest, readAirportStructures_cancel)
+{
+    ifstream input;
+    openTestInputStream("apt_many.dat", input);
+    XPAptDatReader reader(makeHost());
+    int parsedCount = 0;
+
+    reader.readAirportStructures(
+        input,
+        XPAirportReader::noopFilterAirport,
+        [&](shared_ptr<Airport::Structure> structure) {
+            parsedCount++;
+            return parsedCount < 2;
+        }
+    );
+
+    EXPECT_EQ(parsedCount, 2);
+}
+
+TEST(WorldLoadPipelineTest, allAirportsPassAllStages)
+{
+    auto host = TestHostServices::create();
+    auto world = WorldBuilder::assembleSampleWorld(host, {});
+    auto pipeline = makeAptDatPipeline(host, "apt_many.dat");
+
+    pipeline->start();
+    drainUntilFinished(*pipeline, world);
+
+    ASSERT_TRUE(pipeline->finished());
+    EXPECT_EQ(world->airports().size(), 4);
+    EXPECT_EQ(world->controlFacilities().size(), 4);
+    EXPECT_EQ(world->airspaces().size(), 4);
+
+    for (const auto& icao : { "ABCD", "EFGH", "IJKL", "MNOP" })
+    {
+        auto airport = world->getAirport(icao);
+        ASSERT_TRUE(airport->tower() != nullptr);
+        EXPECT_EQ(airport->tower()->airport(), airport);
+        EXPECT_EQ(airport->tower()->airspace()->airport(), airport);
+    }
+
+    for (auto stage : {
+        WorldLoadPipeline::Stage::Parse,
+        WorldLoadPipeline::Stage::Assemble,
+        WorldLoadPipeline::Stage::Link,
+        WorldLoadPipeline::Stage::Index })
+    {
+        auto progress = pipeline->getProgress(stage);
+        EXPECT_EQ(progress.processed, 4);
+        EXPECT_EQ(progress.failed, 0);
+        EXPECT_TRUE(progress.finished);
+    }
+}
+
+TEST(WorldLoadPipelineTest, airportUsableBeforeLoadFinished)
+{
+    auto host = TestHostServices::create();
+    auto world = WorldBuilder::assembleSampleWorld(host, {});
+    // queues of 2 slots and no draining: upstream stages wait for the index stage
+    auto pipeline = makeAptDatPipeline(host, "apt_many.dat", 1, 2);
+
+    pipeline->start();
+
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+    while (pipeline->drainInto(world, 1) == 0 && chrono::steady_clock::now() < deadline)
+    {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    ASSERT_EQ(world->airports().size(), 1);
+    EXPECT_FALSE(pipeline->finished());
+    EXPECT_TRUE(world->getAirport("ABCD")->tower() != nullptr);
+
+    drainUntilFinished(*pipeline, world);
+    EXPECT_EQ(world->airports().size(), 4);
+}
+
+TEST(WorldLoadPipelineTest, stopWhileStagesAreWaiting)
+{
+    auto host = TestHostServices::create();
+    auto pipeline = makeAptDatPipeline(host, "apt_many.dat", 2, 2);
+
+    pipeline->start();
+    this_thread::sleep_for(chrono::milliseconds(20));
+    pipeline->stop();
+
+    EXPECT_LE(pipeline->getProgress(WorldLoadPipeline::Stage::Link).processed, 4);
+    EXPECT_EQ(pipeline->getProgress(WorldLoadPipeline::Stage::Index).processed, 0);
+}
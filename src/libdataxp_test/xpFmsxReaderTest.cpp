@@ -81,3 +81,86 @@ TEST(XPFmsxReaderTest, readFms_compareDepartureAirportIcao) {
         EXPECT_TRUE(departureAirportIcaoEquals);
     }
 }
+
+static shared_ptr<TestHostServices> makeHostWithAirports(const vector<string>& icaoCodes)
+{
+    auto host = TestHostServices::createWithWorld();
+    for (const string& icao : icaoCodes)
+    {
+        XPAirportReader reader(host);
+        stringstream aptDat = makeAptDat({ "1 10 0 0 " + icao + " Test Airport" });
+        reader.readAirport(aptDat);
+        host->getWorld()->addAirport(reader.getAirport());
+    }
+    return host;
+}
+
+TEST(XPFmsxReaderTest, readFromBuffer_crlfLineEnds) {
+    auto host = TestHostServices::createWithWorld();
+    XPFmsxReader reader(host);
+    string text = "I\r\n1100 Version\r\nADEP KJFK\r\nDEPRWY RW04L\r\n\r\nADES KORD \r\nAPP I09L\r\nNUMENR 0\r\n";
+
+    auto flightPlan = reader.readFrom(text.c_str(), text.length());
+
+    EXPECT_EQ(flightPlan->departureAirportIcao(), "KJFK");
+    EXPECT_EQ(flightPlan->departureRunway(), "04L");
+    EXPECT_EQ(flightPlan->arrivalAirportIcao(), "KORD");
+    EXPECT_EQ(flightPlan->approachName(), "I09L");
+    EXPECT_EQ(flightPlan->arrivalRunway(), "09L");
+}
+
+TEST(XPFmsxReaderTest, readDirectory_allFilesRead) {
+    auto host = makeHostWithAirports({ "KJFK", "KORD", "KMIA", "KFLL" });
+    host->useHostFiles("testInputs", { "kjfk_kord.fms", "kjfk_kord.fmx", "kmia_kfll.fms", "apt_kjfk.dat" });
+    XPFmsxReader reader(host);
+
+    auto result = reader.readDirectory({}, 2);
+
+    EXPECT_EQ(result.fileCount, 3);
+    EXPECT_EQ(result.failedFileCount, 0);
+    EXPECT_EQ(result.duplicateCount, 0);
+    EXPECT_EQ(result.unresolvedCount, 0);
+    ASSERT_EQ(result.flightPlans.size(), 3);
+    EXPECT_EQ(result.flightPlans[0]->sidName(), "DEEZZ5");
+    EXPECT_EQ(result.flightPlans[1]->sidName(), "GREKI6");
+    EXPECT_EQ(result.flightPlans[1]->arrivalAirportIcao(), "KORD");
+    EXPECT_EQ(result.flightPlans[2]->departureAirportIcao(), "KMIA");
+}
+
+TEST(XPFmsxReaderTest, readDirectory_duplicatesRemoved) {
+    auto host = makeHostWithAirports({ "KJFK", "KORD" });
+    host->useHostFiles("testInputs", { "kjfk_kord.fms", "kjfk_kord.fmx", "kjfk_kord.fms", "kjfk_kord.fms" });
+    XPFmsxReader reader(host);
+
+    auto result = reader.readDirectory({});
+
+    EXPECT_EQ(result.fileCount, 4);
+    EXPECT_EQ(result.duplicateCount, 2);
+    ASSERT_EQ(result.flightPlans.size(), 2);
+    EXPECT_EQ(result.flightPlans[0]->sidName(), "DEEZZ5");
+    EXPECT_EQ(result.flightPlans[1]->sidName(), "GREKI6");
+}
+
+TEST(XPFmsxReaderTest, readDirectory_unresolvedAirportsSkipped) {
+    auto host = makeHostWithAirports({ "KJFK", "KORD", "KMIA" });
+    host->useHostFiles("testInputs", { "kmia_kfll.fms", "kjfk_kord.fmx" });
+    XPFmsxReader reader(host);
+
+    auto result = reader.readDirectory({});
+
+    EXPECT_EQ(result.unresolvedCount, 1);
+    ASSERT_EQ(result.flightPlans.size(), 1);
+    EXPECT_EQ(result.flightPlans[0]->departureAirportIcao(), "KJFK");
+}
+
+TEST(XPFmsxReaderTest, readDirectory_failedFilesCounted) {
+    auto host = makeHostWithAirports({ "KJFK", "KORD" });
+    host->useHostFiles("testInputs", { "missing.fms", "kjfk_kord.fmx" });
+    XPFmsxReader reader(host);
+
+    auto result = reader.readDirectory({});
+
+    EXPECT_EQ(result.fileCount, 2);
+    EXPECT_EQ(result.failedFileCount, 1);
+    ASSERT_EQ(result.flightPlans.size(), 1);
+}
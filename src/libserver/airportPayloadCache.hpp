@@ -0,0 +1,230 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/unknown_field_set.h>
+
+#include "libworld.h"
+#include "world.pb.h"
+#include "protocolConverter.hpp"
+#include "airportTileSet.hpp"
+
+using namespace std;
+using namespace world;
+
+namespace server
+{
+    // Airport messages are serialized on the first query of every airport, and the bytes are reused by all
+    // subsequent queries, along with their deflated copy for clients which accept it. The message tree itself
+    // is not kept: only tile sets need it, and they parse it back from the bytes.
+    // An entry belongs to the Airport object it was built from: once the airport is reloaded or unloaded,
+    // the world holds a different object or none, and the entry is rebuilt on the next query,
+    // or evicted when another entry is built.
+    // Tile sets are built on the first tiled query of every airport, and follow the same rule.
+    class AirportPayloadCache
+    {
+    public:
+        struct Entry
+        {
+            weak_ptr<Airport> source;
+            string serialized;
+            // zlib stream of the serialized message
+            string deflated;
+            size_t serializedSize;
+        };
+    private:
+        struct TileSetEntry
+        {
+            weak_ptr<const Entry> source;
+            shared_ptr<const AirportTileSet> tileSet;
+        };
+    private:
+        mutex m_lock;
+        unordered_map<string, shared_ptr<const Entry>> m_entryByIcao;
+        unordered_map<string, TileSetEntry> m_tileSetByIcao;
+    public:
+
+        shared_ptr<const Entry> get(const shared_ptr<Airport>& airport)
+        {
+            const string& icao = airport->header().icao();
+            {
+                lock_guard<mutex> lock(m_lock);
+                auto found = m_entryByIcao.find(icao);
+                if (found != m_entryByIcao.end() && found->second->source.lock() == airport)
+                {
+                    return found->second;
+                }
+            }
+
+            // built outside of the lock, so that queries of other airports don't wait;
+            // two concurrent first queries of the same airport may both build it, which is harmless
+            auto entry = build(airport);
+            {
+                lock_guard<mutex> lock(m_lock);
+                m_entryByIcao[icao] = entry;
+                evictStaleEntries();
+            }
+            return entry;
+        }
+
+        shared_ptr<const AirportTileSet> getTileSet(const shared_ptr<Airport>& airport)
+        {
+            const auto entry = get(airport);
+            const string& icao = airport->header().icao();
+            {
+                lock_guard<mutex> lock(m_lock);
+                auto found = m_tileSetByIcao.find(icao);
+                if (found != m_tileSetByIcao.end() && found->second.source.lock() == entry)
+                {
+                    return found->second.tileSet;
+                }
+            }
+
+            auto tileSet = make_shared<const AirportTileSet>(make_shared<const world_proto::Airport>(parseAirport(*entry)));
+            {
+                lock_guard<mutex> lock(m_lock);
+                m_tileSetByIcao[icao] = { entry, tileSet };
+            }
+            return tileSet;
+        }
+
+        void clear()
+        {
+            lock_guard<mutex> lock(m_lock);
+            m_entryByIcao.clear();
+            m_tileSetByIcao.clear();
+        }
+
+        size_t size()
+        {
+            lock_guard<mutex> lock(m_lock);
+            return m_entryByIcao.size();
+        }
+
+    public:
+
+        // the message tree of an entry, e.g. to build tiles of it
+        static world_proto::Airport parseAirport(const Entry& entry)
+        {
+            world_proto::Airport message;
+            if (!message.ParseFromString(entry.serialized))
+            {
+                throw runtime_error("AirportPayloadCache: failed to parse cached airport");
+            }
+            return message;
+        }
+
+        // A length-delimited field is the same on the wire whether it holds a message or its bytes,
+        // so the cached bytes go into the reply as the airport field, and clients parse them as the airport.
+        // This spares copying and re-serializing the whole message tree on every query.
+        static void setSerializedAirport(world_proto::ServerToClient_ReplyQueryAirport& reply, const Entry& entry)
+        {
+            reply.clear_airport();
+            reply.GetReflection()->MutableUnknownFields(&reply)->AddLengthDelimited(
+                world_proto::ServerToClient_ReplyQueryAirport::kAirportFieldNumber,
+                entry.serialized);
+        }
+
+        static string deflate(const string& data)
+        {
+            string result;
+            {
+                google::protobuf::io::StringOutputStream output(&result);
+                google::protobuf::io::GzipOutputStream::Options options;
+                options.format = google::protobuf::io::GzipOutputStream::ZLIB;
+                options.compression_level = 9;
+                google::protobuf::io::GzipOutputStream deflater(&output, options);
+
+                if (!writeAll(deflater, data) || !deflater.Close())
+                {
+                    throw runtime_error("AirportPayloadCache: deflate failed");
+                }
+            }
+            return result;
+        }
+
+        static string inflate(const string& data)
+        {
+            google::protobuf::io::ArrayInputStream input(data.data(), (int)data.size());
+            google::protobuf::io::GzipInputStream inflater(&input, google::protobuf::io::GzipInputStream::ZLIB);
+
+            string result;
+            const void* chunk;
+            int chunkSize;
+            while (inflater.Next(&chunk, &chunkSize))
+            {
+                result.append(static_cast<const char*>(chunk), chunkSize);
+            }
+            if (inflater.ZlibErrorMessage())
+            {
+                throw runtime_error(string("AirportPayloadCache: inflate failed: ") + inflater.ZlibErrorMessage());
+            }
+            return result;
+        }
+
+    private:
+
+        static shared_ptr<const Entry> build(const shared_ptr<Airport>& airport)
+        {
+            auto entry = make_shared<Entry>();
+            entry->source = airport;
+
+            world_proto::Airport message;
+            ProtocolConverter::toMessage(airport, message);
+            if (!message.SerializeToString(&entry->serialized))
+            {
+                throw runtime_error("AirportPayloadCache: failed to serialize airport " + airport->header().icao());
+            }
+            entry->serializedSize = entry->serialized.size();
+            entry->deflated = deflate(entry->serialized);
+            return entry;
+        }
+
+        // entries of airports which were reloaded or unloaded since; the caller holds the lock
+        void evictStaleEntries()
+        {
+            for (auto it = m_entryByIcao.begin() ; it != m_entryByIcao.end() ; )
+            {
+                it = it->second->source.expired() ? m_entryByIcao.erase(it) : next(it);
+            }
+            for (auto it = m_tileSetByIcao.begin() ; it != m_tileSetByIcao.end() ; )
+            {
+                it = it->second.source.expired() ? m_tileSetByIcao.erase(it) : next(it);
+            }
+        }
+
+        static bool writeAll(google::protobuf::io::ZeroCopyOutputStream& output, const string& data)
+        {
+            size_t offset = 0;
+            while (offset < data.size())
+            {
+                void* buffer;
+                int bufferSize;
+                if (!output.Next(&buffer, &bufferSize))
+                {
+                    return false;
+                }
+                size_t length = min((size_t)bufferSize, data.size() - offset);
+                memcpy(buffer, data.data() + offset, length);
+                offset += length;
+                if (length < (size_t)bufferSize)
+                {
+                    output.BackUp(bufferSize - (int)length);
+                }
+            }
+            return true;
+        }
+    };
+}
@@ -0,0 +1,273 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "libworld.h"
+#include "world.pb.h"
+
+using namespace std;
+
+namespace server
+{
+    // An airport message partitioned into square tiles of taxi nodes and parking stands,
+    // so that a client can draw the part it looks at before the rest of the airport arrives.
+    // The runways and a coarse outline go ahead of the tiles, in ReplyQueryAirportTiles.
+    class AirportTileSet
+    {
+    public:
+        struct Tile
+        {
+            int row;
+            int column;
+            world::GeoPoint center;
+            vector<int> taxiNodeIndexes;
+            vector<int> parkingStandIndexes;
+            // edges which have at least one node in the tile
+            vector<int> taxiEdgeIndexes;
+        };
+        static constexpr float defaultTileSizeMeters = 300;
+    private:
+        shared_ptr<const world_proto::Airport> m_airport;
+        float m_tileSizeMeters;
+        double m_tileLatitudeSpan;
+        double m_tileLongitudeSpan;
+        world::GeoPoint m_origin;
+        vector<Tile> m_tiles;
+        vector<world::GeoPoint> m_outline;
+    public:
+        AirportTileSet(shared_ptr<const world_proto::Airport> _airport, float _tileSizeMeters = defaultTileSizeMeters) :
+            m_airport(_airport),
+            m_tileSizeMeters(_tileSizeMeters),
+            m_origin(_airport->location().lat(), _airport->location().lon())
+        {
+            m_tileLatitudeSpan = m_tileSizeMeters / metersPerDegreeLatitude;
+            m_tileLongitudeSpan = m_tileLatitudeSpan / max(cos(m_origin.latitude * world::GeoMath::pi() / 180.0), 0.01);
+            buildTiles();
+            buildOutline();
+        }
+    public:
+        const vector<Tile>& tiles() const { return m_tiles; }
+        const vector<world::GeoPoint>& outline() const { return m_outline; }
+        float tileSizeMeters() const { return m_tileSizeMeters; }
+        const world::GeoPoint& datum() const { return m_origin; }
+
+        void fillHeader(world_proto::ServerToClient_ReplyQueryAirportTiles& reply) const
+        {
+            reply.set_icao(m_airport->icao());
+            *reply.mutable_location() = m_airport->location();
+            *reply.mutable_runways() = m_airport->runways();
+            for (const auto& point : m_outline)
+            {
+                auto message = reply.add_outline();
+                message->set_lat(point.latitude);
+                message->set_lon(point.longitude);
+            }
+            reply.set_tile_count((int)m_tiles.size());
+            reply.set_tile_size_meters(m_tileSizeMeters);
+        }
+
+        // tiles inside the viewport first, then the rest; each group from the center of the viewport outwards
+        vector<int> getTileOrder(double south, double north, double west, double east) const
+        {
+            world::GeoPoint focus((south + north) / 2, (west + east) / 2);
+            vector<pair<double, int>> keys;
+
+            for (int i = 0 ; i < (int)m_tiles.size() ; i++)
+            {
+                const Tile& tile = m_tiles[i];
+                double halfLatitude = m_tileLatitudeSpan / 2;
+                double halfLongitude = m_tileLongitudeSpan / 2;
+                bool isInViewport =
+                    tile.center.latitude + halfLatitude >= south && tile.center.latitude - halfLatitude <= north &&
+                    tile.center.longitude + halfLongitude >= west && tile.center.longitude - halfLongitude <= east;
+
+                // no need for real distances here, only for their order
+                double dy = (tile.center.latitude - focus.latitude) / m_tileLatitudeSpan;
+                double dx = (tile.center.longitude - focus.longitude) / m_tileLongitudeSpan;
+                double key = dx * dx + dy * dy + (isInViewport ? 0 : 1e12);
+                keys.push_back({ key, i });
+            }
+
+            sort(keys.begin(), keys.end());
+
+            vector<int> order;
+            for (const auto& key : keys)
+            {
+                order.push_back(key.second);
+            }
+            return order;
+        }
+
+        // an edge goes with the first tile after which both of its nodes were sent,
+        // so that the client never gets an edge whose nodes it doesn't know yet
+        void forEachTile(const vector<int>& order, const function<void(world_proto::ServerToClient_NotifyAirportTile& tile)>& callback) const
+        {
+            unordered_set<int> sentNodeIds;
+            unordered_set<int> sentEdgeIndexes;
+
+            for (int sequence = 0 ; sequence < (int)order.size() ; sequence++)
+            {
+                const Tile& tile = m_tiles[order[sequence]];
+                world_proto::ServerToClient_NotifyAirportTile message;
+                message.set_icao(m_airport->icao());
+                message.set_sequence(sequence);
+                message.set_row(tile.row);
+                message.set_column(tile.column);
+
+                for (int index : tile.taxiNodeIndexes)
+                {
+                    *message.add_taxi_nodes() = m_airport->taxi_nodes(index);
+                    sentNodeIds.insert(m_airport->taxi_nodes(index).id());
+                }
+                for (int index : tile.parkingStandIndexes)
+                {
+                    *message.add_parking_stands() = m_airport->parking_stands(index);
+                }
+                for (int index : tile.taxiEdgeIndexes)
+                {
+                    const auto& edge = m_airport->taxi_edges(index);
+                    if (sentEdgeIndexes.count(index) == 0 &&
+                        sentNodeIds.count(edge.node_id_1()) > 0 &&
+                        sentNodeIds.count(edge.node_id_2()) > 0)
+                    {
+                        *message.add_taxi_edges() = edge;
+                        sentEdgeIndexes.insert(index);
+                    }
+                }
+
+                callback(message);
+            }
+        }
+
+    private:
+
+        static constexpr double metersPerDegreeLatitude = 111320.0;
+
+        void buildTiles()
+        {
+            unordered_map<int64_t, int> tileIndexByKey;
+            unordered_map<int, int> tileIndexByNodeId;
+
+            const auto getTile = [&](const world_proto::GeoPoint& location) -> Tile& {
+                int row = (int)floor((location.lat() - m_origin.latitude) / m_tileLatitudeSpan + 0.5);
+                int column = (int)floor((location.lon() - m_origin.longitude) / m_tileLongitudeSpan + 0.5);
+                int64_t key = ((int64_t)row << 32) | (uint32_t)column;
+
+                auto found = tileIndexByKey.find(key);
+                if (found != tileIndexByKey.end())
+                {
+                    return m_tiles[found->second];
+                }
+
+                tileIndexByKey[key] = (int)m_tiles.size();
+                m_tiles.push_back({
+                    row,
+                    column,
+                    world::GeoPoint(m_origin.latitude + row * m_tileLatitudeSpan, m_origin.longitude + column * m_tileLongitudeSpan)
+                });
+                return m_tiles.back();
+            };
+
+            for (int i = 0 ; i < m_airport->taxi_nodes_size() ; i++)
+            {
+                Tile& tile = getTile(m_airport->taxi_nodes(i).location());
+                tile.taxiNodeIndexes.push_back(i);
+                tileIndexByNodeId[m_airport->taxi_nodes(i).id()] = (int)(&tile - m_tiles.data());
+            }
+
+            for (int i = 0 ; i < m_airport->parking_stands_size() ; i++)
+            {
+                getTile(m_airport->parking_stands(i).location()).parkingStandIndexes.push_back(i);
+            }
+
+            for (int i = 0 ; i < m_airport->taxi_edges_size() ; i++)
+            {
+                const auto& edge = m_airport->taxi_edges(i);
+                auto tile1 = tileIndexByNodeId.find(edge.node_id_1());
+                auto tile2 = tileIndexByNodeId.find(edge.node_id_2());
+                if (tile1 == tileIndexByNodeId.end() || tile2 == tileIndexByNodeId.end())
+                {
+                    continue;
+                }
+                m_tiles[tile1->second].taxiEdgeIndexes.push_back(i);
+                if (tile2->second != tile1->second)
+                {
+                    m_tiles[tile2->second].taxiEdgeIndexes.push_back(i);
+                }
+            }
+        }
+
+        // convex hull of everything on the airport (monotone chain)
+        void buildOutline()
+        {
+            vector<world::GeoPoint> points;
+            const auto addPoint = [&points](const world_proto::GeoPoint& point) {
+                points.push_back(world::GeoPoint(point.lat(), point.lon()));
+            };
+
+            for (const auto& node : m_airport->taxi_nodes())
+            {
+                addPoint(node.location());
+            }
+            for (const auto& stand : m_airport->parking_stands())
+            {
+                addPoint(stand.location());
+            }
+            for (const auto& runway : m_airport->runways())
+            {
+                addPoint(runway.end_1().centerline_point());
+                addPoint(runway.end_2().centerline_point());
+            }
+
+            sort(points.begin(), points.end(), [](const world::GeoPoint& left, const world::GeoPoint& right) {
+                return left.longitude < right.longitude || (left.longitude == right.longitude && left.latitude < right.latitude);
+            });
+            points.erase(unique(points.begin(), points.end(), [](const world::GeoPoint& left, const world::GeoPoint& right) {
+                return left.longitude == right.longitude && left.latitude == right.latitude;
+            }), points.end());
+
+            if (points.size() < 3)
+            {
+                m_outline = points;
+                return;
+            }
+
+            const auto cross = [](const world::GeoPoint& o, const world::GeoPoint& a, const world::GeoPoint& b) {
+                return (a.longitude - o.longitude) * (b.latitude - o.latitude) - (a.latitude - o.latitude) * (b.longitude - o.longitude);
+            };
+
+            vector<world::GeoPoint> hull(2 * points.size(), world::GeoPoint(0, 0));
+            size_t count = 0;
+            for (size_t i = 0 ; i < points.size() ; i++)
+            {
+                while (count >= 2 && cross(hull[count - 2], hull[count - 1], points[i]) <= 0)
+                {
+                    count--;
+                }
+                hull[count++] = points[i];
+            }
+            for (size_t i = points.size() - 1, lowerCount = count + 1 ; i > 0 ; i--)
+            {
+                while (count >= lowerCount && cross(hull[count - 2], hull[count - 1], points[i - 1]) <= 0)
+                {
+                    count--;
+                }
+                hull[count++] = points[i - 1];
+            }
+
+            // the last point repeats the first one
+            hull.resize(count - 1);
+            m_outline = hull;
+        }
+    };
+}
@@ -0,0 +1,240 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "libworld.h"
+
+using namespace std;
+using namespace world;
+
+namespace server
+{
+    // The region a client follows: a lat/lon box, an optional altitude band, and update intervals
+    // which grow with the distance from the center of the box.
+    class AreaOfInterest
+    {
+    public:
+        struct RateTier
+        {
+            float maxDistanceNm;
+            chrono::milliseconds updateInterval;
+        };
+    private:
+        double m_south;
+        double m_north;
+        double m_west;
+        double m_east;
+        bool m_hasAltitudeBand;
+        float m_minAltitudeFeet;
+        float m_maxAltitudeFeet;
+        vector<RateTier> m_rateTiers;
+        GeoPoint m_center;
+    public:
+        // the box crosses the antimeridian if west is greater than east
+        AreaOfInterest(
+            double _south,
+            double _north,
+            double _west,
+            double _east,
+            vector<RateTier> _rateTiers = vector<RateTier>()
+        ) : m_south(_south),
+            m_north(_north),
+            m_west(_west),
+            m_east(_east),
+            m_hasAltitudeBand(false),
+            m_minAltitudeFeet(0),
+            m_maxAltitudeFeet(0),
+            m_rateTiers(std::move(_rateTiers)),
+            m_center(0, 0)
+        {
+            if (m_south > m_north || m_south < -90 || m_north > 90 || abs(m_west) > 180 || abs(m_east) > 180)
+            {
+                throw runtime_error("AreaOfInterest: invalid box");
+            }
+
+            sort(m_rateTiers.begin(), m_rateTiers.end(), [](const RateTier& left, const RateTier& right) {
+                return left.maxDistanceNm < right.maxDistanceNm;
+            });
+
+            double centerLongitude = m_west + longitudeSpan() / 2;
+            m_center = GeoPoint((m_south + m_north) / 2, centerLongitude > 180 ? centerLongitude - 360 : centerLongitude);
+        }
+    public:
+        double south() const { return m_south; }
+        double north() const { return m_north; }
+        double west() const { return m_west; }
+        double east() const { return m_east; }
+        const GeoPoint& center() const { return m_center; }
+        bool crossesAntimeridian() const { return m_west > m_east; }
+        double longitudeSpan() const { return crossesAntimeridian() ? m_east + 360 - m_west : m_east - m_west; }
+        const vector<RateTier>& rateTiers() const { return m_rateTiers; }
+
+        void setAltitudeBand(float minFeet, float maxFeet)
+        {
+            if (minFeet > maxFeet)
+            {
+                throw runtime_error("AreaOfInterest: invalid altitude band");
+            }
+            m_hasAltitudeBand = true;
+            m_minAltitudeFeet = minFeet;
+            m_maxAltitudeFeet = maxFeet;
+        }
+
+        bool contains(const GeoPoint& location, const Altitude& altitude) const
+        {
+            if (location.latitude < m_south || location.latitude > m_north)
+            {
+                return false;
+            }
+
+            bool isInLongitude = crossesAntimeridian()
+                ? (location.longitude >= m_west || location.longitude <= m_east)
+                : (location.longitude >= m_west && location.longitude <= m_east);
+            if (!isInLongitude)
+            {
+                return false;
+            }
+
+            return !m_hasAltitudeBand || (altitude.feet() >= m_minAltitudeFeet && altitude.feet() <= m_maxAltitudeFeet);
+        }
+
+        // how often an aircraft at this location should be updated; zero means every frame
+        chrono::milliseconds getUpdateInterval(const GeoPoint& location) const
+        {
+            if (m_rateTiers.empty())
+            {
+                return chrono::milliseconds(0);
+            }
+
+            float distanceNm = GeoMath::getDistanceMeters(m_center, location) / METERS_IN_1_NAUTICAL_MILE;
+            for (const auto& tier : m_rateTiers)
+            {
+                if (distanceNm <= tier.maxDistanceNm)
+                {
+                    return tier.updateInterval;
+                }
+            }
+
+            // farther than the outermost tier, e.g. in the corners of the box
+            return m_rateTiers.back().updateInterval;
+        }
+    };
+
+    // Aircraft bucketed by 1x1 degree cells, the same way World buckets airports,
+    // so that an area of interest only looks at the aircraft in the cells it overlaps.
+    class AircraftGridIndex
+    {
+    private:
+        unordered_map<int, vector<shared_ptr<Flight>>> m_flightsByCell;
+        unordered_map<int, int> m_cellByFlightId;
+    public:
+
+        void update(const shared_ptr<Flight>& flight)
+        {
+            const auto aircraft = flight->aircraft();
+            if (!aircraft)
+            {
+                return;
+            }
+
+            const auto& location = aircraft->location();
+            int cell = getCell((int)floor(location.latitude), (int)floor(location.longitude));
+
+            auto existing = m_cellByFlightId.find(flight->id());
+            if (existing != m_cellByFlightId.end())
+            {
+                if (existing->second == cell)
+                {
+                    return;
+                }
+                eraseFromCell(existing->second, flight->id());
+            }
+
+            m_flightsByCell[cell].push_back(flight);
+            m_cellByFlightId[flight->id()] = cell;
+        }
+
+        void remove(int flightId)
+        {
+            auto existing = m_cellByFlightId.find(flightId);
+            if (existing != m_cellByFlightId.end())
+            {
+                eraseFromCell(existing->second, flightId);
+                m_cellByFlightId.erase(existing);
+            }
+        }
+
+        void clear()
+        {
+            m_flightsByCell.clear();
+            m_cellByFlightId.clear();
+        }
+
+        size_t size() const
+        {
+            return m_cellByFlightId.size();
+        }
+
+        // invokes the callback for every flight whose aircraft is inside the area
+        void query(const AreaOfInterest& area, const function<void(const shared_ptr<Flight>& flight)>& callback) const
+        {
+            int southIndex = (int)floor(area.south());
+            int northIndex = min((int)floor(area.north()), 89);
+            int westIndex = (int)floor(area.west());
+            int cellCountLongitude = min((int)floor(area.west() + area.longitudeSpan()) - westIndex + 1, 360);
+
+            for (int latitudeIndex = southIndex ; latitudeIndex <= northIndex ; latitudeIndex++)
+            {
+                for (int i = 0 ; i < cellCountLongitude ; i++)
+                {
+                    auto found = m_flightsByCell.find(getCell(latitudeIndex, westIndex + i));
+                    if (found == m_flightsByCell.end())
+                    {
+                        continue;
+                    }
+                    for (const auto& flight : found->second)
+                    {
+                        const auto aircraft = flight->aircraft();
+                        if (aircraft && area.contains(aircraft->location(), aircraft->altitude()))
+                        {
+                            callback(flight);
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+
+        void eraseFromCell(int cell, int flightId)
+        {
+            auto& flights = m_flightsByCell[cell];
+            flights.erase(
+                remove_if(flights.begin(), flights.end(), [flightId](const shared_ptr<Flight>& flight) {
+                    return flight->id() == flightId;
+                }),
+                flights.end());
+            if (flights.empty())
+            {
+                m_flightsByCell.erase(cell);
+            }
+        }
+
+        static int getCell(int latitudeIndex, int longitudeIndex)
+        {
+            // longitude wraps around the antimeridian; the north pole belongs to the northernmost row
+            int wrappedLongitudeIndex = ((longitudeIndex + 180) % 360 + 360) % 360;
+            return (min(latitudeIndex, 89) + 90) * 360 + wrappedLongitudeIndex;
+        }
+    };
+}
@@ -11,26 +11,31 @@
 #include "blockingconcurrentqueue.h"
 #include "stlhelpers.h"
 #include "libworld.h"
+#include "asyncLog.hpp"
 #include "world.pb.h"
 #include "interfaces.hpp"
+#include "protocolConverter.hpp"
 
 using namespace std;
 using namespace world;
 
 namespace server
 {
+    // Requests are spread over the service threads by client, so that requests of one client
+    // are handled, and replied to, in the order they were received, while other clients are served in parallel.
     class Dispatcher : public DispatcherInterface
     {
     private:
 
         shared_ptr<HostServices> m_host;
         shared_ptr<DispatcherMiddlewareInterface> m_middleware;
-        ReplyCallback m_broadcastToClients;
+        BroadcastCallback m_broadcastToClients;
+        int m_serviceThreadCount;
         int m_senderThreadCount;
         RequestHandler m_noopRequestHandler;
-        shared_ptr<thread> m_serviceThread;
+        vector<shared_ptr<thread>> m_serviceThreads;
         vector<shared_ptr<thread>> m_senderThreads;
-        moodycamel::BlockingConcurrentQueue<WorkItem> m_serviceQueue;
+        vector<unique_ptr<moodycamel::BlockingConcurrentQueue<WorkItem>>> m_serviceQueues;
         moodycamel::BlockingConcurrentQueue<WorkItem> m_senderQueue;
         atomic<bool> m_stopRequested;
 
@@ -38,18 +43,28 @@ namespace server
         Dispatcher(
             shared_ptr<HostServices> _host,
             shared_ptr<DispatcherMiddlewareInterface> _middleware,
+            int _serviceThreadCount,
             int _senderThreadCount
         ) : m_host(_host),
             m_middleware(_middleware),
+            m_serviceThreadCount(max(1, _serviceThreadCount)),
             m_senderThreadCount(_senderThreadCount),
-            m_noopRequestHandler([](const world_proto::ClientToServer& envelope, ReplyCallback reply) {}),
+            m_noopRequestHandler([](const world_proto::ClientToServer& envelope, const shared_ptr<ClientConnection>& client, ReplyCallback reply) {}),
             m_stopRequested(false)
         {
             m_host->writeLog("SRVDSP|INIT starting");
 
-            m_serviceThread = shared_ptr<thread>(new thread([this](){
-                runConsumerThread("service", 0, m_serviceQueue);
-            }));
+            for (int i = 0 ; i < m_serviceThreadCount ; i++)
+            {
+                m_serviceQueues.push_back(unique_ptr<moodycamel::BlockingConcurrentQueue<WorkItem>>(
+                    new moodycamel::BlockingConcurrentQueue<WorkItem>()));
+            }
+            for (int i = 0 ; i < m_serviceThreadCount ; i++)
+            {
+                m_serviceThreads.push_back(shared_ptr<thread>(new thread([=](){
+                    runConsumerThread("service", i, *m_serviceQueues[i]);
+                })));
+            }
 
             for (int i = 0 ; i < m_senderThreadCount ; i++)
             {
@@ -72,7 +87,7 @@ namespace server
 
     public:
 
-        void setBroadcastInterface(DispatcherInterface::ReplyCallback broadcastInterface) override
+        void setBroadcastInterface(DispatcherInterface::BroadcastCallback broadcastInterface) override
         {
             m_broadcastToClients = broadcastInterface;
         }
@@ -84,63 +99,89 @@ namespace server
                 throw runtime_error("Dispatcher::enqueueBroadcast() : broadcast interface was not set");
             }
 
-            m_host->writeLog(
-                "SRVDSP|SEND enqueuing broadcast envelope id[%d] payload[%d]",
-                envelope.id(),
-                envelope.payload_case());
+            // serialized once here, rather than once per connection; all connections share the same buffer
+            shared_ptr<const OutboundMessage> message = OutboundMessage::serialize(envelope);
 
-            m_senderQueue.enqueue([=]() {
-                m_host->writeLog(
-                    "SRVDSP|SEND dequeued broadcast envelope id[%d] payload[%d]",
-                    envelope.id(),
-                    envelope.payload_case());
-                m_broadcastToClients(envelope);
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
+                "SRVDSP|SEND enqueuing broadcast envelope id[%d] payload[%d] size[%llu]",
+                envelope.id(),
+                envelope.payload_case(),
+                message->dataOnWire().size());
+
+            m_senderQueue.enqueue([this, message]() {
+                ATC_LOG_DEBUG(
+                    AsyncLog::Category::Server,
+                    "SRVDSP|SEND dequeued broadcast payload[%d]",
+                    message->payloadCase());
+                m_broadcastToClients(message);
             });
         }
 
-        void enqueueOutbound(const world_proto::ServerToClient& envelope, ReplyCallback replyToSender) //override
+        void enqueueOutbound(world_proto::ServerToClient envelope, ReplyCallback replyToSender) //override
         {
-            m_host->writeLog(
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
                 "SRVDSP|SEND enqueueing envelope id[%d] payload[%d]",
                 envelope.id(),
                 envelope.payload_case());
 
-            m_senderQueue.enqueue([=]() {
-                m_host->writeLog(
+            m_senderQueue.enqueue([envelope = std::move(envelope), replyToSender]() mutable {
+                ATC_LOG_DEBUG(
+                    AsyncLog::Category::Server,
                     "SRVDSP|SEND dequeued envelope id[%d] payload[%d]",
                     envelope.id(),
                     envelope.payload_case());
+                ProtocolConverter::toMessage(chrono::system_clock::now(), *envelope.mutable_sent_at());
                 replyToSender(envelope);
             });
         }
 
-        void enqueueInbound(const world_proto::ClientToServer& envelope, ReplyCallback replyToSender) override
+        void enqueueInbound(
+            const world_proto::ClientToServer& envelope,
+            shared_ptr<ClientConnection> client,
+            ReplyCallback replyToSender) override
         {
+            const auto receivedAt = chrono::system_clock::now();
             bool handlerFound = false;
             const RequestHandler& handler = m_middleware->tryGetHandler(envelope, handlerFound);
 
             if (!handlerFound)
             {
-                m_host->writeLog(
+                ATC_LOG_ERROR(
+                    AsyncLog::Category::Server,
                     "SRVDSP|RECV envelope id[%d] payload[%d] ERROR: no handler found",
                     envelope.id(),
                     envelope.payload_case());
                 return;
             }
 
-            m_host->writeLog(
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
                 "SRVDSP|RECV envelope id[%d] payload[%d] enqueue",
                 envelope.id(),
                 envelope.payload_case());
 
-            m_serviceQueue.enqueue([this, envelope, replyToSender, &handler](){
-                m_host->writeLog(
+            auto& serviceQueue = *m_serviceQueues[client ? client->id() % m_serviceThreadCount : 0];
+            serviceQueue.enqueue([this, envelope, client, replyToSender, receivedAt, &handler](){
+                ATC_LOG_DEBUG(
+                    AsyncLog::Category::Server,
                     "SRVDSP|RECV envelope id[%d] payload[%d] dequeued",
                     envelope.id(),
                     envelope.payload_case());
 
-                handler(envelope, [this, replyToSender](const world_proto::ServerToClient &envelope){
-                    enqueueOutbound(envelope, replyToSender);
+                const auto requestId = envelope.id();
+                const auto requestSentAt = envelope.sent_at();
+                handler(envelope, client, [this, replyToSender, requestId, requestSentAt, receivedAt](const world_proto::ServerToClient &reply){
+                    world_proto::ServerToClient stampedReply(reply);
+                    // world change frames of a subscription are not replies to the subscribe request
+                    if (stampedReply.payload_case() != world_proto::ServerToClient::kNotifyWorldChanges)
+                    {
+                        stampedReply.set_reply_to_request_id(requestId);
+                        *stampedReply.mutable_request_sent_at() = requestSentAt;
+                        ProtocolConverter::toMessage(receivedAt, *stampedReply.mutable_request_received_at());
+                    }
+                    enqueueOutbound(std::move(stampedReply), replyToSender);
                 });
             });
         }
@@ -154,9 +195,12 @@ namespace server
         {
             m_stopRequested = true;
 
-            if (m_serviceThread->joinable())
+            for (const auto& serviceThread : m_serviceThreads)
             {
-                m_serviceThread->join();
+                if (serviceThread->joinable())
+                {
+                    serviceThread->join();
+                }
             }
 
             for (const auto& senderThread : m_senderThreads)
@@ -213,7 +257,10 @@ namespace server
 
     private:
 
-        static void noopRequestHandler(const world_proto::ClientToServer& envelope, ReplyCallback reply)
+        static void noopRequestHandler(
+            const world_proto::ClientToServer& envelope,
+            const shared_ptr<ClientConnection>& client,
+            ReplyCallback reply)
         {
         }
     };
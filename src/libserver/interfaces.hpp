@@ -2,14 +2,36 @@
 
 #include <memory>
 #include <functional>
+#include <atomic>
 
 #include "libworld.h"
 #include "world.pb.h"
+#include "outboundMessage.hpp"
 
 using namespace std;
 
 namespace server
 {
+    // A connected client, as seen by the services. The server holds it while the connection is open,
+    // so a weak_ptr to it tells whether the client is still there.
+    class ClientConnection
+    {
+    private:
+        const uint64_t m_id;
+        atomic<bool> m_hasSubscription;
+    public:
+        explicit ClientConnection(uint64_t _id) :
+            m_id(_id),
+            m_hasSubscription(false)
+        {
+        }
+    public:
+        uint64_t id() const { return m_id; }
+        // the client receives world changes through its own subscription rather than the broadcasts
+        bool hasSubscription() const { return m_hasSubscription; }
+        void setHasSubscription(bool value) { m_hasSubscription = value; }
+    };
+
     class DispatcherInterface
     {
     public:
@@ -19,16 +41,23 @@ namespace server
         )> ReplyCallback;
         typedef function<void(
             const world_proto::ClientToServer &request,
+            const shared_ptr<ClientConnection>& client,
             ReplyCallback replyToSender
         )> RequestHandler;
+        typedef function<void(
+            const shared_ptr<const OutboundMessage>& message
+        )> BroadcastCallback;
     protected:
         DispatcherInterface() = default;
     public:
         virtual ~DispatcherInterface() = default;
-        virtual void setBroadcastInterface(DispatcherInterface::ReplyCallback broadcastInterface) = 0;
+        virtual void setBroadcastInterface(DispatcherInterface::BroadcastCallback broadcastInterface) = 0;
         // virtual void enqueueBroadcast(const world_proto::ServerToClient& envelope) = 0;
         // virtual void enqueueOutbound(const world_proto::ServerToClient& envelope, ReplyCallback replyToSender) = 0;
-        virtual void enqueueInbound(const world_proto::ClientToServer &envelope, ReplyCallback replyToSender) = 0;
+        virtual void enqueueInbound(
+            const world_proto::ClientToServer &envelope,
+            shared_ptr<ClientConnection> client,
+            ReplyCallback replyToSender) = 0;
         virtual void beginStop() = 0;
         virtual void stopNow() = 0;
     };
@@ -65,6 +94,22 @@ namespace server
         virtual void queryTaxiPath(
             const world_proto::ClientToServer_QueryTaxiPath &request,
             world_proto::ServerToClient &replyEnvelope) = 0;
+
+        virtual void queryTaxiPaths(
+            const world_proto::ClientToServer_QueryTaxiPaths &request,
+            world_proto::ServerToClient &replyEnvelope) = 0;
+
+        // replies more than once: the header, and then every tile
+        virtual void queryAirportTiles(
+            const world_proto::ClientToServer_QueryAirportTiles &request,
+            DispatcherInterface::ReplyCallback replyToSender) = 0;
+
+        // notifyClient delivers the world change frames of the subscription
+        virtual void subscribeWorldChanges(
+            const world_proto::ClientToServer_SubscribeWorldChanges &request,
+            const shared_ptr<ClientConnection>& client,
+            DispatcherInterface::ReplyCallback notifyClient,
+            world_proto::ServerToClient &replyEnvelope) = 0;
     };
 
     class ServerInterface
@@ -22,6 +22,8 @@ namespace server
         virtual void start(int listenPort = 9002) = 0;
         virtual void beginStop() = 0;
         virtual bool waitUntilStopped(chrono::milliseconds timeout) = 0;
+        // called by the sim thread after every tick, with the changes taken from the world (null if there were none)
+        virtual void publishWorldChanges(shared_ptr<World::ChangeSet> changeSet) = 0;
     public:
         static shared_ptr<ServerControllerInterface> create(shared_ptr<HostServices> host);
     };
@@ -0,0 +1,145 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdexcept>
+
+#include "world.pb.h"
+
+using namespace std;
+
+namespace server
+{
+    // A ServerToClient envelope serialized once, and shared as is by every connection it is sent to.
+    class OutboundMessage
+    {
+    private:
+        const string m_dataOnWire;
+        const world_proto::ServerToClient::PayloadCase m_payloadCase;
+        const bool m_isDroppable;
+        const bool m_isResyncPoint;
+    public:
+        OutboundMessage(
+            string _dataOnWire,
+            world_proto::ServerToClient::PayloadCase _payloadCase,
+            bool _isDroppable,
+            bool _isResyncPoint
+        ) : m_dataOnWire(std::move(_dataOnWire)),
+            m_payloadCase(_payloadCase),
+            m_isDroppable(_isDroppable),
+            m_isResyncPoint(_isResyncPoint)
+        {
+        }
+    public:
+        const string& dataOnWire() const { return m_dataOnWire; }
+        world_proto::ServerToClient::PayloadCase payloadCase() const { return m_payloadCase; }
+        // a connection which lags behind may skip this message
+        bool isDroppable() const { return m_isDroppable; }
+        // a connection which skipped messages is back in sync once it receives this message
+        bool isResyncPoint() const { return m_isResyncPoint; }
+    public:
+        static shared_ptr<const OutboundMessage> serialize(const world_proto::ServerToClient& envelope)
+        {
+            string dataOnWire;
+            if (!envelope.SerializeToString(&dataOnWire))
+            {
+                throw runtime_error(
+                    "OutboundMessage::serialize() : payload case [" + to_string(envelope.payload_case()) + "] failed");
+            }
+
+            // world change frames are superseded by the next keyframe, everything else must be delivered
+            bool isWorldChanges = (envelope.payload_case() == world_proto::ServerToClient::kNotifyWorldChanges);
+            bool isKeyframe = isWorldChanges && envelope.notify_world_changes().is_keyframe();
+
+            return make_shared<OutboundMessage>(std::move(dataOnWire), envelope.payload_case(), isWorldChanges, isKeyframe);
+        }
+    };
+
+    // Keeps a slow connection from buffering broadcasts without bound. Once the data the connection
+    // has yet to send exceeds the limit, droppable messages are skipped, and since the skipped frames
+    // were deltas, all messages up to the next resync point are skipped as well. The resync is requested
+    // only after the connection has drained its buffer, so that the keyframe isn't dropped, too.
+    class ConnectionBackpressure
+    {
+    public:
+        enum class Decision
+        {
+            Send,
+            Drop,
+            DropAndRequestResync
+        };
+    private:
+        const size_t m_maxBufferedBytes;
+        mutex m_lock;
+        bool m_isOutOfSync;
+        bool m_isResyncRequested;
+        uint64_t m_droppedCount;
+    public:
+        explicit ConnectionBackpressure(size_t _maxBufferedBytes) :
+            m_maxBufferedBytes(_maxBufferedBytes),
+            m_isOutOfSync(false),
+            m_isResyncRequested(false),
+            m_droppedCount(0)
+        {
+        }
+    public:
+        Decision admit(const OutboundMessage& message, size_t bufferedBytes)
+        {
+            if (!message.isDroppable())
+            {
+                return Decision::Send;
+            }
+
+            lock_guard<mutex> lock(m_lock);
+            bool isCongested = (bufferedBytes + message.dataOnWire().size() > m_maxBufferedBytes);
+
+            if (isCongested)
+            {
+                if (!m_isOutOfSync || message.isResyncPoint())
+                {
+                    m_isResyncRequested = false;
+                }
+                m_isOutOfSync = true;
+                m_droppedCount++;
+                return Decision::Drop;
+            }
+
+            if (message.isResyncPoint())
+            {
+                m_isOutOfSync = false;
+                return Decision::Send;
+            }
+
+            if (!m_isOutOfSync)
+            {
+                return Decision::Send;
+            }
+
+            m_droppedCount++;
+            if (m_isResyncRequested)
+            {
+                return Decision::Drop;
+            }
+
+            m_isResyncRequested = true;
+            return Decision::DropAndRequestResync;
+        }
+
+        bool isOutOfSync()
+        {
+            lock_guard<mutex> lock(m_lock);
+            return m_isOutOfSync;
+        }
+
+        uint64_t droppedCount()
+        {
+            lock_guard<mutex> lock(m_lock);
+            return m_droppedCount;
+        }
+    };
+}
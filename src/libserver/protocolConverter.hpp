@@ -1,7 +1,11 @@
+#pragma once
+
 #include <functional>
+#include <chrono>
 
 #include "libworld.h"
 #include "world.pb.h"
+#include "areaOfInterest.hpp"
 
 class ProtocolConverter
 {
@@ -9,8 +13,8 @@ public:
     static void toMessage(shared_ptr<world::Airport> airport, world_proto::Airport& message)
     {
         message.set_icao(airport->header().icao());
-        message.mutable_location()->set_lat(30);
-        message.mutable_location()->set_lon(-73);
+        message.mutable_location()->set_lat(airport->header().datum().latitude);
+        message.mutable_location()->set_lon(airport->header().datum().longitude);
 
         for (const auto& runway : airport->runways())
         {
@@ -33,6 +37,54 @@ public:
         }
     }
 
+    // the box is taken from its corners, so that a client can send it either way around;
+    // throws if the area is invalid
+    static server::AreaOfInterest fromMessage(
+        const world_proto::GeoBox& box,
+        vector<server::AreaOfInterest::RateTier> rateTiers = vector<server::AreaOfInterest::RateTier>())
+    {
+        double south = min(min(box.south_west().lat(), box.south_east().lat()), min(box.north_west().lat(), box.north_east().lat()));
+        double north = max(max(box.south_west().lat(), box.south_east().lat()), max(box.north_west().lat(), box.north_east().lat()));
+        double west = min(box.north_west().lon(), box.south_west().lon());
+        double east = max(box.north_east().lon(), box.south_east().lon());
+        return server::AreaOfInterest(south, north, west, east, rateTiers);
+    }
+
+    static server::AreaOfInterest fromMessage(const world_proto::ClientToServer_SubscribeWorldChanges& message)
+    {
+        vector<server::AreaOfInterest::RateTier> rateTiers;
+        for (const auto& tier : message.rate_tiers())
+        {
+            if (tier.max_distance_nm() <= 0 || tier.update_interval_ms() < 0)
+            {
+                throw runtime_error("Invalid rate tier");
+            }
+            rateTiers.push_back({ tier.max_distance_nm(), chrono::milliseconds(tier.update_interval_ms()) });
+        }
+
+        server::AreaOfInterest area = fromMessage(message.area(), rateTiers);
+        if (message.has_altitude_band())
+        {
+            area.setAltitudeBand((float)message.min_altitude_feet(), (float)message.max_altitude_feet());
+        }
+        return area;
+    }
+
+    // the aircraft descriptor; its situation is sent separately
+    static world_proto::Aircraft toMessage(const shared_ptr<world::Flight> flight)
+    {
+        world_proto::Aircraft message;
+        const auto aircraft = flight->aircraft();
+
+        message.set_id(aircraft->id());
+        message.set_model_icao(aircraft->modelIcao());
+        message.set_airline_icao(aircraft->airlineIcao());
+        message.set_tail_no(aircraft->tailNo());
+        message.set_call_sign(flight->callSign());
+
+        return message;
+    }
+
     static world_proto::Runway toMessage(const shared_ptr<world::Runway> runway)
     {
         world_proto::Runway message;
@@ -97,9 +149,9 @@ public:
         addOperationIf(world::Aircraft::OperationType::Cargo);
         addOperationIf(world::Aircraft::OperationType::Military);
 
-        for (const string& airlineIcao : parkingStand->airlines())
+        for (world::Symbol airline : parkingStand->airlineSymbols())
         {
-            message.mutable_airline_icaos()->Add(std::string(airlineIcao));
+            message.mutable_airline_icaos()->Add(std::string(world::SymbolTable::getGlobalString(airline)));
         }
 
         return message;
@@ -153,6 +205,19 @@ public:
         return message;
     }
 
+    static void toMessage(chrono::system_clock::time_point time, google::protobuf::Timestamp& message)
+    {
+        const auto sinceEpoch = chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count();
+        message.set_seconds(sinceEpoch / 1000000000);
+        message.set_nanos((int32_t)(sinceEpoch % 1000000000));
+    }
+
+    static chrono::system_clock::time_point fromMessage(const google::protobuf::Timestamp& message)
+    {
+        const auto sinceEpoch = chrono::seconds(message.seconds()) + chrono::nanoseconds(message.nanos());
+        return chrono::system_clock::time_point(chrono::duration_cast<chrono::system_clock::duration>(sinceEpoch));
+    }
+
     static world_proto::GeoPoint toMessage(const world::UniPoint uniPoint)
     {
         world_proto::GeoPoint message;
@@ -13,6 +13,7 @@
 #include <websocketpp/server.hpp>
 
 #include "libworld.h"
+#include "asyncLog.hpp"
 #include "interfaces.hpp"
 
 using namespace std;
@@ -24,17 +25,36 @@ namespace server
     {
     private:
         typedef websocketpp::server<websocketpp::config::asio> Endpoint;
+        struct ConnectionEntry
+        {
+            websocketpp::connection_hdl hdl;
+            shared_ptr<ClientConnection> client;
+            shared_ptr<ConnectionBackpressure> backpressure;
+        };
+    public:
+        // how much a connection may have yet to send before broadcast frames are dropped for it
+        static const size_t defaultMaxBufferedBytes = 1024 * 1024;
     private:
         shared_ptr<HostServices> m_host;
         shared_ptr<DispatcherInterface> m_dispatcher;
+        function<void(uint64_t clientId)> m_requestResync;
+        size_t m_maxBufferedBytes;
         Endpoint m_endpoint;
-        forward_list<websocketpp::connection_hdl> m_connections;
+        forward_list<ConnectionEntry> m_connections;
+        uint64_t m_nextClientId;
         mutex m_connectionsLock;
         atomic<bool> m_stopping;
     public:
-        Server(shared_ptr<HostServices> _host, shared_ptr<DispatcherInterface> _dispatcher) :
-            m_host(_host),
+        Server(
+            shared_ptr<HostServices> _host,
+            shared_ptr<DispatcherInterface> _dispatcher,
+            function<void(uint64_t clientId)> _requestResync = nullptr,
+            size_t _maxBufferedBytes = defaultMaxBufferedBytes
+        ) : m_host(_host),
             m_dispatcher(_dispatcher),
+            m_requestResync(_requestResync),
+            m_maxBufferedBytes(_maxBufferedBytes),
+            m_nextClientId(1),
             m_stopping(false)
         {
             m_host->writeLog("SRVHST|INIT starting");
@@ -49,14 +69,20 @@ namespace server
             m_endpoint.set_message_handler([=](websocketpp::connection_hdl hdl, Endpoint::message_ptr msg) {
                 onMessage(hdl, msg);
             });
+            m_endpoint.set_close_handler([=](websocketpp::connection_hdl hdl) {
+                removeConnection(hdl);
+            });
+            m_endpoint.set_fail_handler([=](websocketpp::connection_hdl hdl) {
+                removeConnection(hdl);
+            });
 
             // Initialize Asio
             m_endpoint.init_asio();
             m_endpoint.get_alog().set_ostream(&std::cout);
             m_endpoint.get_elog().set_ostream(&std::cout);
 
-            m_dispatcher->setBroadcastInterface([this](const world_proto::ServerToClient &envelope) {
-                broadcastToClients(envelope);
+            m_dispatcher->setBroadcastInterface([this](const shared_ptr<const OutboundMessage>& message) {
+                broadcastToClients(message);
             });
 
             m_host->writeLog("SRVHST|INIT completed");
@@ -122,7 +148,11 @@ namespace server
                     if (connection && !error)
                     {
                         m_host->writeLog("SRVHST|CONN approved new connection [%p]", connection.get());
-                        m_connections.push_front(hdl);
+                        m_connections.push_front({
+                            hdl,
+                            make_shared<ClientConnection>(m_nextClientId++),
+                            make_shared<ConnectionBackpressure>(m_maxBufferedBytes)
+                        });
                         return true;
                     }
                 }
@@ -136,96 +166,183 @@ namespace server
         {
             if (msg->get_opcode() != websocketpp::frame::opcode::binary)
             {
-                m_host->writeLog("SRVHST|RECV WARNING: not binary format, ignored");
+                ATC_LOG_WARNING(AsyncLog::Category::Server, "SRVHST|RECV WARNING: not binary format, ignored");
                 return;
             }
 
             const string &dataOnWire = msg->get_payload();
-            m_host->writeLog("SRVHST|RECV size[%llu]", dataOnWire.size());
+            ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVHST|RECV size[%llu]", dataOnWire.size());
 
             world_proto::ClientToServer envelope;
             if (!envelope.ParseFromString(dataOnWire))
             {
-                m_host->writeLog("SRVHST|RECV ERROR: failed to parse");
+                ATC_LOG_ERROR(AsyncLog::Category::Server, "SRVHST|RECV ERROR: failed to parse");
                 return;
             }
 
-            m_host->writeLog("SRVHST|RECV payload case[%d], enqueue", envelope.payload_case());
-            m_dispatcher->enqueueInbound(envelope, [=](const world_proto::ServerToClient &replyEnvelope) {
-                sendToConnection(hdl, replyEnvelope);
+            ConnectionEntry entry;
+            if (!tryFindConnection(hdl, entry))
+            {
+                ATC_LOG_ERROR(AsyncLog::Category::Server, "SRVHST|RECV ERROR: connection was closed");
+                return;
+            }
+
+            ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVHST|RECV payload case[%d], enqueue", envelope.payload_case());
+
+            // the callback becomes notifyClient of an area subscription and outlives the request, so it must not
+            // keep the client alive: once the connection is removed, the change feed drops the subscription
+            const websocketpp::connection_hdl hdl = entry.hdl;
+            const uint64_t clientId = entry.client->id();
+            const weak_ptr<ConnectionBackpressure> weakBackpressure = entry.backpressure;
+            m_dispatcher->enqueueInbound(envelope, entry.client, [this, hdl, clientId, weakBackpressure](const world_proto::ServerToClient &replyEnvelope) {
+                sendReply(hdl, clientId, weakBackpressure, replyEnvelope);
             });
         }
 
-        void sendToConnection(websocketpp::connection_hdl hdl, const world_proto::ServerToClient &envelope)
+        // replies, and world change frames of area subscriptions
+        void sendReply(
+            const websocketpp::connection_hdl& hdl,
+            uint64_t clientId,
+            const weak_ptr<ConnectionBackpressure>& weakBackpressure,
+            const world_proto::ServerToClient &envelope)
+        {
+            const auto backpressure = weakBackpressure.lock();
+            if (!backpressure)
+            {
+                ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVHST|SEND payload case[%d] DROPPED: connection was removed", envelope.payload_case());
+                return;
+            }
+
+            shared_ptr<const OutboundMessage> message;
+            try
+            {
+                message = OutboundMessage::serialize(envelope);
+            }
+            catch (const exception& e)
+            {
+                ATC_LOG_ERROR(AsyncLog::Category::Server, "SRVHST|SEND ERROR: %s", e.what());
+                return;
+            }
+
+            const auto connection = tryGetConnection(hdl, *message);
+            if (connection)
+            {
+                admitAndSend(*backpressure, clientId, connection, *message);
+            }
+        }
+
+        void broadcastToClients(const shared_ptr<const OutboundMessage>& message)
+        {
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
+                "SRVHST|SEND starting broadcast of payload case[%d] size[%llu]",
+                message->payloadCase(),
+                message->dataOnWire().size());
+
+            vector<ConnectionEntry> copyOfConnections;
+            copyAllConnections(copyOfConnections);
+
+            bool isWorldChanges = (message->payloadCase() == world_proto::ServerToClient::kNotifyWorldChanges);
+
+            for (const auto& entry : copyOfConnections)
+            {
+                if (isWorldChanges && entry.client->hasSubscription())
+                {
+                    // the client gets frames of its area instead
+                    continue;
+                }
+
+                const auto connection = tryGetConnection(entry.hdl, *message);
+                if (connection)
+                {
+                    admitAndSend(*entry.backpressure, entry.client->id(), connection, *message);
+                }
+            }
+
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
+                "SRVHST|SEND completed broadcast of payload case[%d]",
+                message->payloadCase());
+        }
+
+        void admitAndSend(
+            ConnectionBackpressure& backpressure,
+            uint64_t clientId,
+            const Endpoint::connection_ptr& connection,
+            const OutboundMessage& message)
+        {
+            auto decision = backpressure.admit(message, connection->get_buffered_amount());
+            if (decision == ConnectionBackpressure::Decision::Send)
+            {
+                sendToConnection(connection, message);
+                return;
+            }
+
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
+                "SRVHST|SEND payload case[%d] to connection[%p] DROPPED: buffered[%llu] dropped-so-far[%llu]",
+                message.payloadCase(),
+                connection.get(),
+                connection->get_buffered_amount(),
+                backpressure.droppedCount());
+
+            if (decision == ConnectionBackpressure::Decision::DropAndRequestResync && m_requestResync)
+            {
+                ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVHST|SEND requesting resync for connection[%p] client[%llu]", connection.get(), clientId);
+                m_requestResync(clientId);
+            }
+        }
+
+        Endpoint::connection_ptr tryGetConnection(websocketpp::connection_hdl hdl, const OutboundMessage& message)
         {
             error_code error;
 
             const auto connection = m_endpoint.get_con_from_hdl(hdl, error);
             if (error || !connection)
             {
-                m_host->writeLog(
+                ATC_LOG_ERROR(
+                    AsyncLog::Category::Server,
                     "SRVHST|SEND payload case[%d] ERROR: connection was closed [%s]",
-                    envelope.payload_case(),
+                    message.payloadCase(),
                     error.message().c_str());
-                return;
+                return nullptr;
             }
 
-            string dataOnWire;
-            if (!envelope.SerializeToString(&dataOnWire))
-            {
-                m_host->writeLog(
-                    "SRVHST|SEND payload case[%d] to connection [%p] ERROR: serialization failed",
-                    envelope.payload_case(),
-                    connection.get());
-                return;
-            }
+            return connection;
+        }
 
-            error = connection->send(dataOnWire, websocketpp::frame::opcode::binary);
+        void sendToConnection(const Endpoint::connection_ptr& connection, const OutboundMessage& message)
+        {
+            const string& dataOnWire = message.dataOnWire();
+            const auto error = connection->send(dataOnWire.data(), dataOnWire.size(), websocketpp::frame::opcode::binary);
             if (!error)
             {
-                m_host->writeLog(
+                ATC_LOG_DEBUG(
+                    AsyncLog::Category::Server,
                     "SRVHST|SEND payload case[%d] to connection[%p] size[%llu] OK",
-                    envelope.payload_case(),
+                    message.payloadCase(),
                     connection.get(),
                     dataOnWire.length());
             }
             else
             {
-                m_host->writeLog(
+                ATC_LOG_ERROR(
+                    AsyncLog::Category::Server,
                     "SRVHST|SEND ERROR: payload case[%d] to connection[%p] size[%llu] error[%d]",
-                    envelope.payload_case(),
+                    message.payloadCase(),
                     connection.get(),
                     dataOnWire.length(),
                     error.value());
             }
         }
 
-        void broadcastToClients(const world_proto::ServerToClient &envelope)
-        {
-            m_host->writeLog(
-                "SRVHST|SEND starting broadcast of payload case[%d]",
-                envelope.payload_case());
-
-            vector<websocketpp::connection_hdl> copyOfConnections;
-            copyAllConnections(copyOfConnections);
-
-            for (const auto& hdl : copyOfConnections)
-            {
-                sendToConnection(hdl, envelope);
-            }
-
-            m_host->writeLog(
-                "SRVHST|SEND completed broadcast of payload case[%d]",
-                envelope.payload_case());
-        }
-
         void closeAllConnections()
         {
             lock_guard<mutex> lock(m_connectionsLock);
 
-            for (const auto& hdl : m_connections)
+            for (const auto& entry : m_connections)
             {
-                closeConnection(hdl);
+                closeConnection(entry.hdl);
             }
 
             m_connections.clear();
@@ -249,13 +366,38 @@ namespace server
             }
         }
 
-        void copyAllConnections(vector<websocketpp::connection_hdl>& destination)
+        void removeConnection(const websocketpp::connection_hdl& hdl)
+        {
+            lock_guard<mutex> lock(m_connectionsLock);
+
+            m_connections.remove_if([&hdl](const ConnectionEntry& entry) {
+                return !entry.hdl.owner_before(hdl) && !hdl.owner_before(entry.hdl);
+            });
+        }
+
+        bool tryFindConnection(const websocketpp::connection_hdl& hdl, ConnectionEntry& entry)
+        {
+            lock_guard<mutex> lock(m_connectionsLock);
+
+            for (const auto& existing : m_connections)
+            {
+                if (!existing.hdl.owner_before(hdl) && !hdl.owner_before(existing.hdl))
+                {
+                    entry = existing;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        void copyAllConnections(vector<ConnectionEntry>& destination)
         {
             lock_guard<mutex> lock(m_connectionsLock);
 
-            for (const auto& hdl : m_connections)
+            for (const auto& entry : m_connections)
             {
-                destination.push_back(hdl);
+                destination.push_back(entry);
             }
         }
     };
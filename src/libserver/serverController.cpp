@@ -6,10 +6,14 @@
 #include <atomic>
 #include <future>
 #include <functional>
+#include <thread>
+#include <algorithm>
 
 #include "libserver.hpp"
 #include "interfaces.hpp"
 #include "worldService.hpp"
+#include "worldChangeFeed.hpp"
+#include "worldSnapshot.hpp"
 #include "worldServiceDispatchMiddleware.hpp"
 #include "dispatcher.hpp"
 #include "server.hpp"
@@ -31,13 +35,21 @@ namespace server
         shared_ptr<HostServices> m_host;
         ServerInterface::Factory m_serverFactory;
         shared_ptr<ServerInterface> m_server;
+        shared_ptr<WorldChangeFeed> m_changeFeed;
+        shared_ptr<WorldSnapshotPublisher> m_snapshots;
         atomic<ServerState> m_state;
         future<void> m_serverRunCompletion;
     public:
-        ServerController(shared_ptr<HostServices> _host, ServerInterface::Factory _serverFactory) :
-            m_host(_host),
+        ServerController(
+            shared_ptr<HostServices> _host,
+            ServerInterface::Factory _serverFactory,
+            shared_ptr<WorldChangeFeed> _changeFeed,
+            shared_ptr<WorldSnapshotPublisher> _snapshots
+        ) : m_host(_host),
             m_state(ServerState::Stopped),
-            m_serverFactory(_serverFactory)
+            m_serverFactory(_serverFactory),
+            m_changeFeed(_changeFeed),
+            m_snapshots(_snapshots)
         {
         }
     public:
@@ -73,6 +85,8 @@ namespace server
                 return;
             }
 
+            // frames must not reach the dispatcher while it shuts down
+            m_changeFeed->setBroadcastInterface(nullptr);
             m_server->beginGracefulShutdown();
         }
 
@@ -93,19 +107,55 @@ namespace server
 
             return false;
         }
+
+        void publishWorldChanges(shared_ptr<World::ChangeSet> changeSet) override
+        {
+            try
+            {
+                // kept up to date while stopped too, so that the first requests after start find it
+                m_snapshots->publish(*m_host->getWorld());
+            }
+            catch (const exception& e)
+            {
+                m_host->writeLog("SRVCTL|publish world snapshot CRASHED!!! %s", e.what());
+            }
+
+            if (m_state != ServerState::Started)
+            {
+                return;
+            }
+
+            try
+            {
+                m_changeFeed->publish(*m_host->getWorld(), changeSet.get());
+            }
+            catch (const exception& e)
+            {
+                m_host->writeLog("SRVCTL|publishWorldChanges CRASHED!!! %s", e.what());
+            }
+        }
     };
 
     shared_ptr<ServerControllerInterface> server::ServerControllerInterface::create(shared_ptr<HostServices> host)
     {
-        ServerInterface::Factory serverFactory = [host] {
-            auto service = shared_ptr<WorldService>(new WorldService(host));
+        // the feed outlives server restarts, so that the sim thread can keep publishing to it
+        auto changeFeed = make_shared<WorldChangeFeed>(host);
+        auto snapshots = make_shared<WorldSnapshotPublisher>();
+
+        ServerInterface::Factory serverFactory = [host, changeFeed, snapshots] {
+            auto service = shared_ptr<WorldService>(new WorldService(host, changeFeed, snapshots));
             auto middleware = shared_ptr<WorldServiceDispatchMiddleware>(new WorldServiceDispatchMiddleware(host, service));
-            auto dispatcher = shared_ptr<Dispatcher>(new Dispatcher(host, middleware, 1));
+            // leave some cores to the sim; one sender thread keeps replies to each client in order
+            int serviceThreadCount = min(4, max(1, (int)thread::hardware_concurrency() / 2));
+            auto dispatcher = shared_ptr<Dispatcher>(new Dispatcher(host, middleware, serviceThreadCount, 1));
 
-            shared_ptr<ServerInterface> server = make_shared<Server>(host, dispatcher);
+            // a connection which dropped frames resyncs from the next keyframe of what it follows
+            shared_ptr<ServerInterface> server = make_shared<Server>(host, dispatcher, [changeFeed](uint64_t clientId) {
+                changeFeed->requestKeyframe(clientId);
+            });
             return server;
         };
 
-        return make_shared<ServerController>(host, serverFactory);
+        return make_shared<ServerController>(host, serverFactory, changeFeed, snapshots);
     }
 }
@@ -0,0 +1,641 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+#include "libworld.h"
+#include "asyncLog.hpp"
+#include "world.pb.h"
+#include "interfaces.hpp"
+#include "protocolConverter.hpp"
+#include "areaOfInterest.hpp"
+
+using namespace std;
+using namespace world;
+
+namespace server
+{
+    // Turns world ChangeSets into NotifyWorldChanges frames, which are broadcast to all clients.
+    // publish() is called by the sim thread after every tick. ChangeSets of the ticks between two frames
+    // are merged, so that a frame goes out at most once per frame interval, regardless of the sim frame rate.
+    // A frame only carries what changed since the previous frame, so it is the same for every client;
+    // a client which connects mid-stream needs a keyframe, which goes out on requestKeyframe() and periodically.
+    // A client which subscribes to an area of interest gets its own frames instead, encoded against what
+    // that client was sent, and limited to the aircraft which an AircraftGridIndex finds inside the area;
+    // such a client resyncs alone, through requestKeyframe(clientId).
+    class WorldChangeFeed
+    {
+    public:
+        // aircraft situation in the units of AircraftSituationDelta
+        struct QuantizedSituation
+        {
+            int32_t latitude = 0;
+            int32_t longitude = 0;
+            int32_t altitude = 0;
+            int32_t heading = 0;
+            int32_t pitch = 0;
+            int32_t roll = 0;
+            int32_t groundSpeed = 0;
+            int32_t verticalSpeed = 0;
+            uint32_t flags = 0;
+            uint32_t configuration = 0;
+            int32_t frequencyKhz = 0;
+            string squawk;
+        };
+        enum SituationFlags
+        {
+            FlagOnGround = 0x1,
+            FlagAltitudeAGL = 0x2,
+            FlagLightsShift = 2
+        };
+    private:
+        typedef world_proto::AircraftSituationDelta Delta;
+        typedef world_proto::ServerToClient_NotifyWorldChanges Frame;
+        struct Subscriber
+        {
+            weak_ptr<ClientConnection> client;
+            AreaOfInterest area;
+            DispatcherInterface::ReplyCallback notifyClient;
+            unordered_map<int, QuantizedSituation> lastSentByAircraftId;
+            unordered_map<int, chrono::steady_clock::time_point> lastSentTimeByAircraftId;
+            bool needsKeyframe;
+            uint64_t frameNumber;
+        };
+        struct SubscriptionRequest
+        {
+            uint64_t clientId;
+            weak_ptr<ClientConnection> client;
+            // null to unsubscribe
+            shared_ptr<AreaOfInterest> area;
+            DispatcherInterface::ReplyCallback notifyClient;
+        };
+    private:
+        shared_ptr<HostServices> m_host;
+        const chrono::milliseconds m_frameInterval;
+        const int m_keyframeIntervalFrames;
+        mutex m_broadcastLock;
+        DispatcherInterface::ReplyCallback m_broadcast;
+        atomic<bool> m_keyframeRequested;
+        mutex m_subscriptionLock;
+        vector<SubscriptionRequest> m_subscriptionRequests;
+        vector<uint64_t> m_resyncClientIds;
+        // the rest is only touched by the sim thread
+        unordered_map<int, shared_ptr<Flight>> m_pendingAdded;
+        unordered_map<int, shared_ptr<Flight>> m_pendingUpdated;
+        vector<int> m_pendingRemovedAircraftIds;
+        unordered_map<int, QuantizedSituation> m_lastSentByAircraftId;
+        uint64_t m_frameNumber;
+        int m_framesSinceKeyframe;
+        chrono::steady_clock::time_point m_lastFrameTime;
+        unordered_map<uint64_t, shared_ptr<Subscriber>> m_subscriberByClientId;
+        AircraftGridIndex m_index;
+        bool m_isIndexValid;
+    public:
+        WorldChangeFeed(
+            shared_ptr<HostServices> _host,
+            chrono::milliseconds _frameInterval = chrono::milliseconds(100),
+            int _keyframeIntervalFrames = 300
+        ) : m_host(_host),
+            m_frameInterval(_frameInterval),
+            m_keyframeIntervalFrames(_keyframeIntervalFrames),
+            m_keyframeRequested(true),
+            m_frameNumber(0),
+            m_framesSinceKeyframe(0),
+            m_isIndexValid(false)
+        {
+        }
+    public:
+
+        void setBroadcastInterface(DispatcherInterface::ReplyCallback broadcastInterface)
+        {
+            lock_guard<mutex> lock(m_broadcastLock);
+            m_broadcast = broadcastInterface;
+            // whoever listens now hasn't seen anything yet
+            m_keyframeRequested = true;
+        }
+
+        // safe to call from any thread; the next broadcast frame will be a keyframe.
+        // Subscribers are not affected, they follow their own frames.
+        void requestKeyframe()
+        {
+            m_keyframeRequested = true;
+        }
+
+        // safe to call from any thread; the next frame of the client's subscription will be a keyframe,
+        // or if the client has no subscription, the next broadcast frame
+        void requestKeyframe(uint64_t clientId)
+        {
+            lock_guard<mutex> lock(m_subscriptionLock);
+            m_resyncClientIds.push_back(clientId);
+        }
+
+        // safe to call from any thread; takes effect on the next frame, which will be a keyframe of the area.
+        // A client has at most one subscription, a new one replaces the previous.
+        void subscribe(const shared_ptr<ClientConnection>& client, const AreaOfInterest& area, DispatcherInterface::ReplyCallback notifyClient)
+        {
+            lock_guard<mutex> lock(m_subscriptionLock);
+            m_subscriptionRequests.push_back({ client->id(), client, make_shared<AreaOfInterest>(area), notifyClient });
+        }
+
+        // safe to call from any thread
+        void unsubscribe(uint64_t clientId)
+        {
+            lock_guard<mutex> lock(m_subscriptionLock);
+            m_subscriptionRequests.push_back({ clientId, weak_ptr<ClientConnection>(), nullptr, nullptr });
+        }
+
+        size_t subscriberCount() const
+        {
+            return m_subscriberByClientId.size();
+        }
+
+        // called by the sim thread after every tick; changeSet is null if nothing changed during the tick
+        void publish(const World& world, const World::ChangeSet* changeSet)
+        {
+            if (changeSet)
+            {
+                accumulate(*changeSet);
+            }
+            applySubscriptionRequests();
+
+            auto now = chrono::steady_clock::now();
+            if (now - m_lastFrameTime < m_frameInterval)
+            {
+                return;
+            }
+            m_lastFrameTime = now;
+
+            if (!m_subscriberByClientId.empty())
+            {
+                publishToSubscribers(world, now);
+            }
+
+            lock_guard<mutex> lock(m_broadcastLock);
+            if (!m_broadcast)
+            {
+                // nobody listens; whoever starts listening will get a keyframe
+                m_pendingAdded.clear();
+                m_pendingUpdated.clear();
+                m_pendingRemovedAircraftIds.clear();
+                return;
+            }
+
+            world_proto::ServerToClient envelope;
+            if (!encodeFrame(world, *envelope.mutable_notify_world_changes()))
+            {
+                return;
+            }
+
+            ATC_LOG_DEBUG(
+                AsyncLog::Category::Server,
+                "SRVFEED|frame[%llu] keyframe[%d] added[%d] deltas[%d] removed[%d]",
+                envelope.notify_world_changes().frame_number(),
+                envelope.notify_world_changes().is_keyframe() ? 1 : 0,
+                envelope.notify_world_changes().added_aircraft_size(),
+                envelope.notify_world_changes().situation_deltas_size(),
+                envelope.notify_world_changes().removed_aircraft_ids_size());
+
+            m_broadcast(envelope);
+        }
+
+        // merges the changes of one tick into the next frame
+        void accumulate(const World::ChangeSet& changeSet)
+        {
+            for (const auto& flight : changeSet.flights().added())
+            {
+                m_pendingAdded[flight->id()] = flight;
+                if (m_isIndexValid)
+                {
+                    m_index.update(flight);
+                }
+            }
+            for (const auto& entry : changeSet.flights().updated())
+            {
+                m_pendingUpdated[entry.first] = entry.second;
+                if (m_isIndexValid)
+                {
+                    m_index.update(entry.second);
+                }
+            }
+            for (const auto& flight : changeSet.flights().removed())
+            {
+                m_index.remove(flight->id());
+                m_pendingAdded.erase(flight->id());
+                m_pendingUpdated.erase(flight->id());
+                if (flight->aircraft())
+                {
+                    m_pendingRemovedAircraftIds.push_back(flight->aircraft()->id());
+                }
+            }
+        }
+
+        // returns false if there is nothing to send
+        bool encodeFrame(const World& world, Frame& frame)
+        {
+            bool isKeyframe =
+                m_keyframeRequested.exchange(false) ||
+                (m_keyframeIntervalFrames > 0 && m_framesSinceKeyframe >= m_keyframeIntervalFrames);
+
+            if (isKeyframe)
+            {
+                m_lastSentByAircraftId.clear();
+                for (const auto& flight : world.flights())
+                {
+                    encodeAddedFlight(flight, frame, m_lastSentByAircraftId);
+                }
+            }
+            else
+            {
+                encodePendingChanges(frame);
+            }
+
+            m_pendingAdded.clear();
+            m_pendingUpdated.clear();
+            m_pendingRemovedAircraftIds.clear();
+
+            bool isEmpty =
+                frame.added_aircraft_size() == 0 &&
+                frame.situation_deltas_size() == 0 &&
+                frame.removed_aircraft_ids_size() == 0;
+            if (isEmpty && !isKeyframe)
+            {
+                return false;
+            }
+
+            frame.set_frame_number(++m_frameNumber);
+            frame.set_world_timestamp_us(world.timestamp().count());
+            frame.set_is_keyframe(isKeyframe);
+            m_framesSinceKeyframe = isKeyframe ? 0 : m_framesSinceKeyframe + 1;
+            return true;
+        }
+
+    public:
+
+        static QuantizedSituation quantize(const Aircraft& aircraft)
+        {
+            QuantizedSituation result;
+
+            const auto& location = aircraft.location();
+            const auto& attitude = aircraft.attitude();
+            const auto& altitude = aircraft.altitude();
+
+            result.latitude = (int32_t)lround(location.latitude * 1000000.0);
+            result.longitude = (int32_t)lround(location.longitude * 1000000.0);
+            result.altitude = (int32_t)lround(altitude.feet());
+            result.heading = wrapHeading((int32_t)lround(attitude.heading() * 10.0));
+            result.pitch = (int32_t)lround(attitude.pitch() * 10.0);
+            result.roll = (int32_t)lround(attitude.roll() * 10.0);
+            result.groundSpeed = (int32_t)lround(aircraft.groundSpeedKt() * 10.0);
+            result.verticalSpeed = (int32_t)lround(aircraft.verticalSpeedFpm() / 10.0);
+            result.flags =
+                (altitude.isGround() ? FlagOnGround : 0) |
+                (altitude.type() == Altitude::Type::AGL ? FlagAltitudeAGL : 0) |
+                ((uint32_t)aircraft.lights() << FlagLightsShift);
+            result.configuration =
+                toPercent(aircraft.gearState()) |
+                (toPercent(aircraft.flapState()) << 8) |
+                (toPercent(aircraft.spoilerState()) << 16);
+            result.frequencyKhz = aircraft.frequencyKhz();
+            result.squawk = aircraft.squawk();
+
+            return result;
+        }
+
+        // fills the fields which differ between the two situations, and returns the field mask;
+        // with includeAll, every field is filled, so that the client gets the values which happen to be zero
+        static uint32_t encodeDelta(const QuantizedSituation& previous, const QuantizedSituation& current, bool includeAll, Delta& delta)
+        {
+            uint32_t mask = 0;
+
+            if (includeAll || current.latitude != previous.latitude || current.longitude != previous.longitude)
+            {
+                mask |= Delta::FIELD_LOCATION;
+                delta.set_lat_delta(current.latitude - previous.latitude);
+                delta.set_lon_delta(current.longitude - previous.longitude);
+            }
+            if (includeAll || current.altitude != previous.altitude)
+            {
+                mask |= Delta::FIELD_ALTITUDE;
+                delta.set_altitude_delta(current.altitude - previous.altitude);
+            }
+            if (includeAll || current.heading != previous.heading)
+            {
+                mask |= Delta::FIELD_HEADING;
+                // the short way around, e.g. 359.9 to 0.1 is +2
+                int32_t headingDelta = current.heading - previous.heading;
+                if (headingDelta > 1800)
+                {
+                    headingDelta -= 3600;
+                }
+                else if (headingDelta <= -1800)
+                {
+                    headingDelta += 3600;
+                }
+                delta.set_heading_delta(headingDelta);
+            }
+            if (includeAll || current.pitch != previous.pitch || current.roll != previous.roll)
+            {
+                mask |= Delta::FIELD_PITCH_ROLL;
+                delta.set_pitch_delta(current.pitch - previous.pitch);
+                delta.set_roll_delta(current.roll - previous.roll);
+            }
+            if (includeAll || current.groundSpeed != previous.groundSpeed || current.verticalSpeed != previous.verticalSpeed)
+            {
+                mask |= Delta::FIELD_SPEED;
+                delta.set_ground_speed_delta(current.groundSpeed - previous.groundSpeed);
+                delta.set_vertical_speed_delta(current.verticalSpeed - previous.verticalSpeed);
+            }
+            if (includeAll || current.flags != previous.flags)
+            {
+                mask |= Delta::FIELD_FLAGS;
+                delta.set_flags(current.flags);
+            }
+            if (includeAll || current.configuration != previous.configuration)
+            {
+                mask |= Delta::FIELD_CONFIGURATION;
+                delta.set_configuration(current.configuration);
+            }
+            if (includeAll || current.frequencyKhz != previous.frequencyKhz)
+            {
+                mask |= Delta::FIELD_FREQUENCY;
+                delta.set_frequency_khz(current.frequencyKhz);
+            }
+            if (includeAll || current.squawk != previous.squawk)
+            {
+                mask |= Delta::FIELD_SQUAWK;
+                delta.set_squawk(current.squawk);
+            }
+
+            delta.set_field_mask(mask);
+            return mask;
+        }
+
+    private:
+
+        void encodePendingChanges(Frame& frame)
+        {
+            // removals go first, so that a flight which was removed and added again is re-created by the client
+            for (int aircraftId : m_pendingRemovedAircraftIds)
+            {
+                if (m_lastSentByAircraftId.erase(aircraftId) > 0)
+                {
+                    frame.add_removed_aircraft_ids(aircraftId);
+                }
+            }
+
+            for (const auto& entry : m_pendingAdded)
+            {
+                encodeAddedFlight(entry.second, frame, m_lastSentByAircraftId);
+            }
+
+            for (const auto& entry : m_pendingUpdated)
+            {
+                const auto& flight = entry.second;
+                const auto aircraft = flight->aircraft();
+                if (!aircraft || m_pendingAdded.count(entry.first) > 0)
+                {
+                    continue;
+                }
+
+                auto lastSent = m_lastSentByAircraftId.find(aircraft->id());
+                if (lastSent == m_lastSentByAircraftId.end())
+                {
+                    encodeAddedFlight(flight, frame, m_lastSentByAircraftId);
+                    continue;
+                }
+
+                QuantizedSituation current = quantize(*aircraft);
+                Delta delta;
+                delta.set_aircraft_id(aircraft->id());
+                if (encodeDelta(lastSent->second, current, false, delta) != 0)
+                {
+                    *frame.add_situation_deltas() = std::move(delta);
+                    lastSent->second = std::move(current);
+                }
+            }
+        }
+
+        void applySubscriptionRequests()
+        {
+            vector<SubscriptionRequest> requests;
+            vector<uint64_t> resyncClientIds;
+            {
+                lock_guard<mutex> lock(m_subscriptionLock);
+                requests.swap(m_subscriptionRequests);
+                resyncClientIds.swap(m_resyncClientIds);
+            }
+
+            for (auto& request : requests)
+            {
+                if (!request.area)
+                {
+                    m_subscriberByClientId.erase(request.clientId);
+                    ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVFEED|client[%llu] unsubscribed", request.clientId);
+                    continue;
+                }
+
+                shared_ptr<Subscriber> subscriber(new Subscriber({
+                    request.client,
+                    *request.area,
+                    request.notifyClient,
+                    unordered_map<int, QuantizedSituation>(),
+                    unordered_map<int, chrono::steady_clock::time_point>(),
+                    true,
+                    0
+                }));
+                m_subscriberByClientId[request.clientId] = subscriber;
+                ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVFEED|client[%llu] subscribed", request.clientId);
+            }
+
+            for (uint64_t clientId : resyncClientIds)
+            {
+                auto found = m_subscriberByClientId.find(clientId);
+                if (found != m_subscriberByClientId.end())
+                {
+                    found->second->needsKeyframe = true;
+                }
+                else
+                {
+                    // the client follows the broadcasts, which are the same for everyone
+                    m_keyframeRequested = true;
+                }
+                ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVFEED|client[%llu] resync requested", clientId);
+            }
+
+            if (m_subscriberByClientId.empty())
+            {
+                // nobody needs the index
+                m_index.clear();
+                m_isIndexValid = false;
+            }
+        }
+
+        void publishToSubscribers(const World& world, chrono::steady_clock::time_point now)
+        {
+            // changes may have been missed while the server was stopped, or while nobody was subscribed
+            bool isKeyframeDue = any_of(
+                m_subscriberByClientId.begin(),
+                m_subscriberByClientId.end(),
+                [](const pair<const uint64_t, shared_ptr<Subscriber>>& entry) {
+                    return entry.second->needsKeyframe;
+                });
+            if (isKeyframeDue || !m_isIndexValid)
+            {
+                rebuildIndex(world);
+            }
+
+            for (auto it = m_subscriberByClientId.begin() ; it != m_subscriberByClientId.end() ; )
+            {
+                Subscriber& subscriber = *it->second;
+                if (subscriber.client.expired())
+                {
+                    ATC_LOG_DEBUG(AsyncLog::Category::Server, "SRVFEED|client[%llu] is gone, subscription dropped", it->first);
+                    it = m_subscriberByClientId.erase(it);
+                    continue;
+                }
+
+                bool isKeyframe = subscriber.needsKeyframe;
+                world_proto::ServerToClient envelope;
+                if (encodeSubscriberFrame(world, subscriber, now, isKeyframe, *envelope.mutable_notify_world_changes()))
+                {
+                    subscriber.needsKeyframe = false;
+                    subscriber.notifyClient(envelope);
+                }
+
+                ++it;
+            }
+        }
+
+        bool encodeSubscriberFrame(
+            const World& world,
+            Subscriber& subscriber,
+            chrono::steady_clock::time_point now,
+            bool isKeyframe,
+            Frame& frame)
+        {
+            if (isKeyframe)
+            {
+                subscriber.lastSentByAircraftId.clear();
+                subscriber.lastSentTimeByAircraftId.clear();
+            }
+
+            vector<shared_ptr<Flight>> flightsInArea;
+            unordered_set<int> aircraftIdsInArea;
+            m_index.query(subscriber.area, [&](const shared_ptr<Flight>& flight) {
+                flightsInArea.push_back(flight);
+                aircraftIdsInArea.insert(flight->aircraft()->id());
+            });
+
+            // aircraft which left the area, or the world
+            for (auto it = subscriber.lastSentByAircraftId.begin() ; it != subscriber.lastSentByAircraftId.end() ; )
+            {
+                if (aircraftIdsInArea.count(it->first) == 0)
+                {
+                    frame.add_removed_aircraft_ids(it->first);
+                    subscriber.lastSentTimeByAircraftId.erase(it->first);
+                    it = subscriber.lastSentByAircraftId.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+
+            for (const auto& flight : flightsInArea)
+            {
+                const auto aircraft = flight->aircraft();
+                auto lastSent = subscriber.lastSentByAircraftId.find(aircraft->id());
+                if (lastSent == subscriber.lastSentByAircraftId.end())
+                {
+                    encodeAddedFlight(flight, frame, subscriber.lastSentByAircraftId);
+                    subscriber.lastSentTimeByAircraftId[aircraft->id()] = now;
+                    continue;
+                }
+
+                auto& lastSentTime = subscriber.lastSentTimeByAircraftId[aircraft->id()];
+                if (now - lastSentTime < subscriber.area.getUpdateInterval(aircraft->location()))
+                {
+                    // the change isn't lost: the next delta is taken against what was sent
+                    continue;
+                }
+
+                QuantizedSituation current = quantize(*aircraft);
+                Delta delta;
+                delta.set_aircraft_id(aircraft->id());
+                if (encodeDelta(lastSent->second, current, false, delta) != 0)
+                {
+                    *frame.add_situation_deltas() = std::move(delta);
+                    lastSent->second = std::move(current);
+                    lastSentTime = now;
+                }
+            }
+
+            bool isEmpty =
+                frame.added_aircraft_size() == 0 &&
+                frame.situation_deltas_size() == 0 &&
+                frame.removed_aircraft_ids_size() == 0;
+            if (isEmpty && !isKeyframe)
+            {
+                return false;
+            }
+
+            frame.set_frame_number(++subscriber.frameNumber);
+            frame.set_world_timestamp_us(world.timestamp().count());
+            frame.set_is_keyframe(isKeyframe);
+            return true;
+        }
+
+        void rebuildIndex(const World& world)
+        {
+            m_index.clear();
+            for (const auto& flight : world.flights())
+            {
+                m_index.update(flight);
+            }
+            m_isIndexValid = true;
+        }
+
+        void encodeAddedFlight(
+            const shared_ptr<Flight>& flight,
+            Frame& frame,
+            unordered_map<int, QuantizedSituation>& lastSentByAircraftId)
+        {
+            const auto aircraft = flight->aircraft();
+            if (!aircraft)
+            {
+                return;
+            }
+
+            *frame.add_added_aircraft() = ProtocolConverter::toMessage(flight);
+
+            QuantizedSituation current = quantize(*aircraft);
+            auto delta = frame.add_situation_deltas();
+            delta->set_aircraft_id(aircraft->id());
+            encodeDelta(QuantizedSituation(), current, true, *delta);
+            lastSentByAircraftId[aircraft->id()] = std::move(current);
+        }
+
+        static int32_t wrapHeading(int32_t heading)
+        {
+            heading %= 3600;
+            return heading < 0 ? heading + 3600 : heading;
+        }
+
+        static uint32_t toPercent(float ratio)
+        {
+            long percent = lround(ratio * 100.0f);
+            return (uint32_t)(percent < 0 ? 0 : (percent > 100 ? 100 : percent));
+        }
+    };
+}
@@ -5,32 +5,61 @@
 #include <fstream>
 #include <unordered_map>
 #include <stdarg.h> 
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <atomic>
+#include <algorithm>
 
 #include "libworld.h"
 #include "libdataxp.h"
 #include "world.pb.h"
 #include "interfaces.hpp"
 #include "protocolConverter.hpp"
+#include "worldChangeFeed.hpp"
+#include "airportPayloadCache.hpp"
+#include "worldSnapshot.hpp"
+#include "parallelForPool.hpp"
 
 using namespace std;
 using namespace world;
 
 namespace server
 {
+    // Requests may be handled by several service threads at once; the world is only read through snapshots,
+    // which the sim thread publishes between ticks.
     class WorldService : public WorldServiceInterface
     {
+    public:
+        static constexpr int maxTaxiPathBatchSize = 1000;
     private:
         shared_ptr<HostServices> m_host;
+        shared_ptr<WorldChangeFeed> m_changeFeed;
+        shared_ptr<WorldSnapshotPublisher> m_snapshots;
+        AirportPayloadCache m_airportCache;
+        // batched searches of all requests share the pool
+        ParallelForPool m_workerPool;
     public:
-        WorldService(shared_ptr<HostServices> _host) :
-            m_host(_host)
+        WorldService(
+            shared_ptr<HostServices> _host,
+            shared_ptr<WorldChangeFeed> _changeFeed,
+            shared_ptr<WorldSnapshotPublisher> _snapshots
+        ) : m_host(_host),
+            m_changeFeed(_changeFeed),
+            m_snapshots(_snapshots),
+            m_workerPool(max(1, (int)thread::hardware_concurrency() / 2))
+        {
+        }
+
+        ~WorldService() override
         {
+            m_changeFeed->setBroadcastInterface(nullptr);
         }
     public:
 
         void setBroadcastInterface(DispatcherInterface::ReplyCallback broadcastInterface) override
         {
-            //TODO
+            m_changeFeed->setBroadcastInterface(broadcastInterface);
         }
 
         void connect(
@@ -42,6 +71,8 @@ namespace server
             if (request.token().compare("HELLO") == 0)
             {
                 replyEnvelope.mutable_reply_connect()->set_server_banner("AT&C plugin");
+                // the new client can only follow the world changes from a keyframe
+                m_changeFeed->requestKeyframe();
                 m_host->writeLog("SRVSVC|connect > reply OK");
             }
             else
@@ -59,12 +90,22 @@ namespace server
 
             try
             {
-                const auto airport = m_host->getWorld()->getAirport(request.icao_code());
-                ProtocolConverter::toMessage(
-                    airport,
-                    *replyEnvelope.mutable_reply_query_airport()->mutable_airport()
-                );
-                m_host->writeLog("SRVSVC|queryAirport > reply APT OK");
+                const auto airport = m_snapshots->getCurrent()->getAirport(request.icao_code());
+                const auto cached = m_airportCache.get(airport);
+                auto reply = replyEnvelope.mutable_reply_query_airport();
+                reply->set_airport_size((uint32_t)cached->serializedSize);
+                if (request.accept_deflated())
+                {
+                    reply->set_airport_deflated(cached->deflated);
+                }
+                else
+                {
+                    AirportPayloadCache::setSerializedAirport(*reply, *cached);
+                }
+                m_host->writeLog(
+                    "SRVSVC|queryAirport > reply APT OK size[%llu] deflated[%llu]",
+                    cached->serializedSize,
+                    request.accept_deflated() ? cached->deflated.size() : 0);
             }
             catch (const exception& e)
             {
@@ -87,26 +128,20 @@ namespace server
                 request.to_point().lon(),
                 request.aircraft_model_icao().c_str());
 
-            const auto isTaxiEdge = [](const shared_ptr<TaxiEdge>& edge) {
-                return (edge->type() == TaxiEdge::Type::Taxiway);
-            };
-            const auto hasTaxiEdges = [isTaxiEdge](const shared_ptr<TaxiNode>& node) {
-                return hasAny<shared_ptr<TaxiEdge>>(node->edges(), isTaxiEdge);
-            };
-
             world::GeoPoint fromPoint = { request.from_point().lat(), request.from_point().lon(), 0 };
             world::GeoPoint toPoint = { request.to_point().lat(), request.to_point().lon(), 0 };
 
             shared_ptr<Airport> airport;
             try
             {
-                airport = m_host->getWorld()->getAirport(request.airport_icao());
+                airport = m_snapshots->getCurrent()->getAirport(request.airport_icao());
             }
             catch (const exception& e)
             {
                 const auto fault = replyEnvelope.mutable_fault_not_found();
                 fault->set_message("Airport not found");
                 m_host->writeLog("SRVSVC|queryTaxiPath > reply FAULT APT NOT FOUND (error: %s)", e.what());
+                return;
             }
 
             const auto fromNode = airport->taxiNet()->findClosestNode(fromPoint, hasTaxiEdges);
@@ -130,5 +165,223 @@ namespace server
             *replyEnvelope.mutable_reply_query_taxi_path()->mutable_taxi_path() = ProtocolConverter::toMessage(taxiPath);
             m_host->writeLog("SRVSVC|queryTaxiPath > reply PATH OK");
         }
+
+        void queryTaxiPaths(
+            const world_proto::ClientToServer_QueryTaxiPaths& request,
+            world_proto::ServerToClient& replyEnvelope) override
+        {
+            m_host->writeLog(
+                "SRVSVC|received queryTaxiPaths apt[%s] pairs[%d] profile[%d]",
+                request.airport_icao().c_str(),
+                request.pairs_size(),
+                (int)request.cost_profile());
+
+            if (request.pairs_size() > maxTaxiPathBatchSize)
+            {
+                replyEnvelope.mutable_fault_declined()->set_message("Too many pairs, at most " + to_string(maxTaxiPathBatchSize) + " are allowed");
+                m_host->writeLog("SRVSVC|queryTaxiPaths > reply DECLINE");
+                return;
+            }
+
+            shared_ptr<TaxiNet> taxiNet;
+            try
+            {
+                taxiNet = m_snapshots->getCurrent()->getAirport(request.airport_icao())->taxiNet();
+            }
+            catch (const exception& e)
+            {
+                replyEnvelope.mutable_fault_not_found()->set_message("Airport not found");
+                m_host->writeLog("SRVSVC|queryTaxiPaths > reply FAULT APT NOT FOUND (error: %s)", e.what());
+                return;
+            }
+
+            const auto& pairs = request.pairs();
+            vector<shared_ptr<TaxiNode>> fromNodes(pairs.size());
+            vector<shared_ptr<TaxiNode>> toNodes(pairs.size());
+            runInParallel(pairs.size(), [&](int index) {
+                const auto& pair = pairs.Get(index);
+                fromNodes[index] = taxiNet->findClosestNode(GeoPoint(pair.from_point().lat(), pair.from_point().lon()), hasTaxiEdges);
+                toNodes[index] = taxiNet->findClosestNode(GeoPoint(pair.to_point().lat(), pair.to_point().lon()), hasTaxiEdges);
+            });
+
+            // one search per origin, which finds the paths to all destinations of the origin
+            struct OriginSearch
+            {
+                shared_ptr<TaxiNode> fromNode;
+                vector<shared_ptr<TaxiNode>> toNodes;
+                vector<int> pairIndexes;
+            };
+            vector<OriginSearch> searches;
+            unordered_map<int, int> searchIndexByNodeId;
+            for (int i = 0 ; i < pairs.size() ; i++)
+            {
+                if (!fromNodes[i] || !toNodes[i])
+                {
+                    continue;
+                }
+                auto inserted = searchIndexByNodeId.insert({ fromNodes[i]->id(), (int)searches.size() });
+                if (inserted.second)
+                {
+                    searches.push_back({ fromNodes[i] });
+                }
+                auto& search = searches[inserted.first->second];
+                search.toNodes.push_back(toNodes[i]);
+                search.pairIndexes.push_back(i);
+            }
+
+            const auto costFunction = getCostFunction(request.cost_profile());
+            vector<shared_ptr<TaxiPath>> paths(pairs.size());
+            atomic<int> failedSearchCount(0);
+            runInParallel(searches.size(), [&](int index) {
+                const auto& search = searches[index];
+                try
+                {
+                    auto found = TaxiPath::findMany(taxiNet, search.fromNode, search.toNodes, costFunction);
+                    for (size_t i = 0 ; i < found.size() ; i++)
+                    {
+                        paths[search.pairIndexes[i]] = found[i];
+                    }
+                }
+                catch (const exception& e)
+                {
+                    failedSearchCount++;
+                    m_host->writeLog("SRVSVC|queryTaxiPaths > search from node[%d] FAILED: %s", search.fromNode->id(), e.what());
+                }
+            });
+
+            auto reply = replyEnvelope.mutable_reply_query_taxi_paths();
+            int foundCount = 0;
+            for (const auto& path : paths)
+            {
+                auto result = reply->add_results();
+                result->set_success(path != nullptr);
+                if (path)
+                {
+                    *result->mutable_taxi_path() = ProtocolConverter::toMessage(path);
+                    foundCount++;
+                }
+            }
+
+            m_host->writeLog(
+                "SRVSVC|queryTaxiPaths > reply OK found[%d/%d] searches[%llu] failed[%d]",
+                foundCount, pairs.size(), searches.size(), failedSearchCount.load());
+        }
+
+        void queryAirportTiles(
+            const world_proto::ClientToServer_QueryAirportTiles& request,
+            DispatcherInterface::ReplyCallback replyToSender) override
+        {
+            m_host->writeLog("SRVSVC|received queryAirportTiles icao[%s]", request.icao_code().c_str());
+
+            shared_ptr<const AirportTileSet> tileSet;
+            try
+            {
+                tileSet = m_airportCache.getTileSet(m_snapshots->getCurrent()->getAirport(request.icao_code()));
+            }
+            catch (const exception& e)
+            {
+                world_proto::ServerToClient replyEnvelope;
+                replyEnvelope.mutable_fault_not_found()->set_message("Airport not found");
+                replyToSender(replyEnvelope);
+                m_host->writeLog("SRVSVC|queryAirportTiles > reply NOT FOUND (error: %s)", e.what());
+                return;
+            }
+
+            world_proto::ServerToClient headerEnvelope;
+            tileSet->fillHeader(*headerEnvelope.mutable_reply_query_airport_tiles());
+            replyToSender(headerEnvelope);
+
+            // without a valid viewport, the tiles go from the airport datum outwards
+            const auto& datum = tileSet->datum();
+            vector<int> order;
+            try
+            {
+                if (request.has_viewport())
+                {
+                    const auto viewport = ProtocolConverter::fromMessage(request.viewport());
+                    order = tileSet->getTileOrder(viewport.south(), viewport.north(), viewport.west(), viewport.east());
+                }
+            }
+            catch (const exception& e)
+            {
+                m_host->writeLog("SRVSVC|queryAirportTiles > ignoring invalid viewport (error: %s)", e.what());
+            }
+            if (order.empty())
+            {
+                order = tileSet->getTileOrder(datum.latitude, datum.latitude, datum.longitude, datum.longitude);
+            }
+
+            tileSet->forEachTile(order, [&replyToSender](world_proto::ServerToClient_NotifyAirportTile& tile) {
+                world_proto::ServerToClient tileEnvelope;
+                tileEnvelope.mutable_notify_airport_tile()->Swap(&tile);
+                replyToSender(tileEnvelope);
+            });
+
+            m_host->writeLog("SRVSVC|queryAirportTiles > reply OK tiles[%llu]", order.size());
+        }
+
+        void subscribeWorldChanges(
+            const world_proto::ClientToServer_SubscribeWorldChanges& request,
+            const shared_ptr<ClientConnection>& client,
+            DispatcherInterface::ReplyCallback notifyClient,
+            world_proto::ServerToClient& replyEnvelope) override
+        {
+            m_host->writeLog("SRVSVC|received subscribeWorldChanges client[%llu] area[%d]", client->id(), request.has_area() ? 1 : 0);
+
+            if (!request.has_area())
+            {
+                m_changeFeed->unsubscribe(client->id());
+                client->setHasSubscription(false);
+                // back to the broadcasts, which the client can only follow from a keyframe
+                m_changeFeed->requestKeyframe();
+                replyEnvelope.mutable_reply_subscribe_world_changes()->set_is_area_limited(false);
+                m_host->writeLog("SRVSVC|subscribeWorldChanges > reply UNSUBSCRIBED");
+                return;
+            }
+
+            try
+            {
+                const auto area = ProtocolConverter::fromMessage(request);
+                m_changeFeed->subscribe(client, area, notifyClient);
+                client->setHasSubscription(true);
+                replyEnvelope.mutable_reply_subscribe_world_changes()->set_is_area_limited(true);
+                m_host->writeLog(
+                    "SRVSVC|subscribeWorldChanges > reply SUBSCRIBED lat[%f..%f] lon[%f..%f]",
+                    area.south(), area.north(), area.west(), area.east());
+            }
+            catch (const exception& e)
+            {
+                replyEnvelope.mutable_fault_declined()->set_message(e.what());
+                m_host->writeLog("SRVSVC|subscribeWorldChanges > reply DECLINE (error: %s)", e.what());
+            }
+        }
+
+    private:
+
+        static bool hasTaxiEdges(const shared_ptr<TaxiNode>& node)
+        {
+            return any_of(node->edges().begin(), node->edges().end(), [](const shared_ptr<TaxiEdge>& edge) {
+                return (edge->type() == TaxiEdge::Type::Taxiway);
+            });
+        }
+
+        // taxi edge allocations change as flights taxi, so they are not read here; see WorldSnapshot
+        static TaxiPath::CostFunction getCostFunction(world_proto::ClientToServer_QueryTaxiPaths_CostProfile profile)
+        {
+            if (profile == world_proto::ClientToServer_QueryTaxiPaths::COST_PROFILE_AVOID_ACTIVE_ZONES)
+            {
+                return [](shared_ptr<TaxiEdge> edge) {
+                    return edge->activeZones().hasAny() ? edge->lengthMeters() * 5.0f : edge->lengthMeters();
+                };
+            }
+            return TaxiPath::lengthCostFunction;
+        }
+
+        // the calling thread takes part, so that concurrent requests can't pile up threads;
+        // every item has finished before an exception is rethrown, since the items refer to the caller's stack
+        void runInParallel(size_t count, const function<void(int index)>& work)
+        {
+            m_workerPool.run(count, work);
+        }
     };
 }
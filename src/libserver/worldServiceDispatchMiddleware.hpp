@@ -32,7 +32,9 @@ namespace server
         ) : m_host(_host),
             m_service(_service),
             m_noopRequestHandler(
-                [](const world_proto::ClientToServer& envelope, DispatcherInterface::ReplyCallback reply) {})
+                [](const world_proto::ClientToServer& envelope,
+                   const shared_ptr<ClientConnection>& client,
+                   DispatcherInterface::ReplyCallback reply) {})
         {
             buildHandlerMap();
             m_service->setBroadcastInterface([this](const world_proto::ServerToClient &envelope) {
@@ -62,7 +64,11 @@ namespace server
         {
             m_requestHandlerMap.insert({
                 world_proto::ClientToServer::kConnect,
-                [this](const world_proto::ClientToServer& request, DispatcherInterface::ReplyCallback replyToSender) {
+                [this](
+                    const world_proto::ClientToServer& request,
+                    const shared_ptr<ClientConnection>& client,
+                    DispatcherInterface::ReplyCallback replyToSender
+                ) {
                     world_proto::ServerToClient replyEnvelope;
                     m_service->connect(request.connect(), replyEnvelope);
                     replyToSender(replyEnvelope);
@@ -71,7 +77,11 @@ namespace server
 
             m_requestHandlerMap.insert({
                 world_proto::ClientToServer::kQueryAirport,
-                [this](const world_proto::ClientToServer& request, DispatcherInterface::ReplyCallback replyToSender) {
+                [this](
+                    const world_proto::ClientToServer& request,
+                    const shared_ptr<ClientConnection>& client,
+                    DispatcherInterface::ReplyCallback replyToSender
+                ) {
                     world_proto::ServerToClient replyEnvelope;
                     m_service->queryAirport(request.query_airport(), replyEnvelope);
                     replyToSender(replyEnvelope);
@@ -80,12 +90,53 @@ namespace server
 
             m_requestHandlerMap.insert({
                 world_proto::ClientToServer::kQueryTaxiPath,
-                [this](const world_proto::ClientToServer& request, DispatcherInterface::ReplyCallback replyToSender) {
+                [this](
+                    const world_proto::ClientToServer& request,
+                    const shared_ptr<ClientConnection>& client,
+                    DispatcherInterface::ReplyCallback replyToSender
+                ) {
                     world_proto::ServerToClient replyEnvelope;
                     m_service->queryTaxiPath(request.query_taxi_path(), replyEnvelope);
                     replyToSender(replyEnvelope);
                 }
             });
+
+            m_requestHandlerMap.insert({
+                world_proto::ClientToServer::kQueryTaxiPaths,
+                [this](
+                    const world_proto::ClientToServer& request,
+                    const shared_ptr<ClientConnection>& client,
+                    DispatcherInterface::ReplyCallback replyToSender
+                ) {
+                    world_proto::ServerToClient replyEnvelope;
+                    m_service->queryTaxiPaths(request.query_taxi_paths(), replyEnvelope);
+                    replyToSender(replyEnvelope);
+                }
+            });
+
+            m_requestHandlerMap.insert({
+                world_proto::ClientToServer::kQueryAirportTiles,
+                [this](
+                    const world_proto::ClientToServer& request,
+                    const shared_ptr<ClientConnection>& client,
+                    DispatcherInterface::ReplyCallback replyToSender
+                ) {
+                    m_service->queryAirportTiles(request.query_airport_tiles(), replyToSender);
+                }
+            });
+
+            m_requestHandlerMap.insert({
+                world_proto::ClientToServer::kSubscribeWorldChanges,
+                [this](
+                    const world_proto::ClientToServer& request,
+                    const shared_ptr<ClientConnection>& client,
+                    DispatcherInterface::ReplyCallback replyToSender
+                ) {
+                    world_proto::ServerToClient replyEnvelope;
+                    m_service->subscribeWorldChanges(request.subscribe_world_changes(), client, replyToSender, replyEnvelope);
+                    replyToSender(replyEnvelope);
+                }
+            });
         }
     };
 }
@@ -0,0 +1,106 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "libworld.h"
+
+using namespace std;
+using namespace world;
+
+namespace server
+{
+    // What the service threads read of the world, captured by the sim thread between ticks.
+    // A snapshot never changes once published; the airports it holds stay alive as long as the snapshot,
+    // even if the world has replaced them since. The geometry of an airport is not modified after it is loaded,
+    // so it is read without locks; mutable state, such as taxi edge allocations, must not be read through a snapshot.
+    class WorldSnapshot
+    {
+    private:
+        uint64_t m_generation;
+        uint64_t m_worldAirportsGeneration;
+        vector<shared_ptr<Airport>> m_airports;
+        unordered_map<string, shared_ptr<Airport>> m_airportByIcao;
+    public:
+        WorldSnapshot(uint64_t _generation, const World& _world) :
+            m_generation(_generation),
+            m_worldAirportsGeneration(_world.airportsGeneration()),
+            m_airports(_world.airports())
+        {
+            for (const auto& airport : m_airports)
+            {
+                m_airportByIcao[airport->header().icao()] = airport;
+            }
+        }
+    public:
+        uint64_t generation() const { return m_generation; }
+        const vector<shared_ptr<Airport>>& airports() const { return m_airports; }
+
+        shared_ptr<Airport> getAirport(const string& icaoCode) const
+        {
+            auto found = m_airportByIcao.find(icaoCode);
+            if (found == m_airportByIcao.end())
+            {
+                throw runtime_error("WorldSnapshot: airport [" + icaoCode + "] not found");
+            }
+            return found->second;
+        }
+
+        // whether the world still holds the same airports; only called on the sim thread, on every tick
+        bool isCurrent(const World& world) const
+        {
+            return world.airportsGeneration() == m_worldAirportsGeneration;
+        }
+    };
+
+    // The latest snapshot, replaced as a whole (read-copy-update): readers take a reference to the current one,
+    // and the previous one is released when its last reader is done with it.
+    class WorldSnapshotPublisher
+    {
+    private:
+        shared_ptr<const WorldSnapshot> m_current;
+        uint64_t m_lastGeneration;
+    public:
+        WorldSnapshotPublisher() :
+            m_lastGeneration(0)
+        {
+        }
+    public:
+        // called by the sim thread between ticks; returns false if the current snapshot is still accurate
+        bool publish(const World& world)
+        {
+            const auto current = atomic_load(&m_current);
+            if (current && current->isCurrent(world))
+            {
+                return false;
+            }
+
+            atomic_store(&m_current, shared_ptr<const WorldSnapshot>(make_shared<WorldSnapshot>(++m_lastGeneration, world)));
+            return true;
+        }
+
+        // safe to call from any thread; null until the first snapshot is published
+        shared_ptr<const WorldSnapshot> tryGetCurrent() const
+        {
+            return atomic_load(&m_current);
+        }
+
+        shared_ptr<const WorldSnapshot> getCurrent() const
+        {
+            auto current = tryGetCurrent();
+            if (!current)
+            {
+                throw runtime_error("WorldSnapshotPublisher: world snapshot was not published yet");
+            }
+            return current;
+        }
+    };
+}
@@ -0,0 +1,153 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libworld_test.h"
+#include "airportPayloadCache.hpp"
+
+using namespace std;
+using namespace world;
+using namespace server;
+
+// a single taxiway of taxiNodeCount nodes
+static shared_ptr<Airport> makeTestAirport(shared_ptr<HostServices> host, int taxiNodeCount)
+{
+    return TestGridAirport::create(host, "ABCD", 1, taxiNodeCount, 10);
+}
+
+TEST(AirportPayloadCacheTest, deflate_roundTrip)
+{
+    string data;
+    for (int i = 0 ; i < 1000 ; i++)
+    {
+        data += "taxiway alpha " + to_string(i % 10) + ";";
+    }
+
+    string deflated = AirportPayloadCache::deflate(data);
+    EXPECT_LT(deflated.size(), data.size() / 10);
+    EXPECT_EQ(AirportPayloadCache::inflate(deflated), data);
+
+    EXPECT_EQ(AirportPayloadCache::inflate(AirportPayloadCache::deflate("")), "");
+}
+
+TEST(AirportPayloadCacheTest, get_buildsOnceAndReusesEntry)
+{
+    auto host = TestHostServices::create();
+    auto airport = makeTestAirport(host, 50);
+    AirportPayloadCache cache;
+
+    auto entry1 = cache.get(airport);
+    auto entry2 = cache.get(airport);
+
+    EXPECT_EQ(entry1, entry2);
+    EXPECT_EQ(cache.size(), 1);
+    auto message = AirportPayloadCache::parseAirport(*entry1);
+    EXPECT_EQ(message.icao(), "ABCD");
+    EXPECT_EQ(message.taxi_nodes_size(), 50);
+    EXPECT_EQ(message.taxi_edges_size(), 49);
+
+    world_proto::Airport inflated;
+    string serialized = AirportPayloadCache::inflate(entry1->deflated);
+    EXPECT_EQ(serialized.size(), entry1->serializedSize);
+    ASSERT_TRUE(inflated.ParseFromString(serialized));
+    EXPECT_EQ(inflated.taxi_nodes_size(), 50);
+    EXPECT_EQ(inflated.taxi_edges(48).name(), "R0");
+}
+
+TEST(AirportPayloadCacheTest, setSerializedAirport_parsedAsAirport)
+{
+    auto host = TestHostServices::create();
+    auto airport = makeTestAirport(host, 50);
+    AirportPayloadCache cache;
+    auto entry = cache.get(airport);
+
+    world_proto::ServerToClient envelope;
+    envelope.set_reply_to_request_id(7);
+    AirportPayloadCache::setSerializedAirport(*envelope.mutable_reply_query_airport(), *entry);
+    string dataOnWire;
+    ASSERT_TRUE(envelope.SerializeToString(&dataOnWire));
+
+    world_proto::ServerToClient received;
+    ASSERT_TRUE(received.ParseFromString(dataOnWire));
+    EXPECT_EQ(received.reply_to_request_id(), 7);
+    ASSERT_TRUE(received.reply_query_airport().has_airport());
+    const auto& receivedAirport = received.reply_query_airport().airport();
+    EXPECT_EQ(receivedAirport.icao(), "ABCD");
+    EXPECT_EQ(receivedAirport.taxi_nodes_size(), 50);
+    EXPECT_EQ(receivedAirport.taxi_edges(48).name(), "R0");
+    EXPECT_EQ(receivedAirport.SerializeAsString(), entry->serialized);
+}
+
+TEST(AirportPayloadCacheTest, get_rebuildsReloadedAirport)
+{
+    auto host = TestHostServices::create();
+    auto original = makeTestAirport(host, 5);
+    AirportPayloadCache cache;
+    auto originalEntry = cache.get(original);
+
+    // a reload replaces the Airport object under the same ICAO code
+    auto reloaded = makeTestAirport(host, 7);
+    auto reloadedEntry = cache.get(reloaded);
+
+    EXPECT_NE(reloadedEntry, originalEntry);
+    EXPECT_EQ(AirportPayloadCache::parseAirport(*reloadedEntry).taxi_nodes_size(), 7);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.get(reloaded), reloadedEntry);
+
+    // whoever still holds the old entry can finish sending it
+    EXPECT_EQ(AirportPayloadCache::parseAirport(*originalEntry).taxi_nodes_size(), 5);
+}
+
+TEST(AirportPayloadCacheTest, getTileSet_followsCachedEntry)
+{
+    auto host = TestHostServices::create();
+    auto original = makeTestAirport(host, 5);
+    AirportPayloadCache cache;
+
+    auto tileSet1 = cache.getTileSet(original);
+    auto tileSet2 = cache.getTileSet(original);
+    EXPECT_EQ(tileSet1, tileSet2);
+    EXPECT_GT(tileSet1->tiles().size(), 0);
+
+    auto reloaded = makeTestAirport(host, 5);
+    auto tileSet3 = cache.getTileSet(reloaded);
+    EXPECT_NE(tileSet3, tileSet1);
+}
+
+TEST(AirportPayloadCacheTest, get_setsAirportDatum)
+{
+    auto host = TestHostServices::create();
+    auto airport = makeTestAirport(host, 2);
+    AirportPayloadCache cache;
+
+    auto entry = cache.get(airport);
+
+    auto message = AirportPayloadCache::parseAirport(*entry);
+    EXPECT_DOUBLE_EQ(message.location().lat(), 30);
+    EXPECT_DOUBLE_EQ(message.location().lon(), 45);
+}
+
+TEST(AirportPayloadCacheTest, get_evictsEntriesOfUnloadedAirports)
+{
+    auto host = TestHostServices::create();
+    auto abcd = TestGridAirport::create(host, "ABCD", 1, 5, 10);
+    auto efgh = TestGridAirport::create(host, "EFGH", 1, 5, 10);
+    AirportPayloadCache cache;
+    cache.getTileSet(abcd);
+    cache.getTileSet(efgh);
+    EXPECT_EQ(cache.size(), 2);
+
+    // the world no longer holds EFGH
+    weak_ptr<const AirportTileSet> efghTileSet = cache.getTileSet(efgh);
+    efgh.reset();
+    cache.get(TestGridAirport::create(host, "IJKL", 1, 5, 10));
+
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_TRUE(efghTileSet.expired());
+    EXPECT_EQ(cache.get(abcd), cache.get(abcd));
+}
@@ -0,0 +1,150 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include "gtest/gtest.h"
+#include "airportTileSet.hpp"
+
+using namespace std;
+using namespace server;
+
+// ~111 meters per 0.001 degree of latitude
+static const double METERS_1000_IN_DEGREES = 1000.0 / 111320.0;
+
+// a straight taxiway going north from the datum, nodes 1 km apart, and a parking stand at its far end
+static shared_ptr<world_proto::Airport> makeTestAirport(int taxiNodeCount)
+{
+    auto airport = make_shared<world_proto::Airport>();
+    airport->set_icao("ABCD");
+    airport->mutable_location()->set_lat(0);
+    airport->mutable_location()->set_lon(45);
+
+    for (int i = 0 ; i < taxiNodeCount ; i++)
+    {
+        auto node = airport->add_taxi_nodes();
+        node->set_id(100 + i);
+        node->mutable_location()->set_lat(i * METERS_1000_IN_DEGREES);
+        node->mutable_location()->set_lon(45);
+        if (i > 0)
+        {
+            auto edge = airport->add_taxi_edges();
+            edge->set_id(1000 + i);
+            edge->set_name("A");
+            edge->set_node_id_1(100 + i - 1);
+            edge->set_node_id_2(100 + i);
+        }
+    }
+
+    auto stand = airport->add_parking_stands();
+    stand->set_id(1);
+    stand->set_name("G1");
+    stand->mutable_location()->set_lat((taxiNodeCount - 1) * METERS_1000_IN_DEGREES);
+    stand->mutable_location()->set_lon(45.0001);
+
+    return airport;
+}
+
+TEST(AirportTileSetTest, tiles_partitionAllElements)
+{
+    AirportTileSet tileSet(makeTestAirport(5), 300);
+
+    ASSERT_EQ(tileSet.tiles().size(), 5);
+
+    int nodeCount = 0;
+    int standCount = 0;
+    for (const auto& tile : tileSet.tiles())
+    {
+        EXPECT_EQ(tile.column, 0);
+        nodeCount += tile.taxiNodeIndexes.size();
+        standCount += tile.parkingStandIndexes.size();
+    }
+    EXPECT_EQ(nodeCount, 5);
+    EXPECT_EQ(standCount, 1);
+
+    // every edge crosses a tile boundary, and is listed in both tiles of its nodes
+    EXPECT_EQ(tileSet.tiles()[0].taxiEdgeIndexes.size(), 1);
+    EXPECT_EQ(tileSet.tiles()[2].taxiEdgeIndexes.size(), 2);
+}
+
+TEST(AirportTileSetTest, getTileOrder_viewportFirstFromItsCenter)
+{
+    AirportTileSet tileSet(makeTestAirport(5), 300);
+
+    // the viewport covers the node 3 and the south edge of the tile of node 4; its center is closer to node 3
+    double south = 2.9 * METERS_1000_IN_DEGREES;
+    double north = 3.9 * METERS_1000_IN_DEGREES;
+    auto order = tileSet.getTileOrder(south, north, 44.99, 45.01);
+
+    ASSERT_EQ(order.size(), 5);
+    EXPECT_EQ(tileSet.tiles()[order[0]].taxiNodeIndexes, vector<int>({ 3 }));
+    EXPECT_EQ(tileSet.tiles()[order[1]].taxiNodeIndexes, vector<int>({ 4 }));
+    EXPECT_EQ(tileSet.tiles()[order[2]].taxiNodeIndexes, vector<int>({ 2 }));
+    EXPECT_EQ(tileSet.tiles()[order[3]].taxiNodeIndexes, vector<int>({ 1 }));
+    EXPECT_EQ(tileSet.tiles()[order[4]].taxiNodeIndexes, vector<int>({ 0 }));
+}
+
+TEST(AirportTileSetTest, forEachTile_sendsEdgesAfterBothNodes)
+{
+    AirportTileSet tileSet(makeTestAirport(5), 300);
+    auto order = tileSet.getTileOrder(0, 0, 45, 45);
+
+    unordered_set<int> receivedNodeIds;
+    unordered_set<int> receivedEdgeIds;
+    int receivedStandCount = 0;
+    int expectedSequence = 0;
+
+    tileSet.forEachTile(order, [&](world_proto::ServerToClient_NotifyAirportTile& tile) {
+        EXPECT_EQ(tile.icao(), "ABCD");
+        EXPECT_EQ(tile.sequence(), expectedSequence++);
+
+        for (const auto& node : tile.taxi_nodes())
+        {
+            receivedNodeIds.insert(node.id());
+        }
+        for (const auto& edge : tile.taxi_edges())
+        {
+            EXPECT_EQ(receivedNodeIds.count(edge.node_id_1()), 1);
+            EXPECT_EQ(receivedNodeIds.count(edge.node_id_2()), 1);
+            EXPECT_EQ(receivedEdgeIds.count(edge.id()), 0);
+            receivedEdgeIds.insert(edge.id());
+        }
+        receivedStandCount += tile.parking_stands_size();
+    });
+
+    EXPECT_EQ(expectedSequence, 5);
+    EXPECT_EQ(receivedNodeIds.size(), 5);
+    EXPECT_EQ(receivedEdgeIds.size(), 4);
+    EXPECT_EQ(receivedStandCount, 1);
+}
+
+TEST(AirportTileSetTest, fillHeader_includesRunwaysAndOutline)
+{
+    auto airport = makeTestAirport(3);
+    auto runway = airport->add_runways();
+    runway->mutable_end_1()->set_name("18");
+    runway->mutable_end_1()->mutable_centerline_point()->set_lat(0);
+    runway->mutable_end_1()->mutable_centerline_point()->set_lon(44.99);
+    runway->mutable_end_2()->set_name("36");
+    runway->mutable_end_2()->mutable_centerline_point()->set_lat(2 * METERS_1000_IN_DEGREES);
+    runway->mutable_end_2()->mutable_centerline_point()->set_lon(44.99);
+
+    AirportTileSet tileSet(airport, 300);
+    world_proto::ServerToClient_ReplyQueryAirportTiles header;
+    tileSet.fillHeader(header);
+
+    EXPECT_EQ(header.icao(), "ABCD");
+    EXPECT_EQ(header.runways_size(), 1);
+    EXPECT_EQ(header.tile_count(), 3);
+    EXPECT_FLOAT_EQ(header.tile_size_meters(), 300);
+
+    // the runway ends, the south end of the taxiway, and the stand; the rest is inside
+    ASSERT_EQ(header.outline_size(), 4);
+    for (const auto& point : header.outline())
+    {
+        EXPECT_FALSE(point.lon() == 45 && point.lat() == METERS_1000_IN_DEGREES);
+    }
+}
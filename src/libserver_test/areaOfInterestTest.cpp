@@ -0,0 +1,144 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libworld_test.h"
+#include "areaOfInterest.hpp"
+#include "protocolConverter.hpp"
+
+using namespace std;
+using namespace world;
+using namespace server;
+
+static vector<int> queryFlightIds(const AircraftGridIndex& index, const AreaOfInterest& area)
+{
+    vector<int> result;
+    index.query(area, [&result](const shared_ptr<Flight>& flight) {
+        result.push_back(flight->id());
+    });
+    sort(result.begin(), result.end());
+    return result;
+}
+
+TEST(AreaOfInterestTest, contains_boxAndAltitudeBand)
+{
+    AreaOfInterest area(40, 42, -75, -72);
+
+    EXPECT_TRUE(area.contains(GeoPoint(41, -73), Altitude::msl(35000)));
+    EXPECT_FALSE(area.contains(GeoPoint(39.9, -73), Altitude::msl(3000)));
+    EXPECT_FALSE(area.contains(GeoPoint(41, -71.9), Altitude::msl(3000)));
+
+    area.setAltitudeBand(0, 10000);
+    EXPECT_TRUE(area.contains(GeoPoint(41, -73), Altitude::msl(3000)));
+    EXPECT_FALSE(area.contains(GeoPoint(41, -73), Altitude::msl(35000)));
+
+    EXPECT_THROW(area.setAltitudeBand(10000, 5000), runtime_error);
+    EXPECT_THROW(AreaOfInterest(42, 40, -75, -72), runtime_error);
+}
+
+TEST(AreaOfInterestTest, contains_acrossAntimeridian)
+{
+    AreaOfInterest area(-20, -10, 175, -175);
+
+    EXPECT_TRUE(area.crossesAntimeridian());
+    EXPECT_DOUBLE_EQ(area.longitudeSpan(), 10);
+    EXPECT_NEAR(area.center().longitude, 180, 0.0001);
+    EXPECT_TRUE(area.contains(GeoPoint(-15, 179), Altitude::msl(3000)));
+    EXPECT_TRUE(area.contains(GeoPoint(-15, -178), Altitude::msl(3000)));
+    EXPECT_FALSE(area.contains(GeoPoint(-15, 170), Altitude::msl(3000)));
+}
+
+TEST(AreaOfInterestTest, getUpdateInterval_byDistanceFromCenter)
+{
+    AreaOfInterest area(40, 42, -75, -72, {
+        { 100, chrono::milliseconds(1000) },
+        { 20, chrono::milliseconds(0) },
+        { 50, chrono::milliseconds(500) }
+    });
+
+    EXPECT_EQ(area.getUpdateInterval(area.center()).count(), 0);
+    // about 30 nm north of the center
+    EXPECT_EQ(area.getUpdateInterval(GeoPoint(area.center().latitude + 0.5, area.center().longitude)).count(), 500);
+    // about 60 nm
+    EXPECT_EQ(area.getUpdateInterval(GeoPoint(area.center().latitude + 1.0, area.center().longitude)).count(), 1000);
+    // beyond the last tier
+    EXPECT_EQ(area.getUpdateInterval(GeoPoint(area.center().latitude + 5.0, area.center().longitude)).count(), 1000);
+
+    EXPECT_EQ(AreaOfInterest(40, 42, -75, -72).getUpdateInterval(GeoPoint(42, -72)).count(), 0);
+}
+
+TEST(AreaOfInterestTest, index_queriesOnlyOverlappingCells)
+{
+    auto host = TestHostServices::createWithWorld();
+    AircraftGridIndex index;
+    index.update(host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000)).ptr);
+    index.update(host->addIfrFlight(102, "KJFK", "KBOS", GeoPoint(42.3, -71.0), Altitude::msl(5000)).ptr);
+    index.update(host->addIfrFlight(103, "NZAA", "NFFN", GeoPoint(-15, 179.5), Altitude::msl(35000)).ptr);
+    index.update(host->addIfrFlight(104, "NZAA", "NFFN", GeoPoint(-15, -179.5), Altitude::msl(35000)).ptr);
+    EXPECT_EQ(index.size(), 4);
+
+    EXPECT_EQ(queryFlightIds(index, AreaOfInterest(40, 41, -74, -73)), vector<int>({ 101 }));
+    EXPECT_EQ(queryFlightIds(index, AreaOfInterest(40, 43, -75, -70)), vector<int>({ 101, 102 }));
+    EXPECT_EQ(queryFlightIds(index, AreaOfInterest(-20, -10, 179, -179)), vector<int>({ 103, 104 }));
+
+    AreaOfInterest lowAltitude(-90, 90, -180, 180);
+    lowAltitude.setAltitudeBand(0, 10000);
+    EXPECT_EQ(queryFlightIds(index, lowAltitude), vector<int>({ 101, 102 }));
+}
+
+TEST(AreaOfInterestTest, index_followsMovingAircraft)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    AircraftGridIndex index;
+    index.update(flight.ptr);
+
+    AreaOfInterest jfk(40, 41, -74, -73);
+    AreaOfInterest bos(42, 43, -72, -70);
+
+    flight.aircraft->setLocation(GeoPoint(42.3, -71.0));
+    EXPECT_EQ(queryFlightIds(index, bos), vector<int>());
+    index.update(flight.ptr);
+    EXPECT_EQ(queryFlightIds(index, jfk), vector<int>());
+    EXPECT_EQ(queryFlightIds(index, bos), vector<int>({ 101 }));
+
+    index.remove(101);
+    EXPECT_EQ(queryFlightIds(index, bos), vector<int>());
+    EXPECT_EQ(index.size(), 0);
+}
+
+TEST(AreaOfInterestTest, fromMessage_takesBoxFromCorners)
+{
+    world_proto::ClientToServer_SubscribeWorldChanges message;
+    const auto setCorner = [](world_proto::GeoPoint* corner, double lat, double lon) {
+        corner->set_lat(lat);
+        corner->set_lon(lon);
+    };
+    setCorner(message.mutable_area()->mutable_north_west(), 42, -75);
+    setCorner(message.mutable_area()->mutable_north_east(), 42, -72);
+    setCorner(message.mutable_area()->mutable_south_west(), 40, -75);
+    setCorner(message.mutable_area()->mutable_south_east(), 40, -72);
+    message.set_has_altitude_band(true);
+    message.set_max_altitude_feet(10000);
+    auto tier = message.add_rate_tiers();
+    tier->set_max_distance_nm(20);
+    tier->set_update_interval_ms(250);
+
+    auto area = ProtocolConverter::fromMessage(message);
+    EXPECT_DOUBLE_EQ(area.south(), 40);
+    EXPECT_DOUBLE_EQ(area.north(), 42);
+    EXPECT_DOUBLE_EQ(area.west(), -75);
+    EXPECT_DOUBLE_EQ(area.east(), -72);
+    EXPECT_FALSE(area.contains(GeoPoint(41, -73), Altitude::msl(12000)));
+    ASSERT_EQ(area.rateTiers().size(), 1);
+    EXPECT_EQ(area.rateTiers()[0].updateInterval.count(), 250);
+
+    tier->set_max_distance_nm(0);
+    EXPECT_THROW(ProtocolConverter::fromMessage(message), runtime_error);
+}
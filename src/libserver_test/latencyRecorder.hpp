@@ -0,0 +1,77 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+// Collects latency samples from any number of threads, and summarizes them into nearest-rank percentiles.
+class LatencyRecorder
+{
+public:
+    struct Summary
+    {
+        size_t count;
+        chrono::microseconds p50;
+        chrono::microseconds p99;
+        chrono::microseconds p999;
+        chrono::microseconds max;
+    };
+private:
+    mutex m_lock;
+    vector<int64_t> m_samplesMicroseconds;
+public:
+
+    void record(chrono::microseconds latency)
+    {
+        lock_guard<mutex> lock(m_lock);
+        m_samplesMicroseconds.push_back(latency.count());
+    }
+
+    size_t count()
+    {
+        lock_guard<mutex> lock(m_lock);
+        return m_samplesMicroseconds.size();
+    }
+
+    Summary summarize()
+    {
+        vector<int64_t> sorted;
+        {
+            lock_guard<mutex> lock(m_lock);
+            sorted = m_samplesMicroseconds;
+        }
+        sort(sorted.begin(), sorted.end());
+
+        return {
+            sorted.size(),
+            percentile(sorted, 0.5),
+            percentile(sorted, 0.99),
+            percentile(sorted, 0.999),
+            chrono::microseconds(sorted.empty() ? 0 : sorted.back())
+        };
+    }
+
+public:
+
+    // the smallest sample which is not exceeded by the given fraction of the samples
+    static chrono::microseconds percentile(const vector<int64_t>& sorted, double fraction)
+    {
+        if (sorted.empty())
+        {
+            return chrono::microseconds(0);
+        }
+
+        size_t rank = (size_t)ceil(fraction * sorted.size());
+        size_t index = min(max(rank, (size_t)1), sorted.size()) - 1;
+        return chrono::microseconds(sorted[index]);
+    }
+};
@@ -0,0 +1,76 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "latencyRecorder.hpp"
+
+using namespace std;
+
+TEST(LatencyRecorderTest, summarize_nearestRankPercentiles)
+{
+    LatencyRecorder recorder;
+    // recorded out of order
+    for (int i = 1000 ; i >= 1 ; i--)
+    {
+        recorder.record(chrono::microseconds(i));
+    }
+
+    auto summary = recorder.summarize();
+
+    EXPECT_EQ(summary.count, 1000);
+    EXPECT_EQ(summary.p50.count(), 500);
+    EXPECT_EQ(summary.p99.count(), 990);
+    EXPECT_EQ(summary.p999.count(), 999);
+    EXPECT_EQ(summary.max.count(), 1000);
+}
+
+TEST(LatencyRecorderTest, summarize_fewSamples)
+{
+    LatencyRecorder empty;
+    auto emptySummary = empty.summarize();
+    EXPECT_EQ(emptySummary.count, 0);
+    EXPECT_EQ(emptySummary.p999.count(), 0);
+
+    LatencyRecorder single;
+    single.record(chrono::microseconds(42));
+    auto singleSummary = single.summarize();
+    EXPECT_EQ(singleSummary.p50.count(), 42);
+    EXPECT_EQ(singleSummary.p999.count(), 42);
+
+    // with fewer than 1000 samples, p999 is the slowest one
+    LatencyRecorder few;
+    for (int i = 1 ; i <= 10 ; i++)
+    {
+        few.record(chrono::microseconds(i * 10));
+    }
+    auto fewSummary = few.summarize();
+    EXPECT_EQ(fewSummary.p50.count(), 50);
+    EXPECT_EQ(fewSummary.p99.count(), 100);
+    EXPECT_EQ(fewSummary.p999.count(), 100);
+}
+
+TEST(LatencyRecorderTest, record_fromSeveralThreads)
+{
+    LatencyRecorder recorder;
+    vector<thread> threads;
+    for (int t = 0 ; t < 4 ; t++)
+    {
+        threads.push_back(thread([&recorder] {
+            for (int i = 0 ; i < 1000 ; i++)
+            {
+                recorder.record(chrono::microseconds(i));
+            }
+        }));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(recorder.count(), 4000);
+}
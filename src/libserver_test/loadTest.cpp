@@ -0,0 +1,344 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+// Load generator: runs the server in-process, connects a number of websocket clients to it,
+// and reports throughput and latency percentiles of every request type.
+//
+// usage: libserver_loadtest [--clients=N] [--seconds=N] [--port=N]
+//                           [--airport-rate=R] [--taxi-path-rate=R] [--situation-rate=R]
+// where rates are requests per second of every client.
+// Situation updates are off by default: the server has no handler for them, and logs an error for each.
+//
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include "libworld.h"
+#include "libserver.hpp"
+#include "libworld_test.h"
+#include "protocolConverter.hpp"
+#include "latencyRecorder.hpp"
+#include "testClient.hpp"
+
+using namespace std;
+using namespace world;
+using namespace server;
+
+static const string LOAD_TEST_ICAO = "LOAD";
+
+struct LoadTestOptions
+{
+    int clientCount = 10;
+    int durationSeconds = 10;
+    int port = 9002;
+    double queryAirportRate = 0.2;
+    double queryTaxiPathRate = 5;
+    double updateSituationRate = 0;
+};
+
+// what was sent, and what came back, of one request type
+struct TrafficStats
+{
+    atomic<int> sentCount;
+    atomic<int> replyCount;
+    LatencyRecorder roundTrip;
+    // from receiving the request to sending the reply, as stamped by the server
+    LatencyRecorder server;
+
+    TrafficStats() : sentCount(0), replyCount(0) { }
+};
+
+struct LoadTestStats
+{
+    TrafficStats queryAirport;
+    TrafficStats queryTaxiPath;
+    // the server has no handler for situation updates yet; they only load the receive path and the error log,
+    // and get no replies
+    TrafficStats updateSituation;
+    atomic<int> faultCount;
+
+    LoadTestStats() : faultCount(0) { }
+};
+
+static bool tryParseOption(const char* arg, const char* name, double& value)
+{
+    size_t nameLength = strlen(name);
+    if (strncmp(arg, name, nameLength) != 0 || arg[nameLength] != '=')
+    {
+        return false;
+    }
+    value = atof(arg + nameLength + 1);
+    return true;
+}
+
+static LoadTestOptions parseOptions(int argc, char** argv)
+{
+    LoadTestOptions options;
+
+    for (int i = 1 ; i < argc ; i++)
+    {
+        double value;
+        if (tryParseOption(argv[i], "--clients", value)) { options.clientCount = max(1, (int)value); }
+        else if (tryParseOption(argv[i], "--seconds", value)) { options.durationSeconds = max(1, (int)value); }
+        else if (tryParseOption(argv[i], "--port", value)) { options.port = (int)value; }
+        else if (tryParseOption(argv[i], "--airport-rate", value)) { options.queryAirportRate = value; }
+        else if (tryParseOption(argv[i], "--taxi-path-rate", value)) { options.queryTaxiPathRate = value; }
+        else if (tryParseOption(argv[i], "--situation-rate", value)) { options.updateSituationRate = value; }
+        else
+        {
+            throw runtime_error(string("unknown option: ") + argv[i]);
+        }
+    }
+
+    return options;
+}
+
+static TrafficStats* tryGetStatsOfReply(const world_proto::ServerToClient& reply, LoadTestStats& stats)
+{
+    switch (reply.payload_case())
+    {
+    case world_proto::ServerToClient::kReplyQueryAirport:
+        return &stats.queryAirport;
+    case world_proto::ServerToClient::kReplyQueryTaxiPath:
+        return &stats.queryTaxiPath;
+    default:
+        return nullptr;
+    }
+}
+
+static void printStats(const string& title, TrafficStats& stats, int durationSeconds)
+{
+    const auto toMs = [](chrono::microseconds value) { return value.count() / 1000.0; };
+    auto roundTrip = stats.roundTrip.summarize();
+    auto server = stats.server.summarize();
+
+    printf(
+        "%-24s %8d %8d %9.1f | %8.2f %8.2f %8.2f %8.2f | %8.2f %8.2f\n",
+        title.c_str(),
+        stats.sentCount.load(),
+        stats.replyCount.load(),
+        (double)stats.replyCount.load() / durationSeconds,
+        toMs(roundTrip.p50),
+        toMs(roundTrip.p99),
+        toMs(roundTrip.p999),
+        toMs(roundTrip.max),
+        toMs(server.p50),
+        toMs(server.p99));
+}
+
+int main(int argc, char** argv)
+{
+    LoadTestOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    printf(
+        "clients[%d] seconds[%d] per client: airport[%.2f/s] taxi-path[%.2f/s] situation[%.2f/s]\n",
+        options.clientCount, options.durationSeconds,
+        options.queryAirportRate, options.queryTaxiPathRate, options.updateSituationRate);
+
+    auto host = TestHostServices::createWithWorld();
+    auto world = host->getWorld();
+    // a square grid of taxiways, so that path searches have something to chew on
+    auto airport = TestGridAirport::create(host, LOAD_TEST_ICAO, 30, 30, 50);
+    world->addAirport(airport);
+
+    vector<GeoPoint> nodeLocations;
+    for (const auto& node : airport->taxiNet()->nodes())
+    {
+        nodeLocations.push_back(node->location().geo());
+    }
+
+    auto controller = ServerControllerInterface::create(host);
+    controller->publishWorldChanges(nullptr);
+    controller->start(options.port);
+    this_thread::sleep_for(chrono::milliseconds(250));
+
+    // the world is only touched here, the way the plugin ticks it
+    atomic<bool> stopRequested(false);
+    thread simThread([&] {
+        while (!stopRequested)
+        {
+            world->progressTo(world->timestamp() + chrono::milliseconds(50));
+            controller->publishWorldChanges(world->hasChanges() ? world->takeChanges() : nullptr);
+            this_thread::sleep_for(chrono::milliseconds(50));
+        }
+    });
+
+    LoadTestStats stats;
+
+    const auto onReply = [&](const world_proto::ServerToClient& reply) {
+        if (reply.reply_to_request_id() == 0)
+        {
+            return;
+        }
+
+        const auto receivedAt = chrono::system_clock::now();
+        TrafficStats* replyStats = tryGetStatsOfReply(reply, stats);
+        if (!replyStats)
+        {
+            stats.faultCount++;
+            return;
+        }
+
+        replyStats->replyCount++;
+        replyStats->roundTrip.record(chrono::duration_cast<chrono::microseconds>(
+            receivedAt - ProtocolConverter::fromMessage(reply.request_sent_at())));
+        replyStats->server.record(chrono::duration_cast<chrono::microseconds>(
+            ProtocolConverter::fromMessage(reply.sent_at()) - ProtocolConverter::fromMessage(reply.request_received_at())));
+    };
+
+    vector<unique_ptr<TestClient>> clients;
+    string uri = "ws://localhost:" + to_string(options.port);
+    for (int i = 0 ; i < options.clientCount ; i++)
+    {
+        clients.push_back(unique_ptr<TestClient>(new TestClient()));
+        clients.back()->setMessageListener(onReply);
+        clients.back()->connect(uri);
+    }
+    for (const auto& client : clients)
+    {
+        while (!client->openState() && !client->failedState())
+        {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        world_proto::ClientToServer hello;
+        hello.mutable_connect()->set_token("HELLO");
+        client->send(hello);
+    }
+
+    atomic<uint64_t> nextRequestId(1);
+    const auto sendRequest = [&](TestClient& client, world_proto::ClientToServer& request, TrafficStats& stats) {
+        request.set_id(nextRequestId++);
+        ProtocolConverter::toMessage(chrono::system_clock::now(), *request.mutable_sent_at());
+        client.send(request);
+        stats.sentCount++;
+    };
+
+    // every client keeps its own schedule of every request type, starting at a random phase
+    const auto startTime = chrono::steady_clock::now();
+    const auto endTime = startTime + chrono::seconds(options.durationSeconds);
+    vector<thread> drivers;
+    for (int i = 0 ; i < options.clientCount ; i++)
+    {
+        drivers.push_back(thread([&, i] {
+            TestClient& client = *clients[i];
+            mt19937 random(i);
+            uniform_real_distribution<double> phase(0, 1);
+            uniform_int_distribution<size_t> pickNode(0, nodeLocations.size() - 1);
+
+            const auto getInterval = [](double rate) {
+                return rate > 0
+                    ? chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / rate))
+                    : chrono::steady_clock::duration::max();
+            };
+            const auto airportInterval = getInterval(options.queryAirportRate);
+            const auto taxiPathInterval = getInterval(options.queryTaxiPathRate);
+            const auto situationInterval = getInterval(options.updateSituationRate);
+            const auto getFirstDue = [&](chrono::steady_clock::duration interval) {
+                return interval == chrono::steady_clock::duration::max()
+                    ? chrono::steady_clock::time_point::max()
+                    : startTime + chrono::duration_cast<chrono::steady_clock::duration>(interval * phase(random));
+            };
+
+            auto nextAirport = getFirstDue(airportInterval);
+            auto nextTaxiPath = getFirstDue(taxiPathInterval);
+            auto nextSituation = getFirstDue(situationInterval);
+
+            try
+            {
+                while (true)
+                {
+                    auto due = min(nextAirport, min(nextTaxiPath, nextSituation));
+                    if (due >= endTime)
+                    {
+                        break;
+                    }
+                    this_thread::sleep_until(due);
+
+                    world_proto::ClientToServer request;
+                    if (due == nextAirport)
+                    {
+                        request.mutable_query_airport()->set_icao_code(LOAD_TEST_ICAO);
+                        request.mutable_query_airport()->set_accept_deflated(true);
+                        sendRequest(client, request, stats.queryAirport);
+                        nextAirport += airportInterval;
+                    }
+                    else if (due == nextTaxiPath)
+                    {
+                        auto query = request.mutable_query_taxi_path();
+                        const auto& from = nodeLocations[pickNode(random)];
+                        const auto& to = nodeLocations[pickNode(random)];
+                        query->set_airport_icao(LOAD_TEST_ICAO);
+                        query->set_aircraft_model_icao("B738");
+                        query->mutable_from_point()->set_lat(from.latitude);
+                        query->mutable_from_point()->set_lon(from.longitude);
+                        query->mutable_to_point()->set_lat(to.latitude);
+                        query->mutable_to_point()->set_lon(to.longitude);
+                        sendRequest(client, request, stats.queryTaxiPath);
+                        nextTaxiPath += taxiPathInterval;
+                    }
+                    else
+                    {
+                        auto update = request.mutable_update_aircraft_situation();
+                        const auto& location = nodeLocations[pickNode(random)];
+                        update->set_aircraft_id(1000 + i);
+                        update->mutable_situation()->mutable_location()->set_lat(location.latitude);
+                        update->mutable_situation()->mutable_location()->set_lon(location.longitude);
+                        sendRequest(client, request, stats.updateSituation);
+                        nextSituation += situationInterval;
+                    }
+                }
+            }
+            catch (const exception& e)
+            {
+                fprintf(stderr, "client[%d] stopped: %s\n", i, e.what());
+            }
+        }));
+    }
+
+    for (auto& driver : drivers)
+    {
+        driver.join();
+    }
+
+    // let the replies in flight arrive
+    this_thread::sleep_for(chrono::seconds(1));
+
+    printf(
+        "\n%-24s %8s %8s %9s | %8s %8s %8s %8s | %8s %8s\n",
+        "request", "sent", "replies", "replies/s",
+        "p50 ms", "p99 ms", "p999 ms", "max ms", "srv p50", "srv p99");
+    printStats("QueryAirport", stats.queryAirport, options.durationSeconds);
+    printStats("QueryTaxiPath", stats.queryTaxiPath, options.durationSeconds);
+    printStats("UpdateAircraftSituation", stats.updateSituation, options.durationSeconds);
+    printf("faults: %d\n", stats.faultCount.load());
+
+    for (const auto& client : clients)
+    {
+        client->disconnect();
+    }
+
+    stopRequested = true;
+    simThread.join();
+
+    controller->beginStop();
+    bool stopped = controller->waitUntilStopped(chrono::milliseconds(5000));
+    return stopped ? 0 : 2;
+}
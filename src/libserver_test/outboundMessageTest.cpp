@@ -0,0 +1,104 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "outboundMessage.hpp"
+
+using namespace std;
+using namespace server;
+
+typedef ConnectionBackpressure::Decision Decision;
+
+static shared_ptr<const OutboundMessage> makeFrame(bool isKeyframe, size_t size = 100)
+{
+    return make_shared<OutboundMessage>(
+        string(size, 'x'),
+        world_proto::ServerToClient::kNotifyWorldChanges,
+        true,
+        isKeyframe);
+}
+
+TEST(OutboundMessageTest, serialize_classifiesWorldChangeFrames)
+{
+    world_proto::ServerToClient delta;
+    delta.mutable_notify_world_changes()->set_frame_number(7);
+    auto deltaMessage = OutboundMessage::serialize(delta);
+
+    EXPECT_TRUE(deltaMessage->isDroppable());
+    EXPECT_FALSE(deltaMessage->isResyncPoint());
+    EXPECT_EQ(deltaMessage->payloadCase(), world_proto::ServerToClient::kNotifyWorldChanges);
+
+    world_proto::ServerToClient parsed;
+    ASSERT_TRUE(parsed.ParseFromString(deltaMessage->dataOnWire()));
+    EXPECT_EQ(parsed.notify_world_changes().frame_number(), 7);
+
+    world_proto::ServerToClient keyframe;
+    keyframe.mutable_notify_world_changes()->set_is_keyframe(true);
+    auto keyframeMessage = OutboundMessage::serialize(keyframe);
+    EXPECT_TRUE(keyframeMessage->isDroppable());
+    EXPECT_TRUE(keyframeMessage->isResyncPoint());
+
+    world_proto::ServerToClient reply;
+    reply.set_id(123);
+    reply.mutable_reply_connect()->set_server_banner("test");
+    auto replyMessage = OutboundMessage::serialize(reply);
+    EXPECT_FALSE(replyMessage->isDroppable());
+    EXPECT_FALSE(replyMessage->isResyncPoint());
+}
+
+TEST(OutboundMessageTest, backpressure_sendsWhileBelowLimit)
+{
+    ConnectionBackpressure backpressure(1000);
+
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::Send);
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 900), Decision::Send);
+    EXPECT_FALSE(backpressure.isOutOfSync());
+    EXPECT_EQ(backpressure.droppedCount(), 0);
+}
+
+TEST(OutboundMessageTest, backpressure_skipsFramesUntilKeyframe)
+{
+    ConnectionBackpressure backpressure(1000);
+
+    // congested
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 950), Decision::Drop);
+    EXPECT_TRUE(backpressure.isOutOfSync());
+
+    // drained, but the client missed a delta: one resync request, the rest is dropped
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::DropAndRequestResync);
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::Drop);
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::Drop);
+
+    EXPECT_EQ(backpressure.admit(*makeFrame(true), 0), Decision::Send);
+    EXPECT_FALSE(backpressure.isOutOfSync());
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::Send);
+    EXPECT_EQ(backpressure.droppedCount(), 4);
+}
+
+TEST(OutboundMessageTest, backpressure_requestsResyncAgainIfKeyframeDropped)
+{
+    ConnectionBackpressure backpressure(1000);
+
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 2000), Decision::Drop);
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::DropAndRequestResync);
+
+    // the keyframe arrived while the connection was congested again
+    EXPECT_EQ(backpressure.admit(*makeFrame(true), 2000), Decision::Drop);
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 2000), Decision::Drop);
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 0), Decision::DropAndRequestResync);
+    EXPECT_EQ(backpressure.admit(*makeFrame(true), 0), Decision::Send);
+}
+
+TEST(OutboundMessageTest, backpressure_alwaysSendsReplies)
+{
+    ConnectionBackpressure backpressure(1000);
+    OutboundMessage reply(string(100, 'x'), world_proto::ServerToClient::kReplyConnect, false, false);
+
+    EXPECT_EQ(backpressure.admit(*makeFrame(false), 5000), Decision::Drop);
+    EXPECT_EQ(backpressure.admit(reply, 5000), Decision::Send);
+    EXPECT_TRUE(backpressure.isOutOfSync());
+}
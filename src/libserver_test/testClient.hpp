@@ -11,6 +11,7 @@
 #include <future>
 #include <atomic>
 #include <mutex>
+#include <functional>
 #include <websocketpp/config/asio_no_tls_client.hpp>
 #include <websocketpp/client.hpp>
 #include "world.pb.h"
@@ -23,6 +24,8 @@ using websocketpp::lib::bind;
 
 class TestClient
 {
+public:
+    typedef function<void(const world_proto::ServerToClient& envelope)> MessageListener;
 private:
 
     typedef websocketpp::client<websocketpp::config::asio_client> Endpoint;
@@ -39,6 +42,7 @@ private:
     atomic<bool> m_closedState;
     atomic<bool> m_failedState;
     mutex m_outputLock;
+    MessageListener m_messageListener;
 public:
 
     TestClient() :
@@ -144,6 +148,13 @@ public:
         EXPECT_FALSE(m_failedState.load());
     }
 
+    // received messages are passed to the listener, on the client thread, instead of being kept;
+    // must be set before connect()
+    void setMessageListener(MessageListener listener)
+    {
+        m_messageListener = listener;
+    }
+
 public:
 
     const atomic<bool>& openState() const { return m_openState; }
@@ -177,10 +188,9 @@ private:
 
     void onMessage(websocketpp::connection_hdl hdl, MessagePtr msg)
     {
-        lock_guard<mutex> lock(m_outputLock);
-
         if (msg->get_opcode() != websocketpp::frame::opcode::binary)
         {
+            lock_guard<mutex> lock(m_outputLock);
             m_errors.push_back("onMessage(): not binary format, ignored");
             return;
         }
@@ -189,10 +199,18 @@ private:
         world_proto::ServerToClient envelope;
         if (!envelope.ParseFromString(dataOnWire))
         {
+            lock_guard<mutex> lock(m_outputLock);
             m_errors.push_back("onMessage(): deserialization failed");
             return;
         }
 
+        if (m_messageListener)
+        {
+            m_messageListener(envelope);
+            return;
+        }
+
+        lock_guard<mutex> lock(m_outputLock);
         m_receivedMessages.push_back(envelope);
     }
 
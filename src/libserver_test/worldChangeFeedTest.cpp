@@ -0,0 +1,413 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <vector>
+#include <chrono>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libworld_test.h"
+#include "worldChangeFeed.hpp"
+
+using namespace std;
+using namespace world;
+using namespace server;
+
+typedef world_proto::ServerToClient_NotifyWorldChanges Frame;
+typedef world_proto::AircraftSituationDelta Delta;
+
+static shared_ptr<WorldChangeFeed> createFeed(shared_ptr<TestHostServices> host)
+{
+    auto feed = make_shared<WorldChangeFeed>(host, chrono::milliseconds(0), 0);
+    // the first frame is a keyframe of an empty world
+    Frame frame;
+    feed->encodeFrame(*host->getWorld(), frame);
+    return feed;
+}
+
+static const Delta* findDelta(const Frame& frame, int aircraftId)
+{
+    for (const auto& delta : frame.situation_deltas())
+    {
+        if (delta.aircraft_id() == aircraftId)
+        {
+            return &delta;
+        }
+    }
+    return nullptr;
+}
+
+TEST(WorldChangeFeedTest, keyframe_includesAllFlightsWithFullSituation)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight1 = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    auto flight2 = host->addIfrFlight(102, "KJFK", "KBOS", GeoPoint(40.7, -73.8), Altitude::ground());
+    flight1.aircraft->setAttitude(AircraftAttitude(90.04, 2.5, -10));
+    flight1.aircraft->setGearState(1.0f);
+
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+    Frame frame;
+    ASSERT_TRUE(feed.encodeFrame(*host->getWorld(), frame));
+
+    EXPECT_TRUE(frame.is_keyframe());
+    EXPECT_EQ(frame.frame_number(), 1);
+    ASSERT_EQ(frame.added_aircraft_size(), 2);
+    ASSERT_EQ(frame.situation_deltas_size(), 2);
+    EXPECT_EQ(frame.removed_aircraft_ids_size(), 0);
+
+    const Delta* delta1 = findDelta(frame, 101);
+    ASSERT_TRUE(delta1);
+    EXPECT_EQ(delta1->field_mask(), 0x1FF);
+    EXPECT_EQ(delta1->lat_delta(), 40600000);
+    EXPECT_EQ(delta1->lon_delta(), -73700000);
+    EXPECT_EQ(delta1->altitude_delta(), 3000);
+    EXPECT_EQ(delta1->heading_delta(), 900);
+    EXPECT_EQ(delta1->pitch_delta(), 25);
+    EXPECT_EQ(delta1->roll_delta(), -100);
+    EXPECT_EQ(delta1->flags(), 0);
+    EXPECT_EQ(delta1->configuration(), 100);
+
+    const Delta* delta2 = findDelta(frame, 102);
+    ASSERT_TRUE(delta2);
+    EXPECT_TRUE(delta2->flags() & WorldChangeFeed::FlagOnGround);
+}
+
+TEST(WorldChangeFeedTest, frame_carriesOnlyChangedFields)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight1 = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    auto flight2 = host->addIfrFlight(102, "KJFK", "KBOS", GeoPoint(40.7, -73.8), Altitude::msl(5000));
+    auto feed = createFeed(host);
+    host->getWorld()->takeChanges();
+
+    flight1.aircraft->setLocation(GeoPoint(40.6001, -73.7));
+    World::ChangeSet changes;
+    changes.mutableFlights().updated(flight1.ptr);
+    changes.mutableFlights().updated(flight2.ptr);
+    feed->accumulate(changes);
+
+    Frame frame;
+    ASSERT_TRUE(feed->encodeFrame(*host->getWorld(), frame));
+
+    EXPECT_FALSE(frame.is_keyframe());
+    EXPECT_EQ(frame.added_aircraft_size(), 0);
+    // the second aircraft was reported as updated, but nothing changed after quantization
+    ASSERT_EQ(frame.situation_deltas_size(), 1);
+    EXPECT_EQ(frame.situation_deltas(0).aircraft_id(), 101);
+    EXPECT_EQ(frame.situation_deltas(0).field_mask(), Delta::FIELD_LOCATION);
+    EXPECT_EQ(frame.situation_deltas(0).lat_delta(), 100);
+    EXPECT_EQ(frame.situation_deltas(0).lon_delta(), 0);
+}
+
+TEST(WorldChangeFeedTest, deltas_addUpWithoutDrift)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    flight.aircraft->setAttitude(AircraftAttitude(359.5, 0, 0));
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+
+    int64_t latitude = 0;
+    int64_t heading = 0;
+    const auto applyFrame = [&](const Frame& frame) {
+        const Delta* delta = findDelta(frame, 101);
+        if (delta && (delta->field_mask() & Delta::FIELD_LOCATION))
+        {
+            latitude += delta->lat_delta();
+        }
+        if (delta && (delta->field_mask() & Delta::FIELD_HEADING))
+        {
+            heading = ((heading + delta->heading_delta()) % 3600 + 3600) % 3600;
+        }
+    };
+
+    Frame keyframe;
+    ASSERT_TRUE(feed.encodeFrame(*host->getWorld(), keyframe));
+    applyFrame(keyframe);
+
+    for (int i = 1 ; i <= 20 ; i++)
+    {
+        // increments below the quantum must still add up
+        flight.aircraft->setLocation(GeoPoint(40.6 + i * 0.00000037, -73.7));
+        flight.aircraft->setAttitude(AircraftAttitude(fmod(359.5 + i * 0.13, 360.0), 0, 0));
+
+        World::ChangeSet changes;
+        changes.mutableFlights().updated(flight.ptr);
+        feed.accumulate(changes);
+
+        Frame frame;
+        if (feed.encodeFrame(*host->getWorld(), frame))
+        {
+            applyFrame(frame);
+        }
+    }
+
+    EXPECT_EQ(latitude, lround((40.6 + 20 * 0.00000037) * 1000000.0));
+    EXPECT_EQ(heading, lround(fmod(359.5 + 20 * 0.13, 360.0) * 10.0));
+}
+
+TEST(WorldChangeFeedTest, heading_deltaTakesShortWayAround)
+{
+    WorldChangeFeed::QuantizedSituation previous;
+    WorldChangeFeed::QuantizedSituation current;
+    previous.heading = 3599;
+    current.heading = 1;
+
+    Delta delta;
+    EXPECT_EQ(WorldChangeFeed::encodeDelta(previous, current, false, delta), Delta::FIELD_HEADING);
+    EXPECT_EQ(delta.heading_delta(), 2);
+
+    Delta reverse;
+    WorldChangeFeed::encodeDelta(current, previous, false, reverse);
+    EXPECT_EQ(reverse.heading_delta(), -2);
+}
+
+TEST(WorldChangeFeedTest, addedAndRemovedFlights)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight1 = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    auto feed = createFeed(host);
+    host->getWorld()->takeChanges();
+
+    auto flight2 = host->addIfrFlight(102, "KJFK", "KBOS", GeoPoint(40.7, -73.8), Altitude::msl(5000));
+    host->getWorld()->removeFlight(flight1.ptr);
+    feed->accumulate(*host->getWorld()->takeChanges());
+
+    Frame frame;
+    ASSERT_TRUE(feed->encodeFrame(*host->getWorld(), frame));
+
+    ASSERT_EQ(frame.removed_aircraft_ids_size(), 1);
+    EXPECT_EQ(frame.removed_aircraft_ids(0), 101);
+    ASSERT_EQ(frame.added_aircraft_size(), 1);
+    EXPECT_EQ(frame.added_aircraft(0).id(), 102);
+    EXPECT_EQ(frame.added_aircraft(0).call_sign(), "TES 102");
+    EXPECT_EQ(frame.added_aircraft(0).model_icao(), "B738");
+    ASSERT_TRUE(findDelta(frame, 102));
+    EXPECT_EQ(findDelta(frame, 102)->lat_delta(), 40700000);
+
+    // an aircraft which came and went between two frames is never reported
+    auto flight3 = host->addIfrFlight(103, "KJFK", "KBOS", GeoPoint(40.8, -73.9), Altitude::msl(7000));
+    host->getWorld()->removeFlight(flight3.ptr);
+    feed->accumulate(*host->getWorld()->takeChanges());
+    Frame nextFrame;
+    EXPECT_FALSE(feed->encodeFrame(*host->getWorld(), nextFrame));
+}
+
+TEST(WorldChangeFeedTest, publish_broadcastsMergedTicks)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    host->getWorld()->takeChanges();
+
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+    vector<world_proto::ServerToClient> broadcasts;
+    feed.publish(*host->getWorld(), nullptr);
+    EXPECT_EQ(broadcasts.size(), 0);
+
+    feed.setBroadcastInterface([&](const world_proto::ServerToClient& envelope) {
+        broadcasts.push_back(envelope);
+    });
+    feed.publish(*host->getWorld(), nullptr);
+    ASSERT_EQ(broadcasts.size(), 1);
+    EXPECT_TRUE(broadcasts[0].notify_world_changes().is_keyframe());
+
+    // nothing changed
+    feed.publish(*host->getWorld(), nullptr);
+    EXPECT_EQ(broadcasts.size(), 1);
+
+    flight.aircraft->setAltitude(Altitude::msl(3100));
+    World::ChangeSet changes;
+    changes.mutableFlights().updated(flight.ptr);
+    feed.publish(*host->getWorld(), &changes);
+    ASSERT_EQ(broadcasts.size(), 2);
+    EXPECT_EQ(broadcasts[1].notify_world_changes().frame_number(), 2);
+    EXPECT_EQ(broadcasts[1].notify_world_changes().situation_deltas(0).altitude_delta(), 100);
+
+    feed.requestKeyframe();
+    feed.publish(*host->getWorld(), nullptr);
+    ASSERT_EQ(broadcasts.size(), 3);
+    EXPECT_TRUE(broadcasts[2].notify_world_changes().is_keyframe());
+    EXPECT_EQ(broadcasts[2].notify_world_changes().added_aircraft_size(), 1);
+}
+
+TEST(WorldChangeFeedTest, subscriber_getsOnlyAircraftInArea)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flightJfk = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    auto flightBos = host->addIfrFlight(102, "KBOS", "KJFK", GeoPoint(42.3, -71.0), Altitude::msl(5000));
+    host->getWorld()->takeChanges();
+
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+    vector<world_proto::ServerToClient> broadcasts;
+    vector<world_proto::ServerToClient> notifications;
+    feed.setBroadcastInterface([&](const world_proto::ServerToClient& envelope) {
+        broadcasts.push_back(envelope);
+    });
+
+    auto client = make_shared<ClientConnection>(1);
+    feed.subscribe(client, AreaOfInterest(40, 41, -74, -73), [&](const world_proto::ServerToClient& envelope) {
+        notifications.push_back(envelope);
+    });
+    feed.publish(*host->getWorld(), nullptr);
+
+    EXPECT_EQ(feed.subscriberCount(), 1);
+    ASSERT_EQ(broadcasts.size(), 1);
+    EXPECT_EQ(broadcasts[0].notify_world_changes().added_aircraft_size(), 2);
+    ASSERT_EQ(notifications.size(), 1);
+    const auto& keyframe = notifications[0].notify_world_changes();
+    EXPECT_TRUE(keyframe.is_keyframe());
+    ASSERT_EQ(keyframe.added_aircraft_size(), 1);
+    EXPECT_EQ(keyframe.added_aircraft(0).id(), 101);
+
+    // the BOS aircraft moves, which the subscriber doesn't care about
+    flightBos.aircraft->setAltitude(Altitude::msl(6000));
+    World::ChangeSet changes1;
+    changes1.mutableFlights().updated(flightBos.ptr);
+    feed.publish(*host->getWorld(), &changes1);
+    EXPECT_EQ(broadcasts.size(), 2);
+    EXPECT_EQ(notifications.size(), 1);
+
+    // the BOS aircraft enters the area, the JFK aircraft leaves
+    flightBos.aircraft->setLocation(GeoPoint(40.9, -73.5));
+    flightJfk.aircraft->setLocation(GeoPoint(39.5, -73.7));
+    World::ChangeSet changes2;
+    changes2.mutableFlights().updated(flightBos.ptr);
+    changes2.mutableFlights().updated(flightJfk.ptr);
+    feed.publish(*host->getWorld(), &changes2);
+
+    ASSERT_EQ(notifications.size(), 2);
+    const auto& frame = notifications[1].notify_world_changes();
+    EXPECT_FALSE(frame.is_keyframe());
+    EXPECT_EQ(frame.frame_number(), 2);
+    ASSERT_EQ(frame.added_aircraft_size(), 1);
+    EXPECT_EQ(frame.added_aircraft(0).id(), 102);
+    ASSERT_EQ(frame.removed_aircraft_ids_size(), 1);
+    EXPECT_EQ(frame.removed_aircraft_ids(0), 101);
+}
+
+TEST(WorldChangeFeedTest, subscriber_farAircraftUpdatedLessOften)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto nearFlight = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(41.0, -73.5), Altitude::msl(3000));
+    auto farFlight = host->addIfrFlight(102, "KJFK", "KBOS", GeoPoint(41.9, -73.5), Altitude::msl(3000));
+    host->getWorld()->takeChanges();
+
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+    vector<world_proto::ServerToClient> notifications;
+    auto client = make_shared<ClientConnection>(1);
+    AreaOfInterest area(40, 42, -75, -72, {
+        { 20, chrono::milliseconds(0) },
+        { 200, chrono::milliseconds(60000) }
+    });
+    feed.subscribe(client, area, [&](const world_proto::ServerToClient& envelope) {
+        notifications.push_back(envelope);
+    });
+    feed.publish(*host->getWorld(), nullptr);
+    ASSERT_EQ(notifications.size(), 1);
+
+    nearFlight.aircraft->setAltitude(Altitude::msl(3100));
+    farFlight.aircraft->setAltitude(Altitude::msl(3100));
+    World::ChangeSet changes;
+    changes.mutableFlights().updated(nearFlight.ptr);
+    changes.mutableFlights().updated(farFlight.ptr);
+    feed.publish(*host->getWorld(), &changes);
+
+    ASSERT_EQ(notifications.size(), 2);
+    const auto& frame = notifications[1].notify_world_changes();
+    ASSERT_EQ(frame.situation_deltas_size(), 1);
+    EXPECT_EQ(frame.situation_deltas(0).aircraft_id(), 101);
+
+    // a resync sends everything in the area, regardless of the tiers
+    feed.requestKeyframe(client->id());
+    feed.publish(*host->getWorld(), nullptr);
+    ASSERT_EQ(notifications.size(), 3);
+    EXPECT_TRUE(notifications[2].notify_world_changes().is_keyframe());
+    EXPECT_EQ(notifications[2].notify_world_changes().added_aircraft_size(), 2);
+}
+
+TEST(WorldChangeFeedTest, subscriber_droppedWhenClientIsGone)
+{
+    auto host = TestHostServices::createWithWorld();
+    host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    host->getWorld()->takeChanges();
+
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+    int notificationCount = 0;
+    auto client1 = make_shared<ClientConnection>(1);
+    auto client2 = make_shared<ClientConnection>(2);
+    const auto notify = [&](const world_proto::ServerToClient& envelope) { notificationCount++; };
+
+    feed.subscribe(client1, AreaOfInterest(40, 41, -74, -73), notify);
+    feed.subscribe(client2, AreaOfInterest(40, 41, -74, -73), notify);
+    feed.publish(*host->getWorld(), nullptr);
+    EXPECT_EQ(feed.subscriberCount(), 2);
+    EXPECT_EQ(notificationCount, 2);
+
+    client1.reset();
+    feed.unsubscribe(client2->id());
+    feed.publish(*host->getWorld(), nullptr);
+    EXPECT_EQ(feed.subscriberCount(), 0);
+    EXPECT_EQ(notificationCount, 2);
+}
+
+TEST(WorldChangeFeedTest, requestKeyframe_resyncsOnlyThatClient)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto flight = host->addIfrFlight(101, "KJFK", "KBOS", GeoPoint(40.6, -73.7), Altitude::msl(3000));
+    host->getWorld()->takeChanges();
+
+    WorldChangeFeed feed(host, chrono::milliseconds(0), 0);
+    vector<world_proto::ServerToClient> broadcasts;
+    vector<world_proto::ServerToClient> notifications1;
+    vector<world_proto::ServerToClient> notifications2;
+    auto client1 = make_shared<ClientConnection>(1);
+    auto client2 = make_shared<ClientConnection>(2);
+    auto broadcastClient = make_shared<ClientConnection>(3);
+
+    feed.setBroadcastInterface([&](const world_proto::ServerToClient& envelope) {
+        broadcasts.push_back(envelope);
+    });
+    feed.subscribe(client1, AreaOfInterest(40, 41, -74, -73), [&](const world_proto::ServerToClient& envelope) {
+        notifications1.push_back(envelope);
+    });
+    feed.subscribe(client2, AreaOfInterest(40, 41, -74, -73), [&](const world_proto::ServerToClient& envelope) {
+        notifications2.push_back(envelope);
+    });
+    feed.publish(*host->getWorld(), nullptr);
+    ASSERT_EQ(broadcasts.size(), 1);
+    ASSERT_EQ(notifications1.size(), 1);
+    ASSERT_EQ(notifications2.size(), 1);
+
+    const auto publishUpdate = [&](int altitude) {
+        flight.aircraft->setAltitude(Altitude::msl(altitude));
+        World::ChangeSet changes;
+        changes.mutableFlights().updated(flight.ptr);
+        feed.publish(*host->getWorld(), &changes);
+    };
+
+    feed.requestKeyframe(client1->id());
+    publishUpdate(3100);
+    ASSERT_EQ(notifications1.size(), 2);
+    ASSERT_EQ(notifications2.size(), 2);
+    ASSERT_EQ(broadcasts.size(), 2);
+    EXPECT_TRUE(notifications1[1].notify_world_changes().is_keyframe());
+    EXPECT_FALSE(notifications2[1].notify_world_changes().is_keyframe());
+    EXPECT_FALSE(broadcasts[1].notify_world_changes().is_keyframe());
+
+    // a client without subscription follows the broadcasts, which resync for everyone who follows them
+    feed.requestKeyframe(broadcastClient->id());
+    publishUpdate(3200);
+    ASSERT_EQ(broadcasts.size(), 3);
+    EXPECT_TRUE(broadcasts[2].notify_world_changes().is_keyframe());
+    EXPECT_FALSE(notifications1[2].notify_world_changes().is_keyframe());
+    EXPECT_FALSE(notifications2[2].notify_world_changes().is_keyframe());
+
+    // e.g. a new connection
+    feed.requestKeyframe();
+    publishUpdate(3300);
+    ASSERT_EQ(broadcasts.size(), 4);
+    EXPECT_TRUE(broadcasts[3].notify_world_changes().is_keyframe());
+    EXPECT_FALSE(notifications1[3].notify_world_changes().is_keyframe());
+    EXPECT_FALSE(notifications2[3].notify_world_changes().is_keyframe());
+}
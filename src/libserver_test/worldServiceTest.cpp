@@ -0,0 +1,196 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libworld_test.h"
+#include "worldService.hpp"
+
+using namespace std;
+using namespace world;
+using namespace server;
+
+// a 5x5 grid of taxiways, 100 meters apart; node ids are 1 + row * 5 + column.
+// With activeZoneRow, the taxiways along that row lie in the departure zone of runway 18/36.
+static shared_ptr<TestHostServices> createHostWithGridAirport(int activeZoneRow = -1)
+{
+    auto host = TestHostServices::createWithWorld();
+    vector<shared_ptr<TaxiNode>> nodes;
+    vector<shared_ptr<TaxiEdge>> edges;
+    TestGridAirport::buildTaxiNet(host, 5, 5, 100, nodes, edges);
+
+    for (const auto& edge : edges)
+    {
+        if (edge->name() == "R" + to_string(activeZoneRow))
+        {
+            WorldBuilder::addActiveZone(edge, "18/36", true, false, false);
+        }
+    }
+
+    const float ground = TestGridAirport::groundElevation();
+    auto runway = shared_ptr<Runway>(new Runway(
+        Runway::End("18", 0, 0, UniPoint::fromLocal(host, { 1000.0f, ground, 0.0f })),
+        Runway::End("36", 0, 0, UniPoint::fromLocal(host, { 1000.0f, ground, 400.0f })),
+        45
+    ));
+
+    Airport::Header header("ABCD", "Test", GeoPoint(30, 45), 123);
+    host->getWorld()->addAirport(WorldBuilder::assembleAirport(host, header, { runway }, {}, nodes, edges));
+    return host;
+}
+
+static shared_ptr<WorldService> createService(shared_ptr<TestHostServices> host)
+{
+    auto snapshots = make_shared<WorldSnapshotPublisher>();
+    snapshots->publish(*host->getWorld());
+    return make_shared<WorldService>(host, make_shared<WorldChangeFeed>(host), snapshots);
+}
+
+static void addPair(world_proto::ClientToServer_QueryTaxiPaths& request, const GeoPoint& from, const GeoPoint& to)
+{
+    auto pair = request.add_pairs();
+    pair->mutable_from_point()->set_lat(from.latitude);
+    pair->mutable_from_point()->set_lon(from.longitude);
+    pair->mutable_to_point()->set_lat(to.latitude);
+    pair->mutable_to_point()->set_lon(to.longitude);
+}
+
+TEST(WorldServiceTest, queryTaxiPaths_sameAsQueryTaxiPath)
+{
+    auto host = createHostWithGridAirport();
+    auto service = createService(host);
+    auto taxiNet = host->getWorld()->getAirport("ABCD")->taxiNet();
+    const auto nodeLocation = [&](int nodeId) { return taxiNet->getNodeById(nodeId)->location().geo(); };
+
+    // three pairs from node 1, and one from node 25
+    world_proto::ClientToServer_QueryTaxiPaths request;
+    request.set_airport_icao("ABCD");
+    addPair(request, nodeLocation(1), nodeLocation(25));
+    addPair(request, nodeLocation(25), nodeLocation(1));
+    addPair(request, nodeLocation(1), nodeLocation(5));
+    addPair(request, nodeLocation(1), nodeLocation(13));
+
+    world_proto::ServerToClient batchReply;
+    service->queryTaxiPaths(request, batchReply);
+
+    ASSERT_EQ(batchReply.payload_case(), world_proto::ServerToClient::kReplyQueryTaxiPaths);
+    ASSERT_EQ(batchReply.reply_query_taxi_paths().results_size(), 4);
+
+    for (int i = 0 ; i < request.pairs_size() ; i++)
+    {
+        world_proto::ClientToServer_QueryTaxiPath single;
+        single.set_airport_icao("ABCD");
+        *single.mutable_from_point() = request.pairs(i).from_point();
+        *single.mutable_to_point() = request.pairs(i).to_point();
+        world_proto::ServerToClient singleReply;
+        service->queryTaxiPath(single, singleReply);
+
+        const auto& batchPath = batchReply.reply_query_taxi_paths().results(i);
+        const auto& singlePath = singleReply.reply_query_taxi_path();
+        EXPECT_TRUE(batchPath.success());
+        EXPECT_EQ(batchPath.taxi_path().from_node_id(), singlePath.taxi_path().from_node_id());
+        EXPECT_EQ(batchPath.taxi_path().to_node_id(), singlePath.taxi_path().to_node_id());
+        // paths of equal length may go different ways around the grid
+        EXPECT_EQ(batchPath.taxi_path().edge_ids_size(), singlePath.taxi_path().edge_ids_size());
+    }
+
+    EXPECT_EQ(batchReply.reply_query_taxi_paths().results(0).taxi_path().edge_ids_size(), 8);
+    EXPECT_EQ(batchReply.reply_query_taxi_paths().results(2).taxi_path().edge_ids_size(), 4);
+}
+
+TEST(WorldServiceTest, queryTaxiPaths_faults)
+{
+    auto host = createHostWithGridAirport();
+    auto service = createService(host);
+
+    world_proto::ClientToServer_QueryTaxiPaths unknownAirport;
+    unknownAirport.set_airport_icao("EFGH");
+    addPair(unknownAirport, GeoPoint(30, 45), GeoPoint(30, 45));
+    world_proto::ServerToClient notFoundReply;
+    service->queryTaxiPaths(unknownAirport, notFoundReply);
+    EXPECT_EQ(notFoundReply.payload_case(), world_proto::ServerToClient::kFaultNotFound);
+
+    world_proto::ClientToServer_QueryTaxiPaths tooMany;
+    tooMany.set_airport_icao("ABCD");
+    for (int i = 0 ; i <= WorldService::maxTaxiPathBatchSize ; i++)
+    {
+        addPair(tooMany, GeoPoint(30, 45), GeoPoint(30, 45));
+    }
+    world_proto::ServerToClient declinedReply;
+    service->queryTaxiPaths(tooMany, declinedReply);
+    EXPECT_EQ(declinedReply.payload_case(), world_proto::ServerToClient::kFaultDeclined);
+}
+
+TEST(WorldServiceTest, queryTaxiPaths_avoidActiveZones)
+{
+    auto host = createHostWithGridAirport(0);
+    auto service = createService(host);
+    auto taxiNet = host->getWorld()->getAirport("ABCD")->taxiNet();
+    const auto nodeLocation = [&](int nodeId) { return taxiNet->getNodeById(nodeId)->location().geo(); };
+
+    world_proto::ClientToServer_QueryTaxiPaths request;
+    request.set_airport_icao("ABCD");
+    addPair(request, nodeLocation(1), nodeLocation(5));
+
+    world_proto::ServerToClient shortestReply;
+    service->queryTaxiPaths(request, shortestReply);
+
+    request.set_cost_profile(world_proto::ClientToServer_QueryTaxiPaths::COST_PROFILE_AVOID_ACTIVE_ZONES);
+    world_proto::ServerToClient avoidingReply;
+    service->queryTaxiPaths(request, avoidingReply);
+
+    ASSERT_EQ(shortestReply.reply_query_taxi_paths().results_size(), 1);
+    ASSERT_EQ(avoidingReply.reply_query_taxi_paths().results_size(), 1);
+    const auto& shortestPath = shortestReply.reply_query_taxi_paths().results(0).taxi_path();
+    const auto& avoidingPath = avoidingReply.reply_query_taxi_paths().results(0).taxi_path();
+
+    // straight along row 0, versus down to row 1, along it, and back up
+    EXPECT_EQ(shortestPath.edge_ids_size(), 4);
+    EXPECT_EQ(avoidingPath.edge_ids_size(), 6);
+    EXPECT_EQ(avoidingPath.from_node_id(), 1);
+    EXPECT_EQ(avoidingPath.to_node_id(), 5);
+}
+
+TEST(WorldServiceTest, queryTaxiPaths_largeBatchesFromSeveralThreads)
+{
+    auto host = createHostWithGridAirport();
+    auto service = createService(host);
+    auto taxiNet = host->getWorld()->getAirport("ABCD")->taxiNet();
+    const auto nodeLocation = [&](int nodeId) { return taxiNet->getNodeById(nodeId)->location().geo(); };
+
+    const int batchSize = WorldService::maxTaxiPathBatchSize;
+    world_proto::ClientToServer_QueryTaxiPaths request;
+    request.set_airport_icao("ABCD");
+    for (int i = 0 ; i < batchSize ; i++)
+    {
+        addPair(request, nodeLocation(1 + i % 25), nodeLocation(25 - i % 25));
+    }
+
+    vector<world_proto::ServerToClient> replies(4);
+    vector<thread> threads;
+    for (auto& reply : replies)
+    {
+        threads.emplace_back([&service, &request, &reply]() {
+            service->queryTaxiPaths(request, reply);
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (const auto& reply : replies)
+    {
+        ASSERT_EQ(reply.reply_query_taxi_paths().results_size(), batchSize);
+        for (int i = 0 ; i < batchSize ; i++)
+        {
+            EXPECT_TRUE(reply.reply_query_taxi_paths().results(i).success()) << i;
+        }
+    }
+}
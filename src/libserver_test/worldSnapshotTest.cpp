@@ -0,0 +1,122 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <atomic>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libworld_test.h"
+#include "worldSnapshot.hpp"
+
+using namespace std;
+using namespace world;
+using namespace server;
+
+static shared_ptr<Airport> makeTestAirport(shared_ptr<HostServices> host, const string& icao)
+{
+    return TestGridAirport::create(host, icao, 1, 2, 100);
+}
+
+TEST(WorldSnapshotTest, publish_capturesAirportsOnlyWhenChanged)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto world = host->getWorld();
+    auto abcd = makeTestAirport(host, "ABCD");
+    world->addAirport(abcd);
+    WorldSnapshotPublisher publisher;
+
+    EXPECT_FALSE(publisher.tryGetCurrent());
+    EXPECT_THROW(publisher.getCurrent(), runtime_error);
+
+    EXPECT_TRUE(publisher.publish(*world));
+    auto snapshot1 = publisher.getCurrent();
+    EXPECT_EQ(snapshot1->generation(), 1);
+    EXPECT_EQ(snapshot1->getAirport("ABCD"), abcd);
+    EXPECT_THROW(snapshot1->getAirport("EFGH"), runtime_error);
+
+    EXPECT_FALSE(publisher.publish(*world));
+    EXPECT_EQ(publisher.getCurrent(), snapshot1);
+}
+
+TEST(WorldSnapshotTest, publish_leavesPreviousSnapshotIntact)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto world = host->getWorld();
+    auto oldAbcd = makeTestAirport(host, "ABCD");
+    world->addAirport(oldAbcd);
+    WorldSnapshotPublisher publisher;
+    publisher.publish(*world);
+    auto snapshot1 = publisher.getCurrent();
+
+    auto newAbcd = makeTestAirport(host, "ABCD");
+    world->reloadAirport("ABCD", [=](const string& icao, shared_ptr<ControlledAirspace> airspace) {
+        return newAbcd;
+    });
+    world->addAirport(makeTestAirport(host, "EFGH"));
+    world->progressTo(chrono::seconds(1));
+
+    EXPECT_TRUE(publisher.publish(*world));
+    auto snapshot2 = publisher.getCurrent();
+
+    EXPECT_EQ(snapshot2->generation(), 2);
+    EXPECT_EQ(snapshot2->getAirport("ABCD"), newAbcd);
+    EXPECT_EQ(snapshot2->airports().size(), 2);
+
+    EXPECT_EQ(snapshot1->getAirport("ABCD"), oldAbcd);
+    EXPECT_EQ(snapshot1->airports().size(), 1);
+    EXPECT_THROW(snapshot1->getAirport("EFGH"), runtime_error);
+}
+
+TEST(WorldSnapshotTest, readersRunConcurrentlyWithPublisher)
+{
+    auto host = TestHostServices::createWithWorld();
+    auto world = host->getWorld();
+    world->addAirport(makeTestAirport(host, "A000"));
+    WorldSnapshotPublisher publisher;
+    publisher.publish(*world);
+
+    atomic<bool> stopRequested(false);
+    atomic<int> failureCount(0);
+    vector<thread> readers;
+
+    for (int i = 0 ; i < 4 ; i++)
+    {
+        readers.push_back(thread([&] {
+            uint64_t lastGeneration = 0;
+            while (!stopRequested)
+            {
+                auto snapshot = publisher.getCurrent();
+                bool isValid =
+                    snapshot->generation() >= lastGeneration &&
+                    snapshot->airports().size() == snapshot->generation() &&
+                    snapshot->getAirport("A000")->taxiNet()->edges().size() == 1;
+                if (!isValid)
+                {
+                    failureCount++;
+                }
+                lastGeneration = snapshot->generation();
+            }
+        }));
+    }
+
+    for (int i = 1 ; i < 100 ; i++)
+    {
+        char icao[8];
+        snprintf(icao, sizeof(icao), "A%03d", i);
+        world->addAirport(makeTestAirport(host, icao));
+        publisher.publish(*world);
+    }
+
+    stopRequested = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(failureCount, 0);
+    EXPECT_EQ(publisher.getCurrent()->generation(), 100);
+}
@@ -50,9 +50,13 @@ namespace world
         if (m_frequency)
         {
             m_frequencyKhz = m_frequency->khz();
-            m_frequencyListenerId = m_frequency->addListener([=](shared_ptr<Intent> intent) {
-                m_onCommTransmission(intent);
-            });
+            m_frequencyListenerId = m_frequency->addListener(
+                [=](shared_ptr<Intent> intent) {
+                    m_onCommTransmission(intent);
+                },
+                [this]() {
+                    return Frequency::RadioPosition({ location(), Frequency::getRadioHeightFeet(altitude()) });
+                });
         }
 
         auto flightPtr = m_flight.lock();
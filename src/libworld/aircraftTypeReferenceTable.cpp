@@ -8,6 +8,7 @@
 
 #include "libworld.h"
 #include "aircraftTypeReferenceTable.hpp"
+#include "referenceTableIndex.hpp"
 
 //TODO: complete all callsigns
 //      reference: https://en.wikipedia.org/wiki/List_of_aircraft_type_designators
@@ -358,53 +359,46 @@ using namespace std;
 
 namespace world
 {
-    bool AircraftTypeReferenceTable::tryFindByIcao(const string& icao, AircraftTypeReferenceTable::Entry& entry)
+    typedef ReferenceTableIndex<AircraftTypeReferenceTable::EntryRef, 3> AircraftTypeTableIndex;
+
+    static const AircraftTypeTableIndex& getAircraftTypeTableIndex()
+    {
+        // columns: icao, name, callsign; types without a callsign are called by name
+        static const AircraftTypeTableIndex index(
+            globalAircraftTypeTable,
+            AIRCRAFT_TYPE_TABLE_SIZE,
+            [](const AircraftTypeTableIndex::Row& row) {
+                return AircraftTypeReferenceTable::EntryRef({ row[0], row[1], row[2].empty() ? row[1] : row[2] });
+            });
+        return index;
+    }
+
+    const AircraftTypeReferenceTable::EntryRef* AircraftTypeReferenceTable::findByIcao(const char* icao, size_t length)
     {
-        const char *icaoPtr = icao.c_str();
+        return getAircraftTypeTableIndex().tryFind(icao, length);
+    }
 
-        for (int i = 0 ; i < AIRCRAFT_TYPE_TABLE_SIZE ; i++)
+    bool AircraftTypeReferenceTable::tryFindByIcao(const string& icao, AircraftTypeReferenceTable::Entry& entry)
+    {
+        const EntryRef* found = findByIcao(icao);
+        if (!found)
         {
-            const char *rowPtr = globalAircraftTypeTable[i];
-            if (strstr(rowPtr, icaoPtr) == rowPtr)
-            {
-                parseEntry(rowPtr, entry);
-                return true;
-            }
+            return false;
         }
 
-        return false;
+        entry.icao = found->icao.str();
+        entry.name = found->name.str();
+        entry.callsign = found->callsign.str();
+        return true;
     }
 
-    void AircraftTypeReferenceTable::parseEntry(const char *rowPtr, AircraftTypeReferenceTable::Entry &entry)
+    int AircraftTypeReferenceTable::rowCount()
     {
-        int column = 0;
-        string *destPtr = &entry.icao;
-
-        for (int i = 0 ; rowPtr[i] != 0 ; i++)
-        {
-            char c = rowPtr[i];
-            if (c != ',')
-            {
-                *destPtr += c;
-                continue;
-            }
-
-            switch (++column)
-            {
-            case 1:
-                destPtr = &entry.name;
-                break;
-            case 2:
-                destPtr = &entry.callsign;
-                break;
-            default:
-                return;
-            }
-        }
+        return AIRCRAFT_TYPE_TABLE_SIZE;
+    }
 
-        if (entry.callsign.empty())
-        {
-            entry.callsign = entry.name;
-        }
+    const char* AircraftTypeReferenceTable::getRow(int index)
+    {
+        return globalAircraftTypeTable[index];
     }
 }
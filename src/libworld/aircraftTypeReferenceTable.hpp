@@ -19,9 +19,20 @@ namespace world
             string name;
             string callsign;
         };
+        struct EntryRef
+        {
+            StringRef icao;
+            StringRef name;
+            StringRef callsign;
+        };
     public:
+        // does not allocate; returns nullptr if not found
+        static const EntryRef* findByIcao(const char* icao, size_t length);
+        static const EntryRef* findByIcao(const string& icao) { return findByIcao(icao.c_str(), icao.length()); }
+
         static bool tryFindByIcao(const string& icao, Entry& entry);
-    private:
-        static void parseEntry(const char *rowPtr, Entry& entry);
+
+        static int rowCount();
+        static const char* getRow(int index);
     };
 }
@@ -5,9 +5,11 @@
 
 #include <string>
 #include <memory>
+#include <algorithm>
 
 #include "libworld.h"
 #include "airlineReferenceTable.hpp"
+#include "referenceTableIndex.hpp"
 
 //TODO: replace all country names with ICAO region code
 //      reference: https://en.wikipedia.org/wiki/ICAO_airport_code
@@ -6124,23 +6126,37 @@ using namespace std;
 
 namespace world
 {
+    typedef ReferenceTableIndex<AirlineReferenceTable::EntryRef, 4> AirlineTableIndex;
+
+    static const AirlineTableIndex& getAirlineTableIndex()
+    {
+        // columns: icao, callsign, name, region
+        static const AirlineTableIndex index(
+            globalAirlineTable,
+            AIRLINE_TABLE_SIZE,
+            [](const AirlineTableIndex::Row& row) {
+                return AirlineReferenceTable::EntryRef({ row[0], row[1], row[2], row[3] });
+            });
+        return index;
+    }
+
+    const AirlineReferenceTable::EntryRef* AirlineReferenceTable::findByIcao(const char* icao, size_t length)
+    {
+        return getAirlineTableIndex().tryFind(icao, length);
+    }
+
     bool AirlineReferenceTable::tryFindByIcao(
         const string& icao,
         AirlineReferenceTable::Entry& entry)
     {
-        const char *icaoPtr = icao.c_str();
-
-        for (int i = 0 ; i < AIRLINE_TABLE_SIZE ; i++)
+        const EntryRef* found = findByIcao(icao);
+        if (!found)
         {
-            const char *rowPtr = globalAirlineTable[i];
-            if (strstr(rowPtr, icaoPtr) == rowPtr)
-            {
-                parseEntry(rowPtr, entry);
-                return true;
-            }
+            return false;
         }
 
-        return false;
+        copyEntry(*found, entry);
+        return true;
     }
 
     bool AirlineReferenceTable::tryFindByFlightNumber(
@@ -6148,42 +6164,33 @@ namespace world
         AirlineReferenceTable::Entry& entry,
         string& flightCallsign)
     {
-        string icao = flightNo.substr(0, 3);
-        bool found = tryFindByIcao(icao, entry);
-        flightCallsign = found
-            ? entry.callsign + " " + flightNo.substr(3)
-            : "";
-        return found;
+        const EntryRef* found = findByIcao(flightNo.c_str(), min<size_t>(3, flightNo.length()));
+        if (!found)
+        {
+            flightCallsign = "";
+            return false;
+        }
+
+        copyEntry(*found, entry);
+        flightCallsign = entry.callsign + " " + flightNo.substr(3);
+        return true;
     }
 
-    void AirlineReferenceTable::parseEntry(const char *rowPtr, AirlineReferenceTable::Entry &entry)
+    void AirlineReferenceTable::copyEntry(const EntryRef& source, Entry& entry)
     {
-        int column = 0;
-        string *destPtr = &entry.icao;
+        entry.icao = source.icao.str();
+        entry.callsign = source.callsign.str();
+        entry.name = source.name.str();
+        entry.regionIcao = source.regionIcao.str();
+    }
 
-        for (int i = 0 ; rowPtr[i] != 0 ; i++)
-        {
-            char c = rowPtr[i];
-            if (c != ',')
-            {
-                *destPtr += c;
-                continue;
-            }
+    int AirlineReferenceTable::rowCount()
+    {
+        return AIRLINE_TABLE_SIZE;
+    }
 
-            switch (++column)
-            {
-            case 1:
-                destPtr = &entry.callsign;
-                break;
-            case 2:
-                destPtr = &entry.name;
-                break;
-            case 3:
-                destPtr = &entry.regionIcao;
-                break;
-            default:
-                return;
-            }
-        }
+    const char* AirlineReferenceTable::getRow(int index)
+    {
+        return globalAirlineTable[index];
     }
 }
@@ -20,7 +20,18 @@ namespace world
             string callsign;
             string regionIcao;
         };
+        struct EntryRef
+        {
+            StringRef icao;
+            StringRef callsign;
+            StringRef name;
+            StringRef regionIcao;
+        };
     public:
+        // does not allocate; returns nullptr if not found
+        static const EntryRef* findByIcao(const char* icao, size_t length);
+        static const EntryRef* findByIcao(const string& icao) { return findByIcao(icao.c_str(), icao.length()); }
+
         static bool tryFindByIcao(
             const string& icao,
             Entry& entry);
@@ -29,7 +40,10 @@ namespace world
             const string& flightNo,
             Entry& entry,
             string& flightCallsign);
+
+        static int rowCount();
+        static const char* getRow(int index);
     private:
-        static void parseEntry(const char *rowPtr, Entry& entry);
+        static void copyEntry(const EntryRef& source, Entry& entry);
     };
 }
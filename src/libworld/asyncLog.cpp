@@ -0,0 +1,465 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <stdexcept>
+#include "libworld.h"
+#include "asyncLog.hpp"
+
+using namespace std;
+
+namespace world
+{
+    static size_t alignRecordSize(size_t size)
+    {
+        return (size + 7) & ~(size_t)7;
+    }
+
+    AsyncLog::Ring::Ring(size_t _capacity) :
+        m_capacity(_capacity),
+        m_buffer(new char[_capacity]),
+        m_writePosition(0),
+        m_readPosition(0),
+        m_droppedCount(0)
+    {
+    }
+
+    char* AsyncLog::Ring::beginWrite(size_t size)
+    {
+        const size_t alignedSize = alignRecordSize(size);
+        size_t write = m_writePosition.load(memory_order_relaxed);
+        const size_t read = m_readPosition.load(memory_order_acquire);
+        size_t offset = write & (m_capacity - 1);
+        const size_t contiguous = m_capacity - offset;
+
+        if (alignedSize <= contiguous)
+        {
+            return (write - read) + alignedSize <= m_capacity
+                ? m_buffer.get() + offset
+                : nullptr;
+        }
+
+        if ((write - read) + contiguous + alignedSize > m_capacity)
+        {
+            return nullptr;
+        }
+
+        // the record doesn't fit before the end of the ring: mark a wrap and start over
+        uint32_t wrapMarker = 0;
+        memcpy(m_buffer.get() + offset, &wrapMarker, sizeof(wrapMarker));
+        m_writePosition.store(write + contiguous, memory_order_release);
+        return m_buffer.get();
+    }
+
+    void AsyncLog::Ring::endWrite(size_t size)
+    {
+        const size_t write = m_writePosition.load(memory_order_relaxed);
+        m_writePosition.store(write + alignRecordSize(size), memory_order_release);
+    }
+
+    const char* AsyncLog::Ring::beginRead(size_t& size)
+    {
+        size_t read = m_readPosition.load(memory_order_relaxed);
+        const size_t write = m_writePosition.load(memory_order_acquire);
+
+        while (read != write)
+        {
+            const size_t offset = read & (m_capacity - 1);
+            uint32_t recordSize;
+            memcpy(&recordSize, m_buffer.get() + offset, sizeof(recordSize));
+
+            if (recordSize > 0)
+            {
+                size = recordSize;
+                return m_buffer.get() + offset;
+            }
+
+            read += m_capacity - offset;
+            m_readPosition.store(read, memory_order_release);
+        }
+
+        return nullptr;
+    }
+
+    void AsyncLog::Ring::endRead(size_t size)
+    {
+        const size_t read = m_readPosition.load(memory_order_relaxed);
+        m_readPosition.store(read + alignRecordSize(size), memory_order_release);
+    }
+
+    bool AsyncLog::Ring::empty() const
+    {
+        return m_readPosition.load(memory_order_acquire) == m_writePosition.load(memory_order_acquire);
+    }
+
+    static atomic<uint64_t> nextAsyncLogId(1);
+
+    AsyncLog::AsyncLog(SinkCallback _sink, size_t _ringCapacity, bool _runConsumerThread) :
+        m_id(nextAsyncLogId++),
+        m_ringCapacity(_ringCapacity),
+        m_startTime(chrono::steady_clock::now()),
+        m_sink(std::move(_sink)),
+        m_hasNewRings(false),
+        m_consumerStarted(false),
+        m_stopRequested(false),
+        m_runConsumerThread(_runConsumerThread)
+    {
+        if (_ringCapacity < 256 || (_ringCapacity & (_ringCapacity - 1)) != 0)
+        {
+            throw runtime_error("AsyncLog: ring capacity must be a power of two, at least 256");
+        }
+        for (auto& level : m_levelByCategory)
+        {
+            level = (int)Level::Info;
+        }
+    }
+
+    AsyncLog::~AsyncLog()
+    {
+        stop();
+    }
+
+    void AsyncLog::setLevel(Category category, Level level)
+    {
+        m_levelByCategory[(int)category].store((int)level, memory_order_relaxed);
+    }
+
+    AsyncLog::Level AsyncLog::getLevel(Category category) const
+    {
+        return (Level)m_levelByCategory[(int)category].load(memory_order_relaxed);
+    }
+
+    void AsyncLog::setAllLevels(Level level)
+    {
+        for (int i = 0 ; i < (int)Category::Count ; i++)
+        {
+            setLevel((Category)i, level);
+        }
+    }
+
+    void AsyncLog::setSink(SinkCallback sink)
+    {
+        lock_guard<mutex> lock(m_sinkMutex);
+        m_sink = std::move(sink);
+    }
+
+    int AsyncLog::drain()
+    {
+        lock_guard<mutex> drainLock(m_drainMutex);
+
+        if (m_hasNewRings.load(memory_order_acquire))
+        {
+            lock_guard<mutex> ringsLock(m_ringsMutex);
+            for (auto& ring : m_newRings)
+            {
+                m_rings.push_back({ std::move(ring), 0 });
+            }
+            m_newRings.clear();
+            m_hasNewRings = false;
+        }
+
+        SinkCallback sink;
+        {
+            lock_guard<mutex> sinkLock(m_sinkMutex);
+            sink = m_sink;
+        }
+
+        int count = 0;
+        string line;
+        line.reserve(512);
+
+        for (auto& entry : m_rings)
+        {
+            size_t size;
+            const char* record;
+
+            while ((record = entry.ring->beginRead(size)) != nullptr)
+            {
+                RecordHeader header;
+                memcpy(&header, record, sizeof(header));
+
+                line.clear();
+                formatRecord(header, record + sizeof(header), line);
+                entry.ring->endRead(size);
+
+                if (sink)
+                {
+                    sink(line.c_str(), line.length());
+                }
+                count++;
+            }
+
+            const uint64_t droppedCount = entry.ring->droppedCount();
+            if (droppedCount > entry.reportedDroppedCount)
+            {
+                char warning[128];
+                int length = snprintf(
+                    warning, sizeof(warning),
+                    "AT&C [+%10lld] ASYNCL|WARNING: dropped %llu log records, ring buffer was full\n",
+                    (long long)HostServices::getLogTimestamp().count(),
+                    (unsigned long long)(droppedCount - entry.reportedDroppedCount));
+                if (sink && length > 0)
+                {
+                    sink(warning, (size_t)length);
+                }
+                entry.reportedDroppedCount = droppedCount;
+            }
+        }
+
+        // rings of threads which have exited are only referenced from here
+        m_rings.erase(
+            remove_if(m_rings.begin(), m_rings.end(), [](const RingEntry& entry) {
+                return entry.ring.use_count() == 1 && entry.ring->empty();
+            }),
+            m_rings.end());
+
+        return count;
+    }
+
+    void AsyncLog::flush()
+    {
+        drain();
+    }
+
+    void AsyncLog::stop()
+    {
+        m_stopRequested = true;
+        if (m_consumerThread.joinable())
+        {
+            m_consumerThread.join();
+        }
+        drain();
+    }
+
+    AsyncLog& AsyncLog::instance()
+    {
+        static AsyncLog log;
+        return log;
+    }
+
+    AsyncLog::Level AsyncLog::parseLevel(const string& name)
+    {
+        static const char* names[] = { "trace", "debug", "info", "warning", "error", "off" };
+        for (int i = 0 ; i <= (int)Level::Off ; i++)
+        {
+            if (name == names[i])
+            {
+                return (Level)i;
+            }
+        }
+        throw runtime_error("AsyncLog: unknown log level '" + name + "'");
+    }
+
+    void AsyncLog::writeToStdout(const char* line, size_t length)
+    {
+        fwrite(line, 1, length, stdout);
+    }
+
+    void AsyncLog::formatMessage(const char* format, const char* arguments, uint32_t argumentCount, string& output)
+    {
+        const char* next = arguments;
+        uint32_t remainingCount = argumentCount;
+        char spec[32];
+        char buffer[512];
+        string stringValue;
+
+        const char* p = format;
+        while (*p)
+        {
+            if (*p != '%')
+            {
+                output += *p++;
+                continue;
+            }
+            if (p[1] == '%')
+            {
+                output += '%';
+                p += 2;
+                continue;
+            }
+
+            const char* specStart = p++;
+            while (*p && strchr("-+ #0", *p))
+            {
+                p++;
+            }
+            while (*p && (isdigit((unsigned char)*p) || *p == '.'))
+            {
+                p++;
+            }
+            const size_t prefixLength = p - specStart;
+            while (*p && strchr("hlLqjzt", *p))
+            {
+                p++;
+            }
+            const char conversion = *p;
+            if (!conversion || prefixLength + 4 > sizeof(spec))
+            {
+                break;
+            }
+            p++;
+
+            if (remainingCount == 0)
+            {
+                output += "<?>";
+                continue;
+            }
+            remainingCount--;
+
+            const char tag = *next;
+            uint64_t rawValue = 0;
+            double doubleValue = 0;
+            const char* stringData = nullptr;
+            uint32_t stringLength = 0;
+
+            if (tag == TagString)
+            {
+                memcpy(&stringLength, next + 1, 4);
+                stringData = next + 5;
+                next += 5 + stringLength;
+            }
+            else
+            {
+                memcpy(&rawValue, next + 1, 8);
+                if (tag == TagDouble)
+                {
+                    memcpy(&doubleValue, &rawValue, 8);
+                }
+                next += 9;
+            }
+
+            memcpy(spec, specStart, prefixLength);
+            int length = 0;
+
+            switch (conversion)
+            {
+            case 's':
+                if (tag == TagString && prefixLength == 1)
+                {
+                    output.append(stringData, stringLength);
+                    continue;
+                }
+                if (tag == TagString)
+                {
+                    stringValue.assign(stringData, stringLength);
+                    strcpy(spec + prefixLength, "s");
+                    length = snprintf(buffer, sizeof(buffer), spec, stringValue.c_str());
+                }
+                else
+                {
+                    strcpy(spec + prefixLength, "lld");
+                    length = snprintf(buffer, sizeof(buffer), spec, (long long)rawValue);
+                }
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec[prefixLength] = conversion;
+                spec[prefixLength + 1] = '\0';
+                length = snprintf(
+                    buffer, sizeof(buffer), spec,
+                    tag == TagDouble ? doubleValue : (tag == TagSigned ? (double)(int64_t)rawValue : (double)rawValue));
+                break;
+            case 'c':
+                strcpy(spec + prefixLength, "c");
+                length = snprintf(buffer, sizeof(buffer), spec, (int)rawValue);
+                break;
+            case 'p':
+                strcpy(spec + prefixLength, "p");
+                length = snprintf(buffer, sizeof(buffer), spec, (void*)(uintptr_t)rawValue);
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                spec[prefixLength] = 'l';
+                spec[prefixLength + 1] = 'l';
+                spec[prefixLength + 2] = conversion;
+                spec[prefixLength + 3] = '\0';
+                length = snprintf(
+                    buffer, sizeof(buffer), spec,
+                    tag == TagDouble ? (unsigned long long)doubleValue : (unsigned long long)rawValue);
+                break;
+            default:
+                strcpy(spec + prefixLength, "lld");
+                length = snprintf(
+                    buffer, sizeof(buffer), spec,
+                    tag == TagDouble ? (long long)doubleValue : (long long)rawValue);
+                break;
+            }
+
+            if (length > 0)
+            {
+                output.append(buffer, min((size_t)length, sizeof(buffer) - 1));
+            }
+        }
+    }
+
+    AsyncLog::Ring& AsyncLog::getThreadRing()
+    {
+        struct ThreadRings
+        {
+            uint64_t lastLogId = 0;
+            Ring* lastRing = nullptr;
+            vector<pair<uint64_t, shared_ptr<Ring>>> ringByLogId;
+        };
+        thread_local ThreadRings threadRings;
+
+        if (threadRings.lastLogId == m_id)
+        {
+            return *threadRings.lastRing;
+        }
+
+        shared_ptr<Ring> ring;
+        for (const auto& entry : threadRings.ringByLogId)
+        {
+            if (entry.first == m_id)
+            {
+                ring = entry.second;
+                break;
+            }
+        }
+
+        if (!ring)
+        {
+            ring = make_shared<Ring>(m_ringCapacity);
+            threadRings.ringByLogId.push_back({ m_id, ring });
+            {
+                lock_guard<mutex> lock(m_ringsMutex);
+                m_newRings.push_back(ring);
+                m_hasNewRings = true;
+            }
+            if (m_runConsumerThread && !m_consumerStarted.exchange(true))
+            {
+                m_consumerThread = thread([this] { runConsumerThread(); });
+            }
+        }
+
+        threadRings.lastLogId = m_id;
+        threadRings.lastRing = ring.get();
+        return *ring;
+    }
+
+    void AsyncLog::runConsumerThread()
+    {
+        while (!m_stopRequested)
+        {
+            if (drain() == 0)
+            {
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        }
+    }
+
+    void AsyncLog::formatRecord(const RecordHeader& header, const char* arguments, string& line)
+    {
+        // the record was written some time ago; stamp it relative to the log start time of HostServices
+        const auto age = chrono::steady_clock::now() - (m_startTime + chrono::nanoseconds(header.timestampNanoseconds));
+        const auto timestamp = HostServices::getLogTimestamp() - chrono::duration_cast<chrono::milliseconds>(age);
+
+        char prefix[32];
+        int prefixLength = snprintf(prefix, sizeof(prefix), "AT&C [+%10lld] ", (long long)timestamp.count());
+        line.append(prefix, prefixLength);
+
+        formatMessage(header.format->text, arguments, header.argumentCount, line);
+        line += '\n';
+    }
+}
@@ -0,0 +1,306 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Trace calls below this level are compiled out entirely;
+// 0 keeps trace calls, 1 removes them. Release builds remove them by default.
+#ifndef ATC_LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define ATC_LOG_COMPILE_LEVEL 1
+#else
+#define ATC_LOG_COMPILE_LEVEL 0
+#endif
+#endif
+
+// Logs into the given AsyncLog; arguments are only evaluated when the level of the category is enabled.
+// The format descriptor is a function-local static, and its address is the format ID of the record.
+#define ATC_LOG_TO(log, category, level, format, ...) \
+    do { \
+        static const ::world::AsyncLog::Format atcLogFormat = { (category), (level), (format) }; \
+        auto& atcLog = (log); \
+        if (atcLog.isEnabled((category), (level))) \
+        { \
+            atcLog.write(&atcLogFormat, ##__VA_ARGS__); \
+        } \
+    } while (false)
+
+#define ATC_LOG(category, level, format, ...) \
+    ATC_LOG_TO(::world::AsyncLog::instance(), category, level, format, ##__VA_ARGS__)
+
+#if ATC_LOG_COMPILE_LEVEL <= 0
+#define ATC_LOG_TRACE(category, format, ...) \
+    ATC_LOG(category, ::world::AsyncLog::Level::Trace, format, ##__VA_ARGS__)
+#else
+#define ATC_LOG_TRACE(category, format, ...) do { } while (false)
+#endif
+
+#define ATC_LOG_DEBUG(category, format, ...) \
+    ATC_LOG(category, ::world::AsyncLog::Level::Debug, format, ##__VA_ARGS__)
+#define ATC_LOG_INFO(category, format, ...) \
+    ATC_LOG(category, ::world::AsyncLog::Level::Info, format, ##__VA_ARGS__)
+#define ATC_LOG_WARNING(category, format, ...) \
+    ATC_LOG(category, ::world::AsyncLog::Level::Warning, format, ##__VA_ARGS__)
+#define ATC_LOG_ERROR(category, format, ...) \
+    ATC_LOG(category, ::world::AsyncLog::Level::Error, format, ##__VA_ARGS__)
+
+namespace world
+{
+    // Low-overhead logging for hot paths. A log call copies a pointer to its static format
+    // descriptor, a timestamp and the raw arguments into a ring buffer owned by the calling thread,
+    // and returns; printf-style formatting is deferred to a background thread, which drains
+    // the rings and passes formatted lines to the sink. When a ring is full, records are dropped
+    // and counted rather than blocking the caller.
+    //
+    // Records of one thread are delivered in order; records of different threads may interleave.
+    class AsyncLog
+    {
+    public:
+        enum class Level
+        {
+            Trace = 0,
+            Debug = 1,
+            Info = 2,
+            Warning = 3,
+            Error = 4,
+            Off = 5
+        };
+        enum class Category
+        {
+            General = 0,
+            World = 1,
+            Frequency = 2,
+            AI = 3,
+            Server = 4,
+            Data = 5,
+            Count = 6
+        };
+        struct Format
+        {
+            Category category;
+            Level level;
+            const char* text;
+        };
+        typedef function<void(const char* line, size_t length)> SinkCallback;
+    private:
+        enum ArgumentTag : uint8_t
+        {
+            TagSigned = 'i',
+            TagUnsigned = 'u',
+            TagDouble = 'd',
+            TagString = 's',
+            TagPointer = 'p'
+        };
+        struct RecordHeader
+        {
+            uint32_t size; // 0 marks a wrap to the beginning of the ring
+            uint32_t argumentCount;
+            const Format* format;
+            int64_t timestampNanoseconds;
+        };
+        class Ring
+        {
+        private:
+            const size_t m_capacity;
+            unique_ptr<char[]> m_buffer;
+            char m_padding1[64];
+            atomic<size_t> m_writePosition;
+            char m_padding2[64];
+            atomic<size_t> m_readPosition;
+            atomic<uint64_t> m_droppedCount;
+        public:
+            explicit Ring(size_t _capacity);
+        public:
+            // producer side; returns nullptr if the record doesn't fit
+            char* beginWrite(size_t size);
+            void endWrite(size_t size);
+            // consumer side; returns nullptr if the ring is empty
+            const char* beginRead(size_t& size);
+            void endRead(size_t size);
+            bool empty() const;
+            void countDropped() { m_droppedCount.fetch_add(1, memory_order_relaxed); }
+            uint64_t droppedCount() const { return m_droppedCount.load(memory_order_relaxed); }
+        };
+        struct RingEntry
+        {
+            shared_ptr<Ring> ring;
+            uint64_t reportedDroppedCount;
+        };
+    private:
+        const uint64_t m_id;
+        const size_t m_ringCapacity;
+        const chrono::steady_clock::time_point m_startTime;
+        atomic<int> m_levelByCategory[(int)Category::Count];
+        SinkCallback m_sink;
+        mutex m_sinkMutex;
+        mutex m_ringsMutex;
+        vector<shared_ptr<Ring>> m_newRings;
+        atomic<bool> m_hasNewRings;
+        vector<RingEntry> m_rings; // consumer-owned
+        mutex m_drainMutex;
+        thread m_consumerThread;
+        atomic<bool> m_consumerStarted;
+        atomic<bool> m_stopRequested;
+        const bool m_runConsumerThread;
+    public:
+        explicit AsyncLog(SinkCallback _sink = writeToStdout, size_t _ringCapacity = 1 << 16, bool _runConsumerThread = true);
+        AsyncLog(const AsyncLog& other) = delete;
+        AsyncLog& operator=(const AsyncLog& other) = delete;
+        ~AsyncLog();
+    public:
+        bool isEnabled(Category category, Level level) const
+        {
+            return (int)level >= m_levelByCategory[(int)category].load(memory_order_relaxed);
+        }
+
+        template<class... TArgs>
+        void write(const Format* format, const TArgs&... args)
+        {
+            const size_t size = sizeof(RecordHeader) + sumOf({ (size_t)0, encodedSize(args)... });
+            Ring& ring = getThreadRing();
+            char* record = ring.beginWrite(size);
+            if (!record)
+            {
+                ring.countDropped();
+                return;
+            }
+
+            RecordHeader header = {
+                (uint32_t)size,
+                (uint32_t)sizeof...(TArgs),
+                format,
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_startTime).count()
+            };
+            memcpy(record, &header, sizeof(header));
+
+            char* next = record + sizeof(header);
+            char* unused[] = { next, (next = encode(next, args))... };
+            (void)unused;
+
+            ring.endWrite(size);
+        }
+
+        void setLevel(Category category, Level level);
+        Level getLevel(Category category) const;
+        void setAllLevels(Level level);
+        void setSink(SinkCallback sink);
+        // formats and passes to the sink all records written so far; returns the number of records
+        int drain();
+        // waits until the records written so far by any thread have been passed to the sink
+        void flush();
+        void stop();
+    public:
+        static AsyncLog& instance();
+        static Level parseLevel(const string& name);
+        static void writeToStdout(const char* line, size_t length);
+        // formats a printf-style format string with arguments encoded by write()
+        static void formatMessage(const char* format, const char* arguments, uint32_t argumentCount, string& output);
+    private:
+        Ring& getThreadRing();
+        void runConsumerThread();
+        void formatRecord(const RecordHeader& header, const char* arguments, string& line);
+
+        static size_t sumOf(initializer_list<size_t> sizes)
+        {
+            size_t sum = 0;
+            for (size_t size : sizes)
+            {
+                sum += size;
+            }
+            return sum;
+        }
+
+        template<class T>
+        static typename enable_if<is_integral<T>::value || is_enum<T>::value, size_t>::type encodedSize(const T&)
+        {
+            return 1 + 8;
+        }
+        template<class T>
+        static typename enable_if<is_floating_point<T>::value, size_t>::type encodedSize(const T&)
+        {
+            return 1 + 8;
+        }
+        template<class T>
+        static size_t encodedSize(const T*)
+        {
+            return 1 + 8;
+        }
+        static size_t encodedSize(const char* value)
+        {
+            return 1 + 4 + (value ? strlen(value) : 6);
+        }
+        static size_t encodedSize(char* value)
+        {
+            return encodedSize((const char*)value);
+        }
+        static size_t encodedSize(const string& value)
+        {
+            return 1 + 4 + value.length();
+        }
+
+        template<class T>
+        static typename enable_if<is_integral<T>::value || is_enum<T>::value, char*>::type encode(char* target, const T& value)
+        {
+            if (is_signed<T>::value || is_enum<T>::value)
+            {
+                return encodeScalar(target, TagSigned, (int64_t)value);
+            }
+            return encodeScalar(target, TagUnsigned, (uint64_t)value);
+        }
+        template<class T>
+        static typename enable_if<is_floating_point<T>::value, char*>::type encode(char* target, const T& value)
+        {
+            return encodeScalar(target, TagDouble, (double)value);
+        }
+        template<class T>
+        static char* encode(char* target, const T* value)
+        {
+            return encodeScalar(target, TagPointer, (uint64_t)(uintptr_t)value);
+        }
+        static char* encode(char* target, const char* value)
+        {
+            return value
+                ? encodeString(target, value, strlen(value))
+                : encodeString(target, "(null)", 6);
+        }
+        static char* encode(char* target, char* value)
+        {
+            return encode(target, (const char*)value);
+        }
+        static char* encode(char* target, const string& value)
+        {
+            return encodeString(target, value.c_str(), value.length());
+        }
+
+        template<class T>
+        static char* encodeScalar(char* target, ArgumentTag tag, T value)
+        {
+            *target = (char)tag;
+            memcpy(target + 1, &value, 8);
+            return target + 9;
+        }
+        static char* encodeString(char* target, const char* value, size_t length)
+        {
+            uint32_t length32 = (uint32_t)length;
+            *target = (char)TagString;
+            memcpy(target + 1, &length32, 4);
+            memcpy(target + 5, value, length);
+            return target + 5 + length;
+        }
+    };
+}
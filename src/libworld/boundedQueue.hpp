@@ -0,0 +1,132 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+namespace world
+{
+    // Fixed-capacity lock-free queue for any number of producers and consumers.
+    // Every slot carries a sequence number which tells whether the slot is ready
+    // to be written (sequence == position) or to be read (sequence == position + 1).
+    // Capacity must be a power of two.
+    template<class T>
+    class BoundedQueue
+    {
+    private:
+        struct Slot
+        {
+            atomic<size_t> sequence;
+            T item;
+        };
+    private:
+        const size_t m_capacity;
+        const size_t m_mask;
+        unique_ptr<Slot[]> m_slots;
+        char m_padding1[64];
+        atomic<size_t> m_enqueuePosition;
+        char m_padding2[64];
+        atomic<size_t> m_dequeuePosition;
+    public:
+        explicit BoundedQueue(size_t _capacity) :
+            m_capacity(_capacity),
+            m_mask(_capacity - 1),
+            m_slots(new Slot[_capacity]),
+            m_enqueuePosition(0),
+            m_dequeuePosition(0)
+        {
+            if (_capacity < 2 || (_capacity & (_capacity - 1)) != 0)
+            {
+                throw runtime_error("BoundedQueue: capacity must be a power of two");
+            }
+            for (size_t i = 0 ; i < _capacity ; i++)
+            {
+                m_slots[i].sequence.store(i, memory_order_relaxed);
+            }
+        }
+        BoundedQueue(const BoundedQueue& other) = delete;
+        BoundedQueue& operator=(const BoundedQueue& other) = delete;
+    public:
+        size_t capacity() const { return m_capacity; }
+        size_t sizeApprox() const
+        {
+            size_t enqueued = m_enqueuePosition.load(memory_order_relaxed);
+            size_t dequeued = m_dequeuePosition.load(memory_order_relaxed);
+            return enqueued >= dequeued ? enqueued - dequeued : 0;
+        }
+    public:
+        bool tryPush(T&& item)
+        {
+            Slot* slot;
+            size_t position = m_enqueuePosition.load(memory_order_relaxed);
+
+            while (true)
+            {
+                slot = &m_slots[position & m_mask];
+                size_t sequence = slot->sequence.load(memory_order_acquire);
+                intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+                if (difference == 0)
+                {
+                    if (m_enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false; // full
+                }
+                else
+                {
+                    position = m_enqueuePosition.load(memory_order_relaxed);
+                }
+            }
+
+            slot->item = std::move(item);
+            slot->sequence.store(position + 1, memory_order_release);
+            return true;
+        }
+
+        bool tryPop(T& item)
+        {
+            Slot* slot;
+            size_t position = m_dequeuePosition.load(memory_order_relaxed);
+
+            while (true)
+            {
+                slot = &m_slots[position & m_mask];
+                size_t sequence = slot->sequence.load(memory_order_acquire);
+                intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+                if (difference == 0)
+                {
+                    if (m_dequeuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    return false; // empty
+                }
+                else
+                {
+                    position = m_dequeuePosition.load(memory_order_relaxed);
+                }
+            }
+
+            item = std::move(slot->item);
+            slot->item = T();
+            slot->sequence.store(position + m_capacity, memory_order_release);
+            return true;
+        }
+    };
+}
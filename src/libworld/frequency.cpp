@@ -2,32 +2,46 @@
 // This file is part of AT&C project which simulates virtual world of air traffic and ATC.
 // Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
 // 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include "libworld.h"
+#include "asyncLog.hpp"
 
 using namespace std;
 
 namespace world
 {
+    // assumed height of ATC antennas and of radios on the ground
+    static const float antennaHeightFeet = 100;
+    static const float minRadioHeightFeet = 6;
+
+    constexpr size_t Frequency::RegularQueueCapacity;
+    constexpr size_t Frequency::CriticalQueueCapacity;
+    constexpr size_t Frequency::PushToTalkQueue::InitialSlotCount;
+    constexpr chrono::microseconds Frequency::NoArbitrationScheduled;
+    constexpr chrono::microseconds Frequency::ListenerGridRefreshInterval;
+    constexpr float Frequency::ListenerMovementMarginNm;
+    constexpr float Frequency::ListenerClimbMarginFeet;
+
     void Frequency::logTransmission(const string& message, shared_ptr<Transmission> transmission)
     {
-        const auto& intent = transmission->intent();
-
-        string fromCallSign = (intent->direction() == Intent::Direction::PilotToController 
-            ? intent->subjectFlight()->callSign() 
-            : intent->subjectControl()->callSign());
-
-        string toCallSign = (intent->direction() == Intent::Direction::PilotToController 
-            ? intent->subjectControl()->callSign()
-            : intent->subjectFlight()->callSign());
+        if (!AsyncLog::instance().isEnabled(AsyncLog::Category::Frequency, AsyncLog::Level::Info))
+        {
+            return;
+        }
 
-        auto verbalizedUtterance = transmission->verbalizedUtterance();
+        const auto& intent = transmission->intent();
+        const bool fromPilot = (intent->direction() == Intent::Direction::PilotToController);
+        const auto& verbalizedUtterance = transmission->verbalizedUtterance();
 
-        m_host->writeLog(
+        ATC_LOG_INFO(
+            AsyncLog::Category::Frequency,
             "%d|%s [%s]->[%s] intent id[%d] code[%d] crit[%d] state[%d] reply-to[%d] %s",
             m_khz,
-            message.c_str(),
-            fromCallSign.c_str(),
-            toCallSign.c_str(),
+            message,
+            fromPilot ? intent->subjectFlight()->callSign() : intent->subjectControl()->callSign(),
+            fromPilot ? intent->subjectControl()->callSign() : intent->subjectFlight()->callSign(),
             intent->id(),
             intent->code(),
             intent->isCritical() ? 1 : 0,
@@ -38,20 +52,15 @@ namespace world
 
     void Frequency::logIntent(const string& message, shared_ptr<Intent> intent)
     {
-        string fromCallSign = (intent->direction() == Intent::Direction::PilotToController
-            ? intent->subjectFlight()->callSign()
-            : intent->subjectControl()->callSign());
-
-        string toCallSign = (intent->direction() == Intent::Direction::PilotToController
-            ? intent->subjectControl()->callSign()
-            : intent->subjectFlight()->callSign());
+        const bool fromPilot = (intent->direction() == Intent::Direction::PilotToController);
 
-        m_host->writeLog(
+        ATC_LOG_INFO(
+            AsyncLog::Category::Frequency,
             "%d|%s [%s]->[%s] intent id[%d] code[%d] crit[%d] state[%d] reply-to[%d]",
             m_khz,
-            message.c_str(),
-            fromCallSign.c_str(),
-            toCallSign.c_str(),
+            message,
+            fromPilot ? intent->subjectFlight()->callSign() : intent->subjectControl()->callSign(),
+            fromPilot ? intent->subjectControl()->callSign() : intent->subjectFlight()->callSign(),
             intent->id(),
             intent->code(),
             intent->isCritical() ? 1 : 0,
@@ -115,23 +124,22 @@ namespace world
         TransmissionCallback onTransmission,
         CancellationQueryCallback onQueryCancel)
     {
-        if (m_regularAwaiters.size() >= 1000)
+        int id = m_nextPushToTalkId++;
+        auto& queue = intent->isCritical() ? m_criticalAwaiters : m_regularAwaiters;
+
+        if (queue.size() >= (intent->isCritical() ? CriticalQueueCapacity : RegularQueueCapacity))
         {
             m_host->writeLog("%d|ERROR push-to-talk queue full, cannot enqueue intent code[%d]", m_khz, intent->code());
             return;
         }
 
+        auto transmission = createVerbalizedTransmission(intent);
+        queue.tryPush({ id, silence, intent, transmission, onTransmission, onQueryCancel });
+
         logIntent("ENQEUE PTT silence[" + to_string(silence.count()) + "]", intent);
+        m_arbitrationScheduleInvalidated = true;
 
-        int id = m_nextPushToTalkId++;
-        if (intent->isCritical())
-        {
-            m_criticalAwaiters.push_back({ id, silence, intent, onTransmission, onQueryCancel});
-        }
-        else
-        {
-            m_regularAwaiters.push_back({id, silence, intent, onTransmission, onQueryCancel});
-        }
+        m_host->services().get<TextToSpeechService>()->prepareTransmission(shared_from_this(), transmission);
     }
 
     shared_ptr<Transmission> Frequency::enqueueTransmission(const shared_ptr<Intent> intent)
@@ -142,10 +150,26 @@ namespace world
             return nullptr;
         }
 
-        auto now =  m_host->getWorld()->timestamp();
-        auto transmission = shared_ptr<Transmission>(new Transmission(m_nextTransmissionId++, intent));
+        auto transmission = createVerbalizedTransmission(intent);
+        pushTransmission(transmission);
+        m_host->services().get<TextToSpeechService>()->prepareTransmission(shared_from_this(), transmission);
+        return transmission;
+    }
+
+    shared_ptr<Transmission> Frequency::createVerbalizedTransmission(const shared_ptr<Intent> intent)
+    {
+        // transmission ids are unique across all frequencies, so that they can key per-world caches
+        static atomic<uint64_t> nextTransmissionId(1);
+        auto transmission = shared_ptr<Transmission>(new Transmission(nextTransmissionId++, intent));
         auto utterance = m_host->services().get<PhraseologyService>()->verbalizeIntent(intent);
         transmission->setVerbalizedUtterance(utterance);
+        return transmission;
+    }
+
+    void Frequency::pushTransmission(shared_ptr<Transmission> transmission)
+    {
+        const auto& intent = transmission->intent();
+        auto now =  m_host->getWorld()->timestamp();
 
         logTransmission("ENQEUE TRANSMISSION", transmission);
 
@@ -153,8 +177,6 @@ namespace world
         m_lastTransmittedIntentId = intent->id();
         m_lastConversationState = intent->conversationState();
         m_conversationStateExpiryTimestamp = now + chrono::minutes(10);
-
-        return transmission;
     }
 
     void Frequency::beginTransmission(shared_ptr<Transmission> transmission, chrono::microseconds timestamp)
@@ -187,12 +209,31 @@ namespace world
         {
             m_conversationStateExpiryTimestamp = timestamp + chrono::seconds(5);
         }
+        m_arbitrationScheduleInvalidated = true;
+
+        // only listeners within radio range of the speaker or the antenna are invoked;
+        // the listener grid narrows down whose positions have to be queried
+        refreshListenerGrid(timestamp);
+        const RadioPosition speaker = getSpeakerPosition(intent);
+        vector<int> candidateIds = m_unpositionedListenerIds;
+        findListenersPossiblyInRange(speaker, candidateIds);
 
-        for (const auto& pair : m_listenerById)
+        for (int listenerId : candidateIds)
         {
+            // a listener callback may remove other listeners
+            auto found = m_listenerById.find(listenerId);
+            if (found == m_listenerById.end())
+            {
+                continue;
+            }
+
+            const ListenerEntry& listener = found->second;
             try
             {
-                pair.second(intent);
+                if (!listener.onQueryPosition || isInRadioRange(speaker, listener.onQueryPosition()))
+                {
+                    listener.callback(intent);
+                }
             }
             catch(const exception& e)
             {
@@ -202,15 +243,124 @@ namespace world
     }
 
     int Frequency::addListener(Frequency::Listener callback)
+    {
+        return addListener(callback, nullptr);
+    }
+
+    int Frequency::addListener(Frequency::Listener callback, QueryListenerPositionCallback onQueryPosition)
     {
         int newId = m_nextListenerId++;
-        m_listenerById.insert({ newId, callback });
+        auto& listener = m_listenerById.insert({ newId, { callback, onQueryPosition, { GeoPoint::empty, 0 }, -1 } }).first->second;
+
+        if (onQueryPosition)
+        {
+            indexListener(newId, listener);
+        }
+        else
+        {
+            m_unpositionedListenerIds.push_back(newId);
+        }
+
         return newId;
     }
     
     void Frequency::removeListener(int listenerId)
     {
-        m_listenerById.erase(listenerId);
+        auto found = m_listenerById.find(listenerId);
+        if (found == m_listenerById.end())
+        {
+            return;
+        }
+
+        if (found->second.onQueryPosition)
+        {
+            unindexListener(listenerId, found->second);
+        }
+        else
+        {
+            m_unpositionedListenerIds.erase(
+                remove(m_unpositionedListenerIds.begin(), m_unpositionedListenerIds.end(), listenerId),
+                m_unpositionedListenerIds.end());
+        }
+
+        m_listenerById.erase(found);
+    }
+
+    void Frequency::indexListener(int listenerId, ListenerEntry& listener)
+    {
+        try
+        {
+            listener.indexedPosition = listener.onQueryPosition();
+        }
+        catch(const exception& e)
+        {
+            m_host->writeLog("%d|FREQUENCY LISTENER POSITION CRASHED!!! %s", m_khz, e.what());
+            listener.indexedPosition = { m_antennaLocation, minRadioHeightFeet };
+        }
+
+        const GeoPoint& location = listener.indexedPosition.location;
+        listener.gridCell = m_listenerGrid.add(location, listenerId);
+        m_maxIndexedListenerHeightFeet = max(m_maxIndexedListenerHeightFeet, listener.indexedPosition.heightFeet);
+    }
+
+    void Frequency::unindexListener(int listenerId, const ListenerEntry& listener)
+    {
+        m_listenerGrid.remove(listener.gridCell, listenerId);
+    }
+
+    void Frequency::refreshListenerGrid(chrono::microseconds timestamp)
+    {
+        if (timestamp - m_listenerGridRefreshTimestamp < ListenerGridRefreshInterval)
+        {
+            return;
+        }
+
+        m_listenerGridRefreshTimestamp = timestamp;
+        m_listenerGrid.clear();
+        m_maxIndexedListenerHeightFeet = 0;
+
+        for (auto& pair : m_listenerById)
+        {
+            if (pair.second.onQueryPosition)
+            {
+                indexListener(pair.first, pair.second);
+            }
+        }
+    }
+
+    // appends ids of the listeners which were close enough to the antenna or to the speaker
+    // as of the last refresh, allowing for the distance they could have moved since
+    void Frequency::findListenersPossiblyInRange(const RadioPosition& speaker, vector<int>& listenerIds) const
+    {
+        if (m_listenerGrid.empty())
+        {
+            return;
+        }
+
+        size_t firstFoundIndex = listenerIds.size();
+        float maxLineOfSightNm = getRadioHorizonNm(speaker.heightFeet, m_maxIndexedListenerHeightFeet + ListenerClimbMarginFeet);
+
+        findIndexedListenersNear(m_antennaLocation, m_radiusNm + ListenerMovementMarginNm, speaker, listenerIds);
+        findIndexedListenersNear(speaker.location, maxLineOfSightNm + ListenerMovementMarginNm, speaker, listenerIds);
+
+        // a listener close to both the antenna and the speaker is found twice
+        sort(listenerIds.begin() + firstFoundIndex, listenerIds.end());
+        listenerIds.erase(unique(listenerIds.begin() + firstFoundIndex, listenerIds.end()), listenerIds.end());
+    }
+
+    void Frequency::findIndexedListenersNear(
+        const GeoPoint& center,
+        float radiusNm,
+        const RadioPosition& speaker,
+        vector<int>& listenerIds) const
+    {
+        m_listenerGrid.forEachNear(center, radiusNm, [&](int listenerId) {
+            const ListenerEntry& listener = m_listenerById.at(listenerId);
+            if (mayBeInRadioRange(speaker, listener.indexedPosition))
+            {
+                listenerIds.push_back(listenerId);
+            }
+        });
     }
 
     void Frequency::progressTo(chrono::microseconds timestamp)
@@ -230,15 +380,20 @@ namespace world
         {
             checkConversationStateExpiry(timestamp);
 
-            PushToTalkAwaiter awaiter;
-            bool dequeued =
-                    tryDequeueAwaiter(m_criticalAwaiters, awaiter) ||
-                    tryDequeueAwaiter(m_regularAwaiters, awaiter);
-
-            if (dequeued)
+            if (timestamp >= getNextArbitrationTimestamp())
             {
-                auto transmission = enqueueTransmission(awaiter.intent);
-                awaiter.onTransmission(transmission); //TODO: try/catch
+                PushToTalkAwaiter awaiter;
+                bool dequeued =
+                        tryDequeueAwaiter(m_criticalAwaiters, awaiter) ||
+                        tryDequeueAwaiter(m_regularAwaiters, awaiter);
+
+                if (dequeued)
+                {
+                    pushTransmission(awaiter.transmission);
+                    awaiter.onTransmission(awaiter.transmission); //TODO: try/catch
+                }
+
+                m_arbitrationScheduleInvalidated = true;
             }
         }
 
@@ -256,6 +411,7 @@ namespace world
         m_transmissionInProgress.reset();
         m_queryTransmissionCompletion = TextToSpeechService::noopQueryCompletion;
         m_regularAwaiters.clear();
+        m_arbitrationScheduleInvalidated = true;
         m_lastTransmittedIntentId = 0;
         m_lastConversationState = Intent::ConversationState::End;
         m_conversationStateExpiryTimestamp = chrono::microseconds(0);
@@ -279,68 +435,86 @@ namespace world
         return (wasSilentFor >= duration);
     }
 
-    bool Frequency::tryDequeueAwaiter(list<PushToTalkAwaiter>& queue, PushToTalkAwaiter& dequeued)
+    bool Frequency::tryDequeueAwaiter(PushToTalkQueue& queue, PushToTalkAwaiter& dequeued)
     {
-        if (!m_transmissionInProgress)
+        if (m_transmissionInProgress)
         {
-            //int index = 0;
+            return false;
+        }
 
-            for (auto it = queue.begin() ; it != queue.end() ; )
+        for (size_t index = 0 ; index < queue.size() ; )
+        {
+            PushToTalkAwaiter& awaiter = queue.at(index);
+            if (!wasSilentFor(awaiter.silence, awaiter.intent->replyToId()))
             {
-                bool match = wasSilentFor(it->silence, it->intent->replyToId());
-//                m_host->writeLog(
-//                    "%d|tryDequeuePTT at index[%d]%s intent: silence[%d] reply-do[%d] code[%d] id[%d] crit[%d]",
-//                    m_khz,
-//                    index,
-//                    (match ? " MATCHED" : ""),
-//                    it->silence.count(),
-//                    it->intent->replyToId(),
-//                    it->intent->code(),
-//                    it->intent->id(),
-//                    it->intent->isCritical() ? 1 : 0);
-
-                auto currentIt = it;
-                it++;
-
-                if (match)
-                {
-                    bool cancelled = currentIt->onQueryCancel();
-                    if (cancelled)
-                    {
-                        cancelAwaiter(*currentIt);
-                    }
-                    else
-                    {
-                        dequeued = *currentIt;
-                    }
-
-                    queue.erase(currentIt);
-
-                    if (!cancelled)
-                    {
-                        return true;
-                    }
-                }
+                index++;
+                continue;
+            }
+
+            // the cancellation query only runs for an awaiter which is about to transmit
+            bool cancelled = awaiter.onQueryCancel();
+            if (cancelled)
+            {
+                cancelAwaiter(awaiter);
+                queue.removeAt(index);
+                continue;
             }
+
+            dequeued = queue.takeAt(index);
+            return true;
         }
 
         return false;
     }
 
+    chrono::microseconds Frequency::getNextArbitrationTimestamp()
+    {
+        if (m_arbitrationScheduleInvalidated)
+        {
+            m_nextArbitrationTimestamp = computeNextArbitrationTimestamp();
+            m_arbitrationScheduleInvalidated = false;
+        }
+        return m_nextArbitrationTimestamp;
+    }
+
+    // the earliest time at which wasSilentFor() can become true for any of the awaiters
+    chrono::microseconds Frequency::computeNextArbitrationTimestamp()
+    {
+        if (m_criticalAwaiters.empty() && m_regularAwaiters.empty())
+        {
+            return NoArbitrationScheduled;
+        }
+
+        bool conversationContinues = (m_lastConversationState == Intent::ConversationState::Continue);
+        if (conversationContinues &&
+            (m_criticalAwaiters.hasReplyTo(m_lastTransmittedIntentId) || m_regularAwaiters.hasReplyTo(m_lastTransmittedIntentId)))
+        {
+            return chrono::microseconds(0);
+        }
+
+        chrono::milliseconds minSilence = min(m_criticalAwaiters.minSilence(), m_regularAwaiters.minSilence());
+
+        // while a conversation continues, only a reply can transmit, until the conversation expires
+        return conversationContinues
+            ? m_conversationStateExpiryTimestamp
+            : m_lastTransmissionEndTimestamp + chrono::duration_cast<chrono::microseconds>(minSilence);
+    }
+
     void Frequency::cancelAwaiter(PushToTalkAwaiter& awaiter)
     {
-        auto transmission = shared_ptr<Transmission>(new Transmission(m_nextTransmissionId++, awaiter.intent));
+        auto transmission = awaiter.transmission;
         transmission->m_endTimestamp = m_host->getWorld()->timestamp();
         transmission->m_state = Transmission::State::Cancelled;
         logTransmission("CANCEL TRANSMISSION", transmission);
+        m_host->services().get<TextToSpeechService>()->discardTransmission(transmission);
         awaiter.onTransmission(transmission); //TODO: try/catch
     }
 
     bool Frequency::wasPushToTalkDequeued(int pushToTalkId)
     {
-        for (auto it = m_regularAwaiters.begin() ; it != m_regularAwaiters.end() ; it++)
+        for (size_t i = 0 ; i < m_regularAwaiters.size() ; i++)
         {
-            if (it->id == pushToTalkId)
+            if (m_regularAwaiters.at(i).id == pushToTalkId)
             {
                 return false;
             }
@@ -364,7 +538,178 @@ namespace world
             m_lastTransmittedIntentId = 0;
             m_lastConversationState = Intent::ConversationState::End;
             m_conversationStateExpiryTimestamp = timestamp + chrono::hours(1);
+            m_arbitrationScheduleInvalidated = true;
         }
     }
-}
 
+    bool Frequency::PushToTalkQueue::tryPush(PushToTalkAwaiter&& awaiter)
+    {
+        if (m_count == m_slots.size())
+        {
+            if (m_count >= m_capacity)
+            {
+                return false;
+            }
+            grow();
+        }
+
+        count(awaiter);
+        m_slots[(m_head + m_count) % m_slots.size()] = std::move(awaiter);
+        m_count++;
+        return true;
+    }
+
+    Frequency::PushToTalkAwaiter Frequency::PushToTalkQueue::takeAt(size_t index)
+    {
+        uncount(at(index));
+        PushToTalkAwaiter taken = std::move(at(index));
+        vacateAt(index);
+        return taken;
+    }
+
+    void Frequency::PushToTalkQueue::removeAt(size_t index)
+    {
+        uncount(at(index));
+        vacateAt(index);
+    }
+
+    void Frequency::PushToTalkQueue::clear()
+    {
+        for (size_t i = 0 ; i < m_count ; i++)
+        {
+            at(i) = PushToTalkAwaiter();
+        }
+        m_head = 0;
+        m_count = 0;
+        m_countBySilence.clear();
+        m_countByReplyToId.clear();
+    }
+
+    chrono::milliseconds Frequency::PushToTalkQueue::minSilence() const
+    {
+        return m_countBySilence.empty()
+            ? chrono::milliseconds::max()
+            : m_countBySilence.begin()->first;
+    }
+
+    void Frequency::PushToTalkQueue::grow()
+    {
+        size_t newSlotCount = min(m_capacity, max(InitialSlotCount, m_slots.size() * 2));
+        vector<PushToTalkAwaiter> newSlots(newSlotCount);
+        for (size_t i = 0 ; i < m_count ; i++)
+        {
+            newSlots[i] = std::move(at(i));
+        }
+        m_slots.swap(newSlots);
+        m_head = 0;
+    }
+
+    void Frequency::PushToTalkQueue::count(const PushToTalkAwaiter& awaiter)
+    {
+        m_countBySilence[awaiter.silence]++;
+        m_countByReplyToId[awaiter.intent->replyToId()]++;
+    }
+
+    void Frequency::PushToTalkQueue::uncount(const PushToTalkAwaiter& awaiter)
+    {
+        auto silence = m_countBySilence.find(awaiter.silence);
+        if (silence != m_countBySilence.end() && --silence->second == 0)
+        {
+            m_countBySilence.erase(silence);
+        }
+        auto replyToId = m_countByReplyToId.find(awaiter.intent->replyToId());
+        if (replyToId != m_countByReplyToId.end() && --replyToId->second == 0)
+        {
+            m_countByReplyToId.erase(replyToId);
+        }
+    }
+
+    void Frequency::PushToTalkQueue::vacateAt(size_t index)
+    {
+        if (index == 0)
+        {
+            at(0) = PushToTalkAwaiter();
+            m_head = (m_head + 1) % m_slots.size();
+            m_count--;
+            return;
+        }
+
+        for (size_t i = index ; i + 1 < m_count ; i++)
+        {
+            at(i) = std::move(at(i + 1));
+        }
+
+        // release the intent and callbacks held by the vacated slot
+        at(m_count - 1) = PushToTalkAwaiter();
+        m_count--;
+
+        if (m_count == 0)
+        {
+            m_head = 0;
+        }
+    }
+
+    Frequency::RadioPosition Frequency::getSpeakerPosition(shared_ptr<Intent> intent) const
+    {
+        if (intent->direction() == Intent::Direction::PilotToController && intent->subjectFlight())
+        {
+            auto aircraft = intent->subjectFlight()->aircraft();
+            if (aircraft)
+            {
+                return { aircraft->location(), getRadioHeightFeet(aircraft->altitude()) };
+            }
+        }
+
+        return { m_antennaLocation, antennaHeightFeet };
+    }
+
+    bool Frequency::isInRadioRange(const RadioPosition& speaker, const RadioPosition& listener) const
+    {
+        if (getApproximateDistanceNm(m_antennaLocation, listener.location) <= m_radiusNm)
+        {
+            return true;
+        }
+
+        float lineOfSightNm = getRadioHorizonNm(speaker.heightFeet, listener.heightFeet);
+        return getApproximateDistanceNm(speaker.location, listener.location) <= lineOfSightNm;
+    }
+
+    bool Frequency::mayBeInRadioRange(const RadioPosition& speaker, const RadioPosition& indexedListener) const
+    {
+        if (getApproximateDistanceNm(m_antennaLocation, indexedListener.location) <= m_radiusNm + ListenerMovementMarginNm)
+        {
+            return true;
+        }
+
+        float lineOfSightNm = getRadioHorizonNm(speaker.heightFeet, indexedListener.heightFeet + ListenerClimbMarginFeet);
+        return getApproximateDistanceNm(speaker.location, indexedListener.location) <= lineOfSightNm + ListenerMovementMarginNm;
+    }
+
+    float Frequency::getRadioHeightFeet(const Altitude& altitude)
+    {
+        // MSL altitude is taken as height: it only overestimates the range over high terrain
+        return altitude.type() == Altitude::Type::Ground
+            ? minRadioHeightFeet
+            : max(minRadioHeightFeet, altitude.feet());
+    }
+
+    float Frequency::getRadioHorizonNm(float heightFeet1, float heightFeet2)
+    {
+        // VHF line of sight, with heights in feet
+        return 1.23f * (sqrt(max(0.0f, heightFeet1)) + sqrt(max(0.0f, heightFeet2)));
+    }
+
+    float Frequency::getApproximateDistanceNm(const GeoPoint& p1, const GeoPoint& p2)
+    {
+        // equirectangular approximation, accurate enough within radio range
+        const double degreesToRadians = 3.14159265358979323846 / 180.0;
+        double deltaLongitude = abs(p2.longitude - p1.longitude);
+        if (deltaLongitude > 180.0)
+        {
+            deltaLongitude = 360.0 - deltaLongitude;
+        }
+        double deltaLatNm = (p2.latitude - p1.latitude) * 60.0;
+        double deltaLonNm = deltaLongitude * 60.0 * cos((p1.latitude + p2.latitude) * 0.5 * degreesToRadians);
+        return (float)sqrt(deltaLatNm * deltaLatNm + deltaLonNm * deltaLonNm);
+    }
+}
@@ -13,9 +13,13 @@
 #include <vector>
 #include <unordered_map>
 #include <list>
+#include <map>
 #include <queue>
 #include <functional>
 #include <chrono>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
 #include "stlhelpers.h"
 
 using namespace std;
@@ -275,6 +279,84 @@ namespace world
         static double hypotenuse(double side);
     };
 
+    // Items bucketed by 1x1 degree cells, so that finding the items near a point only looks at
+    // the cells around it; longitude wraps around the antimeridian. Used for airports of the world
+    // and for listeners of a frequency.
+    template<class T>
+    class GeoGridIndex
+    {
+    public:
+        typedef int Cell;
+    private:
+        unordered_map<Cell, vector<T>> m_itemsByCell;
+    public:
+        Cell add(const GeoPoint& location, const T& item)
+        {
+            Cell cell = getCell(location);
+            m_itemsByCell[cell].push_back(item);
+            return cell;
+        }
+
+        void remove(Cell cell, const T& item)
+        {
+            auto found = m_itemsByCell.find(cell);
+            if (found == m_itemsByCell.end())
+            {
+                return;
+            }
+
+            auto& items = found->second;
+            items.erase(std::remove(items.begin(), items.end(), item), items.end());
+            if (items.empty())
+            {
+                m_itemsByCell.erase(found);
+            }
+        }
+
+        void clear() { m_itemsByCell.clear(); }
+        bool empty() const { return m_itemsByCell.empty(); }
+
+        // visits every item of the cells which overlap the radius; the caller checks the actual distance
+        template<class TVisit>
+        void forEachNear(const GeoPoint& center, float radiusNm, TVisit visit) const
+        {
+            const double latitudeSpan = radiusNm / 60.0;
+            const double longitudeSpan = min(180.0, latitudeSpan / max(0.01, cos(GeoMath::degreesToRadians(center.latitude))));
+
+            const int minLatitudeIndex = max(-90, (int)floor(center.latitude - latitudeSpan));
+            const int maxLatitudeIndex = min(89, (int)floor(center.latitude + latitudeSpan));
+            const int minLongitudeIndex = (int)floor(center.longitude - longitudeSpan);
+            const int maxLongitudeIndex = min(minLongitudeIndex + 359, (int)floor(center.longitude + longitudeSpan));
+
+            for (int latitudeIndex = minLatitudeIndex ; latitudeIndex <= maxLatitudeIndex ; latitudeIndex++)
+            {
+                for (int longitudeIndex = minLongitudeIndex ; longitudeIndex <= maxLongitudeIndex ; longitudeIndex++)
+                {
+                    auto found = m_itemsByCell.find(getCell(latitudeIndex, longitudeIndex));
+                    if (found == m_itemsByCell.end())
+                    {
+                        continue;
+                    }
+                    for (const T& item : found->second)
+                    {
+                        visit(item);
+                    }
+                }
+            }
+        }
+    public:
+        static Cell getCell(const GeoPoint& location)
+        {
+            return getCell((int)floor(location.latitude), (int)floor(location.longitude));
+        }
+    private:
+        static Cell getCell(int latitudeIndex, int longitudeIndex)
+        {
+            int wrappedLongitudeIndex = ((longitudeIndex + 180) % 360 + 360) % 360;
+            return (latitudeIndex + 90) * 360 + wrappedLongitudeIndex;
+        }
+    };
+
     template<class TKey>
     class HaveKey
     {
@@ -282,6 +364,101 @@ namespace world
         virtual const TKey& getKey() = 0;
     };
 
+    // World-wide table of interned names: taxiways, runway ends, parking stands, airlines.
+    // Such names repeat thousands of times across the world, so entities store a small
+    // integer Symbol instead of a string, and comparing two names becomes an integer compare.
+    // Interning is thread-safe; resolving a symbol back to its string does not take a lock.
+    class SymbolTable
+    {
+    public:
+        typedef uint32_t Symbol;
+        static constexpr Symbol EmptySymbol = 0;
+        static constexpr Symbol NotFound = 0xFFFFFFFF;
+    private:
+        static constexpr int ChunkSizeBits = 10;
+        static constexpr int ChunkSize = 1 << ChunkSizeBits;
+        static constexpr int MaxChunks = 4096;
+        typedef unordered_map<reference_wrapper<const string>, Symbol, hash<string>, equal_to<string>> SymbolByStringMap;
+    private:
+        mutable mutex m_mutex;
+        unique_ptr<string[]> m_chunks[MaxChunks];
+        Symbol m_count;
+        SymbolByStringMap m_symbolByString;
+    public:
+        SymbolTable();
+        SymbolTable(const SymbolTable& other) = delete;
+    public:
+        Symbol intern(const string& s);
+        Symbol tryFind(const string& s) const;
+        const string& getString(Symbol symbol) const
+        {
+            return m_chunks[symbol >> ChunkSizeBits][symbol & (ChunkSize - 1)];
+        }
+        size_t size() const;
+    public:
+        static SymbolTable& global();
+        static Symbol internGlobal(const string& s) { return global().intern(s); }
+        static const string& getGlobalString(Symbol symbol) { return global().getString(symbol); }
+    };
+
+    typedef SymbolTable::Symbol Symbol;
+
+    // Non-owning reference to characters stored elsewhere, e.g. in a static table.
+    // Lookups that return StringRef do not allocate.
+    struct StringRef
+    {
+        const char* data = "";
+        size_t length = 0;
+
+        bool empty() const { return length == 0; }
+        string str() const { return string(data, length); }
+        bool equals(const char* s, size_t sLength) const
+        {
+            return length == sLength && memcmp(data, s, length) == 0;
+        }
+    };
+
+    inline bool operator==(const StringRef& ref, const string& s) { return ref.equals(s.c_str(), s.length()); }
+    inline bool operator==(const string& s, const StringRef& ref) { return ref.equals(s.c_str(), s.length()); }
+
+    // Aircraft type attributes as listed in ICAO Doc 8643
+    struct AircraftTypeInfo
+    {
+        enum class AircraftClass : uint8_t
+        {
+            Unknown = 0,
+            Landplane = 1,
+            Seaplane = 2,
+            Amphibian = 3,
+            Helicopter = 4,
+            Gyrocopter = 5,
+            Tiltrotor = 6
+        };
+        enum class EngineType : uint8_t
+        {
+            Unknown = 0,
+            Piston = 1,
+            Turboprop = 2,
+            Jet = 3,
+            Electric = 4,
+            Rocket = 5
+        };
+        enum class WakeCategory : uint8_t
+        {
+            Unknown = 0,
+            Light = 1,
+            LightMedium = 2,
+            Medium = 3,
+            Heavy = 4,
+            Super = 5
+        };
+
+        AircraftClass aircraftClass = AircraftClass::Unknown;
+        int engineCount = 0;
+        EngineType engineType = EngineType::Unknown;
+        WakeCategory wakeCategory = WakeCategory::Unknown;
+    };
+
     struct AircraftAttitude
     {
     private:
@@ -475,6 +652,7 @@ namespace world
             friend class WorldBuilder;
         private:
             string m_name; // name in HHS format: HH=heading/10 (e.g. 117 -> 12), S=suffix L/R/C/empty
+            Symbol m_nameSymbol;
             int m_number;  // runway number: heading/10
             char m_suffix; // L/R/C or 0 if none
             float m_displacedThresholdMeters;
@@ -490,6 +668,7 @@ namespace world
                 float _overrunAreaMeters,
                 const UniPoint& _centerlinePoint
             ) : m_name(_name),
+                m_nameSymbol(SymbolTable::internGlobal(_name)),
                 m_number(getRunwayEndNumber(_name)),
                 m_suffix(getRunwayEndSuffix(_name)),
                 m_displacedThresholdMeters(_displacedThresholdMeters),
@@ -502,6 +681,7 @@ namespace world
         public:
             float heading() const { return m_heading; }
             const string& name() const { return m_name; }
+            Symbol nameSymbol() const { return m_nameSymbol; }
             int number() const { return m_number; }
             char suffix() const { return m_suffix; }
             float displacedThresholdMeters() const { return m_displacedThresholdMeters; }
@@ -620,12 +800,15 @@ namespace world
         };
         typedef function<shared_ptr<World::ChangeSet>()> OnChangesCallback;
         typedef function<float(const GeoPoint& location)> OnQueryElevationCallback;
+        typedef function<bool(const string& typeIcao, AircraftTypeInfo& info)> OnQueryAircraftTypeCallback;
+        typedef function<shared_ptr<Airport>(const string& icao, shared_ptr<ControlledAirspace> airspace)> ReloadAirportCallback;
     private:
         struct WorkItem
         {
             string description;
             chrono::microseconds timestamp;
             function<void()> callback;
+            int flightId;
         };
         typedef priority_queue<
             WorkItem, 
@@ -648,8 +831,12 @@ namespace world
         vector<shared_ptr<ControlFacility>> m_controlFacilities;
         unordered_map<int, shared_ptr<ControlledAirspace>> m_airspaceById;
         unordered_map<string, shared_ptr<Airport>> m_airportByIcao;
+        GeoGridIndex<shared_ptr<Airport>> m_airportGrid;
         unordered_map<int, shared_ptr<Flight>> m_flightById;
+        unordered_map<int, shared_ptr<Flight>> m_scheduledFlightById;
+        uint64_t m_airportsGeneration;
         OnQueryElevationCallback m_onQueryTerrainElevation;
+        OnQueryAircraftTypeCallback m_onQueryAircraftType;
     public:
         World(const shared_ptr<HostServices> _host, time_t _startTime) :
             m_startTime(_startTime), 
@@ -659,27 +846,39 @@ namespace world
             m_host(_host),
             m_workItemQueue(compareWorkItems),
             m_changeSet(make_shared<ChangeSet>()),
-            m_onQueryTerrainElevation(onQueryTerrainElevationUnassigned)
+            m_airportsGeneration(0),
+            m_onQueryTerrainElevation(onQueryTerrainElevationUnassigned),
+            m_onQueryAircraftType(onQueryAircraftTypeUnassigned)
         {
         }
     public:
         void progressTo(chrono::microseconds futureTimestamp);
+        void addAirport(shared_ptr<Airport> airport);
         void addFlight(shared_ptr<Flight> flight);
         void addFlightColdAndDark(shared_ptr<Flight> flight);
+        // the flight is added at the given time, then onAdded is invoked; until then it is revalidated
+        // on airport reload and can be removed, same as an added flight
+        void scheduleFlight(const string& description, shared_ptr<Flight> flight, time_t time, function<void()> onAdded);
+        void removeFlight(shared_ptr<Flight> flight);
+        void reloadAirport(const string& icaoCode, const ReloadAirportCallback& onReloadAirport);
         void clearAllFlights();
         void clearWorkItems();
         void notifyConfigurationChanged();
         shared_ptr<World::ChangeSet> takeChanges();
-        void deferUntilNextTick(const string& description, function<void()> callback);
-        void deferUntil(const string& description, time_t time, function<void()> callback);
-        void deferBy(const string& description, chrono::microseconds microseconds, function<void()> callback);
+        // work items deferred on behalf of a flight are discarded when the flight is removed
+        void deferUntilNextTick(const string& description, function<void()> callback, int flightId = -1);
+        void deferUntil(const string& description, time_t time, function<void()> callback, int flightId = -1);
+        void deferBy(const string& description, chrono::microseconds microseconds, function<void()> callback, int flightId = -1);
         // shared_ptr<ControlledAirspace> findAirspaceById(int id) const;
         shared_ptr<Flight> getFlightById(int id) const { return getValueOrThrow(m_flightById, id); }
         shared_ptr<Airport> getAirport(const string& icaoCode) const { return getValueOrThrow(m_airportByIcao, icaoCode); }
+        shared_ptr<Airport> tryFindAirport(const string& icaoCode) const;
+        vector<shared_ptr<Airport>> findAirportsInRadius(const GeoPoint& center, float radiusNm) const;
         shared_ptr<Runway> getRunway(const string& airportIcao, const string& runwayName) const;
         const Runway::End& getRunwayEnd(const string& airportIcao, const string& runwayName) const;
         shared_ptr<Frequency> tryFindCommFrequency(shared_ptr<Flight> flight, int frequencyKhz);
         float queryTerrainElevationAt(const GeoPoint& location) { return m_onQueryTerrainElevation(location); }
+        bool tryQueryAircraftType(const string& typeIcao, AircraftTypeInfo& info) const { return m_onQueryAircraftType(typeIcao, info); }
         bool detectAircraftInRect(
             const GeoPoint& topLeft,
             const GeoPoint& bottomRight,
@@ -691,10 +890,13 @@ namespace world
         bool hasChanges() const { return !m_changeSet->empty(); }
         const vector<shared_ptr<ControlledAirspace>>& airspaces() const { return m_airspaces; }
         const vector<shared_ptr<Airport>>& airports() const { return m_airports; }
+        // changes whenever an airport is added or replaced, so that copies of airports() can be checked cheaply
+        uint64_t airportsGeneration() const { return m_airportsGeneration; }
         const vector<shared_ptr<Flight>>& flights() const { return m_flights; }
         const vector<shared_ptr<ControlFacility>>& controlFacilities() const { return m_controlFacilities; }
     public:
         void onQueryTerrainElevation(OnQueryElevationCallback callback) { m_onQueryTerrainElevation = callback; }
+        void onQueryAircraftType(OnQueryAircraftTypeCallback callback) { m_onQueryAircraftType = callback; }
     public:
         static shared_ptr<ChangeSet> onChangesUnassigned() { throw runtime_error("onChanges callback was not assigned"); }
     private:
@@ -702,9 +904,15 @@ namespace world
         void processFlights();
         void processControlFacilities();
         void processHeartbeat();
+        void replaceAirport(shared_ptr<Airport> oldAirport, shared_ptr<Airport> newAirport);
+        int revalidateFlightsAt(shared_ptr<Airport> airport);
+        int discardWorkItemsOf(int flightId);
     private:
+        static bool isFlightPlanValidAt(shared_ptr<FlightPlan> plan, shared_ptr<Airport> airport);
         static bool compareWorkItems(const WorkItem& left, const WorkItem& right);
         static float onQueryTerrainElevationUnassigned(const GeoPoint&) { throw runtime_error("onQueryTerrainElevation callback was not assigned"); }
+        // aircraft type data is optional, lookups just fail until it is loaded
+        static bool onQueryAircraftTypeUnassigned(const string&, AircraftTypeInfo&) { return false; }
     };
 
     class Actor
@@ -1081,6 +1289,10 @@ namespace world
     public:
         virtual QueryCompletion vocalizeTransmission(shared_ptr<Frequency> frequency, shared_ptr<Transmission> transmission) = 0;
         virtual void clearAll() = 0;
+        // lookahead hints: a verbalized transmission was queued, and will likely be vocalized later
+        virtual void prepareTransmission(shared_ptr<Frequency> frequency, shared_ptr<Transmission> transmission) { }
+        // a prepared transmission was cancelled, and won't be vocalized
+        virtual void discardTransmission(shared_ptr<Transmission> transmission) { }
     public:
         static bool noopQueryCompletion()
         {
@@ -1189,28 +1401,99 @@ namespace world
         typedef function<void(shared_ptr<Intent> intent)> Listener;
         typedef function<void(shared_ptr<Transmission> transmission)> TransmissionCallback;
         typedef function<bool()> CancellationQueryCallback;
+        struct RadioPosition
+        {
+            GeoPoint location;
+            float heightFeet; // above ground, determines line-of-sight range
+        };
+        typedef function<RadioPosition()> QueryListenerPositionCallback;
+        struct ListenerEntry
+        {
+            Listener callback;
+            QueryListenerPositionCallback onQueryPosition; // listeners without position receive everything
+            RadioPosition indexedPosition; // as of the last refresh of the listener grid
+            GeoGridIndex<int>::Cell gridCell;
+        };
         struct PushToTalkAwaiter
         {
             int id;
             chrono::milliseconds silence;
             shared_ptr<Intent> intent;
+            // verbalized when the awaiter is queued, so that speech can be prepared in advance
+            shared_ptr<Transmission> transmission;
             TransmissionCallback onTransmission;
             CancellationQueryCallback onQueryCancel;
         };
+        // Bounded FIFO of awaiters in a ring which starts small and doubles up to the capacity.
+        // Awaiters are normally taken from the front; a reply which can be transmitted earlier
+        // than awaiters queued before it is removed from the middle.
+        // Silences and reply-to ids of the queued awaiters are counted as they come and go,
+        // so that arbitration can be scheduled without scanning the queue.
+        class PushToTalkQueue
+        {
+        private:
+            static constexpr size_t InitialSlotCount = 4;
+            vector<PushToTalkAwaiter> m_slots;
+            size_t m_capacity;
+            size_t m_head;
+            size_t m_count;
+            map<chrono::milliseconds, int> m_countBySilence;
+            unordered_map<uint64_t, int> m_countByReplyToId;
+        public:
+            explicit PushToTalkQueue(size_t _capacity) :
+                m_capacity(_capacity),
+                m_head(0),
+                m_count(0)
+            {
+            }
+        public:
+            bool tryPush(PushToTalkAwaiter&& awaiter);
+            PushToTalkAwaiter takeAt(size_t index);
+            void removeAt(size_t index);
+            void clear();
+            PushToTalkAwaiter& at(size_t index) { return m_slots[(m_head + index) % m_slots.size()]; }
+            size_t size() const { return m_count; }
+            size_t slotCount() const { return m_slots.size(); }
+            bool empty() const { return m_count == 0; }
+            bool hasReplyTo(uint64_t intentId) const { return m_countByReplyToId.count(intentId) > 0; }
+            // chrono::milliseconds::max() if the queue is empty
+            chrono::milliseconds minSilence() const;
+        private:
+            void grow();
+            void count(const PushToTalkAwaiter& awaiter);
+            void uncount(const PushToTalkAwaiter& awaiter);
+            void vacateAt(size_t index);
+        };
     private:
+        static constexpr size_t RegularQueueCapacity = 1000;
+        static constexpr size_t CriticalQueueCapacity = 100;
+        static constexpr chrono::microseconds NoArbitrationScheduled = chrono::microseconds::max();
+        // listener positions are re-indexed this often; in between, a listener is assumed
+        // to move by no more than the margins below
+        static constexpr chrono::microseconds ListenerGridRefreshInterval = chrono::microseconds(10000000);
+        static constexpr float ListenerMovementMarginNm = 2.0f;
+        static constexpr float ListenerClimbMarginFeet = 1000.0f;
         shared_ptr<HostServices> m_host;
         int m_khz; //e.g. 118325
         GeoPoint m_antennaLocation;
         float m_radiusNm;
-        long long m_nextTransmissionId;
         int m_nextListenerId;
         int m_nextPushToTalkId;
-        list<PushToTalkAwaiter> m_regularAwaiters;
-        list<PushToTalkAwaiter> m_criticalAwaiters;
+        PushToTalkQueue m_regularAwaiters;
+        PushToTalkQueue m_criticalAwaiters;
+        // awaiters are only examined once the frequency can possibly be free for one of them
+        chrono::microseconds m_nextArbitrationTimestamp;
+        bool m_arbitrationScheduleInvalidated;
         queue<shared_ptr<Transmission>> m_pendingTransmissions;
         shared_ptr<Transmission> m_transmissionInProgress;
         TextToSpeechService::QueryCompletion m_queryTransmissionCompletion;
-        unordered_map<int, Listener> m_listenerById;
+        unordered_map<int, ListenerEntry> m_listenerById;
+        // positioned listeners bucketed by 1x1 degree cells, so that a transmission
+        // only queries positions of the listeners which can possibly be in range
+        GeoGridIndex<int> m_listenerGrid;
+        vector<int> m_unpositionedListenerIds;
+        chrono::microseconds m_listenerGridRefreshTimestamp;
+        float m_maxIndexedListenerHeightFeet;
         weak_ptr<ControllerPosition> m_controllerPosition;
         uint64_t m_lastTransmittedIntentId;
         Intent::ConversationState m_lastConversationState;
@@ -1226,10 +1509,15 @@ namespace world
             m_khz(_khz),
             m_antennaLocation(_antennaLocation),
             m_radiusNm(_radiusNm),
-            m_nextTransmissionId(1),
             m_nextListenerId(1),
             m_nextPushToTalkId(1),
+            m_regularAwaiters(RegularQueueCapacity),
+            m_criticalAwaiters(CriticalQueueCapacity),
+            m_nextArbitrationTimestamp(NoArbitrationScheduled),
+            m_arbitrationScheduleInvalidated(false),
             m_queryTransmissionCompletion(TextToSpeechService::noopQueryCompletion),
+            m_listenerGridRefreshTimestamp(0),
+            m_maxIndexedListenerHeightFeet(0),
             m_lastTransmittedIntentId(0),
             m_lastConversationState(Intent::ConversationState::End),
             m_lastTransmissionEndTimestamp(0),
@@ -1249,19 +1537,40 @@ namespace world
             CancellationQueryCallback onQueryCancel = noopQueryCancelCallback);
         shared_ptr<Transmission> enqueueTransmission(const shared_ptr<Intent> intent);
         int addListener(Listener callback);
+        int addListener(Listener callback, QueryListenerPositionCallback onQueryPosition);
         void removeListener(int listenerId);
         void progressTo(chrono::microseconds timestamp);
         void clearTransmissions();
         bool wasSilentFor(chrono::milliseconds duration, uint64_t replyToId = 0);
     private:
-        bool tryDequeueAwaiter(list<PushToTalkAwaiter>& queue, PushToTalkAwaiter& dequeued);
+        bool tryDequeueAwaiter(PushToTalkQueue& queue, PushToTalkAwaiter& dequeued);
+        chrono::microseconds getNextArbitrationTimestamp();
+        chrono::microseconds computeNextArbitrationTimestamp();
         void cancelAwaiter(PushToTalkAwaiter& awaiter);
+        shared_ptr<Transmission> createVerbalizedTransmission(const shared_ptr<Intent> intent);
+        void pushTransmission(shared_ptr<Transmission> transmission);
         void beginTransmission(shared_ptr<Transmission> transmission, chrono::microseconds timestamp);
         void endTransmission(chrono::microseconds timestamp);
         void logTransmission(const string& message, shared_ptr<Transmission> transmission);
         void logIntent(const string& message, shared_ptr<Intent> intent);
         bool wasPushToTalkDequeued(int id);
         void checkConversationStateExpiry(chrono::microseconds timestamp);
+        RadioPosition getSpeakerPosition(shared_ptr<Intent> intent) const;
+        bool isInRadioRange(const RadioPosition& speaker, const RadioPosition& listener) const;
+        bool mayBeInRadioRange(const RadioPosition& speaker, const RadioPosition& indexedListener) const;
+        void indexListener(int listenerId, ListenerEntry& listener);
+        void unindexListener(int listenerId, const ListenerEntry& listener);
+        void refreshListenerGrid(chrono::microseconds timestamp);
+        void findListenersPossiblyInRange(const RadioPosition& speaker, vector<int>& listenerIds) const;
+        void findIndexedListenersNear(
+            const GeoPoint& center,
+            float radiusNm,
+            const RadioPosition& speaker,
+            vector<int>& listenerIds) const;
+    public:
+        static float getRadioHeightFeet(const Altitude& altitude);
+        static float getRadioHorizonNm(float heightFeet1, float heightFeet2);
+        static float getApproximateDistanceNm(const GeoPoint& p1, const GeoPoint& p2);
     public:
         static void noopListener(shared_ptr<Intent> intent) { }
         static void noopTRansmissionCallback(shared_ptr<Transmission> transmission) { }
@@ -1318,8 +1627,9 @@ namespace world
     class UtteranceBuilder
     {
     private:
-        stringstream m_plainText;
+        string m_plainText;
         vector<Utterance::Part> m_parts;
+        const char* m_openPartSuffix;
     public:
         UtteranceBuilder();
     public:
@@ -1332,9 +1642,24 @@ namespace world
         void addAffirmation(const string& text);
         void addNegation(const string& text);
         void addPunctuation();
+        // copies the text and parts into an exactly sized utterance, and leaves the builder empty
+        // with its buffers kept, so that a reused builder doesn't grow them again
         shared_ptr<Utterance> getUtterance();
-    private:
-        Utterance::Part& addPart(const string& text, Utterance::PartType type);
+        // forgets all parts but keeps the buffers, so that the builder can be reused without allocations
+        void clear();
+        size_t textCapacity() const { return m_plainText.capacity(); }
+    public:
+        // low-level API: the text of a part is appended in place between beginPart() and endPart();
+        // the part is wrapped in the same markup as add*() would use for the given type
+        void beginPart(Utterance::PartType type, bool slowDown = false);
+        void append(const char* text, size_t length);
+        void append(const char* text);
+        void append(const string& text) { append(text.c_str(), text.length()); }
+        void append(char c);
+        void appendNumber(int value);
+        void endPart();
+    private:
+        void addPart(const string& text, Utterance::PartType type, bool slowDown = false);
     };
 
     class PhraseologyService
@@ -1966,6 +2291,15 @@ namespace world
             const GeoPoint& datum() const { return m_datum; }
             float elevation() const { return m_elevation; }
         };
+        struct Structure
+        {
+            Header header;
+            vector<shared_ptr<Runway>> runways;
+            vector<shared_ptr<ParkingStand>> parkingStands;
+            vector<shared_ptr<TaxiNode>> taxiNodes;
+            vector<shared_ptr<TaxiEdge>> taxiEdges;
+            vector<ControllerPosition::Structure> controllerPositions;
+        };
     private:
         struct MutableState
         {
@@ -2049,14 +2383,14 @@ namespace world
         };
     private:
         int m_id;
-        string m_name;
+        Symbol m_name;
         Type m_type;
         UniPoint m_location;
         float m_heading;
-        string m_widthCode;
+        Symbol m_widthCode;
         Aircraft::Category m_aircraftCategories;
         Aircraft::OperationType m_operationTypes;
-        vector<string> m_airlines;
+        vector<Symbol> m_airlines;
     public:
         ParkingStand(
             int _id,
@@ -2069,26 +2403,33 @@ namespace world
             Aircraft::OperationType _operationTypes = Aircraft::OperationType::None,
             const vector<string>& _airlines = {}) :
                 m_id(_id),
-                m_name(_name),
+                m_name(SymbolTable::internGlobal(_name)),
                 m_type(_type),
                 m_location(_location),
                 m_heading(_heading),
-                m_widthCode(_widthCode),
+                m_widthCode(SymbolTable::internGlobal(_widthCode)),
                 m_aircraftCategories(_aircraftCategories),
-                m_operationTypes(_operationTypes),
-                m_airlines(_airlines)
+                m_operationTypes(_operationTypes)
         {
+            m_airlines.reserve(_airlines.size());
+            for (const auto& airline : _airlines)
+            {
+                m_airlines.push_back(SymbolTable::internGlobal(airline));
+            }
         }
     public:
         const int id() const { return m_id; }
-        const string& name() const { return m_name; }
+        const string& name() const { return SymbolTable::getGlobalString(m_name); }
+        Symbol nameSymbol() const { return m_name; }
         const ParkingStand::Type type() const { return m_type; }
         const UniPoint& location() const { return m_location; }
         float heading() const { return m_heading; }
-        const string& widthCode() const { return m_widthCode; }
+        const string& widthCode() const { return SymbolTable::getGlobalString(m_widthCode); }
         Aircraft::Category aircraftCategories() const { return m_aircraftCategories; }
         Aircraft::OperationType operationTypes() const { return m_operationTypes; }
-        const vector<string>& airlines() const { return m_airlines; }
+        const vector<Symbol>& airlineSymbols() const { return m_airlines; }
+        vector<string> airlines() const;
+        bool hasAirline(Symbol airlineSymbol) const;
         bool hasAircraftCategory(Aircraft::Category category) const { 
             return ((m_aircraftCategories & category) == category);
         }
@@ -2251,9 +2592,9 @@ namespace world
         int m_id;
         Type m_type;
         bool m_isOneWay;
-        string m_highSpeedExitRunway;
-        string m_runwayEndName;
-        string m_name;
+        Symbol m_highSpeedExitRunway;
+        Symbol m_runwayEndName;
+        Symbol m_name;
         float m_lengthMeters;
         float m_heading;
         int m_nodeId1;
@@ -2284,7 +2625,8 @@ namespace world
         bool isOneWay() const { return m_isOneWay; }
         bool canFlipOver() const { return !m_isOneWay; }
         //const string& highSpeedExitRunway() const { return m_highSpeedExitRunway; }
-        const string& name() const { return m_name; }
+        const string& name() const { return SymbolTable::getGlobalString(m_name); }
+        Symbol nameSymbol() const { return m_name; }
         float lengthMeters() const { return m_lengthMeters; }
         float heading() const { return m_heading; }
         int nodeId1() const { return m_nodeId1; }
@@ -2296,8 +2638,10 @@ namespace world
         Flight::Phase flightPhaseAllocation() const { return m_flightPhaseAllocation; }
         int widthHint() const {return m_widthHint; }
     public:
-        bool isRunway(const string& runwayEndName) const { return m_runwayEndName == runwayEndName; }
-        bool isHighSpeedExitRunway(const string& runwayName) const { return m_highSpeedExitRunway == runwayName; }
+        bool isRunway(Symbol runwayEndName) const { return m_runwayEndName == runwayEndName; }
+        bool isRunway(const string& runwayEndName) const { return SymbolTable::getGlobalString(m_runwayEndName) == runwayEndName; }
+        bool isHighSpeedExitRunway(Symbol runwayName) const { return m_highSpeedExitRunway == runwayName; }
+        bool isHighSpeedExitRunway(const string& runwayName) const { return SymbolTable::getGlobalString(m_highSpeedExitRunway) == runwayName; }
         void setFlightPhaseAllocation(Flight::Phase allocation);
     public:
         static shared_ptr<TaxiEdge> flipOver(shared_ptr<TaxiEdge> source);
@@ -2375,6 +2719,12 @@ namespace world
             const GeoPoint& fromPoint,
             const GeoPoint& toPoint,
             CostFunction costFunction = lengthCostFunction);
+        // one search from the origin for all destinations; null where a destination cannot be reached
+        static vector<shared_ptr<TaxiPath>> findMany(
+            shared_ptr<TaxiNet> net,
+            shared_ptr<TaxiNode> from,
+            const vector<shared_ptr<TaxiNode>>& to,
+            CostFunction costFunction = lengthCostFunction);
 
         static float lengthCostFunction(shared_ptr<TaxiEdge> edge)
         {
@@ -2399,6 +2749,17 @@ namespace world
             shared_ptr<ControlFacility> tower = nullptr,
             shared_ptr<ControlledAirspace> airspace = nullptr);
 
+        static shared_ptr<Airport> assembleAirport(
+            shared_ptr<HostServices> host,
+            const Airport::Structure& structure,
+            shared_ptr<ControlledAirspace> airspace = nullptr);
+
+        static void attachAirportTower(
+            shared_ptr<HostServices> host,
+            shared_ptr<Airport> airport,
+            shared_ptr<ControlledAirspace> airspace,
+            const vector<ControllerPosition::Structure>& positions);
+
         static shared_ptr<ControlFacility> assembleAirportTower(
             shared_ptr<HostServices> host, 
             const Airport::Header& header,
@@ -2435,15 +2796,16 @@ namespace world
             const vector<shared_ptr<Runway>>& runways,
             const vector<shared_ptr<TaxiNode>>& nodes,
             const vector<shared_ptr<TaxiEdge>>& edges);
-    private:
-        static void fixUpEdgesAndRunways(
-            shared_ptr<HostServices> host,
-            shared_ptr<Airport> airport);
+
         static void linkAirportTowerAirspace(
             shared_ptr<HostServices> host,
             shared_ptr<Airport> airport,
             shared_ptr<ControlFacility> tower,
             shared_ptr<ControlledAirspace> airspace);
+    private:
+        static void fixUpEdgesAndRunways(
+            shared_ptr<HostServices> host,
+            shared_ptr<Airport> airport);
         static int countLeadingDigits(const string& s);
     };
 
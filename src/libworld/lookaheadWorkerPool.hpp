@@ -0,0 +1,318 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace world
+{
+    // Runs jobs ahead of the moment their results are needed, on a small pool of worker threads.
+    // Every job is submitted under a key, and its result is later taken by the same key:
+    // take() returns a ready result immediately, waits for a job which is running,
+    // and runs a job which has not started yet on the calling thread.
+    //
+    // Memory is bounded twice: by the number of queued jobs, beyond which submit() refuses
+    // new ones, and by the total size of results not taken yet, beyond which workers pause.
+    // Results which won't be taken must be discarded, otherwise the workers eventually stall.
+    template<class TKey, class TResult>
+    class LookaheadWorkerPool
+    {
+    public:
+        typedef function<shared_ptr<TResult>()> Job;
+        typedef function<size_t(const TResult& result)> SizeOfResult;
+        typedef function<bool()> WorkerStartHook;
+        typedef function<void()> WorkerStopHook;
+    private:
+        enum class EntryState
+        {
+            Queued = 0,
+            Running = 1,
+            Ready = 2
+        };
+        struct Entry
+        {
+            EntryState state;
+            Job job;
+            shared_ptr<TResult> result;
+            size_t size;
+            bool discarded; // while running
+        };
+    private:
+        const size_t m_maxQueuedCount;
+        const size_t m_maxReadyBytes;
+        const SizeOfResult m_sizeOfResult;
+        mutex m_mutex;
+        condition_variable m_workAvailable;
+        condition_variable m_entryCompleted;
+        unordered_map<TKey, Entry> m_entryByKey;
+        deque<TKey> m_queue;
+        size_t m_readyBytes;
+        bool m_stopRequested;
+        vector<thread> m_workers;
+    public:
+        LookaheadWorkerPool(
+            int _workerCount,
+            size_t _maxQueuedCount,
+            size_t _maxReadyBytes,
+            SizeOfResult _sizeOfResult,
+            WorkerStartHook _onWorkerStart = noopWorkerStart,
+            WorkerStopHook _onWorkerStop = noopWorkerStop
+        ) : m_maxQueuedCount(_maxQueuedCount),
+            m_maxReadyBytes(_maxReadyBytes),
+            m_sizeOfResult(_sizeOfResult),
+            m_readyBytes(0),
+            m_stopRequested(false)
+        {
+            if (_workerCount < 1)
+            {
+                throw runtime_error("LookaheadWorkerPool: at least one worker is required");
+            }
+            for (int i = 0 ; i < _workerCount ; i++)
+            {
+                m_workers.emplace_back([this, _onWorkerStart, _onWorkerStop]() {
+                    if (_onWorkerStart())
+                    {
+                        runWorker();
+                    }
+                    _onWorkerStop();
+                });
+            }
+        }
+        LookaheadWorkerPool(const LookaheadWorkerPool& other) = delete;
+        LookaheadWorkerPool& operator=(const LookaheadWorkerPool& other) = delete;
+        ~LookaheadWorkerPool()
+        {
+            stop();
+        }
+    public:
+        // returns false if the key is already known, or if the queue is full
+        bool submit(const TKey& key, Job job)
+        {
+            {
+                lock_guard<mutex> lock(m_mutex);
+                if (m_stopRequested || m_queue.size() >= m_maxQueuedCount || m_entryByKey.count(key) > 0)
+                {
+                    return false;
+                }
+                m_entryByKey.insert({ key, { EntryState::Queued, job, nullptr, 0, false } });
+                m_queue.push_back(key);
+            }
+            m_workAvailable.notify_one();
+            return true;
+        }
+
+        // returns nullptr if the key is unknown, or if its job has failed
+        shared_ptr<TResult> take(const TKey& key)
+        {
+            Job jobToRunHere;
+            shared_ptr<TResult> result = takeEntry(key, jobToRunHere);
+            return jobToRunHere ? jobToRunHere() : result;
+        }
+
+        // same as take(), except that a job which has not started yet is removed rather than run,
+        // and nullptr is returned; for callers which have a cheaper way of doing the work themselves
+        shared_ptr<TResult> takeIfStarted(const TKey& key)
+        {
+            Job notStartedJob;
+            return takeEntry(key, notStartedJob);
+        }
+
+        void discard(const TKey& key)
+        {
+            {
+                lock_guard<mutex> lock(m_mutex);
+                auto found = m_entryByKey.find(key);
+                if (found == m_entryByKey.end())
+                {
+                    return;
+                }
+                discardEntry(found);
+            }
+            m_workAvailable.notify_one();
+            m_entryCompleted.notify_all();
+        }
+
+        void clear()
+        {
+            {
+                lock_guard<mutex> lock(m_mutex);
+                for (auto it = m_entryByKey.begin() ; it != m_entryByKey.end() ; )
+                {
+                    auto next = std::next(it);
+                    discardEntry(it);
+                    it = next;
+                }
+            }
+            m_workAvailable.notify_all();
+            m_entryCompleted.notify_all();
+        }
+
+        void stop()
+        {
+            {
+                lock_guard<mutex> lock(m_mutex);
+                if (m_stopRequested && m_workers.empty())
+                {
+                    return;
+                }
+                m_stopRequested = true;
+            }
+            m_workAvailable.notify_all();
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+            m_workers.clear();
+        }
+
+        size_t queuedCount()
+        {
+            lock_guard<mutex> lock(m_mutex);
+            return m_queue.size();
+        }
+
+        size_t readyBytes()
+        {
+            lock_guard<mutex> lock(m_mutex);
+            return m_readyBytes;
+        }
+    public:
+        static bool noopWorkerStart() { return true; }
+        static void noopWorkerStop() { }
+    private:
+        // removes the entry: returns its result, or moves out its job if it has not started yet
+        shared_ptr<TResult> takeEntry(const TKey& key, Job& notStartedJob)
+        {
+            unique_lock<mutex> lock(m_mutex);
+            auto found = m_entryByKey.find(key);
+            if (found == m_entryByKey.end())
+            {
+                return nullptr;
+            }
+
+            if (found->second.state == EntryState::Running)
+            {
+                m_entryCompleted.wait(lock, [this, &key]() {
+                    auto entry = m_entryByKey.find(key);
+                    return entry == m_entryByKey.end() || entry->second.state != EntryState::Running;
+                });
+                found = m_entryByKey.find(key);
+                if (found == m_entryByKey.end())
+                {
+                    return nullptr;
+                }
+            }
+
+            if (found->second.state == EntryState::Queued)
+            {
+                notStartedJob = std::move(found->second.job);
+                removeFromQueue(key);
+                m_entryByKey.erase(found);
+                return nullptr;
+            }
+
+            shared_ptr<TResult> result = found->second.result;
+            m_readyBytes -= found->second.size;
+            m_entryByKey.erase(found);
+            lock.unlock();
+            m_workAvailable.notify_one();
+            return result;
+        }
+
+        void runWorker()
+        {
+            while (true)
+            {
+                TKey key;
+                Job job;
+                {
+                    unique_lock<mutex> lock(m_mutex);
+                    m_workAvailable.wait(lock, [this]() {
+                        return m_stopRequested || (!m_queue.empty() && m_readyBytes < m_maxReadyBytes);
+                    });
+                    if (m_stopRequested)
+                    {
+                        return;
+                    }
+
+                    key = m_queue.front();
+                    m_queue.pop_front();
+                    Entry& entry = m_entryByKey.at(key);
+                    entry.state = EntryState::Running;
+                    job = std::move(entry.job);
+                }
+
+                shared_ptr<TResult> result;
+                try
+                {
+                    result = job();
+                }
+                catch (const exception&)
+                {
+                    // take() returns nullptr, and the caller falls back to doing the work itself
+                }
+
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    auto found = m_entryByKey.find(key);
+                    if (found->second.discarded)
+                    {
+                        m_entryByKey.erase(found);
+                    }
+                    else
+                    {
+                        found->second.state = EntryState::Ready;
+                        found->second.result = result;
+                        found->second.size = result ? m_sizeOfResult(*result) : 0;
+                        m_readyBytes += found->second.size;
+                    }
+                }
+                m_entryCompleted.notify_all();
+            }
+        }
+
+        // must be called under the lock
+        void discardEntry(typename unordered_map<TKey, Entry>::iterator entry)
+        {
+            switch (entry->second.state)
+            {
+            case EntryState::Queued:
+                removeFromQueue(entry->first);
+                m_entryByKey.erase(entry);
+                break;
+            case EntryState::Running:
+                // the worker erases the entry once the job completes
+                entry->second.discarded = true;
+                break;
+            case EntryState::Ready:
+                m_readyBytes -= entry->second.size;
+                m_entryByKey.erase(entry);
+                break;
+            }
+        }
+
+        void removeFromQueue(const TKey& key)
+        {
+            for (auto it = m_queue.begin() ; it != m_queue.end() ; ++it)
+            {
+                if (*it == key)
+                {
+                    m_queue.erase(it);
+                    return;
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,180 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace world
+{
+    // Runs a loop body over a range of indices on a fixed pool of worker threads, shared by all callers.
+    // Indices are handed out in chunks from an atomic counter, so a run costs one allocation regardless
+    // of its size. The calling thread takes chunks as well, so a run completes even if all workers
+    // are busy with runs of other callers; concurrent runs are served by the workers in FIFO order.
+    // run() returns once every index has completed; the first exception thrown by the body is rethrown then.
+    class ParallelForPool
+    {
+    public:
+        typedef function<void(int index)> Body;
+    private:
+        struct Run
+        {
+            const Body* body;
+            size_t count;
+            size_t chunkSize;
+            atomic<size_t> nextIndex;
+            atomic<size_t> completedCount;
+            mutex completionMutex;
+            condition_variable completed;
+            exception_ptr failure;
+        };
+    private:
+        mutex m_mutex;
+        condition_variable m_runAvailable;
+        deque<shared_ptr<Run>> m_runs;
+        bool m_stopping;
+        vector<thread> m_workers;
+    public:
+        explicit ParallelForPool(int workerCount) :
+            m_stopping(false)
+        {
+            for (int i = 0 ; i < workerCount ; i++)
+            {
+                m_workers.emplace_back([this]() { workerLoop(); });
+            }
+        }
+        ParallelForPool(const ParallelForPool& other) = delete;
+        ParallelForPool& operator=(const ParallelForPool& other) = delete;
+        ~ParallelForPool()
+        {
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_runAvailable.notify_all();
+            for (auto& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+    public:
+        void run(size_t count, const Body& body)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            auto run = make_shared<Run>();
+            run->body = &body;
+            run->count = count;
+            // a few chunks per thread, so that threads which got cheap indices take over from the others
+            run->chunkSize = max((size_t)1, count / ((m_workers.size() + 1) * 4));
+            run->nextIndex = 0;
+            run->completedCount = 0;
+
+            if (count > run->chunkSize && !m_workers.empty())
+            {
+                {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_runs.push_back(run);
+                }
+                m_runAvailable.notify_all();
+            }
+
+            while (runChunk(*run))
+            {
+            }
+
+            {
+                unique_lock<mutex> lock(run->completionMutex);
+                run->completed.wait(lock, [&run]() { return run->completedCount.load() == run->count; });
+            }
+
+            if (run->failure)
+            {
+                rethrow_exception(run->failure);
+            }
+        }
+
+        size_t workerCount() const
+        {
+            return m_workers.size();
+        }
+
+    private:
+
+        void workerLoop()
+        {
+            while (true)
+            {
+                shared_ptr<Run> run;
+                {
+                    unique_lock<mutex> lock(m_mutex);
+                    m_runAvailable.wait(lock, [this]() { return m_stopping || !m_runs.empty(); });
+                    if (m_stopping)
+                    {
+                        return;
+                    }
+                    run = m_runs.front();
+                }
+
+                if (!runChunk(*run))
+                {
+                    // every index is taken; the run leaves the queue, whoever took the last chunk completes it
+                    lock_guard<mutex> lock(m_mutex);
+                    if (!m_runs.empty() && m_runs.front() == run)
+                    {
+                        m_runs.pop_front();
+                    }
+                }
+            }
+        }
+
+        // returns false if no indices were left to take
+        static bool runChunk(Run& run)
+        {
+            size_t begin = run.nextIndex.fetch_add(run.chunkSize);
+            if (begin >= run.count)
+            {
+                return false;
+            }
+            size_t end = min(begin + run.chunkSize, run.count);
+
+            for (size_t index = begin ; index < end ; index++)
+            {
+                try
+                {
+                    (*run.body)((int)index);
+                }
+                catch (...)
+                {
+                    lock_guard<mutex> lock(run.completionMutex);
+                    if (!run.failure)
+                    {
+                        run.failure = current_exception();
+                    }
+                }
+            }
+
+            if (run.completedCount.fetch_add(end - begin) + (end - begin) == run.count)
+            {
+                lock_guard<mutex> lock(run.completionMutex);
+                run.completed.notify_all();
+            }
+            return true;
+        }
+    };
+}
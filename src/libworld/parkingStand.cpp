@@ -0,0 +1,29 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <algorithm>
+#include "libworld.h"
+
+using namespace std;
+
+namespace world
+{
+    vector<string> ParkingStand::airlines() const
+    {
+        vector<string> result;
+        result.reserve(m_airlines.size());
+
+        for (Symbol airline : m_airlines)
+        {
+            result.push_back(SymbolTable::getGlobalString(airline));
+        }
+
+        return result;
+    }
+
+    bool ParkingStand::hasAirline(Symbol airlineSymbol) const
+    {
+        return (find(m_airlines.begin(), m_airlines.end(), airlineSymbol) != m_airlines.end());
+    }
+}
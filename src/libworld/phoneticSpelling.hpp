@@ -0,0 +1,162 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <string>
+#include <cctype>
+
+using namespace std;
+
+namespace world
+{
+    // How callsigns, runways, frequencies and codes are read out on the radio.
+    // Every rule appends to a sink which has append(char) and append(const char*):
+    // PhraseologyTemplate spells straight into an UtteranceBuilder, and
+    // SimplePhraseologyService spells into a string through StringSink.
+    class PhoneticSpelling
+    {
+    public:
+        class StringSink
+        {
+        private:
+            string& m_text;
+        public:
+            explicit StringSink(string& _text) :
+                m_text(_text)
+            {
+            }
+        public:
+            void append(char c) { m_text += c; }
+            void append(const char* text) { m_text += text; }
+        };
+    public:
+
+        static const char* letter(char c)
+        {
+            static const char* alphabet[26] = {
+                "Alpha", "Bravo", "Charlie", "Delta", "Echo", "Foxtrot", "Golf", "Hotel", "India",
+                "Juliett", "Kilo", "Lima", "Mike", "November", "Oscar", "Papa", "Quebec", "Romeo",
+                "Sierra", "Tango", "Uniform", "Victor", "Whiskey", "X-ray", "Yankee", "Zulu"
+            };
+            int index = toupper(c) - 'A';
+            return index >= 0 && index < 26
+                ? alphabet[index]
+                : "?";
+        }
+
+        static const char* digit(char c)
+        {
+            static const char* digits[10] = {
+                "Zeero", "One", "Too", "Tree", "Fower", "Fife", "Six", "Seven", "Ait", "Niner"
+            };
+            int index = c - '0';
+            return index >= 0 && index < 10
+                ? digits[index]
+                : "?";
+        }
+
+        // digits are spoken one by one, letters as one word: "DAL123" -> "DAL 1 2 3"
+        template<class TSink>
+        static void appendCallsign(TSink& sink, const char* callsign, size_t length)
+        {
+            for (size_t i = 0 ; i < length ; i++)
+            {
+                if (i > 0 && (isdigit(callsign[i]) || isdigit(callsign[i-1])))
+                {
+                    sink.append(' ');
+                }
+                sink.append(callsign[i]);
+            }
+        }
+
+        // "04L" -> "0 4 Left"
+        template<class TSink>
+        static void appendRunway(TSink& sink, const char* name, size_t length)
+        {
+            for (size_t i = 0 ; i < length ; i++)
+            {
+                if (i > 0)
+                {
+                    sink.append(' ');
+                }
+                switch (name[i])
+                {
+                case 'L': sink.append("Left"); break;
+                case 'R': sink.append("Right"); break;
+                case 'C': sink.append("Center"); break;
+                default: sink.append(name[i]);
+                }
+            }
+        }
+
+        // trailing zeros of the kHz part are omitted: 118000 -> "1 1 8 point 0", 132025 -> "1 3 2 point 0 2 5"
+        template<class TSink>
+        static void appendFrequency(TSink& sink, int khz)
+        {
+            int mhzOnly = khz / 1000;
+            int khzOnly = khz % 1000;
+
+            sink.append((char)('0' + mhzOnly / 100));
+            sink.append(' ');
+            sink.append((char)('0' + (mhzOnly / 10) % 10));
+            sink.append(' ');
+            sink.append((char)('0' + mhzOnly % 10));
+            sink.append(" point ");
+            sink.append((char)('0' + khzOnly / 100));
+
+            if (khzOnly % 100 != 0)
+            {
+                sink.append(' ');
+                sink.append((char)('0' + (khzOnly / 10) % 10));
+            }
+            if (khzOnly % 10 != 0)
+            {
+                sink.append(' ');
+                sink.append((char)('0' + khzOnly % 10));
+            }
+        }
+
+        // "A3" -> "Alpha Tree"
+        template<class TSink>
+        static void appendPhonetic(TSink& sink, const char* s, size_t length)
+        {
+            for (size_t i = 0 ; i < length ; i++)
+            {
+                if (i > 0)
+                {
+                    sink.append(' ');
+                }
+
+                char c = s[i];
+                if (c >= '0' && c <= '9')
+                {
+                    sink.append(digit(c));
+                }
+                else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                {
+                    sink.append(letter(c));
+                }
+                else
+                {
+                    sink.append(c);
+                }
+            }
+        }
+
+        // every character spoken separately: "4521" -> "4 5 2 1"
+        template<class TSink>
+        static void appendDigits(TSink& sink, const char* s, size_t length)
+        {
+            for (size_t i = 0 ; i < length ; i++)
+            {
+                if (i > 0)
+                {
+                    sink.append(' ');
+                }
+                sink.append(s[i]);
+            }
+        }
+    };
+}
@@ -0,0 +1,252 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include "libworld.h"
+#include "phoneticSpelling.hpp"
+
+using namespace std;
+
+namespace world
+{
+    // A phrase compiled once into a list of literal parts and data slots, which renders
+    // straight into an UtteranceBuilder: slot values are spelled in place, without temporaries.
+    //
+    // Pattern syntax:
+    //
+    //   literal text           a Text part; runs of literal text are trimmed
+    //   ,                      a Punctuation part
+    //   {N:spelling|modifiers} slot N spelled as one of: plain, callsign, runway, frequency,
+    //                          phonetic, digits, number; spelling defaults to plain
+    //   {=text|modifiers}      literal text which needs modifiers, or which contains commas
+    //
+    // Modifiers: 'slow', and a part type: 'text', 'data', 'farewell', 'affirmation', 'negation'.
+    // Slots are Data parts by default, and {=...} literals are Text parts.
+    //
+    // Example: "{0:callsign}, contact tower on {1:frequency} {=have a good one|farewell}"
+    class PhraseologyTemplate
+    {
+    public:
+        enum class Spelling
+        {
+            Plain = 0,
+            Callsign = 1,
+            Runway = 2,
+            Frequency = 3,
+            Phonetic = 4,
+            Digits = 5,
+            Number = 6
+        };
+        // a slot value is either a string or an integer, depending on the spelling of the slot
+        struct Argument
+        {
+            const char* text;
+            size_t length;
+            int number;
+
+            Argument(const string& s) : text(s.c_str()), length(s.length()), number(0) { }
+            Argument(const char* s) : text(s), length(strlen(s)), number(0) { }
+            Argument(int n) : text(""), length(0), number(n) { }
+        };
+    private:
+        struct Segment
+        {
+            Utterance::PartType type;
+            bool slowDown;
+            int slotIndex; // -1 for literals
+            Spelling spelling;
+            string literal;
+        };
+    private:
+        vector<Segment> m_segments;
+        int m_slotCount;
+    public:
+        PhraseologyTemplate() :
+            m_slotCount(0)
+        {
+        }
+    public:
+        int slotCount() const { return m_slotCount; }
+
+        template<class... TArgs>
+        void render(UtteranceBuilder& builder, const TArgs&... args) const
+        {
+            const Argument arguments[] = { Argument(args)..., Argument(0) };
+            renderArguments(builder, arguments, (int)sizeof...(TArgs));
+        }
+
+        void renderArguments(UtteranceBuilder& builder, const Argument* arguments, int argumentCount) const
+        {
+            if (argumentCount < m_slotCount)
+            {
+                throw runtime_error(
+                    "PhraseologyTemplate: expected " + to_string(m_slotCount) +
+                    " arguments, but got " + to_string(argumentCount));
+            }
+
+            for (const auto& segment : m_segments)
+            {
+                if (segment.type == Utterance::PartType::Punctuation)
+                {
+                    builder.addPunctuation();
+                    continue;
+                }
+
+                builder.beginPart(segment.type, segment.slowDown);
+                if (segment.slotIndex < 0)
+                {
+                    builder.append(segment.literal);
+                }
+                else
+                {
+                    appendSpelled(builder, segment.spelling, arguments[segment.slotIndex]);
+                }
+                builder.endPart();
+            }
+        }
+
+    public:
+
+        static PhraseologyTemplate compile(const string& pattern)
+        {
+            PhraseologyTemplate result;
+            string literal;
+
+            for (size_t i = 0 ; i < pattern.length() ; i++)
+            {
+                char c = pattern[i];
+                if (c == ',')
+                {
+                    result.addLiteral(literal, Utterance::PartType::Text, false);
+                    result.m_segments.push_back({ Utterance::PartType::Punctuation, false, -1, Spelling::Plain, "" });
+                }
+                else if (c == '{')
+                {
+                    size_t closing = pattern.find('}', i);
+                    if (closing == string::npos)
+                    {
+                        throw runtime_error("PhraseologyTemplate: missing '}' in pattern: " + pattern);
+                    }
+                    result.addLiteral(literal, Utterance::PartType::Text, false);
+                    result.addPlaceholder(pattern.substr(i + 1, closing - i - 1), pattern);
+                    i = closing;
+                }
+                else
+                {
+                    literal += c;
+                }
+            }
+
+            result.addLiteral(literal, Utterance::PartType::Text, false);
+            return result;
+        }
+
+        static void appendSpelled(UtteranceBuilder& builder, Spelling spelling, const Argument& argument)
+        {
+            switch (spelling)
+            {
+            case Spelling::Callsign:
+                PhoneticSpelling::appendCallsign(builder, argument.text, argument.length);
+                break;
+            case Spelling::Runway:
+                PhoneticSpelling::appendRunway(builder, argument.text, argument.length);
+                break;
+            case Spelling::Frequency:
+                PhoneticSpelling::appendFrequency(builder, argument.number);
+                break;
+            case Spelling::Phonetic:
+                PhoneticSpelling::appendPhonetic(builder, argument.text, argument.length);
+                break;
+            case Spelling::Digits:
+                PhoneticSpelling::appendDigits(builder, argument.text, argument.length);
+                break;
+            case Spelling::Number:
+                builder.appendNumber(argument.number);
+                break;
+            default:
+                builder.append(argument.text, argument.length);
+                break;
+            }
+        }
+
+    private:
+
+        void addLiteral(string& literal, Utterance::PartType type, bool slowDown)
+        {
+            size_t first = literal.find_first_not_of(' ');
+            if (first != string::npos)
+            {
+                size_t last = literal.find_last_not_of(' ');
+                m_segments.push_back({ type, slowDown, -1, Spelling::Plain, literal.substr(first, last - first + 1) });
+            }
+            literal.clear();
+        }
+
+        void addPlaceholder(const string& placeholder, const string& pattern)
+        {
+            size_t modifiersStart = placeholder.find('|');
+            string head = placeholder.substr(0, modifiersStart);
+            bool isLiteral = (!head.empty() && head[0] == '=');
+            Segment segment = {
+                isLiteral ? Utterance::PartType::Text : Utterance::PartType::Data,
+                false,
+                -1,
+                Spelling::Plain,
+                ""
+            };
+
+            if (isLiteral)
+            {
+                segment.literal = head.substr(1);
+            }
+            else
+            {
+                size_t colon = head.find(':');
+                string index = head.substr(0, colon);
+                if (index.empty() || index.find_first_not_of("0123456789") != string::npos)
+                {
+                    throw runtime_error("PhraseologyTemplate: bad slot '" + placeholder + "' in pattern: " + pattern);
+                }
+                segment.slotIndex = stoi(index);
+                segment.spelling = colon == string::npos
+                    ? Spelling::Plain
+                    : parseSpelling(head.substr(colon + 1), pattern);
+                m_slotCount = max(m_slotCount, segment.slotIndex + 1);
+            }
+
+            while (modifiersStart != string::npos)
+            {
+                size_t next = placeholder.find('|', modifiersStart + 1);
+                string modifier = placeholder.substr(modifiersStart + 1, next == string::npos ? string::npos : next - modifiersStart - 1);
+                if (modifier == "slow") segment.slowDown = true;
+                else if (modifier == "text") segment.type = Utterance::PartType::Text;
+                else if (modifier == "data") segment.type = Utterance::PartType::Data;
+                else if (modifier == "farewell") segment.type = Utterance::PartType::Farewell;
+                else if (modifier == "affirmation") segment.type = Utterance::PartType::Affirmation;
+                else if (modifier == "negation") segment.type = Utterance::PartType::Negation;
+                else throw runtime_error("PhraseologyTemplate: unknown modifier '" + modifier + "' in pattern: " + pattern);
+                modifiersStart = next;
+            }
+
+            m_segments.push_back(segment);
+        }
+
+        static Spelling parseSpelling(const string& name, const string& pattern)
+        {
+            if (name == "plain") return Spelling::Plain;
+            if (name == "callsign") return Spelling::Callsign;
+            if (name == "runway") return Spelling::Runway;
+            if (name == "frequency") return Spelling::Frequency;
+            if (name == "phonetic") return Spelling::Phonetic;
+            if (name == "digits") return Spelling::Digits;
+            if (name == "number") return Spelling::Number;
+            throw runtime_error("PhraseologyTemplate: unknown spelling '" + name + "' in pattern: " + pattern);
+        }
+    };
+}
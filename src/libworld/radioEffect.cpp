@@ -0,0 +1,298 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <algorithm>
+#include <cmath>
+#include "libworld.h"
+#include "radioEffect.hpp"
+
+#if ATC_RADIO_EFFECT_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace world
+{
+    static const float pcm16ToFloat = 1.0f / 32768.0f;
+    static const float noiseToFloat = 1.0f / 2147483648.0f;
+
+    RadioEffect::RadioEffect(int _sampleRate, const Settings& _settings, uint32_t _noiseSeed, bool _useSimd) :
+        m_sampleRate(_sampleRate),
+        m_settings(_settings),
+        m_useSimd(_useSimd && isSimdAvailable()),
+        m_highPass(createHighPass(_sampleRate, _settings.highPassHz)),
+        m_lowPass(createLowPass(_sampleRate, _settings.lowPassHz)),
+        m_hasLowPass(_settings.lowPassHz > 0 && _settings.lowPassHz < _sampleRate * 0.45f)
+    {
+        if (_sampleRate <= 0)
+        {
+            throw runtime_error("RadioEffect: invalid sample rate " + to_string(_sampleRate));
+        }
+
+        // xorshift gets stuck at zero, and every lane needs its own sequence
+        uint32_t seed = _noiseSeed != 0 ? _noiseSeed : 1;
+        for (int i = 0 ; i < 4 ; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            m_noiseState[i] = seed != 0 ? seed : 1;
+        }
+    }
+
+    void RadioEffect::processPcm16(int16_t* samples, size_t count)
+    {
+        for (size_t offset = 0 ; offset < count ; offset += BlockSize)
+        {
+            size_t blockCount = min((size_t)BlockSize, count - offset);
+            convertToFloat(samples + offset, m_block, blockCount, m_useSimd);
+            processBlock(m_block, blockCount);
+            convertToPcm16(m_block, samples + offset, blockCount, m_useSimd);
+        }
+    }
+
+    void RadioEffect::processBlock(float* samples, size_t count)
+    {
+        applyFilters(samples, count);
+        if (m_useSimd)
+        {
+            applyClipAndNoise(samples, count);
+        }
+        else
+        {
+            applyClipAndNoiseScalar(samples, count);
+        }
+    }
+
+    RadioEffect::Settings RadioEffect::getSettings(Actor::Nature nature, Actor::Role role, Actor::RadioQuality quality)
+    {
+        if (nature == Actor::Nature::Human)
+        {
+            // the user's co-pilot speaks in the cockpit, not over the radio
+            return { 250, 0, 0, 0, 1.1f };
+        }
+
+        Settings settings;
+        switch (quality)
+        {
+        case Actor::RadioQuality::Good:
+            settings = { 2500, 5500, 1.5f, 0.008f, 1.1f };
+            break;
+        case Actor::RadioQuality::Poor:
+            settings = { 1500, 3500, 4.0f, 0.045f, 1.1f };
+            break;
+        default:
+            settings = { 2000, 4500, 2.5f, 0.02f, 1.1f };
+        }
+
+        settings.highPassHz += (role == Actor::Role::Pilot ? 500 : -500);
+        return settings;
+    }
+
+    bool RadioEffect::isSimdAvailable()
+    {
+#if ATC_RADIO_EFFECT_SSE2
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void RadioEffect::applyFilters(float* samples, size_t count)
+    {
+        // coefficients and state are kept in locals, so that the compiler keeps them in registers;
+        // the terms are grouped so that only one multiply and one add depend on the previous output
+        const float hb0 = m_highPass.b0, hb1 = m_highPass.b1, hb2 = m_highPass.b2, ha1 = m_highPass.a1, ha2 = m_highPass.a2;
+        float hz1 = m_highPass.z1, hz2 = m_highPass.z2;
+
+        if (m_hasLowPass)
+        {
+            const float lb0 = m_lowPass.b0, lb1 = m_lowPass.b1, lb2 = m_lowPass.b2, la1 = m_lowPass.a1, la2 = m_lowPass.a2;
+            float lz1 = m_lowPass.z1, lz2 = m_lowPass.z2;
+
+            for (size_t i = 0 ; i < count ; i++)
+            {
+                float x = samples[i];
+                float h = hb0 * x + hz1;
+                hz1 = (hb1 * x + hz2) - ha1 * h;
+                hz2 = hb2 * x - ha2 * h;
+
+                float l = lb0 * h + lz1;
+                lz1 = (lb1 * h + lz2) - la1 * l;
+                lz2 = lb2 * h - la2 * l;
+                samples[i] = l;
+            }
+
+            m_lowPass.z1 = lz1;
+            m_lowPass.z2 = lz2;
+        }
+        else
+        {
+            for (size_t i = 0 ; i < count ; i++)
+            {
+                float x = samples[i];
+                float h = hb0 * x + hz1;
+                hz1 = (hb1 * x + hz2) - ha1 * h;
+                hz2 = hb2 * x - ha2 * h;
+                samples[i] = h;
+            }
+        }
+
+        m_highPass.z1 = hz1;
+        m_highPass.z2 = hz2;
+    }
+
+    void RadioEffect::applyClipAndNoise(float* samples, size_t count)
+    {
+#if ATC_RADIO_EFFECT_SSE2
+        const bool clip = m_settings.drive > 0;
+        const __m128 drive = _mm_set1_ps(m_settings.drive);
+        const __m128 limit = _mm_set1_ps(3.0f);
+        const __m128 minusLimit = _mm_set1_ps(-3.0f);
+        const __m128 c27 = _mm_set1_ps(27.0f);
+        const __m128 c9 = _mm_set1_ps(9.0f);
+        const __m128 noiseScale = _mm_set1_ps(m_settings.noiseLevel * noiseToFloat);
+        const __m128 gain = _mm_set1_ps(m_settings.outputGain);
+        __m128i state = _mm_loadu_si128((const __m128i*)m_noiseState);
+
+        size_t i = 0;
+        for ( ; i + 4 <= count ; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(samples + i);
+            if (clip)
+            {
+                // x * (27 + x^2) / (27 + 9 * x^2), a rational approximation of tanh() within [-3, 3]
+                x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(x, drive), minusLimit), limit);
+                __m128 x2 = _mm_mul_ps(x, x);
+                x = _mm_div_ps(_mm_mul_ps(x, _mm_add_ps(c27, x2)), _mm_add_ps(c27, _mm_mul_ps(c9, x2)));
+            }
+
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+            state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+            state = _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+            x = _mm_add_ps(x, _mm_mul_ps(_mm_cvtepi32_ps(state), noiseScale));
+
+            _mm_storeu_ps(samples + i, _mm_mul_ps(x, gain));
+        }
+
+        _mm_storeu_si128((__m128i*)m_noiseState, state);
+        applyClipAndNoiseScalar(samples + i, count - i);
+#else
+        applyClipAndNoiseScalar(samples, count);
+#endif
+    }
+
+    void RadioEffect::applyClipAndNoiseScalar(float* samples, size_t count)
+    {
+        const bool clip = m_settings.drive > 0;
+        const float noiseScale = m_settings.noiseLevel * noiseToFloat;
+
+        for (size_t i = 0 ; i < count ; i++)
+        {
+            float x = samples[i];
+            if (clip)
+            {
+                x = min(max(x * m_settings.drive, -3.0f), 3.0f);
+                float x2 = x * x;
+                x = (x * (27.0f + x2)) / (27.0f + 9.0f * x2);
+            }
+
+            // lanes advance in the same order as in the SIMD loop, so both produce the same noise
+            uint32_t& state = m_noiseState[i % 4];
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            x += (float)(int32_t)state * noiseScale;
+
+            samples[i] = x * m_settings.outputGain;
+        }
+    }
+
+    void RadioEffect::convertToFloat(const int16_t* source, float* target, size_t count, bool useSimd)
+    {
+        size_t i = 0;
+#if ATC_RADIO_EFFECT_SSE2
+        if (useSimd)
+        {
+            const __m128 scale = _mm_set1_ps(pcm16ToFloat);
+            for ( ; i + 8 <= count ; i += 8)
+            {
+                __m128i pcm = _mm_loadu_si128((const __m128i*)(source + i));
+                // sign-extend 16-bit samples into the upper halves, then shift them down
+                __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+                __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+                _mm_storeu_ps(target + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+                _mm_storeu_ps(target + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+            }
+        }
+#endif
+        for ( ; i < count ; i++)
+        {
+            target[i] = (float)source[i] * pcm16ToFloat;
+        }
+    }
+
+    void RadioEffect::convertToPcm16(const float* source, int16_t* target, size_t count, bool useSimd)
+    {
+        size_t i = 0;
+#if ATC_RADIO_EFFECT_SSE2
+        if (useSimd)
+        {
+            const __m128 scale = _mm_set1_ps(32767.0f);
+            const __m128 limit = _mm_set1_ps(1.0f);
+            const __m128 minusLimit = _mm_set1_ps(-1.0f);
+            for ( ; i + 8 <= count ; i += 8)
+            {
+                __m128 low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i), minusLimit), limit);
+                __m128 high = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source + i + 4), minusLimit), limit);
+                __m128i pcm = _mm_packs_epi32(
+                    _mm_cvtps_epi32(_mm_mul_ps(low, scale)),
+                    _mm_cvtps_epi32(_mm_mul_ps(high, scale)));
+                _mm_storeu_si128((__m128i*)(target + i), pcm);
+            }
+        }
+#endif
+        for ( ; i < count ; i++)
+        {
+            float sample = min(max(source[i], -1.0f), 1.0f);
+            target[i] = (int16_t)lrintf(sample * 32767.0f);
+        }
+    }
+
+    RadioEffect::Biquad RadioEffect::createHighPass(int sampleRate, float frequency)
+    {
+        // Butterworth, after the RBJ audio EQ cookbook
+        float clamped = min(max(frequency, 1.0f), sampleRate * 0.45f);
+        double w0 = 2 * 3.14159265358979323846 * clamped / sampleRate;
+        double alpha = sin(w0) / (2 * 0.7071067811865476);
+        double cosw0 = cos(w0);
+        double a0 = 1 + alpha;
+
+        return {
+            (float)((1 + cosw0) / 2 / a0),
+            (float)(-(1 + cosw0) / a0),
+            (float)((1 + cosw0) / 2 / a0),
+            (float)(-2 * cosw0 / a0),
+            (float)((1 - alpha) / a0),
+            0, 0
+        };
+    }
+
+    RadioEffect::Biquad RadioEffect::createLowPass(int sampleRate, float frequency)
+    {
+        float clamped = min(max(frequency, 1.0f), sampleRate * 0.45f);
+        double w0 = 2 * 3.14159265358979323846 * clamped / sampleRate;
+        double alpha = sin(w0) / (2 * 0.7071067811865476);
+        double cosw0 = cos(w0);
+        double a0 = 1 + alpha;
+
+        return {
+            (float)((1 - cosw0) / 2 / a0),
+            (float)((1 - cosw0) / a0),
+            (float)((1 - cosw0) / 2 / a0),
+            (float)(-2 * cosw0 / a0),
+            (float)((1 - alpha) / a0),
+            0, 0
+        };
+    }
+}
@@ -0,0 +1,73 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "libworld.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ATC_RADIO_EFFECT_SSE2 1
+#endif
+
+using namespace std;
+
+namespace world
+{
+    // Makes synthesized speech sound like it came over VHF radio. Mono 16-bit PCM is processed
+    // in place, in blocks of float samples, through the chain:
+    //
+    //   band-pass (2nd-order high-pass and low-pass) -> drive into a soft clipper -> white noise -> output gain
+    //
+    // The conversions, the clipper and the noise generator run 4 samples at a time with SSE2 where available;
+    // the filters are recursive, and run one sample at a time over the whole block without branches.
+    // The effect is stateful and meant to process one utterance from start to end.
+    class RadioEffect
+    {
+    public:
+        struct Settings
+        {
+            float highPassHz;
+            float lowPassHz;   // 0 to disable
+            float drive;       // gain into the soft clipper; 0 to disable clipping
+            float noiseLevel;  // relative to full scale; 0 to disable
+            float outputGain;
+        };
+    private:
+        // transposed direct form II
+        struct Biquad
+        {
+            float b0, b1, b2, a1, a2;
+            float z1, z2;
+        };
+        enum { BlockSize = 256 };
+    private:
+        const int m_sampleRate;
+        const Settings m_settings;
+        const bool m_useSimd;
+        Biquad m_highPass;
+        Biquad m_lowPass;
+        bool m_hasLowPass;
+        uint32_t m_noiseState[4];
+        alignas(16) float m_block[BlockSize];
+    public:
+        RadioEffect(int _sampleRate, const Settings& _settings, uint32_t _noiseSeed = 1, bool _useSimd = true);
+    public:
+        void processPcm16(int16_t* samples, size_t count);
+        void processBlock(float* samples, size_t count);
+        const Settings& settings() const { return m_settings; }
+    public:
+        static Settings getSettings(Actor::Nature nature, Actor::Role role, Actor::RadioQuality quality);
+        static bool isSimdAvailable();
+    private:
+        void applyFilters(float* samples, size_t count);
+        void applyClipAndNoise(float* samples, size_t count);
+        void applyClipAndNoiseScalar(float* samples, size_t count);
+        static void convertToFloat(const int16_t* source, float* target, size_t count, bool useSimd);
+        static void convertToPcm16(const float* source, int16_t* target, size_t count, bool useSimd);
+        static Biquad createHighPass(int sampleRate, float frequency);
+        static Biquad createLowPass(int sampleRate, float frequency);
+    };
+}
@@ -0,0 +1,120 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "libworld.h"
+
+using namespace std;
+
+namespace world
+{
+    // Index over a static table of comma-separated rows, keyed by the first column.
+    // Rows are split into columns once, and mapped into entries whose StringRef fields
+    // reference the row literals. Lookups go through an open-addressing hash table,
+    // so they neither scan the table nor allocate. Rows with an empty key are skipped;
+    // for duplicate keys, the first row wins.
+    template<class TEntry, int ColumnCount>
+    class ReferenceTableIndex
+    {
+    public:
+        typedef array<StringRef, ColumnCount> Row;
+        typedef function<TEntry(const Row& row)> MapRowCallback;
+    private:
+        enum { EmptySlot = -1 };
+        vector<StringRef> m_keys;
+        vector<TEntry> m_entries;
+        vector<int32_t> m_slots;
+        size_t m_slotMask;
+    public:
+        ReferenceTableIndex(const char* const* table, int rowCount, const MapRowCallback& mapRow)
+        {
+            size_t slotCount = 16;
+            while (slotCount < (size_t)rowCount * 2)
+            {
+                slotCount <<= 1;
+            }
+
+            m_keys.reserve(rowCount);
+            m_entries.reserve(rowCount);
+            m_slots.assign(slotCount, EmptySlot);
+            m_slotMask = slotCount - 1;
+
+            for (int i = 0 ; i < rowCount ; i++)
+            {
+                Row row;
+                splitColumns(table[i], row);
+                const StringRef& key = row[0];
+
+                if (key.empty() || tryFind(key.data, key.length))
+                {
+                    continue;
+                }
+
+                size_t slot = hashKey(key.data, key.length) & m_slotMask;
+                while (m_slots[slot] != EmptySlot)
+                {
+                    slot = (slot + 1) & m_slotMask;
+                }
+                m_slots[slot] = (int32_t)m_entries.size();
+                m_keys.push_back(key);
+                m_entries.push_back(mapRow(row));
+            }
+        }
+        ReferenceTableIndex(const ReferenceTableIndex& other) = delete;
+    public:
+        const TEntry* tryFind(const char* key, size_t length) const
+        {
+            size_t slot = hashKey(key, length) & m_slotMask;
+
+            while (m_slots[slot] != EmptySlot)
+            {
+                int32_t index = m_slots[slot];
+                if (m_keys[index].equals(key, length))
+                {
+                    return &m_entries[index];
+                }
+                slot = (slot + 1) & m_slotMask;
+            }
+
+            return nullptr;
+        }
+        size_t size() const { return m_entries.size(); }
+    private:
+        static void splitColumns(const char* rowPtr, Row& row)
+        {
+            int column = 0;
+            const char* columnStart = rowPtr;
+
+            for (const char* p = rowPtr ; ; p++)
+            {
+                if (*p == ',' || *p == 0)
+                {
+                    row[column].data = columnStart;
+                    row[column].length = p - columnStart;
+                    columnStart = p + 1;
+                    if (*p == 0 || ++column == ColumnCount)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+        static size_t hashKey(const char* key, size_t length)
+        {
+            // FNV-1a
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0 ; i < length ; i++)
+            {
+                hash ^= (uint8_t)key[i];
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+    };
+}
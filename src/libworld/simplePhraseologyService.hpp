@@ -9,52 +9,11 @@
 #include "libworld.h"
 #include "intentTypes.hpp"
 #include "aircraftTypeReferenceTable.hpp"
+#include "phoneticSpelling.hpp"
+#include "phraseologyTemplate.hpp"
 
 using namespace std;
 
-static const int PHONETIC_ALPHABET_SIZE = 26;
-static const char* PHONETIC_ALPHABET[PHONETIC_ALPHABET_SIZE] = {
-    "Alpha",
-    "Bravo",
-    "Charlie",
-    "Delta",
-    "Echo",
-    "Foxtrot",
-    "Golf",
-    "Hotel",
-    "India",
-    "Juliett",
-    "Kilo",
-    "Lima",
-    "Mike",
-    "November",
-    "Oscar",
-    "Papa",
-    "Quebec",
-    "Romeo",
-    "Sierra",
-    "Tango",
-    "Uniform",
-    "Victor",
-    "Whiskey",
-    "X-ray",
-    "Yankee",
-    "Zulu"
-};
-
-static const char* PHONETIC_DIGITS[10] = {
-    "Zeero",
-    "One",
-    "Too",
-    "Tree",
-    "Fower",
-    "Fife",
-    "Six",
-    "Seven",
-    "Ait",
-    "Niner"
-};
-
 #define MAP_VERBALIZER_INTENT(type, handler) \
     m_verbalizerByIntentCode.insert({ type::IntentCode, [this](UtteranceBuilder& builder, shared_ptr<Intent> intent) { \
         handler(builder, dynamic_pointer_cast<type>(intent));\
@@ -67,6 +26,37 @@ namespace world
     private:
         shared_ptr<HostServices> m_host;
         unordered_map<int, function<void(UtteranceBuilder& builder, shared_ptr<Intent> intent)>> m_verbalizerByIntentCode;
+        struct Templates
+        {
+            PhraseologyTemplate pilotRoger = PhraseologyTemplate::compile("{=Roger|affirmation}, {0:callsign|farewell}");
+            PhraseologyTemplate pilotCopyThat = PhraseologyTemplate::compile("{=copy that|affirmation}");
+            PhraseologyTemplate pilotCopy = PhraseologyTemplate::compile("{=copy|affirmation}");
+            PhraseologyTemplate handoffReadback = PhraseologyTemplate::compile("{0:frequency} {=thank you|farewell}");
+            PhraseologyTemplate handoffRoger = PhraseologyTemplate::compile("{=Roger|farewell}");
+            PhraseologyTemplate ifrClearanceReadback = PhraseologyTemplate::compile(
+                "To {0:phonetic} via {1|slow} and {2|slow}, {=squawk|slow} {3:digits|slow} climb {4:number|slow}, {5:callsign|farewell}");
+            PhraseologyTemplate readbackCorrectHeads = PhraseologyTemplate::compile(
+                "{0:callsign} readback correct, Contact ground on {1:frequency|slow} when ready {=have a good flight|farewell}");
+            PhraseologyTemplate readbackCorrectTails = PhraseologyTemplate::compile(
+                "{0:callsign} readback correct, Contact ground on {1:frequency|slow} for taxi {=have a good one|farewell}");
+            PhraseologyTemplate pushAndStartRequestHeads = PhraseologyTemplate::compile("{0:callsign}, {1:callsign} at gate {2} push with Quebec");
+            PhraseologyTemplate pushAndStartRequestTails = PhraseologyTemplate::compile(
+                "{0:callsign}, {1:callsign} at gate {2} information Quebec requesting push and start");
+            PhraseologyTemplate departureTaxiRequest = PhraseologyTemplate::compile("{0:callsign}, {1:callsign} requesting taxi to active");
+            PhraseologyTemplate runwayCrossClearance = PhraseologyTemplate::compile("{0:callsign}, Ground, Cross runway {1:runway} continue taxiing");
+            PhraseologyTemplate runwayCrossReadbackHeads = PhraseologyTemplate::compile("Crossing runway {0:runway} {1:callsign|farewell}");
+            PhraseologyTemplate runwayCrossReadbackTails = PhraseologyTemplate::compile("Crossing {0:runway} {1:callsign|farewell}");
+            PhraseologyTemplate holdShortReadbackHeads = PhraseologyTemplate::compile("Holding short runway {0:runway} {1:callsign|farewell}");
+            PhraseologyTemplate holdShortReadbackTails = PhraseologyTemplate::compile("Holding short of {0:runway} {1:callsign|farewell}");
+            PhraseologyTemplate switchToTower = PhraseologyTemplate::compile("{0:callsign} contact tower on {1:frequency} {=have a good one|farewell}");
+            PhraseologyTemplate lineUpAndWaitReadback = PhraseologyTemplate::compile("runway {0:runway} line up and wait {1:callsign|farewell}");
+            PhraseologyTemplate reportFinal = PhraseologyTemplate::compile("{0:callsign}, {1:callsign} final runway {2:runway}");
+            PhraseologyTemplate landingClearanceReadback = PhraseologyTemplate::compile("cleared to land {0:runway} {1:callsign|farewell}");
+            PhraseologyTemplate continueApproachReadback = PhraseologyTemplate::compile("continue approach {0:callsign|farewell}");
+            PhraseologyTemplate goAround = PhraseologyTemplate::compile("{0:callsign}, Go Around!");
+            PhraseologyTemplate goAroundReadback = PhraseologyTemplate::compile("going around, {0:callsign|farewell}");
+        };
+        const Templates m_templates;
     public:
         SimplePhraseologyService(shared_ptr<HostServices> _host) :
             m_host(_host)
@@ -86,7 +76,10 @@ namespace world
             
             const auto& verbalizer = found->second;
 
-            UtteranceBuilder builder;
+            // the builder is reused between transmissions; its text is copied into the utterance,
+            // so that its buffers stay allocated for the next one
+            thread_local UtteranceBuilder builder;
+            builder.clear();
             verbalizer(builder, intent);
 
             return builder.getUtterance();
@@ -242,11 +235,13 @@ namespace world
 
         void verbalizePilotAffirmation(UtteranceBuilder& builder, shared_ptr<PilotAffirmationIntent> intent)
         {
-            builder.addAffirmation(isHeads(intent) ? "Roger" : (isMale(intent) ? "copy that" : "copy"));
             if (isHeads(intent))
             {
-                builder.addPunctuation();
-                builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+                m_templates.pilotRoger.render(builder, intent->subjectFlight()->callSign());
+            }
+            else
+            {
+                (isMale(intent) ? m_templates.pilotCopyThat : m_templates.pilotCopy).render(builder);
             }
         }
 
@@ -254,12 +249,11 @@ namespace world
         {
             if (isTails(intent))
             {
-                builder.addData(spellFrequency(intent->newFrequencyKhz()));
-                builder.addFarewell("thank you");
+                m_templates.handoffReadback.render(builder, intent->newFrequencyKhz());
             }
             else
             {
-                builder.addFarewell("Roger");
+                m_templates.handoffRoger.render(builder);
             }
         }
 
@@ -328,41 +322,30 @@ namespace world
         void verbalizeIfrClearanceReadback(UtteranceBuilder& builder, shared_ptr<PilotIfrClearanceReadbackIntent> intent)
         {
             auto clearance = intent->clearance();
-
-            builder.addText("To");
-            builder.addData(spellPhoneticString(clearance->limit()));
-            builder.addText("via");
-            builder.addData(clearance->sid(), true);
-            builder.addText("and");
-            builder.addData(clearance->transition(), true);
-            builder.addPunctuation();
-            builder.addText("squawk", true);
-            builder.addData(spellSquawk(clearance->squawk()), true);
-            builder.addText("climb");
-            builder.addData(spellAltitude(clearance->initialAltitudeFeet()), true);
-            builder.addPunctuation();
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            m_templates.ifrClearanceReadback.render(
+                builder,
+                clearance->limit(),
+                clearance->sid(),
+                clearance->transition(),
+                clearance->squawk(),
+                (int)clearance->initialAltitudeFeet(),
+                intent->subjectFlight()->callSign());
         }
 
         void verbalizeIfrClearanceReadbackCorrect(UtteranceBuilder& builder, shared_ptr<DeliveryIfrClearanceReadbackCorrectIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addText("readback correct");
-            builder.addPunctuation();
-            builder.addText("Contact ground on");
-            builder.addData(spellFrequency(intent->groundKhz()), true);
-            builder.addText(isHeads(intent) ? "when ready" : "for taxi");
-            builder.addFarewell(isHeads(intent) ? "have a good flight" : "have a good one");
+            const auto& phrase = isHeads(intent) ? m_templates.readbackCorrectHeads : m_templates.readbackCorrectTails;
+            phrase.render(builder, intent->subjectFlight()->callSign(), intent->groundKhz());
         }
 
         void verbalizePushAndStartRequest(UtteranceBuilder& builder, shared_ptr<PilotPushAndStartRequestIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectControl()->callSign()));
-            builder.addPunctuation();
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addText("at gate");
-            builder.addData(intent->subjectFlight()->plan()->departureGate());
-            builder.addText(isHeads(intent) ? "push with Quebec" : "information Quebec requesting push and start");
+            const auto& phrase = isHeads(intent) ? m_templates.pushAndStartRequestHeads : m_templates.pushAndStartRequestTails;
+            phrase.render(
+                builder,
+                intent->subjectControl()->callSign(),
+                intent->subjectFlight()->callSign(),
+                intent->subjectFlight()->plan()->departureGate());
         }
 
         void verbalizePushAndStartReply(UtteranceBuilder& builder, shared_ptr<GroundPushAndStartReplyIntent> intent)
@@ -391,10 +374,10 @@ namespace world
 
         void verbalizeDepartureTaxiRequest(UtteranceBuilder& builder, shared_ptr<PilotDepartureTaxiRequestIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectControl()->callSign()));
-            builder.addPunctuation();
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addText("requesting taxi to active");
+            m_templates.departureTaxiRequest.render(
+                builder,
+                intent->subjectControl()->callSign(),
+                intent->subjectFlight()->callSign());
         }
 
         void verbalizeDepartureTaxiReply(UtteranceBuilder& builder, shared_ptr<GroundDepartureTaxiReplyIntent> intent)
@@ -454,41 +437,22 @@ namespace world
 
         void verbalizeRunwayCrossClearance(UtteranceBuilder& builder, shared_ptr<GroundRunwayCrossClearanceIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addPunctuation();
-            builder.addText("Ground");
-            builder.addPunctuation();
-            builder.addText("Cross runway");
-            builder.addData(spellRunway(intent->clearance()->runwayName()));
-            builder.addText("continue taxiing");
+            m_templates.runwayCrossClearance.render(
+                builder,
+                intent->subjectFlight()->callSign(),
+                intent->clearance()->runwayName());
         }
 
         void verbalizePilotRunwayCrossReadback(UtteranceBuilder& builder, shared_ptr<PilotRunwayCrossReadbackIntent> intent)
         {
-            auto clearance = intent->clearance();
-
-            builder.addText("Crossing");
-            if (isHeads(intent))
-            {
-                builder.addText("runway");
-            }
-            builder.addData(spellRunway(clearance->runwayName()));
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            const auto& phrase = isHeads(intent) ? m_templates.runwayCrossReadbackHeads : m_templates.runwayCrossReadbackTails;
+            phrase.render(builder, intent->clearance()->runwayName(), intent->subjectFlight()->callSign());
         }
 
         void verbalizePilotRunwayHoldShortReadback(UtteranceBuilder& builder, shared_ptr<PilotRunwayHoldShortReadbackIntent> intent)
         {
-            builder.addText("Holding short");
-            if (isHeads(intent))
-            {
-                builder.addText("runway");
-            }
-            else
-            {
-                builder.addText("of");
-            }
-            builder.addData(spellRunway(intent->runway()));
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            const auto& phrase = isHeads(intent) ? m_templates.holdShortReadbackHeads : m_templates.holdShortReadbackTails;
+            phrase.render(builder, intent->runway(), intent->subjectFlight()->callSign());
         }
 
         void verbalizeGroundHoldShortRunway(UtteranceBuilder& builder, shared_ptr<GroundHoldShortRunwayIntent> intent)
@@ -506,10 +470,7 @@ namespace world
 
         void verbalizeSwitchToTower(UtteranceBuilder& builder, shared_ptr<GroundSwitchToTowerIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addText("contact tower on");
-            builder.addData(spellFrequency(intent->towerKhz()));
-            builder.addFarewell("have a good one");
+            m_templates.switchToTower.render(builder, intent->subjectFlight()->callSign(), intent->towerKhz());
         }
 
         void verbalizeCheckInWithTower(UtteranceBuilder& builder, shared_ptr<PilotCheckInWithTowerIntent> intent)
@@ -575,10 +536,7 @@ namespace world
 
         void verbalizeLineUpAndWaitReadback(UtteranceBuilder& builder, shared_ptr<PilotLineUpAndWaitReadbackIntent> intent)
         {
-            builder.addText("runway");
-            builder.addData(spellRunway(intent->runway()));
-            builder.addText("line up and wait");
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            m_templates.lineUpAndWaitReadback.render(builder, intent->runway(), intent->subjectFlight()->callSign());
         }
 
         void verbalizeTowerDepartureHoldShort(UtteranceBuilder& builder, shared_ptr<TowerDepartureHoldShortIntent> intent)
@@ -665,11 +623,11 @@ namespace world
 
         void verbalizeReportFinal(UtteranceBuilder& builder, shared_ptr<PilotReportFinalIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectControl()->callSign()));
-            builder.addPunctuation();
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addText("final runway");
-            builder.addData(spellRunway(intent->runway()));
+            m_templates.reportFinal.render(
+                builder,
+                intent->subjectControl()->callSign(),
+                intent->subjectFlight()->callSign(),
+                intent->runway());
         }
 
         void verbalizeLandingClearance(UtteranceBuilder& builder, shared_ptr<TowerClearedForLandingIntent> intent)
@@ -689,9 +647,10 @@ namespace world
 
         void verbalizeLandingClearanceReadback(UtteranceBuilder& builder, shared_ptr<PilotLandingClearanceReadbackIntent> intent)
         {
-            builder.addText("cleared to land");
-            builder.addData(spellRunway(intent->clearance()->runway()));
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            m_templates.landingClearanceReadback.render(
+                builder,
+                intent->clearance()->runway(),
+                intent->subjectFlight()->callSign());
         }
 
         void verbalizeArrivalCheckInWithGround(UtteranceBuilder& builder, shared_ptr<PilotArrivalCheckInWithGroundIntent> intent)
@@ -769,22 +728,17 @@ namespace world
 
         void verbalizePilotContinueApproachReadback(UtteranceBuilder& builder, shared_ptr<PilotContinueApproachReadbackIntent> intent)
         {
-            builder.addText("continue approach");
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            m_templates.continueApproachReadback.render(builder, intent->subjectFlight()->callSign());
         }
 
         void verbalizeTowerGoAround(UtteranceBuilder& builder, shared_ptr<TowerGoAroundIntent> intent)
         {
-            builder.addData(spellCallsign(intent->subjectFlight()->callSign()));
-            builder.addPunctuation();
-            builder.addText("Go Around!");
+            m_templates.goAround.render(builder, intent->subjectFlight()->callSign());
         }
 
         void verbalizePilotGoAroundReadback(UtteranceBuilder& builder, shared_ptr<PilotGoAroundReadbackIntent> intent)
         {
-            builder.addText("going around");
-            builder.addPunctuation();
-            builder.addFarewell(spellCallsign(intent->subjectFlight()->callSign()));
+            m_templates.goAroundReadback.render(builder, intent->subjectFlight()->callSign());
         }
 
     public:
@@ -845,12 +799,10 @@ namespace world
 
         string spellAircraftType(const string& s)
         {
-            AircraftTypeReferenceTable::Entry typeEntry;
-            if (!s.empty() && AircraftTypeReferenceTable::tryFindByIcao(s, typeEntry))
-            {
-                return typeEntry.callsign;
-            }
-            return "";
+            const auto* typeEntry = AircraftTypeReferenceTable::findByIcao(s);
+            return typeEntry
+                ? typeEntry->callsign.str()
+                : "";
         }
 
         string spellMiles(int miles)
@@ -860,47 +812,10 @@ namespace world
 
         string spellPhoneticString(const string& s)
         {
-            stringstream result;
-
-            for (int i = 0 ; i < s.length() ; i++)
-            {
-                if (i > 0)
-                {
-                    result << " ";
-                }
-
-                char c = s[i];
-                if (c >= '0' && c <= '9')
-                {
-                    result << spellPhoneticDigit(c);
-                }
-                else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
-                {
-                    result << spellPhoneticChar(c);
-                }
-                else
-                {
-                    result << c;
-                }
-            }
-
-            return result.str();
-        }
-
-        const char* spellPhoneticChar(char c)
-        {
-            int index = toupper(c) - 'A';
-            return index >= 0 && index < PHONETIC_ALPHABET_SIZE
-               ? PHONETIC_ALPHABET[index]
-               : "?";
-        }
-
-        const char* spellPhoneticDigit(char c)
-        {
-            int index = c - '0';
-            return index >= 0 && index < 10
-               ? PHONETIC_DIGITS[index]
-               : "?";
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendPhonetic(sink, s.c_str(), s.length());
+            return text;
         }
 
         static string spellFrequencyKhz(int khz)
@@ -927,126 +842,51 @@ namespace world
 
         static string spellFrequency(int khz)
         {
-            stringstream text;
-
-            int mhzOnly = khz / 1000;
-            int khzOnly = khz % 1000;
-
-            int mhzDigits[3] = { mhzOnly / 100, (mhzOnly / 10) % 10, mhzOnly % 10 };
-            int khzDigits[3] = { khzOnly / 100, (khzOnly / 10) % 10, khzOnly % 10 };
-
-            text << mhzDigits[0] << ' ' << mhzDigits[1] << ' ' << mhzDigits[2]
-                 << " point "
-                 << khzDigits[0];
-
-            if (khzDigits[1] != 0 || khzDigits[2] != 0)
-            {
-                text << ' ' << khzDigits[1];
-            }
-
-            if (khzDigits[2] != 0)
-            {
-                text << ' ' << khzDigits[2];
-            }
-
-            return text.str();
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendFrequency(sink, khz);
+            return text;
         }
 
         static string spellRunway(const string& name)
         {
-            stringstream text;
-
-            for (int i = 0 ; i < name.length() ; i++)
-            {
-                if (i > 0)
-                {
-                    text << ' ';
-                }
-                
-                char c = name[i];
-                switch (c)
-                {
-                case 'L':
-                    text << "Left";
-                    break;
-                case 'R':
-                    text << "Right";
-                    break;
-                case 'C':
-                    text << "Center";
-                    break;
-                default:
-                    text << c;
-                }
-            }
-
-            return text.str();
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendRunway(sink, name.c_str(), name.length());
+            return text;
         }
 
-
         static string spellSquawk(const string& squawk)
         {
-            stringstream text;
-
-            for (int i = 0 ; i < squawk.length() ; i++)
-            {
-                if (i > 0)
-                {
-                    text << ' ';
-                }
-                text << squawk[i];
-            }
-
-            return text.str();
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendDigits(sink, squawk.c_str(), squawk.length());
+            return text;
         }
 
         static string spellIcaoCode(const string& icaoCode)
         {
-            stringstream text;
-
-            for (int i = 0 ; i < icaoCode.length() ; i++)
-            {
-                if (i > 0)
-                {
-                    text << ' ';
-                }
-                text << icaoCode[i];
-            }
-
-            return text.str();
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendDigits(sink, icaoCode.c_str(), icaoCode.length());
+            return text;
         }
 
         static string spellHeading(float heading)
         {
             string digits = to_string((int)heading);
-            stringstream text;
-
-            for (int i = 0 ; i < digits.length() ; i++)
-            {
-                if (i > 0)
-                {
-                    text << ' ';
-                }
-                text << digits[i];
-            }
-
-            return text.str();
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendDigits(sink, digits.c_str(), digits.length());
+            return text;
         }
 
         static string spellCallsign(const string& callsign)
         {
-            stringstream text;
-
-            for (int i = 0 ; i < callsign.length() ; i++)
-            {
-                if (i > 0 && (isdigit(callsign[i]) || isdigit(callsign[i-1])))
-                {
-                    text << ' ';
-                }
-                text << callsign[i];
-            }
-
-            return text.str();
+            string text;
+            PhoneticSpelling::StringSink sink(text);
+            PhoneticSpelling::appendCallsign(sink, callsign.c_str(), callsign.length());
+            return text;
         }
 
         static string spellAltitude(float feet)
@@ -0,0 +1,528 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <tuple>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+#include "libworld.h"
+#include "speechAudioCache.hpp"
+
+using namespace std;
+
+namespace world
+{
+    static const uint32_t clipFileMagic = 0x53435441; // "ATCS"
+    static const uint32_t clipFileVersion = 1;
+
+    static bool writeBytes(FILE* file, const void* data, size_t size)
+    {
+        return size == 0 || fwrite(data, size, 1, file) == 1;
+    }
+
+    static bool readBytes(FILE* file, void* data, size_t size)
+    {
+        return size == 0 || fread(data, size, 1, file) == 1;
+    }
+
+    static bool writeString(FILE* file, const string& value)
+    {
+        uint32_t length = (uint32_t)value.length();
+        return writeBytes(file, &length, sizeof(length)) && writeBytes(file, value.data(), length);
+    }
+
+    static bool readString(FILE* file, string& value)
+    {
+        uint32_t length = 0;
+        if (!readBytes(file, &length, sizeof(length)) || length > 64 * 1024)
+        {
+            return false;
+        }
+        value.resize(length);
+        return readBytes(file, &value[0], length);
+    }
+
+    constexpr uint64_t SpeechAudioCache::DefaultMaxDiskBytes;
+
+    SpeechAudioCache::SpeechAudioCache(size_t _maxMemoryBytes, const string& _diskDirectory, uint64_t _maxDiskBytes) :
+        m_maxMemoryBytes(_maxMemoryBytes),
+        m_diskDirectory(_diskDirectory),
+        m_memoryBytes(0),
+        m_memoryHitCount(0),
+        m_diskHitCount(0),
+        m_missCount(0),
+        m_maxDiskBytes(_maxDiskBytes),
+        m_diskBytes(0)
+    {
+        if (!m_diskDirectory.empty())
+        {
+            // fails harmlessly if the directory exists
+#ifdef _WIN32
+            _mkdir(m_diskDirectory.c_str());
+#else
+            mkdir(m_diskDirectory.c_str(), 0755);
+#endif
+            loadDiskFiles();
+        }
+    }
+
+    shared_ptr<const SpeechAudioCache::Clip> SpeechAudioCache::find(const Key& key)
+    {
+        const string keyString = getKeyString(key);
+        {
+            lock_guard<mutex> lock(m_mutex);
+            auto found = m_entryByKey.find(keyString);
+            if (found != m_entryByKey.end())
+            {
+                m_entries.splice(m_entries.begin(), m_entries, found->second);
+                m_memoryHitCount++;
+                return found->second->clip;
+            }
+        }
+
+        // disk I/O is done outside of the lock, so that other threads can hit the memory tier meanwhile
+        shared_ptr<const Clip> clip;
+        if (!m_diskDirectory.empty())
+        {
+            const string fileName = getClipFileName(key);
+            clip = readClipFile(getClipFilePath(fileName), keyString);
+            if (clip)
+            {
+                touchDiskFile(fileName);
+            }
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+        if (!clip)
+        {
+            m_missCount++;
+            return nullptr;
+        }
+
+        m_diskHitCount++;
+        insertToMemory(keyString, clip);
+        return clip;
+    }
+
+    void SpeechAudioCache::store(const Key& key, shared_ptr<const Clip> clip)
+    {
+        const string keyString = getKeyString(key);
+        {
+            lock_guard<mutex> lock(m_mutex);
+            insertToMemory(keyString, clip);
+        }
+
+        if (!m_diskDirectory.empty())
+        {
+            writeClipFile(getClipFileName(key), keyString, *clip);
+        }
+    }
+
+    SpeechAudioCache::Statistics SpeechAudioCache::getStatistics() const
+    {
+        uint64_t diskBytes;
+        size_t diskFileCount;
+        {
+            lock_guard<mutex> diskLock(m_diskMutex);
+            diskBytes = m_diskBytes;
+            diskFileCount = m_diskFiles.size();
+        }
+
+        lock_guard<mutex> lock(m_mutex);
+        return { m_memoryHitCount, m_diskHitCount, m_missCount, m_memoryBytes, m_entries.size(), diskBytes, diskFileCount };
+    }
+
+    string SpeechAudioCache::formatStatistics() const
+    {
+        Statistics statistics = getStatistics();
+        stringstream text;
+        text << "hit-rate[" << fixed << setprecision(1) << statistics.hitRate() * 100 << "%]"
+             << " memory-hits[" << statistics.memoryHitCount << "]"
+             << " disk-hits[" << statistics.diskHitCount << "]"
+             << " misses[" << statistics.missCount << "]"
+             << " clips[" << statistics.clipCount << "]"
+             << " memory[" << statistics.memoryBytes / 1024 << "/" << m_maxMemoryBytes / 1024 << " KB]"
+             << " disk[" << statistics.diskBytes / 1024 << "/" << m_maxDiskBytes / 1024 << " KB]";
+        return text.str();
+    }
+
+    vector<SpeechAudioCache::Segment> SpeechAudioCache::splitIntoSegments(const Utterance& utterance)
+    {
+        vector<Segment> segments;
+        const auto& parts = utterance.parts();
+        bool canSplit = true;
+        int segmentStart = -1;
+        int segmentEnd = -1;
+
+        for (const auto& part : parts)
+        {
+            if (part.type == Utterance::PartType::Punctuation && canSplit)
+            {
+                if (segmentStart >= 0)
+                {
+                    segments.push_back({ segmentStart, segmentEnd - segmentStart });
+                    segmentStart = -1;
+                }
+                continue;
+            }
+
+            if (segmentStart < 0)
+            {
+                segmentStart = part.startIndex;
+            }
+            segmentEnd = part.startIndex + part.length;
+
+            // farewell markup is not closed, it changes pitch and rate of everything that follows
+            if (part.type == Utterance::PartType::Farewell)
+            {
+                canSplit = false;
+            }
+        }
+
+        if (segmentStart >= 0)
+        {
+            segments.push_back({ segmentStart, segmentEnd - segmentStart });
+        }
+        if (segments.empty() && !utterance.plainText().empty())
+        {
+            segments.push_back({ 0, (int)utterance.plainText().length() });
+        }
+
+        return segments;
+    }
+
+    shared_ptr<SpeechAudioCache::Clip> SpeechAudioCache::concatenate(const vector<shared_ptr<const Clip>>& clips, chrono::milliseconds gap)
+    {
+        if (clips.empty())
+        {
+            throw runtime_error("SpeechAudioCache::concatenate: no clips");
+        }
+
+        auto result = make_shared<Clip>();
+        const Clip& first = *clips[0];
+        result->sampleRate = first.sampleRate;
+        result->channelCount = first.channelCount;
+        result->bitsPerSample = first.bitsPerSample;
+        result->platformVoiceId = first.platformVoiceId;
+
+        const size_t bytesPerFrame = (size_t)(first.channelCount * first.bitsPerSample / 8);
+        const size_t gapBytes = bytesPerFrame * (size_t)(first.sampleRate * gap.count() / 1000);
+        // 8-bit PCM is unsigned, its silence is in the middle of the range
+        const char silence = (first.bitsPerSample == 8 ? (char)0x80 : 0);
+
+        size_t totalBytes = gapBytes * (clips.size() - 1);
+        for (const auto& clip : clips)
+        {
+            if (clip->sampleRate != first.sampleRate ||
+                clip->channelCount != first.channelCount ||
+                clip->bitsPerSample != first.bitsPerSample)
+            {
+                throw runtime_error("SpeechAudioCache::concatenate: clips differ in format");
+            }
+            totalBytes += clip->pcm.size();
+        }
+
+        result->pcm.reserve(totalBytes);
+        for (size_t i = 0 ; i < clips.size() ; i++)
+        {
+            if (i > 0)
+            {
+                result->pcm.insert(result->pcm.end(), gapBytes, silence);
+            }
+            result->pcm.insert(result->pcm.end(), clips[i]->pcm.begin(), clips[i]->pcm.end());
+        }
+
+        return result;
+    }
+
+    uint64_t SpeechAudioCache::hashKey(const Key& key)
+    {
+        // 64-bit FNV-1a
+        const string keyString = getKeyString(key);
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : keyString)
+        {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void SpeechAudioCache::insertToMemory(const string& keyString, shared_ptr<const Clip> clip)
+    {
+        auto existing = m_entryByKey.find(keyString);
+        if (existing != m_entryByKey.end())
+        {
+            m_memoryBytes -= getClipBytes(*existing->second->clip);
+            m_entries.erase(existing->second);
+            m_entryByKey.erase(existing);
+        }
+
+        m_entries.push_front({ keyString, clip });
+        m_entryByKey[keyString] = m_entries.begin();
+        m_memoryBytes += getClipBytes(*clip);
+
+        // the newest clip stays, even if alone it exceeds the limit
+        while (m_memoryBytes > m_maxMemoryBytes && m_entries.size() > 1)
+        {
+            const Entry& oldest = m_entries.back();
+            m_memoryBytes -= getClipBytes(*oldest.clip);
+            m_entryByKey.erase(oldest.keyString);
+            m_entries.pop_back();
+        }
+    }
+
+    string SpeechAudioCache::getClipFilePath(const string& fileName) const
+    {
+        return m_diskDirectory + "/" + fileName;
+    }
+
+    shared_ptr<const SpeechAudioCache::Clip> SpeechAudioCache::readClipFile(const string& filePath, const string& keyString) const
+    {
+        FILE* file = fopen(filePath.c_str(), "rb");
+        if (!file)
+        {
+            return nullptr;
+        }
+
+        auto clip = make_shared<Clip>();
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        int32_t format[3] = { 0 };
+        string storedKeyString;
+        uint64_t pcmLength = 0;
+
+        bool valid =
+            readBytes(file, &magic, sizeof(magic)) && magic == clipFileMagic &&
+            readBytes(file, &version, sizeof(version)) && version == clipFileVersion &&
+            readBytes(file, format, sizeof(format)) &&
+            readString(file, storedKeyString) && storedKeyString == keyString && // guards against hash collisions
+            readString(file, clip->platformVoiceId) &&
+            readBytes(file, &pcmLength, sizeof(pcmLength)) && pcmLength <= 64 * 1024 * 1024;
+
+        if (valid)
+        {
+            clip->sampleRate = format[0];
+            clip->channelCount = format[1];
+            clip->bitsPerSample = format[2];
+            clip->pcm.resize((size_t)pcmLength);
+            valid = readBytes(file, clip->pcm.data(), clip->pcm.size());
+        }
+
+        fclose(file);
+        return valid ? clip : nullptr;
+    }
+
+    void SpeechAudioCache::writeClipFile(const string& fileName, const string& keyString, const Clip& clip)
+    {
+        static atomic<uint64_t> nextTempFileId(1);
+
+        const string filePath = getClipFilePath(fileName);
+        FILE* existing = fopen(filePath.c_str(), "rb");
+        if (existing)
+        {
+            fclose(existing);
+            touchDiskFile(fileName);
+            return;
+        }
+
+        // written aside and renamed, so that a reader never sees a partially written clip
+        const string tempFilePath = filePath + ".tmp" + to_string(nextTempFileId++);
+        FILE* file = fopen(tempFilePath.c_str(), "wb");
+        if (!file)
+        {
+            return;
+        }
+
+        const int32_t format[3] = { clip.sampleRate, clip.channelCount, clip.bitsPerSample };
+        const uint64_t pcmLength = clip.pcm.size();
+
+        bool written =
+            writeBytes(file, &clipFileMagic, sizeof(clipFileMagic)) &&
+            writeBytes(file, &clipFileVersion, sizeof(clipFileVersion)) &&
+            writeBytes(file, format, sizeof(format)) &&
+            writeString(file, keyString) &&
+            writeString(file, clip.platformVoiceId) &&
+            writeBytes(file, &pcmLength, sizeof(pcmLength)) &&
+            writeBytes(file, clip.pcm.data(), clip.pcm.size());
+
+        const uint64_t fileBytes = (uint64_t)ftell(file);
+        written = (fclose(file) == 0) && written;
+        if (!written || rename(tempFilePath.c_str(), filePath.c_str()) != 0)
+        {
+            remove(tempFilePath.c_str());
+            return;
+        }
+
+        addDiskFile(fileName, fileBytes);
+    }
+
+    void SpeechAudioCache::loadDiskFiles()
+    {
+        vector<tuple<time_t, string, uint64_t>> files; // modification time, name, size
+
+        auto addFile = [&](const string& fileName, uint64_t bytes, time_t modifiedTime) {
+            if (fileName.find(".pcm.tmp") != string::npos)
+            {
+                // left over from a write which was interrupted
+                remove(getClipFilePath(fileName).c_str());
+            }
+            else if (fileName.length() > 4 && fileName.compare(fileName.length() - 4, 4, ".pcm") == 0)
+            {
+                files.emplace_back(modifiedTime, fileName, bytes);
+            }
+        };
+
+#ifdef _WIN32
+        _finddata_t found;
+        intptr_t handle = _findfirst(getClipFilePath("*").c_str(), &found);
+        if (handle != -1)
+        {
+            do
+            {
+                if (!(found.attrib & _A_SUBDIR))
+                {
+                    addFile(found.name, (uint64_t)found.size, found.time_write);
+                }
+            }
+            while (_findnext(handle, &found) == 0);
+            _findclose(handle);
+        }
+#else
+        DIR* directory = opendir(m_diskDirectory.c_str());
+        if (directory)
+        {
+            while (const dirent* entry = readdir(directory))
+            {
+                struct stat fileStat;
+                if (stat(getClipFilePath(entry->d_name).c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode))
+                {
+                    addFile(entry->d_name, (uint64_t)fileStat.st_size, fileStat.st_mtime);
+                }
+            }
+            closedir(directory);
+        }
+#endif
+
+        // the most recently used first
+        sort(files.begin(), files.end(), [](const tuple<time_t, string, uint64_t>& left, const tuple<time_t, string, uint64_t>& right) {
+            return get<0>(left) > get<0>(right);
+        });
+
+        {
+            lock_guard<mutex> lock(m_diskMutex);
+            for (const auto& file : files)
+            {
+                m_diskFiles.push_back({ get<1>(file), get<2>(file) });
+                m_diskFileByName[get<1>(file)] = prev(m_diskFiles.end());
+                m_diskBytes += get<2>(file);
+            }
+        }
+
+        // the limit could have been lowered since the last session
+        pruneDiskFiles();
+    }
+
+    bool SpeechAudioCache::touchDiskFile(const string& fileName)
+    {
+        {
+            lock_guard<mutex> lock(m_diskMutex);
+            auto found = m_diskFileByName.find(fileName);
+            if (found == m_diskFileByName.end())
+            {
+                return false;
+            }
+            m_diskFiles.splice(m_diskFiles.begin(), m_diskFiles, found->second);
+        }
+
+        // the next session orders files by their modification time
+#ifdef _WIN32
+        _utime(getClipFilePath(fileName).c_str(), nullptr);
+#else
+        utime(getClipFilePath(fileName).c_str(), nullptr);
+#endif
+        return true;
+    }
+
+    void SpeechAudioCache::addDiskFile(const string& fileName, uint64_t bytes)
+    {
+        {
+            lock_guard<mutex> lock(m_diskMutex);
+            auto existing = m_diskFileByName.find(fileName);
+            if (existing != m_diskFileByName.end())
+            {
+                m_diskBytes -= existing->second->bytes;
+                m_diskFiles.erase(existing->second);
+            }
+
+            m_diskFiles.push_front({ fileName, bytes });
+            m_diskFileByName[fileName] = m_diskFiles.begin();
+            m_diskBytes += bytes;
+        }
+
+        pruneDiskFiles();
+    }
+
+    void SpeechAudioCache::pruneDiskFiles()
+    {
+        vector<string> evictedFileNames;
+        {
+            // the newest file stays, even if alone it exceeds the limit
+            lock_guard<mutex> lock(m_diskMutex);
+            while (m_diskBytes > m_maxDiskBytes && m_diskFiles.size() > 1)
+            {
+                const DiskFile& oldest = m_diskFiles.back();
+                evictedFileNames.push_back(oldest.fileName);
+                m_diskBytes -= oldest.bytes;
+                m_diskFileByName.erase(oldest.fileName);
+                m_diskFiles.pop_back();
+            }
+        }
+
+        for (const string& fileName : evictedFileNames)
+        {
+            remove(getClipFilePath(fileName).c_str());
+        }
+    }
+
+    string SpeechAudioCache::getClipFileName(const Key& key)
+    {
+        stringstream fileName;
+        fileName << hex << setw(16) << setfill('0') << hashKey(key) << ".pcm";
+        return fileName.str();
+    }
+
+    string SpeechAudioCache::getKeyString(const Key& key)
+    {
+        string keyString;
+        keyString.reserve(key.voiceId.length() + key.text.length() + 16);
+        keyString += key.voiceId;
+        keyString += '\x1f';
+        keyString += to_string(key.rate);
+        keyString += '\x1f';
+        keyString += to_string(key.quality);
+        keyString += '\x1f';
+        keyString += key.text;
+        return keyString;
+    }
+
+    size_t SpeechAudioCache::getClipBytes(const Clip& clip)
+    {
+        return clip.pcm.capacity() + sizeof(Clip);
+    }
+}
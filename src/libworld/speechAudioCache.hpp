@@ -0,0 +1,132 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "libworld.h"
+
+using namespace std;
+
+namespace world
+{
+    // Content-addressed cache of synthesized speech. A clip is identified by everything that
+    // affects how it sounds: the platform voice, the rate, the radio quality, and the text with its markup.
+    // Clips are kept in memory up to a byte limit, least recently used first out;
+    // with a disk directory, every stored clip is also written to a file named by the hash of its key,
+    // and clips evicted from memory (or stored by an earlier session) are reloaded from there.
+    // Files on disk are limited by total size as well: the least recently used are deleted first,
+    // and their use is carried over between sessions by the modification time of the file.
+    //
+    // Utterances are cached in segments rather than as a whole: a segment is a run of parts between
+    // punctuation, so that recurring phrases (callsigns, "cleared for takeoff runway 2 2 Right", readbacks)
+    // are synthesized once and reused across different transmissions. Safe to use from multiple threads.
+    class SpeechAudioCache
+    {
+    public:
+        struct Key
+        {
+            string voiceId;
+            int rate;
+            int quality;
+            string text;
+        };
+        struct Clip
+        {
+            int sampleRate;
+            int channelCount;
+            int bitsPerSample;
+            vector<char> pcm;
+            string platformVoiceId; // the voice picked by the synthesizer, if known
+        };
+        struct Segment
+        {
+            int startIndex;
+            int length;
+        };
+        struct Statistics
+        {
+            uint64_t memoryHitCount;
+            uint64_t diskHitCount;
+            uint64_t missCount;
+            size_t memoryBytes;
+            size_t clipCount;
+            uint64_t diskBytes;
+            size_t diskFileCount;
+        public:
+            double hitRate() const
+            {
+                uint64_t lookupCount = memoryHitCount + diskHitCount + missCount;
+                return lookupCount > 0 ? (double)(memoryHitCount + diskHitCount) / (double)lookupCount : 0.0;
+            }
+        };
+    private:
+        struct Entry
+        {
+            string keyString;
+            shared_ptr<const Clip> clip;
+        };
+        struct DiskFile
+        {
+            string fileName;
+            uint64_t bytes;
+        };
+    public:
+        static constexpr uint64_t DefaultMaxDiskBytes = 256 * 1024 * 1024;
+    private:
+        const size_t m_maxMemoryBytes;
+        const string m_diskDirectory;
+        mutable mutex m_mutex;
+        list<Entry> m_entries; // most recently used first
+        unordered_map<string, list<Entry>::iterator> m_entryByKey;
+        size_t m_memoryBytes;
+        uint64_t m_memoryHitCount;
+        uint64_t m_diskHitCount;
+        uint64_t m_missCount;
+        const uint64_t m_maxDiskBytes;
+        mutable mutex m_diskMutex;
+        list<DiskFile> m_diskFiles; // most recently used first
+        unordered_map<string, list<DiskFile>::iterator> m_diskFileByName;
+        uint64_t m_diskBytes;
+    public:
+        // an empty disk directory disables the disk tier
+        explicit SpeechAudioCache(
+            size_t _maxMemoryBytes,
+            const string& _diskDirectory = "",
+            uint64_t _maxDiskBytes = DefaultMaxDiskBytes);
+        SpeechAudioCache(const SpeechAudioCache& other) = delete;
+        SpeechAudioCache& operator=(const SpeechAudioCache& other) = delete;
+    public:
+        shared_ptr<const Clip> find(const Key& key);
+        void store(const Key& key, shared_ptr<const Clip> clip);
+        Statistics getStatistics() const;
+        string formatStatistics() const;
+    public:
+        // splits at punctuation, except after a part whose markup carries over to the rest of the utterance
+        static vector<Segment> splitIntoSegments(const Utterance& utterance);
+        // joins clips of the same format, with silence of the given duration between them
+        static shared_ptr<Clip> concatenate(const vector<shared_ptr<const Clip>>& clips, chrono::milliseconds gap);
+        static uint64_t hashKey(const Key& key);
+        // heap retained by a clip, including PCM capacity beyond its length
+        static size_t getClipBytes(const Clip& clip);
+    private:
+        void insertToMemory(const string& keyString, shared_ptr<const Clip> clip);
+        string getClipFilePath(const string& fileName) const;
+        shared_ptr<const Clip> readClipFile(const string& filePath, const string& keyString) const;
+        void writeClipFile(const string& fileName, const string& keyString, const Clip& clip);
+        void loadDiskFiles();
+        bool touchDiskFile(const string& fileName);
+        void addDiskFile(const string& fileName, uint64_t bytes);
+        void pruneDiskFiles();
+        static string getClipFileName(const Key& key);
+        static string getKeyString(const Key& key);
+    };
+}
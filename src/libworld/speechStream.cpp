@@ -0,0 +1,213 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "speechStream.hpp"
+
+using namespace std;
+
+namespace world
+{
+    SpeechStream::SpeechStream() :
+        m_state(State::Streaming),
+        m_hasFormat(false),
+        m_format({ 0, 0, 0 }),
+        m_readOffset(0),
+        m_availableBytes(0),
+        m_totalBytes(0),
+        m_createdAt(chrono::steady_clock::now())
+    {
+    }
+
+    bool SpeechStream::append(const Format& format, const char* data, size_t length)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_state == State::Cancelled)
+            {
+                return false;
+            }
+            if (m_state != State::Streaming)
+            {
+                throw runtime_error("SpeechStream::append: stream is already over");
+            }
+
+            if (!m_hasFormat)
+            {
+                if (format.bytesPerFrame() <= 0 || format.sampleRate <= 0)
+                {
+                    throw runtime_error("SpeechStream::append: invalid format");
+                }
+                m_format = format;
+                m_hasFormat = true;
+            }
+            else if (format != m_format)
+            {
+                throw runtime_error("SpeechStream::append: chunks differ in format");
+            }
+
+            if (length == 0)
+            {
+                return true;
+            }
+            if (m_totalBytes == 0)
+            {
+                m_firstChunkAt = chrono::steady_clock::now();
+            }
+
+            m_chunks.emplace_back(data, data + length);
+            m_availableBytes += length;
+            m_totalBytes += length;
+        }
+
+        m_chunkAppended.notify_all();
+        return true;
+    }
+
+    void SpeechStream::finish()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_state == State::Streaming)
+            {
+                m_state = State::Finished;
+            }
+        }
+        m_chunkAppended.notify_all();
+    }
+
+    void SpeechStream::fail(const string& error)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (m_state == State::Streaming)
+            {
+                m_state = State::Failed;
+                m_error = error;
+            }
+        }
+        m_chunkAppended.notify_all();
+    }
+
+    void SpeechStream::cancel()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_state = State::Cancelled;
+            m_chunks.clear();
+            m_readOffset = 0;
+            m_availableBytes = 0;
+        }
+        m_chunkAppended.notify_all();
+    }
+
+    size_t SpeechStream::read(char* buffer, size_t maxLength)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        size_t length = min(maxLength, getReadableBytes());
+        if (m_hasFormat)
+        {
+            length -= length % m_format.bytesPerFrame();
+        }
+
+        size_t copied = 0;
+        while (copied < length)
+        {
+            vector<char>& chunk = m_chunks.front();
+            size_t count = min(length - copied, chunk.size() - m_readOffset);
+            memcpy(buffer + copied, chunk.data() + m_readOffset, count);
+            copied += count;
+            m_readOffset += count;
+
+            if (m_readOffset == chunk.size())
+            {
+                m_chunks.pop_front();
+                m_readOffset = 0;
+            }
+        }
+
+        m_availableBytes -= copied;
+        return copied;
+    }
+
+    bool SpeechStream::waitForData(chrono::milliseconds timeout)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        return m_chunkAppended.wait_for(lock, timeout, [this] {
+            return getReadableBytes() > 0 || m_state != State::Streaming;
+        });
+    }
+
+    bool SpeechStream::tryGetFormat(Format& format) const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_hasFormat)
+        {
+            format = m_format;
+        }
+        return m_hasFormat;
+    }
+
+    size_t SpeechStream::availableBytes() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return getReadableBytes();
+    }
+
+    bool SpeechStream::isEndOfStream() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_state != State::Streaming && getReadableBytes() == 0;
+    }
+
+    bool SpeechStream::isCancelled() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_state == State::Cancelled;
+    }
+
+    SpeechStream::State SpeechStream::state() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_state;
+    }
+
+    string SpeechStream::error() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_error;
+    }
+
+    chrono::milliseconds SpeechStream::appendedDuration() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_hasFormat)
+        {
+            return chrono::milliseconds(0);
+        }
+        uint64_t frameCount = m_totalBytes / m_format.bytesPerFrame();
+        return chrono::milliseconds(frameCount * 1000 / m_format.sampleRate);
+    }
+
+    chrono::milliseconds SpeechStream::timeToFirstChunk() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (m_totalBytes == 0)
+        {
+            return chrono::milliseconds(0);
+        }
+        return chrono::duration_cast<chrono::milliseconds>(m_firstChunkAt - m_createdAt);
+    }
+
+    size_t SpeechStream::getReadableBytes() const
+    {
+        // a trailing partial frame can only be completed by the next chunk
+        return m_hasFormat
+            ? m_availableBytes - m_availableBytes % m_format.bytesPerFrame()
+            : 0;
+    }
+}
@@ -0,0 +1,89 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace world
+{
+    // PCM of one utterance, passed from the synthesizer to playback while it is being synthesized.
+    // The producer appends chunks as the synthesizer emits them, and finishes (or fails) the stream;
+    // the consumer reads whole frames as soon as they are appended, and may cancel the stream,
+    // which makes further appends fail, so that the producer can stop synthesizing.
+    // All chunks must be of the same format. Safe for one producer and one consumer thread.
+    class SpeechStream
+    {
+    public:
+        struct Format
+        {
+            int sampleRate;
+            int channelCount;
+            int bitsPerSample;
+        public:
+            int bytesPerFrame() const { return channelCount * bitsPerSample / 8; }
+            bool operator==(const Format& other) const
+            {
+                return sampleRate == other.sampleRate && channelCount == other.channelCount && bitsPerSample == other.bitsPerSample;
+            }
+            bool operator!=(const Format& other) const { return !(*this == other); }
+        };
+        enum class State
+        {
+            Streaming = 1,
+            Finished = 2,
+            Failed = 3,
+            Cancelled = 4
+        };
+    private:
+        mutable mutex m_mutex;
+        condition_variable m_chunkAppended;
+        State m_state;
+        bool m_hasFormat;
+        Format m_format;
+        deque<vector<char>> m_chunks;
+        size_t m_readOffset; // into the first chunk
+        size_t m_availableBytes;
+        uint64_t m_totalBytes;
+        string m_error;
+        const chrono::steady_clock::time_point m_createdAt;
+        chrono::steady_clock::time_point m_firstChunkAt;
+    public:
+        SpeechStream();
+        SpeechStream(const SpeechStream& other) = delete;
+        SpeechStream& operator=(const SpeechStream& other) = delete;
+    public:
+        // returns false if the stream was cancelled; throws if the format differs from earlier chunks
+        bool append(const Format& format, const char* data, size_t length);
+        void finish();
+        void fail(const string& error);
+        void cancel();
+    public:
+        // copies up to maxLength bytes, rounded down to whole frames; never blocks
+        size_t read(char* buffer, size_t maxLength);
+        // waits until there is something to read or the stream is over; returns false on timeout
+        bool waitForData(chrono::milliseconds timeout);
+        bool tryGetFormat(Format& format) const;
+        size_t availableBytes() const;
+        // the stream is over, and everything was read
+        bool isEndOfStream() const;
+        bool isCancelled() const;
+        State state() const;
+        string error() const;
+        // how much playback time has been appended so far
+        chrono::milliseconds appendedDuration() const;
+        // from creation to the first appended chunk; zero while nothing was appended
+        chrono::milliseconds timeToFirstChunk() const;
+    private:
+        size_t getReadableBytes() const;
+    };
+}
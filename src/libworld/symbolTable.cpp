@@ -0,0 +1,71 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <mutex>
+#include "libworld.h"
+
+using namespace std;
+
+namespace world
+{
+    constexpr SymbolTable::Symbol SymbolTable::EmptySymbol;
+    constexpr SymbolTable::Symbol SymbolTable::NotFound;
+
+    SymbolTable::SymbolTable() :
+        m_count(0)
+    {
+        intern("");
+    }
+
+    SymbolTable::Symbol SymbolTable::intern(const string& s)
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto found = m_symbolByString.find(cref(s));
+        if (found != m_symbolByString.end())
+        {
+            return found->second;
+        }
+
+        Symbol symbol = m_count;
+        int chunkIndex = symbol >> ChunkSizeBits;
+        if (chunkIndex >= MaxChunks)
+        {
+            throw runtime_error("SymbolTable: capacity exceeded");
+        }
+        if (!m_chunks[chunkIndex])
+        {
+            m_chunks[chunkIndex].reset(new string[ChunkSize]);
+        }
+
+        string& stored = m_chunks[chunkIndex][symbol & (ChunkSize - 1)];
+        stored = s;
+        m_symbolByString.insert({ cref(stored), symbol });
+        m_count++;
+
+        return symbol;
+    }
+
+    SymbolTable::Symbol SymbolTable::tryFind(const string& s) const
+    {
+        lock_guard<mutex> lock(m_mutex);
+
+        auto found = m_symbolByString.find(cref(s));
+        return found != m_symbolByString.end()
+            ? found->second
+            : NotFound;
+    }
+
+    size_t SymbolTable::size() const
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_count;
+    }
+
+    SymbolTable& SymbolTable::global()
+    {
+        static SymbolTable instance;
+        return instance;
+    }
+}
@@ -20,7 +20,9 @@ namespace world
         float _lengthMeters,
         int _widthHint
     ) : m_id(_id),
-        m_name(_name),
+        m_name(SymbolTable::internGlobal(_name)),
+        m_highSpeedExitRunway(SymbolTable::EmptySymbol),
+        m_runwayEndName(SymbolTable::EmptySymbol),
         m_nodeId1(_nodeId1),
         m_nodeId2(_nodeId2),
         m_widthHint(_widthHint),
@@ -45,6 +47,7 @@ namespace world
         m_node2(_flippingOver ? _source->m_node1 : _source->m_node2),
         m_widthHint(_source->m_widthHint),
         m_highSpeedExitRunway(_source->m_highSpeedExitRunway),
+        m_runwayEndName(SymbolTable::EmptySymbol),
         m_activeZones(_source->m_activeZones),
         m_flightPhaseAllocation(_source->m_flightPhaseAllocation),
         m_flipOver(_source)
@@ -55,7 +58,9 @@ namespace world
         m_id(-1),
         m_type(TaxiEdge::Type::Taxiway),
         m_isOneWay(true),
-        m_name(""),
+        m_name(SymbolTable::EmptySymbol),
+        m_highSpeedExitRunway(SymbolTable::EmptySymbol),
+        m_runwayEndName(SymbolTable::EmptySymbol),
         m_lengthMeters(GeoMath::getDistanceMeters(_fromPoint.geo(), _toPoint.geo())),
         m_heading(GeoMath::getHeadingFromPoints(_fromPoint.geo(), _toPoint.geo())),
         m_nodeId1(-1),
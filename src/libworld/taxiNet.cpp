@@ -112,7 +112,7 @@ namespace world
 
         for (const auto& edge : runway->edges())
         {
-            const auto& effectiveEdge = edge->isRunway(runwayEnd.name())
+            const auto& effectiveEdge = edge->isRunway(runwayEnd.nameSymbol())
                 ? edge
                 : TaxiEdge::flipOver(edge);
 
@@ -295,7 +295,7 @@ namespace world
         while (node)
         {
             highSpeedExit = node->tryFindEdge([&](shared_ptr<TaxiEdge> e) {
-                return e->isHighSpeedExitRunway(runwayEnd.name()) && isInGateDirection(e);
+                return e->isHighSpeedExitRunway(runwayEnd.nameSymbol()) && isInGateDirection(e);
             });
             if (highSpeedExit)
             {
@@ -308,7 +308,7 @@ namespace world
                 });
             }
             shared_ptr<TaxiEdge> nextEdge = node->tryFindEdge([&](shared_ptr<TaxiEdge> e) {
-                return e->isRunway(runwayEnd.name());
+                return e->isRunway(runwayEnd.nameSymbol());
             });
             node = nextEdge ? nextEdge->node2() : nullptr;
         }
@@ -209,4 +209,73 @@ namespace world
         reverse(solution.begin(), solution.end());
         return shared_ptr<TaxiPath>(new TaxiPath(from, to, solution));
     }
+
+    vector<shared_ptr<TaxiPath>> TaxiPath::findMany(
+        shared_ptr<TaxiNet> net,
+        shared_ptr<TaxiNode> from,
+        const vector<shared_ptr<TaxiNode>>& to,
+        CostFunction costFunction)
+    {
+        // uniform cost search, which goes on until every destination is reached or the frontier is exhausted
+
+        unordered_map<int, PathStep> stepDoneById;
+        unordered_set<int> pendingIds;
+        PathStepPriorityQueue frontier(PathStep::compare);
+
+        for (const auto& toNode : to)
+        {
+            pendingIds.insert(toNode->id());
+        }
+        frontier.push({ from->id(), nullptr, 0 });
+
+        while (!pendingIds.empty() && frontier.size() > 0)
+        {
+            PathStep tail = frontier.top();
+            frontier.pop();
+
+            if (!stepDoneById.insert({ tail.id, tail }).second)
+            {
+                continue; // reached earlier at a lower cost
+            }
+            pendingIds.erase(tail.id);
+
+            auto tailNode = net->getNodeById(tail.id);
+            for (const auto& edge : tailNode->edges())
+            {
+                if (edge->type() != TaxiEdge::Type::Taxiway)
+                {
+                    continue;
+                }
+
+                int nextId = edge->node2()->id();
+                if (stepDoneById.find(nextId) == stepDoneById.end())
+                {
+                    frontier.push({ nextId, edge, tail.lengthToHere + costFunction(edge) });
+                }
+            }
+        }
+
+        vector<shared_ptr<TaxiPath>> paths;
+        for (const auto& toNode : to)
+        {
+            auto found = stepDoneById.find(toNode->id());
+            if (found == stepDoneById.end())
+            {
+                paths.push_back(nullptr);
+                continue;
+            }
+
+            vector<shared_ptr<TaxiEdge>> solution;
+            for (const PathStep* step = &found->second ; step->edgeToHere ; )
+            {
+                solution.push_back(step->edgeToHere);
+                step = &stepDoneById.at(step->edgeToHere->node1()->id());
+            }
+
+            reverse(solution.begin(), solution.end());
+            paths.push_back(shared_ptr<TaxiPath>(new TaxiPath(from, toNode, solution)));
+        }
+
+        return paths;
+    }
 }
@@ -4,45 +4,37 @@
 // 
 #include <vector>
 #include <string>
+#include <cstring>
 #include "libworld.h"
 
 using namespace std;
 
 namespace world
 {
-    UtteranceBuilder::UtteranceBuilder()
+    UtteranceBuilder::UtteranceBuilder() :
+        m_openPartSuffix(nullptr)
     {
+        m_plainText.reserve(512);
+        m_parts.reserve(32);
     }
 
     void UtteranceBuilder::addText(const string& text, bool slowDown)
     {
-        if (slowDown)
-        {
-            addPart("<rate speed='-5'>" + text + "</rate>", Utterance::PartType::Text);
-        }
-        else
-        {
-            addPart(text, Utterance::PartType::Text);
-        }
+        addPart(text, Utterance::PartType::Text, slowDown);
     }
 
     void UtteranceBuilder::addData(const string& text, bool slowDown)
     {
-        if (slowDown)
-        {
-            addPart("<rate speed='-2'>" + text + "</rate>", Utterance::PartType::Data);
-        }
-        else
-        {
-            addPart("<rate speed='-1'>" + text + "</rate>", Utterance::PartType::Data);
-        }
+        addPart(text, Utterance::PartType::Data, slowDown);
     }
 
     void UtteranceBuilder::addDisfluency(const string& text, bool skip)
     {
         if (!skip)
         {
-            addPart("<rate speed='-7'><pitch middle='-1'><silence msec='1'/>uhm</pitch></rate>", Utterance::PartType::Disfluency);
+            beginPart(Utterance::PartType::Disfluency);
+            append("<rate speed='-7'><pitch middle='-1'><silence msec='1'/>uhm</pitch></rate>");
+            endPart();
         }
     }
 
@@ -50,7 +42,9 @@ namespace world
     {
         if (!skip)
         {
-            addPart("<rate speed='1'><pitch middle='-1'><silence msec='100'/>err</pitch><silence msec='100'/><pitch middle='1'>correction</pitch></rate>", Utterance::PartType::Disfluency);
+            beginPart(Utterance::PartType::Disfluency);
+            append("<rate speed='1'><pitch middle='-1'><silence msec='100'/>err</pitch><silence msec='100'/><pitch middle='1'>correction</pitch></rate>");
+            endPart();
             addPart(text, Utterance::PartType::Correction);
         }
     }
@@ -62,7 +56,7 @@ namespace world
 
     void UtteranceBuilder::addFarewell(const string& text)
     {
-        addPart("<pitch middle='1'/><rate speed='1'/>" + text, Utterance::PartType::Farewell);
+        addPart(text, Utterance::PartType::Farewell);
     }
 
     void UtteranceBuilder::addAffirmation(const string& text)
@@ -77,28 +71,112 @@ namespace world
 
     void UtteranceBuilder::addPunctuation()
     {
-        m_parts.push_back({ (int)m_plainText.tellp(), 1, Utterance::PartType::Punctuation });
-        m_plainText << ',';
+        m_parts.push_back({ (int)m_plainText.length(), 1, Utterance::PartType::Punctuation });
+        m_plainText += ',';
     }
 
     shared_ptr<Utterance> UtteranceBuilder::getUtterance()
     {
         auto utterance = make_shared<Utterance>();
-        utterance->m_plainText = m_plainText.str();
+        utterance->m_plainText = m_plainText;
         utterance->m_parts = m_parts;
+        clear();
         return utterance;
     }
 
-    Utterance::Part& UtteranceBuilder::addPart(const string& text, Utterance::PartType type)
+    void UtteranceBuilder::clear()
+    {
+        m_plainText.clear();
+        m_parts.clear();
+        m_openPartSuffix = nullptr;
+    }
+
+    void UtteranceBuilder::beginPart(Utterance::PartType type, bool slowDown)
     {
         if (m_parts.size() > 0)
         {
-            m_plainText << " ";
+            m_plainText += ' ';
+        }
+
+        m_parts.push_back({ (int)m_plainText.length(), 0, type });
+        m_openPartSuffix = "";
+
+        switch (type)
+        {
+        case Utterance::PartType::Text:
+            if (slowDown)
+            {
+                append("<rate speed='-5'>");
+                m_openPartSuffix = "</rate>";
+            }
+            break;
+        case Utterance::PartType::Data:
+            append(slowDown ? "<rate speed='-2'>" : "<rate speed='-1'>");
+            m_openPartSuffix = "</rate>";
+            break;
+        case Utterance::PartType::Farewell:
+            append("<pitch middle='1'/><rate speed='1'/>");
+            break;
+        default:
+            break;
+        }
+    }
+
+    void UtteranceBuilder::append(const char* text, size_t length)
+    {
+        m_plainText.append(text, length);
+    }
+
+    void UtteranceBuilder::append(const char* text)
+    {
+        m_plainText.append(text, strlen(text));
+    }
+
+    void UtteranceBuilder::append(char c)
+    {
+        m_plainText += c;
+    }
+
+    void UtteranceBuilder::appendNumber(int value)
+    {
+        char digits[16];
+        int count = 0;
+        unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+        do
+        {
+            digits[count++] = (char)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+
+        if (value < 0)
+        {
+            m_plainText += '-';
+        }
+        while (count > 0)
+        {
+            m_plainText += digits[--count];
+        }
+    }
+
+    void UtteranceBuilder::endPart()
+    {
+        if (!m_openPartSuffix)
+        {
+            throw runtime_error("UtteranceBuilder::endPart: no part was begun");
         }
 
-        m_parts.push_back({ (int)m_plainText.tellp(), (int)text.length(), type });
-        m_plainText << text;
+        append(m_openPartSuffix);
+        m_openPartSuffix = nullptr;
 
-        return m_parts[m_parts.size() - 1];
+        auto& part = m_parts.back();
+        part.length = (int)m_plainText.length() - part.startIndex;
+    }
+
+    void UtteranceBuilder::addPart(const string& text, Utterance::PartType type, bool slowDown)
+    {
+        beginPart(type, slowDown);
+        append(text);
+        endPart();
     }
 }
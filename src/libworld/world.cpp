@@ -3,7 +3,10 @@
 // Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
 // 
 #include <algorithm>
+#include <cmath>
 #include "libworld.h"
+#include "stlhelpers.h"
+#include "asyncLog.hpp"
 
 using namespace std;
 
@@ -45,6 +48,23 @@ namespace world
         }
     }
 
+    void World::addAirport(shared_ptr<Airport> airport)
+    {
+        m_airports.push_back(airport);
+        m_airportByIcao.insert({ airport->header().icao(), airport });
+        m_airportsGeneration++;
+
+        m_airportGrid.add(airport->header().datum(), airport);
+
+        if (airport->tower())
+        {
+            auto airspace = airport->tower()->airspace();
+            m_airspaces.push_back(airspace);
+            m_airspaceById.insert({ airspace->id(), airspace });
+            m_controlFacilities.push_back(airport->tower());
+        }
+    }
+
     void World::addFlight(shared_ptr<Flight> flight)
     {
         m_flights.push_back(flight);
@@ -78,6 +98,79 @@ namespace world
         flight->aircraft()->park(parkingStand);
     }
 
+    void World::scheduleFlight(const string& description, shared_ptr<Flight> flight, time_t time, function<void()> onAdded)
+    {
+        m_scheduledFlightById[flight->id()] = flight;
+
+        deferUntil(description, time, [this, flight, onAdded] {
+            m_scheduledFlightById.erase(flight->id());
+            addFlight(flight);
+            onAdded();
+        }, flight->id());
+    }
+
+    void World::removeFlight(shared_ptr<Flight> flight)
+    {
+        // a flight which is scheduled but not yet added only has work items to discard
+        int discardedWorkItemCount = discardWorkItemsOf(flight->id());
+        m_scheduledFlightById.erase(flight->id());
+
+        auto found = find(m_flights.begin(), m_flights.end(), flight);
+        if (found == m_flights.end())
+        {
+            return;
+        }
+
+        m_flights.erase(found);
+        m_flightById.erase(flight->id());
+        m_changeSet->m_flights.removed(flight);
+
+        // the frequency listener of the aircraft refers to it by raw pointer
+        if (flight->aircraft())
+        {
+            flight->aircraft()->setFrequency(nullptr);
+        }
+
+        // changes which a detached flight still makes no longer reach the world
+        auto detachedChangeSet = make_shared<ChangeSet>();
+        flight->onChanges([detachedChangeSet] {
+            return detachedChangeSet;
+        });
+
+        m_host->writeLog(
+            "Removed flight: %s, discarded [%d] work items",
+            flight->callSign().c_str(),
+            discardedWorkItemCount);
+    }
+
+    void World::reloadAirport(const string& icaoCode, const ReloadAirportCallback& onReloadAirport)
+    {
+        auto oldAirport = getAirport(icaoCode);
+        auto airspace = oldAirport->tower()
+            ? oldAirport->tower()->airspace()
+            : nullptr;
+
+        auto newAirport = onReloadAirport(icaoCode, airspace);
+
+        // assembling the new airport links the shared airspace to it; the airspace is pointed
+        // back at the old airport until the swap, and re-linked in replaceAirport()
+        if (airspace)
+        {
+            WorldBuilder::linkAirportTowerAirspace(m_host, oldAirport, oldAirport->tower(), airspace);
+        }
+
+        if (!newAirport || newAirport->header().icao() != icaoCode)
+        {
+            throw runtime_error("World::reloadAirport: airport [" + icaoCode + "] could not be reloaded");
+        }
+
+        // the airport is assembled right away, but swapped in only before the next tick,
+        // so that flights and controllers never observe a half-replaced airport
+        deferUntilNextTick("reloadAirport:" + icaoCode, [this, oldAirport, newAirport] {
+            replaceAirport(oldAirport, newAirport);
+        });
+    }
+
     void World::clearAllFlights()
     {
         for (const auto& facility : m_controlFacilities)
@@ -89,6 +182,7 @@ namespace world
         m_host->services().get<AircraftObjectService>()->clearAll();
         m_flights.clear();
         m_flightById.clear();
+        m_scheduledFlightById.clear();
 
         clearWorkItems();
     }
@@ -113,13 +207,13 @@ namespace world
             return;
         }
 
-        m_host->writeLog("World is processing due work items");
+        ATC_LOG_DEBUG(AsyncLog::Category::World, "World is processing due work items");
         int count = 0;
 
         while (!m_workItemQueue.empty() && m_workItemQueue.top().timestamp <= m_timestamp)
         {
             const auto& workItem = m_workItemQueue.top();
-            m_host->writeLog("WORLD |work item [%s]", workItem.description.c_str());
+            ATC_LOG_TRACE(AsyncLog::Category::World, "WORLD |work item [%s]", workItem.description);
 
             try
             {
@@ -127,16 +221,17 @@ namespace world
             }
             catch(const exception& e)
             {
-                m_host->writeLog(
+                ATC_LOG_ERROR(
+                    AsyncLog::Category::World,
                     "WORLD |work item [%s] callback CRASHED!!! %s",
-                    workItem.description.c_str(), e.what());
+                    workItem.description, e.what());
             }
             
             m_workItemQueue.pop();
             count++;
         }
 
-        m_host->writeLog("World has processed %d work items, %d remaining", count, m_workItemQueue.size());
+        ATC_LOG_DEBUG(AsyncLog::Category::World, "World has processed %d work items, %d remaining", count, m_workItemQueue.size());
     }
 
     void World::processFlights()
@@ -190,21 +285,47 @@ namespace world
         return temp;
     }
 
-    void World::deferUntilNextTick(const string& description, function<void()> callback)
+    void World::deferUntilNextTick(const string& description, function<void()> callback, int flightId)
     {
-        m_workItemQueue.push({ description, m_timestamp, callback });
+        m_workItemQueue.push({ description, m_timestamp, callback, flightId });
     }
     
-    void World::deferUntil(const string& description, time_t time, function<void()> callback)
+    void World::deferUntil(const string& description, time_t time, function<void()> callback, int flightId)
     {
         time_t deltaTimeInSeconds = time - currentTime();
         chrono::microseconds deferredTimestamp = chrono::microseconds(m_timestamp.count() + deltaTimeInSeconds * 1000000);
-        m_workItemQueue.push({ description, deferredTimestamp, callback });
+        m_workItemQueue.push({ description, deferredTimestamp, callback, flightId });
     }
     
-    void World::deferBy(const string& description, chrono::microseconds microseconds, function<void()> callback)
+    void World::deferBy(const string& description, chrono::microseconds microseconds, function<void()> callback, int flightId)
     {
-        m_workItemQueue.push({ description, m_timestamp + microseconds, callback });
+        m_workItemQueue.push({ description, m_timestamp + microseconds, callback, flightId });
+    }
+
+    int World::discardWorkItemsOf(int flightId)
+    {
+        vector<WorkItem> keptWorkItems;
+        int discardedCount = 0;
+
+        while (!m_workItemQueue.empty())
+        {
+            if (m_workItemQueue.top().flightId == flightId)
+            {
+                discardedCount++;
+            }
+            else
+            {
+                keptWorkItems.push_back(m_workItemQueue.top());
+            }
+            m_workItemQueue.pop();
+        }
+
+        for (auto& workItem : keptWorkItems)
+        {
+            m_workItemQueue.push(std::move(workItem));
+        }
+
+        return discardedCount;
     }
 
     shared_ptr<Frequency> World::tryFindCommFrequency(shared_ptr<Flight> flight, int frequencyKhz)
@@ -231,6 +352,28 @@ namespace world
         return airport->getRunwayOrThrow(runwayName);
     }
 
+    shared_ptr<Airport> World::tryFindAirport(const string& icaoCode) const
+    {
+        shared_ptr<Airport> airport;
+        tryGetValue(m_airportByIcao, icaoCode, airport);
+        return airport;
+    }
+
+    vector<shared_ptr<Airport>> World::findAirportsInRadius(const GeoPoint& center, float radiusNm) const
+    {
+        vector<shared_ptr<Airport>> results;
+        const float radiusMeters = radiusNm * 1852.0f;
+
+        m_airportGrid.forEachNear(center, radiusNm, [&](const shared_ptr<Airport>& airport) {
+            if (GeoMath::getDistanceMeters(center, airport->header().datum()) <= radiusMeters)
+            {
+                results.push_back(airport);
+            }
+        });
+
+        return results;
+    }
+
     const Runway::End& World::getRunwayEnd(const string& airportIcao, const string& runwayName) const
     {
         auto airport = getAirport(airportIcao);
@@ -238,6 +381,121 @@ namespace world
         return runway->getEndOrThrow(runwayName);
     }
 
+    void World::replaceAirport(shared_ptr<Airport> oldAirport, shared_ptr<Airport> newAirport)
+    {
+        replace(m_airports.begin(), m_airports.end(), oldAirport, newAirport);
+        m_airportByIcao[newAirport->header().icao()] = newAirport;
+        m_airportsGeneration++;
+
+        m_airportGrid.remove(GeoGridIndex<shared_ptr<Airport>>::getCell(oldAirport->header().datum()), oldAirport);
+        m_airportGrid.add(newAirport->header().datum(), newAirport);
+
+        auto oldTower = oldAirport->tower();
+        auto newTower = newAirport->tower();
+        if (oldTower)
+        {
+            oldTower->clearFlights();
+            m_controlFacilities.erase(
+                remove(m_controlFacilities.begin(), m_controlFacilities.end(), oldTower),
+                m_controlFacilities.end());
+        }
+        if (newTower)
+        {
+            m_controlFacilities.push_back(newTower);
+            auto airspace = newTower->airspace();
+            WorldBuilder::linkAirportTowerAirspace(m_host, newAirport, newTower, airspace);
+            if (!hasKey(m_airspaceById, airspace->id()))
+            {
+                m_airspaces.push_back(airspace);
+                m_airspaceById.insert({ airspace->id(), airspace });
+            }
+        }
+
+        if (newTower && !oldAirport->activeDepartureRunways().empty())
+        {
+            newAirport->selectActiveRunways();
+            newAirport->selectArrivalAndDepartureTaxiways();
+        }
+
+        int removedFlightCount = revalidateFlightsAt(newAirport);
+        m_changeSet->setConfigurationChanged();
+
+        m_host->writeLog(
+            "WORLD |reloaded airport [%s], removed [%d] flights",
+            newAirport->header().icao().c_str(),
+            removedFlightCount);
+    }
+
+    int World::revalidateFlightsAt(shared_ptr<Airport> airport)
+    {
+        const string& icao = airport->header().icao();
+        vector<shared_ptr<Flight>> invalidFlights;
+
+        const auto revalidate = [&](const shared_ptr<Flight>& flight, bool isScheduled) {
+            auto plan = flight->plan();
+            if (plan->departureAirportIcao() != icao && plan->arrivalAirportIcao() != icao)
+            {
+                return;
+            }
+
+            // AI pilots on the ground hold on to taxi paths and controllers of the replaced airport;
+            // scheduled flights haven't started yet, so only their flight plans can be invalid
+            bool isAI = flight->pilot() && flight->pilot()->nature() == Actor::Nature::AI;
+            bool isOnGround = !isScheduled && flight->aircraft()->altitude().isGround();
+            bool isValid = isFlightPlanValidAt(plan, airport);
+
+            if ((isAI || isScheduled) && (isOnGround || !isValid))
+            {
+                invalidFlights.push_back(flight);
+            }
+            else if (!isValid)
+            {
+                m_host->writeLog(
+                    "WORLD |WARNING: flight plan of [%s] is not valid at reloaded airport [%s]",
+                    flight->callSign().c_str(),
+                    icao.c_str());
+            }
+        };
+
+        for (const auto& flight : m_flights)
+        {
+            revalidate(flight, false);
+        }
+        for (const auto& entry : m_scheduledFlightById)
+        {
+            revalidate(entry.second, true);
+        }
+
+        for (const auto& flight : invalidFlights)
+        {
+            removeFlight(flight);
+        }
+
+        return invalidFlights.size();
+    }
+
+    bool World::isFlightPlanValidAt(shared_ptr<FlightPlan> plan, shared_ptr<Airport> airport)
+    {
+        const auto isValidRunway = [&](const string& name) {
+            return name.empty() || airport->tryFindRunway(name);
+        };
+        const auto isValidGate = [&](const string& name) {
+            return name.empty() || airport->tryFindParkingStand(name);
+        };
+
+        if (plan->departureAirportIcao() == airport->header().icao() &&
+            (!isValidRunway(plan->departureRunway()) || !isValidGate(plan->departureGate())))
+        {
+            return false;
+        }
+        if (plan->arrivalAirportIcao() == airport->header().icao() &&
+            (!isValidRunway(plan->arrivalRunway()) || !isValidGate(plan->arrivalGate())))
+        {
+            return false;
+        }
+        return true;
+    }
+
     bool World::compareWorkItems(const World::WorkItem& left, const World::WorkItem& right)
     {
         return (left.timestamp > right.timestamp);
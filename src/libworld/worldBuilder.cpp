@@ -27,15 +27,7 @@ namespace world
 
         for (const auto& airport : airports)
         {
-            world->m_airports.push_back(airport);
-            world->m_airportByIcao.insert({airport->header().icao(), airport});
-            if (airport->tower())
-            {
-                auto airspace = airport->tower()->airspace();
-                world->m_airspaces.push_back(airspace);
-                world->m_airspaceById.insert({airspace->id(), airspace});
-                world->m_controlFacilities.push_back(airport->tower());
-            }
+            world->addAirport(airport);
         }
 
         return world;
@@ -61,7 +53,7 @@ namespace world
         for (auto parking : parkingStands)
         {
             airport->m_parkingStands.push_back(parking);
-            airport->m_parkingStandByName.insert({ parking->m_name, parking });
+            airport->m_parkingStandByName.insert({ parking->name(), parking });
         }
 
         fixUpEdgesAndRunways(host, airport);
@@ -70,6 +62,38 @@ namespace world
         return airport;
     }
 
+    shared_ptr<Airport> WorldBuilder::assembleAirport(
+        shared_ptr<HostServices> host,
+        const Airport::Structure& structure,
+        shared_ptr<ControlledAirspace> airspace)
+    {
+        auto airport = assembleAirport(
+            host,
+            structure.header,
+            structure.runways,
+            structure.parkingStands,
+            structure.taxiNodes,
+            structure.taxiEdges);
+
+        attachAirportTower(host, airport, airspace, structure.controllerPositions);
+        return airport;
+    }
+
+    void WorldBuilder::attachAirportTower(
+        shared_ptr<HostServices> host,
+        shared_ptr<Airport> airport,
+        shared_ptr<ControlledAirspace> airspace,
+        const vector<ControllerPosition::Structure>& positions)
+    {
+        if (!airspace)
+        {
+            return;
+        }
+
+        auto tower = assembleAirportTower(host, airport->header(), airspace, positions);
+        linkAirportTowerAirspace(host, airport, tower, airspace);
+    }
+
     shared_ptr<ControlFacility> WorldBuilder::assembleAirportTower(
         shared_ptr<HostServices> host, 
         const Airport::Header& header,
@@ -404,14 +428,14 @@ namespace world
                 float turnDegrees1 = GeoMath::getTurnDegrees(runway->m_end1.m_heading, edge->m_heading);
                 if (abs(turnDegrees1) < 60)
                 {
-                    edge->m_highSpeedExitRunway = runway->m_end1.m_name;
+                    edge->m_highSpeedExitRunway = runway->m_end1.m_nameSymbol;
                     continue;
                 }
 
                 float turnDegrees2 = GeoMath::getTurnDegrees(runway->m_end2.m_heading, edge->m_heading);
                 if (abs(turnDegrees2) < 60)
                 {
-                    edge->m_highSpeedExitRunway = runway->m_end2.m_name;
+                    edge->m_highSpeedExitRunway = runway->m_end2.m_nameSymbol;
                 }
             }
         };
@@ -423,15 +447,15 @@ namespace world
         ) {
             float end1Turn = GeoMath::getTurnDegrees(runway->m_end1.m_heading, edge1->m_heading);
             edge1->m_runwayEndName = abs(end1Turn) < 45
-                ? runway->m_end1.m_name
-                : runway->m_end2.m_name;
+                ? runway->m_end1.m_nameSymbol
+                : runway->m_end2.m_nameSymbol;
 
             if (edge2)
             {
                 edge2->m_runway = runway;
                 edge2->m_runwayEndName = abs(end1Turn) < 45
-                    ? runway->m_end2.m_name
-                    : runway->m_end1.m_name;
+                    ? runway->m_end2.m_nameSymbol
+                    : runway->m_end1.m_nameSymbol;
             }
         };
 
@@ -439,7 +463,7 @@ namespace world
             switch (edge->m_type)
             {
             case TaxiEdge::Type::Runway:
-                edge->m_runway = airport->getRunwayOrThrow(edge->m_name);
+                edge->m_runway = airport->getRunwayOrThrow(edge->name());
                 edge->m_runway->m_edges.push_back(edge);
                 edge->m_node1->m_hasRunway = true;
                 edge->m_node2->m_hasRunway = true;
@@ -0,0 +1,307 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "libworld.h"
+#include "boundedQueue.hpp"
+
+using namespace std;
+
+namespace world
+{
+    // Loads airports into the world in stages, so that every airport becomes
+    // available as soon as it is done, rather than after all of them are done:
+    //
+    //   parse (1 thread) -> assemble (N threads) -> link tower & airspace (1 thread) -> index (drainInto)
+    //
+    // Stages are connected by bounded queues; a stage which runs ahead waits
+    // for the next one to catch up. The index stage adds airports to the world
+    // and runs on the thread which owns the world, from drainInto().
+    class WorldLoadPipeline
+    {
+    public:
+        typedef function<bool(shared_ptr<Airport::Structure> structure)> EmitAirportCallback;
+        typedef function<void(const EmitAirportCallback& emit)> ParseAirportsCallback;
+        typedef function<shared_ptr<ControlledAirspace>(const Airport::Header& header)> QueryAirspaceCallback;
+        enum class Stage
+        {
+            Parse = 0,
+            Assemble = 1,
+            Link = 2,
+            Index = 3
+        };
+        struct StageProgress
+        {
+            int processed;
+            int failed;
+            bool finished;
+        };
+    private:
+        struct AssembledAirport
+        {
+            shared_ptr<Airport> airport;
+            shared_ptr<Airport::Structure> structure;
+        };
+        struct StageCounters
+        {
+            atomic<int> processed;
+            atomic<int> failed;
+            atomic<bool> finished;
+        };
+    private:
+        static constexpr int StageCount = 4;
+        shared_ptr<HostServices> m_host;
+        ParseAirportsCallback m_onParseAirports;
+        QueryAirspaceCallback m_onQueryAirspace;
+        int m_assembleThreadCount;
+        BoundedQueue<shared_ptr<Airport::Structure>> m_parsedQueue;
+        BoundedQueue<AssembledAirport> m_assembledQueue;
+        BoundedQueue<shared_ptr<Airport>> m_linkedQueue;
+        StageCounters m_stages[StageCount];
+        atomic<int> m_runningAssembleThreads;
+        atomic<bool> m_stopRequested;
+        vector<thread> m_threads;
+    public:
+        WorldLoadPipeline(
+            shared_ptr<HostServices> _host,
+            ParseAirportsCallback _onParseAirports,
+            QueryAirspaceCallback _onQueryAirspace,
+            int _assembleThreadCount = 2,
+            size_t _queueCapacity = 256
+        ) : m_host(_host),
+            m_onParseAirports(std::move(_onParseAirports)),
+            m_onQueryAirspace(std::move(_onQueryAirspace)),
+            m_assembleThreadCount(max(1, _assembleThreadCount)),
+            m_parsedQueue(_queueCapacity),
+            m_assembledQueue(_queueCapacity),
+            m_linkedQueue(_queueCapacity),
+            m_runningAssembleThreads(0),
+            m_stopRequested(false)
+        {
+            for (auto& stage : m_stages)
+            {
+                stage.processed = 0;
+                stage.failed = 0;
+                stage.finished = false;
+            }
+        }
+
+        ~WorldLoadPipeline()
+        {
+            stop();
+        }
+
+    public:
+
+        void start()
+        {
+            if (!m_threads.empty())
+            {
+                throw runtime_error("WorldLoadPipeline::start: already started");
+            }
+
+            m_runningAssembleThreads = m_assembleThreadCount;
+            m_threads.emplace_back([this] { runParseStage(); });
+            for (int i = 0 ; i < m_assembleThreadCount ; i++)
+            {
+                m_threads.emplace_back([this] { runAssembleStage(); });
+            }
+            m_threads.emplace_back([this] { runLinkStage(); });
+        }
+
+        void stop()
+        {
+            m_stopRequested = true;
+            for (auto& thread : m_threads)
+            {
+                if (thread.joinable())
+                {
+                    thread.join();
+                }
+            }
+        }
+
+        // must be called on the thread which owns the world;
+        // returns the number of airports added to the world
+        int drainInto(shared_ptr<World> world, int maxAirports = -1)
+        {
+            int count = 0;
+            shared_ptr<Airport> airport;
+
+            while ((maxAirports < 0 || count < maxAirports) && m_linkedQueue.tryPop(airport))
+            {
+                world->addAirport(airport);
+                m_stages[(int)Stage::Index].processed++;
+                count++;
+            }
+
+            if (m_stages[(int)Stage::Link].finished && m_linkedQueue.sizeApprox() == 0)
+            {
+                m_stages[(int)Stage::Index].finished = true;
+            }
+
+            return count;
+        }
+
+        StageProgress getProgress(Stage stage) const
+        {
+            const auto& counters = m_stages[(int)stage];
+            return { counters.processed.load(), counters.failed.load(), counters.finished.load() };
+        }
+
+        bool finished() const
+        {
+            return m_stages[(int)Stage::Index].finished;
+        }
+
+        void logProgress()
+        {
+            const auto parse = getProgress(Stage::Parse);
+            const auto assemble = getProgress(Stage::Assemble);
+            const auto link = getProgress(Stage::Link);
+            const auto index = getProgress(Stage::Index);
+
+            m_host->writeLog(
+                "LWORLD|load progress: parsed[%d%s] assembled[%d/%d failed%s] linked[%d/%d failed%s] indexed[%d%s]",
+                parse.processed, parse.finished ? ",done" : "",
+                assemble.processed, assemble.failed, assemble.finished ? ",done" : "",
+                link.processed, link.failed, link.finished ? ",done" : "",
+                index.processed, index.finished ? ",done" : "");
+        }
+
+    private:
+
+        void runParseStage()
+        {
+            auto& counters = m_stages[(int)Stage::Parse];
+
+            try
+            {
+                m_onParseAirports([this, &counters](shared_ptr<Airport::Structure> structure) {
+                    if (!pushOrWait(m_parsedQueue, std::move(structure)))
+                    {
+                        return false;
+                    }
+                    counters.processed++;
+                    return true;
+                });
+            }
+            catch (const exception& e)
+            {
+                counters.failed++;
+                m_host->writeLog("LWORLD|parse stage CRASHED!!! %s", e.what());
+            }
+
+            counters.finished = true;
+        }
+
+        void runAssembleStage()
+        {
+            auto& counters = m_stages[(int)Stage::Assemble];
+            shared_ptr<Airport::Structure> structure;
+
+            while (popOrWait(m_parsedQueue, structure, m_stages[(int)Stage::Parse].finished))
+            {
+                try
+                {
+                    auto airport = WorldBuilder::assembleAirport(m_host, *structure);
+                    if (!pushOrWait(m_assembledQueue, AssembledAirport({ airport, structure })))
+                    {
+                        break;
+                    }
+                    counters.processed++;
+                }
+                catch (const exception& e)
+                {
+                    counters.failed++;
+                    m_host->writeLog(
+                        "LWORLD|FAILED to assemble airport [%s]: %s",
+                        structure->header.icao().c_str(),
+                        e.what());
+                }
+            }
+
+            if (--m_runningAssembleThreads == 0)
+            {
+                counters.finished = true;
+            }
+        }
+
+        void runLinkStage()
+        {
+            auto& counters = m_stages[(int)Stage::Link];
+            AssembledAirport assembled;
+
+            while (popOrWait(m_assembledQueue, assembled, m_stages[(int)Stage::Assemble].finished))
+            {
+                try
+                {
+                    auto airspace = m_onQueryAirspace(assembled.airport->header());
+                    WorldBuilder::attachAirportTower(
+                        m_host,
+                        assembled.airport,
+                        airspace,
+                        assembled.structure->controllerPositions);
+
+                    if (!pushOrWait(m_linkedQueue, std::move(assembled.airport)))
+                    {
+                        break;
+                    }
+                    counters.processed++;
+                }
+                catch (const exception& e)
+                {
+                    counters.failed++;
+                    m_host->writeLog(
+                        "LWORLD|FAILED to link tower of airport [%s]: %s",
+                        assembled.structure->header.icao().c_str(),
+                        e.what());
+                }
+            }
+
+            counters.finished = true;
+        }
+
+        template<class T>
+        bool pushOrWait(BoundedQueue<T>& queue, T&& item)
+        {
+            while (!queue.tryPush(std::move(item)))
+            {
+                if (m_stopRequested)
+                {
+                    return false;
+                }
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            return true;
+        }
+
+        // returns false once the upstream stage has finished and the queue is drained
+        template<class T>
+        bool popOrWait(BoundedQueue<T>& queue, T& item, const atomic<bool>& upstreamFinished)
+        {
+            while (!m_stopRequested)
+            {
+                if (queue.tryPop(item))
+                {
+                    return true;
+                }
+                if (upstreamFinished)
+                {
+                    // everything pushed upstream happened before the finished flag was set
+                    return queue.tryPop(item);
+                }
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            return false;
+        }
+    };
+}
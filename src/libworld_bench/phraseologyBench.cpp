@@ -0,0 +1,229 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+// Counts heap allocations per verbalized transmission: a "contact tower" handoff built
+// with stringstream spelling helpers into a stringstream builder (the way transmissions
+// were built before phraseology templates), the same handoff built with today's spell*()
+// helpers into a fresh builder, and rendered from a compiled template into a reused
+// builder (the way SimplePhraseologyService builds it now).
+//
+// usage: phraseology_bench [--iterations <n>]
+//
+// --iterations  how many transmissions are verbalized per variant (default: 100000)
+//
+// The template path is expected to allocate only what the utterance itself owns: the shared
+// block, the text and the parts; rendering into the reused builder allocates nothing.
+// Exits with a non-zero code if it allocates more than that.
+//
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "libworld.h"
+#include "simplePhraseologyService.hpp"
+#include "phraseologyTemplate.hpp"
+
+using namespace std;
+using namespace world;
+
+// allocations are counted by replacing global operator new
+static atomic<long long> allocationCount(0);
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    void* block = malloc(size > 0 ? size : 1);
+    if (!block)
+    {
+        throw bad_alloc();
+    }
+    return block;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+// keeps the optimizer from dropping the utterances
+static volatile size_t utteranceSink = 0;
+
+// the stringstream builder and spelling helpers as they were before phraseology templates;
+// the utterance is a copy of the builder's text and parts, like Utterance is
+struct LegacyUtterance
+{
+    string plainText;
+    vector<Utterance::Part> parts;
+};
+
+class LegacyUtteranceBuilder
+{
+private:
+    stringstream m_plainText;
+    vector<Utterance::Part> m_parts;
+public:
+    void addText(const string& text)
+    {
+        addPart(text, Utterance::PartType::Text);
+    }
+    void addData(const string& text)
+    {
+        addPart("<rate speed='-1'>" + text + "</rate>", Utterance::PartType::Data);
+    }
+    void addFarewell(const string& text)
+    {
+        addPart("<pitch middle='1'/><rate speed='1'/>" + text, Utterance::PartType::Farewell);
+    }
+    shared_ptr<LegacyUtterance> getUtterance()
+    {
+        auto utterance = make_shared<LegacyUtterance>();
+        utterance->plainText = m_plainText.str();
+        utterance->parts = m_parts;
+        return utterance;
+    }
+    static string spellCallsign(const string& callsign)
+    {
+        stringstream text;
+        for (int i = 0 ; i < callsign.length() ; i++)
+        {
+            if (i > 0 && (isdigit(callsign[i]) || isdigit(callsign[i-1])))
+            {
+                text << ' ';
+            }
+            text << callsign[i];
+        }
+        return text.str();
+    }
+    static string spellFrequency(int khz)
+    {
+        stringstream text;
+        int mhzOnly = khz / 1000;
+        int khzOnly = khz % 1000;
+        int mhzDigits[3] = { mhzOnly / 100, (mhzOnly / 10) % 10, mhzOnly % 10 };
+        int khzDigits[3] = { khzOnly / 100, (khzOnly / 10) % 10, khzOnly % 10 };
+        text << mhzDigits[0] << ' ' << mhzDigits[1] << ' ' << mhzDigits[2] << " point " << khzDigits[0];
+        if (khzDigits[1] != 0 || khzDigits[2] != 0)
+        {
+            text << ' ' << khzDigits[1];
+        }
+        if (khzDigits[2] != 0)
+        {
+            text << ' ' << khzDigits[2];
+        }
+        return text.str();
+    }
+private:
+    void addPart(const string& text, Utterance::PartType type)
+    {
+        if (m_parts.size() > 0)
+        {
+            m_plainText << " ";
+        }
+        m_parts.push_back({ (int)m_plainText.tellp(), (int)text.length(), type });
+        m_plainText << text;
+    }
+};
+
+struct VariantResult
+{
+    double allocationsPerTransmission = 0;
+    double microsecondsPerTransmission = 0;
+};
+
+static VariantResult measure(int iterations, const function<size_t(int index)>& verbalize)
+{
+    // warm up: the first transmission grows the reused buffers
+    utteranceSink += verbalize(0);
+
+    long long allocationsBefore = allocationCount.load();
+    auto startTime = chrono::high_resolution_clock::now();
+
+    for (int i = 0 ; i < iterations ; i++)
+    {
+        utteranceSink += verbalize(i);
+    }
+
+    auto endTime = chrono::high_resolution_clock::now();
+    long long allocations = allocationCount.load() - allocationsBefore;
+
+    VariantResult result;
+    result.allocationsPerTransmission = (double)allocations / iterations;
+    result.microsecondsPerTransmission =
+        chrono::duration<double, micro>(endTime - startTime).count() / iterations;
+    return result;
+}
+
+static const char* callsigns[] = { "DAL123", "AAL9", "N123AB", "UAL2041" };
+static const int frequencies[] = { 118300, 121900, 132025, 119100 };
+
+int main(int argc, char* argv[])
+{
+    int iterations = 100000;
+    for (int i = 1 ; i < argc ; i++)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else
+        {
+            cerr << "usage: phraseology_bench [--iterations <n>]" << endl;
+            return 1;
+        }
+    }
+
+    auto legacyResult = measure(iterations, [](int index) {
+        LegacyUtteranceBuilder builder;
+        builder.addData(LegacyUtteranceBuilder::spellCallsign(callsigns[index % 4]));
+        builder.addText("contact tower on");
+        builder.addData(LegacyUtteranceBuilder::spellFrequency(frequencies[index % 4]));
+        builder.addFarewell("have a good one");
+        return builder.getUtterance()->plainText.length();
+    });
+
+    auto helpersResult = measure(iterations, [](int index) {
+        UtteranceBuilder builder;
+        builder.addData(SimplePhraseologyService::spellCallsign(callsigns[index % 4]));
+        builder.addText("contact tower on");
+        builder.addData(SimplePhraseologyService::spellFrequency(frequencies[index % 4]));
+        builder.addFarewell("have a good one");
+        return builder.getUtterance()->plainText().length();
+    });
+
+    auto phrase = PhraseologyTemplate::compile(
+        "{0:callsign} contact tower on {1:frequency} {=have a good one|farewell}");
+    UtteranceBuilder reusedBuilder;
+    auto templateResult = measure(iterations, [&](int index) {
+        reusedBuilder.clear();
+        phrase.render(reusedBuilder, callsigns[index % 4], frequencies[index % 4]);
+        return reusedBuilder.getUtterance()->plainText().length();
+    });
+
+    printf("stringstream builder and helpers:  %6.2f allocations, %6.3f us per transmission\n",
+        legacyResult.allocationsPerTransmission, legacyResult.microsecondsPerTransmission);
+    printf("spell helpers, fresh builder:      %6.2f allocations, %6.3f us per transmission\n",
+        helpersResult.allocationsPerTransmission, helpersResult.microsecondsPerTransmission);
+    printf("compiled template, reused builder: %6.2f allocations, %6.3f us per transmission\n",
+        templateResult.allocationsPerTransmission, templateResult.microsecondsPerTransmission);
+
+    printf("compiled templates allocate %.1f times less than stringstream builder\n",
+        legacyResult.allocationsPerTransmission / templateResult.allocationsPerTransmission);
+
+    const double utteranceOwnAllocations = 3;
+    if (templateResult.allocationsPerTransmission > utteranceOwnAllocations)
+    {
+        printf("FAILED: rendering a compiled template into a reused builder allocates\n");
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+
+// Measures throughput of the radio effect applied to 16-bit speech PCM: the block-based chain
+// with SSE2, the same chain with scalar code only, and a biquad high-pass which processes
+// one sample at a time with a switch on sample format (the way speech buffers were filtered before).
+//
+// usage: radio_effect_bench [--iterations <n>] [--min-samples-per-sec <n>]
+//
+// --iterations           how many times 10 seconds of speech are processed (default: 50)
+// --min-samples-per-sec  exit with code 1 if the SIMD chain is slower than that
+//
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "libworld.h"
+#include "radioEffect.hpp"
+
+using namespace std;
+using namespace world;
+
+static const int sampleRate = 22050;
+
+// keeps the optimizer from dropping the processing
+static volatile int sampleSink = 0;
+
+class PerSampleHighPassFilter
+{
+private:
+    const float c, a1, a2, a3, b1, b2;
+    const uint16_t bitsPerSample;
+    float inputHistory[2] = { 0 };
+    float outputHistory[3] = { 0 };
+public:
+    PerSampleHighPassFilter(int sampleRate, uint16_t _bitsPerSample, float frequency, float resonance) :
+        c(tanf(3.14159265f * frequency / sampleRate)),
+        a1(1.0f / (1.0f + resonance * c + c * c)),
+        a2(-2.0f * a1),
+        a3(a1),
+        b1(2.0f * (c * c - 1.0f) * a1),
+        b2((1.0f - resonance * c + c * c) * a1),
+        bitsPerSample(_bitsPerSample)
+    {
+    }
+    void processBuffer(void* buffer, size_t sampleCount)
+    {
+        for (size_t i = 0 ; i < sampleCount ; i++)
+        {
+            float input;
+            switch (bitsPerSample)
+            {
+            case 8: input = (float)((uint8_t*)buffer)[i] - 128.0f; break;
+            case 16: input = (float)((int16_t*)buffer)[i]; break;
+            default: input = 0;
+            }
+
+            float output = a1 * input + a2 * inputHistory[0] + a3 * inputHistory[1] - b1 * outputHistory[0] - b2 * outputHistory[1];
+            inputHistory[1] = inputHistory[0];
+            inputHistory[0] = input;
+            outputHistory[2] = outputHistory[1];
+            outputHistory[1] = outputHistory[0];
+            outputHistory[0] = output;
+
+            switch (bitsPerSample)
+            {
+            case 8: ((uint8_t*)buffer)[i] = (uint8_t)(max(-128.0f, min(127.0f, output)) + 128.0f); break;
+            case 16: ((int16_t*)buffer)[i] = (int16_t)max(-32768.0f, min(32767.0f, output)); break;
+            }
+        }
+    }
+};
+
+static vector<int16_t> makeSpeechLikeSignal(size_t count)
+{
+    // a few harmonics of a voice-like fundamental, modulated like syllables
+    vector<int16_t> samples(count);
+    for (size_t i = 0 ; i < count ; i++)
+    {
+        float t = (float)i / sampleRate;
+        float envelope = 0.5f + 0.5f * sinf(2 * 3.14159265f * 4 * t);
+        float voice = 0.5f * sinf(2 * 3.14159265f * 140 * t)
+            + 0.3f * sinf(2 * 3.14159265f * 1100 * t)
+            + 0.2f * sinf(2 * 3.14159265f * 2900 * t);
+        samples[i] = (int16_t)(20000 * envelope * voice);
+    }
+    return samples;
+}
+
+static double runBenchmark(
+    const char* title,
+    const vector<int16_t>& source,
+    int iterations,
+    const function<void(int16_t* samples, size_t count)>& process)
+{
+    vector<int16_t> samples(source.size());
+    double seconds = 0;
+
+    for (int i = 0 ; i < iterations ; i++)
+    {
+        // every iteration is a new utterance; copying the source is not measured
+        memcpy(samples.data(), source.data(), source.size() * sizeof(int16_t));
+        auto started = chrono::steady_clock::now();
+        process(samples.data(), samples.size());
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        sampleSink += samples[i % samples.size()];
+    }
+
+    long long sampleCount = (long long)source.size() * iterations;
+    double samplesPerSec = sampleCount / seconds;
+    printf("    %-24s %12lld samples %10.1f M samples/sec %8.0fx realtime\n",
+        title, sampleCount, samplesPerSec / 1e6, samplesPerSec / sampleRate);
+    return samplesPerSec;
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 50;
+    double minSamplesPerSec = 0;
+
+    for (int i = 1 ; i < argc ; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc)
+        {
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--min-samples-per-sec" && i + 1 < argc)
+        {
+            minSamplesPerSec = atof(argv[++i]);
+        }
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--iterations <n>] [--min-samples-per-sec <n>]" << endl;
+            return 1;
+        }
+    }
+
+    const vector<int16_t> speech = makeSpeechLikeSignal(sampleRate * 10);
+    const auto settings = RadioEffect::getSettings(Actor::Nature::AI, Actor::Role::Controller, Actor::RadioQuality::Medium);
+
+    printf("radio effect: %d Hz, simd %s\n", sampleRate, RadioEffect::isSimdAvailable() ? "available" : "not available");
+    double simdSamplesPerSec = runBenchmark("chain (simd)", speech, iterations, [&](int16_t* samples, size_t count) {
+        RadioEffect(sampleRate, settings, 1, true).processPcm16(samples, count);
+    });
+    runBenchmark("chain (scalar)", speech, iterations, [&](int16_t* samples, size_t count) {
+        RadioEffect(sampleRate, settings, 1, false).processPcm16(samples, count);
+    });
+    // the same work as the per-sample filter below, for a like-for-like comparison
+    const RadioEffect::Settings highPassOnly = { settings.highPassHz, 0, 0, 0, 1.0f };
+    runBenchmark("high-pass only (simd)", speech, iterations, [&](int16_t* samples, size_t count) {
+        RadioEffect(sampleRate, highPassOnly, 1, true).processPcm16(samples, count);
+    });
+    runBenchmark("per-sample high-pass", speech, iterations, [&](int16_t* samples, size_t count) {
+        PerSampleHighPassFilter(sampleRate, 16, settings.highPassHz, 1.0f).processBuffer(samples, count);
+    });
+
+    if (minSamplesPerSec > 0 && simdSamplesPerSec < minSamplesPerSec)
+    {
+        cerr << "FAILED: " << simdSamplesPerSec << " samples/sec is below the minimum of " << minSamplesPerSec << endl;
+        return 1;
+    }
+
+    return 0;
+}
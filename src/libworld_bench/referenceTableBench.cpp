@@ -0,0 +1,150 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+
+// Measures airline and aircraft type lookups: the indexed findByIcao(), tryFindByIcao()
+// which copies the found entry into strings, and a linear scan which re-parses
+// the found row (the way lookups worked before the tables were indexed).
+//
+// usage: libworld_bench [--iterations <n>]
+//
+// --iterations  how many times every ICAO code in the tables is looked up (default: 20)
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "libworld.h"
+#include "airlineReferenceTable.hpp"
+#include "aircraftTypeReferenceTable.hpp"
+
+using namespace std;
+using namespace world;
+
+typedef function<int(const string& icao)> LookupCallback;
+
+// keeps the optimizer from dropping the lookups
+static volatile size_t lookupSink = 0;
+
+static vector<string> collectIcaoCodes(int rowCount, const function<const char*(int index)>& getRow)
+{
+    vector<string> codes;
+    for (int i = 0 ; i < rowCount ; i++)
+    {
+        const char* row = getRow(i);
+        codes.push_back(string(row, strchr(row, ',') - row));
+    }
+    // misses cost a full scan without the index
+    codes.push_back("ZZZZ");
+    return codes;
+}
+
+static bool linearScanLookup(
+    int rowCount,
+    const function<const char*(int index)>& getRow,
+    const string& icao,
+    vector<string>& columns)
+{
+    for (int i = 0 ; i < rowCount ; i++)
+    {
+        const char* rowPtr = getRow(i);
+        if (strstr(rowPtr, icao.c_str()) == rowPtr)
+        {
+            columns.assign(1, string());
+            for (int j = 0 ; rowPtr[j] != 0 ; j++)
+            {
+                if (rowPtr[j] == ',')
+                {
+                    columns.push_back(string());
+                }
+                else
+                {
+                    columns.back() += rowPtr[j];
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runBenchmark(const char* title, const vector<string>& codes, int iterations, const LookupCallback& lookup)
+{
+    auto started = chrono::steady_clock::now();
+    size_t found = 0;
+
+    for (int i = 0 ; i < iterations ; i++)
+    {
+        for (const string& icao : codes)
+        {
+            found += lookup(icao);
+        }
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    long long lookupCount = (long long)codes.size() * iterations;
+    lookupSink += found;
+
+    printf("    %-24s %10lld lookups %10.1f ns/lookup\n", title, lookupCount, seconds * 1e9 / lookupCount);
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 20;
+
+    for (int i = 1 ; i < argc ; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc)
+        {
+            iterations = max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            cerr << "usage: " << argv[0] << " [--iterations <n>]" << endl;
+            return 1;
+        }
+    }
+
+    vector<string> airlineCodes = collectIcaoCodes(AirlineReferenceTable::rowCount(), AirlineReferenceTable::getRow);
+    vector<string> typeCodes = collectIcaoCodes(AircraftTypeReferenceTable::rowCount(), AircraftTypeReferenceTable::getRow);
+
+    printf("airlines: %d rows\n", AirlineReferenceTable::rowCount());
+    runBenchmark("findByIcao", airlineCodes, iterations, [](const string& icao) {
+        const auto* entry = AirlineReferenceTable::findByIcao(icao);
+        return entry ? (int)entry->callsign.length : 0;
+    });
+    runBenchmark("tryFindByIcao", airlineCodes, iterations, [](const string& icao) {
+        AirlineReferenceTable::Entry entry;
+        return AirlineReferenceTable::tryFindByIcao(icao, entry) ? (int)entry.callsign.length() : 0;
+    });
+    runBenchmark("linear scan", airlineCodes, iterations, [](const string& icao) {
+        vector<string> columns;
+        return linearScanLookup(AirlineReferenceTable::rowCount(), AirlineReferenceTable::getRow, icao, columns)
+            ? (int)columns.size()
+            : 0;
+    });
+
+    printf("aircraft types: %d rows\n", AircraftTypeReferenceTable::rowCount());
+    runBenchmark("findByIcao", typeCodes, iterations, [](const string& icao) {
+        const auto* entry = AircraftTypeReferenceTable::findByIcao(icao);
+        return entry ? (int)entry->callsign.length : 0;
+    });
+    runBenchmark("tryFindByIcao", typeCodes, iterations, [](const string& icao) {
+        AircraftTypeReferenceTable::Entry entry;
+        return AircraftTypeReferenceTable::tryFindByIcao(icao, entry) ? (int)entry.callsign.length() : 0;
+    });
+    runBenchmark("linear scan", typeCodes, iterations, [](const string& icao) {
+        vector<string> columns;
+        return linearScanLookup(AircraftTypeReferenceTable::rowCount(), AircraftTypeReferenceTable::getRow, icao, columns)
+            ? (int)columns.size()
+            : 0;
+    });
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <memory>
+#include <functional>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "aircraftTypeReferenceTable.hpp"
+#include "libworld_test.h"
+
+using namespace world;
+
+TEST(AircraftTypeReferenceTableTest, findByIcao_success)
+{
+    const auto* entry = AircraftTypeReferenceTable::findByIcao("B738");
+
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->icao, "B738");
+    EXPECT_EQ(entry->name, "Boeing 737-800");
+    EXPECT_EQ(entry->callsign, "Boeing seven thirty seven");
+}
+
+TEST(AircraftTypeReferenceTableTest, findByIcao_firstDuplicateWins)
+{
+    const auto* entry = AircraftTypeReferenceTable::findByIcao("A320");
+
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->name, "Airbus A320");
+}
+
+TEST(AircraftTypeReferenceTableTest, findByIcao_callsignDefaultsToName)
+{
+    const auto* entry = AircraftTypeReferenceTable::findByIcao("C172");
+
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->callsign, "Cessna 172");
+}
+
+TEST(AircraftTypeReferenceTableTest, tryFindByIcao_failure)
+{
+    AircraftTypeReferenceTable::Entry entry;
+
+    bool result = AircraftTypeReferenceTable::tryFindByIcao("B73", entry);
+
+    EXPECT_FALSE(result);
+    EXPECT_TRUE(entry.icao.empty());
+    EXPECT_TRUE(entry.name.empty());
+    EXPECT_TRUE(entry.callsign.empty());
+}
@@ -66,3 +66,39 @@ TEST(AirlineReferenceTableTest, tryFindByFLightNumber_failure)
     EXPECT_TRUE(entry.regionIcao.empty());
     EXPECT_TRUE(flightCallsign.empty());
 }
+
+TEST(AirlineReferenceTableTest, findByIcao_success)
+{
+    const auto* entry = AirlineReferenceTable::findByIcao("BAW");
+
+    ASSERT_TRUE(entry != nullptr);
+    EXPECT_EQ(entry->icao, "BAW");
+    EXPECT_EQ(entry->callsign, "SPEEDBIRD");
+    EXPECT_EQ(entry->name, "British Airways");
+    EXPECT_EQ(entry->regionIcao, "EG");
+}
+
+TEST(AirlineReferenceTableTest, findByIcao_exactMatchOnly)
+{
+    EXPECT_TRUE(AirlineReferenceTable::findByIcao("UA") == nullptr);
+    EXPECT_TRUE(AirlineReferenceTable::findByIcao("UALX") == nullptr);
+    EXPECT_TRUE(AirlineReferenceTable::findByIcao("") == nullptr);
+}
+
+TEST(AirlineReferenceTableTest, findByIcao_allRowsFound)
+{
+    for (int i = 0 ; i < AirlineReferenceTable::rowCount() ; i++)
+    {
+        const char* row = AirlineReferenceTable::getRow(i);
+        size_t icaoLength = strchr(row, ',') - row;
+        if (icaoLength == 0)
+        {
+            continue;
+        }
+
+        const auto* entry = AirlineReferenceTable::findByIcao(row, icaoLength);
+
+        ASSERT_TRUE(entry != nullptr) << row;
+        EXPECT_TRUE(entry->icao.equals(row, icaoLength)) << row;
+    }
+}
@@ -0,0 +1,159 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "asyncLog.hpp"
+
+using namespace world;
+
+typedef AsyncLog::Category Category;
+typedef AsyncLog::Level Level;
+
+// strips the "AT&C [+    123456] " prefix and the trailing newline
+static string getMessage(const string& line)
+{
+    size_t start = line.find("] ");
+    return line.substr(start + 2, line.length() - start - 3);
+}
+
+TEST(AsyncLogTest, write_formatsArgumentsOnDrain)
+{
+    vector<string> lines;
+    AsyncLog log([&lines](const char* line, size_t length) { lines.push_back(string(line, length)); }, 1024, false);
+
+    string callsign = "DAL123";
+    ATC_LOG_TO(log, Category::World, Level::Info, "flight[%s] id[%d] alt[%.1f] size[%llu] hex[%x] %s%%",
+        callsign, 42, 3500.25f, (size_t)7, 255u, "done");
+    EXPECT_TRUE(lines.empty());
+
+    EXPECT_EQ(log.drain(), 1);
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(lines[0].substr(0, 7), "AT&C [+");
+    EXPECT_EQ(lines[0].back(), '\n');
+    EXPECT_EQ(getMessage(lines[0]), "flight[DAL123] id[42] alt[3500.2] size[7] hex[ff] done%");
+}
+
+TEST(AsyncLogTest, write_copiesStringArguments)
+{
+    vector<string> lines;
+    AsyncLog log([&lines](const char* line, size_t length) { lines.push_back(string(line, length)); }, 1024, false);
+
+    {
+        string temporary = "temporary";
+        const char* nullString = nullptr;
+        ATC_LOG_TO(log, Category::General, Level::Error, "[%s] [%-5s] [%s]", temporary.c_str(), "ab", nullString);
+        temporary = "overwritten";
+    }
+
+    log.drain();
+    ASSERT_EQ(lines.size(), 1);
+    EXPECT_EQ(getMessage(lines[0]), "[temporary] [ab   ] [(null)]");
+}
+
+TEST(AsyncLogTest, levels_filterPerCategory)
+{
+    vector<string> lines;
+    AsyncLog log([&lines](const char* line, size_t length) { lines.push_back(string(line, length)); }, 1024, false);
+    int evaluatedCount = 0;
+    const auto evaluate = [&evaluatedCount]() { return ++evaluatedCount; };
+
+    log.setLevel(Category::Frequency, Level::Warning);
+    ATC_LOG_TO(log, Category::Frequency, Level::Info, "info %d", evaluate());
+    ATC_LOG_TO(log, Category::Frequency, Level::Error, "error %d", evaluate());
+    ATC_LOG_TO(log, Category::World, Level::Info, "world %d", evaluate());
+    ATC_LOG_TO(log, Category::World, Level::Debug, "debug %d", evaluate());
+
+    log.drain();
+    ASSERT_EQ(lines.size(), 2);
+    EXPECT_EQ(getMessage(lines[0]), "error 1");
+    EXPECT_EQ(getMessage(lines[1]), "world 2");
+    EXPECT_EQ(evaluatedCount, 2);
+    EXPECT_EQ(log.getLevel(Category::Frequency), Level::Warning);
+    EXPECT_EQ(AsyncLog::parseLevel("debug"), Level::Debug);
+    EXPECT_THROW(AsyncLog::parseLevel("verbose"), runtime_error);
+}
+
+TEST(AsyncLogTest, ringFull_dropsAndReports)
+{
+    vector<string> lines;
+    AsyncLog log([&lines](const char* line, size_t length) { lines.push_back(string(line, length)); }, 256, false);
+
+    // every record takes 24 bytes of header plus 9 bytes of argument, aligned to 40
+    for (int i = 0 ; i < 10 ; i++)
+    {
+        ATC_LOG_TO(log, Category::World, Level::Info, "record %d", i);
+    }
+
+    log.drain();
+    ASSERT_EQ(lines.size(), 7);
+    EXPECT_EQ(getMessage(lines[0]), "record 0");
+    EXPECT_EQ(getMessage(lines[5]), "record 5");
+    EXPECT_NE(lines[6].find("dropped 4 log records"), string::npos);
+}
+
+TEST(AsyncLogTest, ring_wrapsAround)
+{
+    vector<string> lines;
+    AsyncLog log([&lines](const char* line, size_t length) { lines.push_back(string(line, length)); }, 256, false);
+
+    for (int i = 0 ; i < 100 ; i++)
+    {
+        ATC_LOG_TO(log, Category::World, Level::Info, "record %d %s", i, i % 3 == 0 ? "with a longer tail" : "");
+        if (i % 4 == 3)
+        {
+            log.drain();
+        }
+    }
+
+    ASSERT_EQ(lines.size(), 100);
+    for (int i = 0 ; i < 100 ; i++)
+    {
+        EXPECT_EQ(getMessage(lines[i]), "record " + to_string(i) + (i % 3 == 0 ? " with a longer tail" : " "));
+    }
+}
+
+TEST(AsyncLogTest, consumerThread_deliversRecordsOfAllThreads)
+{
+    mutex linesMutex;
+    vector<string> lines;
+    AsyncLog log([&](const char* line, size_t length) {
+        lock_guard<mutex> lock(linesMutex);
+        lines.push_back(string(line, length));
+    });
+
+    vector<thread> threads;
+    for (int t = 0 ; t < 4 ; t++)
+    {
+        threads.emplace_back([&log, t]() {
+            for (int i = 0 ; i < 250 ; i++)
+            {
+                ATC_LOG_TO(log, Category::AI, Level::Info, "thread %d record %d", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    log.flush();
+
+    lock_guard<mutex> lock(linesMutex);
+    ASSERT_EQ(lines.size(), 1000);
+
+    int nextRecordByThread[4] = { 0, 0, 0, 0 };
+    for (const auto& line : lines)
+    {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(sscanf(getMessage(line).c_str(), "thread %d record %d", &t, &i), 2);
+        ASSERT_GE(t, 0);
+        ASSERT_LT(t, 4);
+        EXPECT_EQ(i, nextRecordByThread[t]++);
+    }
+}
@@ -0,0 +1,118 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "boundedQueue.hpp"
+
+using namespace world;
+
+TEST(BoundedQueueTest, pushPop_fifo)
+{
+    BoundedQueue<int> queue(4);
+
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_TRUE(queue.tryPush(3));
+    EXPECT_EQ(queue.sizeApprox(), 3);
+
+    int item = 0;
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, 1);
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, 2);
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, 3);
+    EXPECT_FALSE(queue.tryPop(item));
+}
+
+TEST(BoundedQueueTest, tryPush_failsWhenFull)
+{
+    BoundedQueue<int> queue(2);
+
+    EXPECT_TRUE(queue.tryPush(1));
+    EXPECT_TRUE(queue.tryPush(2));
+    EXPECT_FALSE(queue.tryPush(3));
+
+    int item = 0;
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_TRUE(queue.tryPush(3));
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, 2);
+    EXPECT_TRUE(queue.tryPop(item));
+    EXPECT_EQ(item, 3);
+}
+
+TEST(BoundedQueueTest, ctor_capacityMustBePowerOfTwo)
+{
+    EXPECT_THROW(BoundedQueue<int>(3), runtime_error);
+    EXPECT_THROW(BoundedQueue<int>(0), runtime_error);
+    EXPECT_EQ(BoundedQueue<int>(8).capacity(), 8);
+}
+
+TEST(BoundedQueueTest, tryPop_releasesItem)
+{
+    BoundedQueue<shared_ptr<int>> queue(2);
+    auto item = make_shared<int>(123);
+
+    EXPECT_TRUE(queue.tryPush(shared_ptr<int>(item)));
+    EXPECT_EQ(item.use_count(), 2);
+
+    shared_ptr<int> popped;
+    EXPECT_TRUE(queue.tryPop(popped));
+    popped.reset();
+    EXPECT_EQ(item.use_count(), 1);
+}
+
+TEST(BoundedQueueTest, multipleProducersAndConsumers)
+{
+    const int producerCount = 4;
+    const int itemsPerProducer = 20000;
+    BoundedQueue<int> queue(64);
+    atomic<long long> poppedSum(0);
+    atomic<int> poppedCount(0);
+    vector<thread> threads;
+
+    for (int p = 0 ; p < producerCount ; p++)
+    {
+        threads.emplace_back([&queue, p] {
+            for (int i = 1 ; i <= itemsPerProducer ; i++)
+            {
+                while (!queue.tryPush(p * itemsPerProducer + i))
+                {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0 ; c < 2 ; c++)
+    {
+        threads.emplace_back([&] {
+            int item;
+            while (poppedCount < producerCount * itemsPerProducer)
+            {
+                if (queue.tryPop(item))
+                {
+                    poppedSum += item;
+                    poppedCount++;
+                }
+                else
+                {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    const long long total = (long long)producerCount * itemsPerProducer;
+    EXPECT_EQ(poppedCount, total);
+    EXPECT_EQ(poppedSum.load(), total * (total + 1) / 2);
+}
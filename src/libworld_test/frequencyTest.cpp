@@ -0,0 +1,317 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "intentTypes.hpp"
+#include "libworld_test.h"
+
+using namespace world;
+
+class FrequencyTest : public ::testing::Test
+{
+protected:
+    class NullPhraseologyService : public PhraseologyService
+    {
+    public:
+        shared_ptr<Utterance> verbalizeIntent(shared_ptr<Intent> intent) override { return nullptr; }
+    };
+    class CriticalAffirmationIntent : public PilotAffirmationIntent
+    {
+    public:
+        using PilotAffirmationIntent::PilotAffirmationIntent;
+        bool isCritical() const override { return true; }
+    };
+protected:
+    shared_ptr<TestHostServices> host;
+    shared_ptr<Frequency> frequency;
+    shared_ptr<ControllerPosition> position;
+    vector<int> receivedFlightIds;
+protected:
+    void SetUp() override
+    {
+        host = TestHostServices::createWithWorld();
+        host->services().use<PhraseologyService>(make_shared<NullPhraseologyService>());
+        frequency = make_shared<Frequency>(host, 118000, GeoPoint(0, 0), 10.0f);
+        position = make_shared<ControllerPosition>(
+            host, ControllerPosition::Type::Local, nullptr, "Test Tower", frequency, nullptr);
+    }
+
+    shared_ptr<Flight> addListeningFlight(int flightNo, const GeoPoint& location, const Altitude& altitude)
+    {
+        auto flight = host->addIfrFlight(flightNo, "ABCD", "EFGH", location, altitude).ptr;
+        flight->aircraft()->setFrequency(frequency);
+        flight->aircraft()->onCommTransmission([this, flightNo](shared_ptr<Intent> intent) {
+            receivedFlightIds.push_back(flightNo);
+        });
+        return flight;
+    }
+
+    void progressTo(int milliseconds)
+    {
+        auto timestamp = chrono::microseconds(milliseconds * 1000);
+        host->getWorld()->progressTo(timestamp);
+        frequency->progressTo(timestamp);
+    }
+
+    void transmit(shared_ptr<Intent> intent)
+    {
+        frequency->enqueueTransmission(intent);
+        frequency->progressTo(chrono::microseconds(1000000));
+        frequency->progressTo(chrono::microseconds(2000000));
+    }
+};
+
+TEST_F(FrequencyTest, radioHorizon)
+{
+    EXPECT_NEAR(Frequency::getRadioHorizonNm(100, 10000), 135.3, 0.1);
+    EXPECT_NEAR(Frequency::getRadioHorizonNm(0, 0), 0, 0.001);
+    EXPECT_FLOAT_EQ(Frequency::getRadioHeightFeet(Altitude::ground()), 6);
+    EXPECT_FLOAT_EQ(Frequency::getRadioHeightFeet(Altitude::agl(3000)), 3000);
+}
+
+TEST_F(FrequencyTest, approximateDistance)
+{
+    EXPECT_NEAR(Frequency::getApproximateDistanceNm(GeoPoint(0, 0), GeoPoint(1, 0)), 60, 0.01);
+    EXPECT_NEAR(Frequency::getApproximateDistanceNm(GeoPoint(60, 0), GeoPoint(60, 1)), 30, 0.01);
+    EXPECT_NEAR(Frequency::getApproximateDistanceNm(GeoPoint(0, 179.5), GeoPoint(0, -179.5)), 60, 0.01);
+}
+
+TEST_F(FrequencyTest, endTransmission_deliversOnlyInRange)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0.05), Altitude::ground());
+    addListeningFlight(2, GeoPoint(0, 0.15), Altitude::ground());        // 9 nm from antenna
+    addListeningFlight(3, GeoPoint(1, 0), Altitude::ground());           // 60 nm, on the ground
+    addListeningFlight(4, GeoPoint(1, 0), Altitude::msl(10000));         // 60 nm, in line of sight
+    addListeningFlight(5, GeoPoint(0.3, 0.05), Altitude::ground());      // 18 nm, out of ground range
+
+    transmit(make_shared<PilotAffirmationIntent>(1, 0, speaker, position));
+
+    EXPECT_EQ(receivedFlightIds.size(), 3);
+    EXPECT_NE(find(receivedFlightIds.begin(), receivedFlightIds.end(), 1), receivedFlightIds.end());
+    EXPECT_NE(find(receivedFlightIds.begin(), receivedFlightIds.end(), 2), receivedFlightIds.end());
+    EXPECT_NE(find(receivedFlightIds.begin(), receivedFlightIds.end(), 4), receivedFlightIds.end());
+}
+
+TEST_F(FrequencyTest, endTransmission_listenerWithoutPositionReceivesAll)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(5, 5), Altitude::ground());
+    int receivedCount = 0;
+    frequency->addListener([&receivedCount](shared_ptr<Intent> intent) {
+        receivedCount++;
+    });
+
+    transmit(make_shared<PilotAffirmationIntent>(1, 0, speaker, position));
+
+    EXPECT_EQ(receivedCount, 1);
+}
+
+TEST_F(FrequencyTest, endTransmission_distantListenersNotQueried)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0.05), Altitude::ground());
+    int nearQueryCount = 0;
+    int farQueryCount = 0;
+    int farReceivedCount = 0;
+
+    frequency->addListener(
+        Frequency::noopListener,
+        [&nearQueryCount] {
+            nearQueryCount++;
+            return Frequency::RadioPosition({ GeoPoint(0, 0.1), 6 });
+        });
+    frequency->addListener(
+        [&farReceivedCount](shared_ptr<Intent> intent) { farReceivedCount++; },
+        [&farQueryCount] {
+            farQueryCount++;
+            return Frequency::RadioPosition({ GeoPoint(5, 5), 6 });
+        });
+
+    // positions are queried once when listeners are indexed
+    EXPECT_EQ(nearQueryCount, 1);
+    EXPECT_EQ(farQueryCount, 1);
+
+    transmit(make_shared<PilotAffirmationIntent>(1, 0, speaker, position));
+
+    EXPECT_EQ(nearQueryCount, 2);
+    EXPECT_EQ(farQueryCount, 1);
+    EXPECT_EQ(farReceivedCount, 0);
+}
+
+TEST_F(FrequencyTest, endTransmission_listenerGridFollowsMovedListeners)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0.05), Altitude::ground());
+    GeoPoint listenerLocation(5, 5);
+    int receivedCount = 0;
+
+    int listenerId = frequency->addListener(
+        [&receivedCount](shared_ptr<Intent> intent) { receivedCount++; },
+        [&listenerLocation] { return Frequency::RadioPosition({ listenerLocation, 6 }); });
+
+    // the listener comes into range after it was indexed, and is found once the grid is refreshed
+    listenerLocation = GeoPoint(0, 0.1);
+    frequency->enqueueTransmission(make_shared<PilotAffirmationIntent>(1, 0, speaker, position));
+    frequency->progressTo(chrono::seconds(20));
+    frequency->progressTo(chrono::seconds(21));
+
+    EXPECT_EQ(receivedCount, 1);
+
+    frequency->removeListener(listenerId);
+    transmit(make_shared<PilotAffirmationIntent>(2, 0, speaker, position));
+
+    EXPECT_EQ(receivedCount, 1);
+}
+
+TEST_F(FrequencyTest, pushToTalk_awaitersNotQueriedBeforeSilenceElapses)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0), Altitude::ground());
+    shared_ptr<Transmission> transmission;
+    int cancelQueryCount = 0;
+
+    frequency->enqueuePushToTalk(
+        chrono::milliseconds(500),
+        make_shared<PilotAffirmationIntent>(1, 0, speaker, position),
+        [&transmission](shared_ptr<Transmission> t) { transmission = t; },
+        [&cancelQueryCount]() { cancelQueryCount++; return false; });
+
+    progressTo(100);
+    progressTo(200);
+    progressTo(499);
+
+    EXPECT_FALSE(transmission);
+    EXPECT_EQ(cancelQueryCount, 0);
+
+    progressTo(500);
+
+    ASSERT_TRUE(transmission);
+    EXPECT_EQ(cancelQueryCount, 1);
+    EXPECT_EQ(transmission->state(), Transmission::State::InProgress);
+}
+
+TEST_F(FrequencyTest, pushToTalk_criticalLaneGoesFirst)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0), Altitude::ground());
+    vector<int> transmittedIntentIds;
+    const auto onTransmission = [&transmittedIntentIds](shared_ptr<Transmission> t) {
+        transmittedIntentIds.push_back((int)t->intent()->id());
+    };
+
+    frequency->enqueuePushToTalk(chrono::milliseconds(0), make_shared<PilotAffirmationIntent>(1, 0, speaker, position), onTransmission);
+    frequency->enqueuePushToTalk(chrono::milliseconds(0), make_shared<PilotAffirmationIntent>(2, 0, speaker, position), onTransmission);
+    frequency->enqueuePushToTalk(chrono::milliseconds(0), make_shared<CriticalAffirmationIntent>(3, 0, speaker, position), onTransmission);
+
+    for (int time = 100 ; time <= 1000 ; time += 100)
+    {
+        progressTo(time);
+    }
+
+    EXPECT_EQ(transmittedIntentIds, vector<int>({ 3, 1, 2 }));
+}
+
+TEST_F(FrequencyTest, pushToTalk_cancelledAwaiterSkipped)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0), Altitude::ground());
+    vector<Transmission::State> states;
+    const auto onTransmission = [&states](shared_ptr<Transmission> t) {
+        states.push_back(t->state());
+    };
+
+    frequency->enqueuePushToTalk(
+        chrono::milliseconds(0),
+        make_shared<PilotAffirmationIntent>(1, 0, speaker, position),
+        onTransmission,
+        []() { return true; });
+    frequency->enqueuePushToTalk(
+        chrono::milliseconds(0),
+        make_shared<PilotAffirmationIntent>(2, 0, speaker, position),
+        onTransmission);
+
+    progressTo(100);
+
+    EXPECT_EQ(states, vector<Transmission::State>({ Transmission::State::Cancelled, Transmission::State::NotStarted }));
+}
+
+TEST_F(FrequencyTest, pushToTalkQueue_growsOnDemandAndCountsAwaiters)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0), Altitude::ground());
+    Frequency::PushToTalkQueue queue(10);
+    const auto makeAwaiter = [&](int id, int silenceMs, uint64_t replyToId) {
+        Frequency::PushToTalkAwaiter awaiter;
+        awaiter.id = id;
+        awaiter.silence = chrono::milliseconds(silenceMs);
+        awaiter.intent = make_shared<PilotAffirmationIntent>(id, replyToId, speaker, position);
+        return awaiter;
+    };
+
+    EXPECT_EQ(queue.slotCount(), 0);
+    EXPECT_EQ(queue.minSilence(), chrono::milliseconds::max());
+
+    for (int id = 1 ; id <= 10 ; id++)
+    {
+        EXPECT_TRUE(queue.tryPush(makeAwaiter(id, 1000 + id, 100 + id)));
+        EXPECT_LE(queue.slotCount(), 10);
+    }
+    EXPECT_FALSE(queue.tryPush(makeAwaiter(11, 1, 1)));
+    EXPECT_EQ(queue.minSilence(), chrono::milliseconds(1001));
+    EXPECT_TRUE(queue.hasReplyTo(105));
+
+    auto taken = queue.takeAt(4);
+    EXPECT_EQ(taken.id, 5);
+    EXPECT_FALSE(queue.hasReplyTo(105));
+    queue.removeAt(0);
+    EXPECT_EQ(queue.minSilence(), chrono::milliseconds(1002));
+
+    vector<int> remainingIds;
+    for (size_t i = 0 ; i < queue.size() ; i++)
+    {
+        remainingIds.push_back(queue.at(i).id);
+    }
+    EXPECT_EQ(remainingIds, vector<int>({ 2, 3, 4, 6, 7, 8, 9, 10 }));
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.minSilence(), chrono::milliseconds::max());
+    EXPECT_FALSE(queue.hasReplyTo(102));
+}
+
+TEST_F(FrequencyTest, lookahead_transmissionsPreparedWhenQueued)
+{
+    auto speaker = addListeningFlight(1, GeoPoint(0, 0), Altitude::ground());
+    auto tts = host->textToSpeechService();
+    shared_ptr<Transmission> cancelled;
+    shared_ptr<Transmission> transmitted;
+
+    auto enqueued = frequency->enqueueTransmission(make_shared<PilotAffirmationIntent>(1, 0, speaker, position));
+    frequency->enqueuePushToTalk(
+        chrono::milliseconds(0),
+        make_shared<PilotAffirmationIntent>(2, 0, speaker, position),
+        [&cancelled](shared_ptr<Transmission> t) { cancelled = t; },
+        []() { return true; });
+    frequency->enqueuePushToTalk(
+        chrono::milliseconds(0),
+        make_shared<PilotAffirmationIntent>(3, 0, speaker, position),
+        [&transmitted](shared_ptr<Transmission> t) { transmitted = t; });
+
+    ASSERT_EQ(tts->preparedTransmissions().size(), 3);
+    EXPECT_EQ(tts->preparedTransmissions()[0], enqueued);
+    EXPECT_EQ(tts->preparedTransmissions()[1]->intent()->id(), 2);
+    EXPECT_EQ(tts->preparedTransmissions()[2]->intent()->id(), 3);
+    EXPECT_TRUE(tts->transmissionHistory().empty());
+
+    for (int time = 100 ; time <= 1000 ; time += 100)
+    {
+        progressTo(time);
+    }
+
+    // the awaiter transmits the same transmission which was prepared, and isn't prepared twice
+    ASSERT_TRUE(cancelled);
+    ASSERT_TRUE(transmitted);
+    EXPECT_EQ(tts->preparedTransmissions().size(), 3);
+    EXPECT_EQ(tts->discardedTransmissions(), vector<shared_ptr<Transmission>>({ cancelled }));
+    EXPECT_EQ(cancelled, tts->preparedTransmissions()[1]);
+    EXPECT_EQ(transmitted, tts->preparedTransmissions()[2]);
+    EXPECT_EQ(tts->transmissionHistory(), vector<shared_ptr<Transmission>>({ enqueued, transmitted }));
+}
@@ -7,6 +7,7 @@
 #include <memory>
 #include <functional>
 #include "libworld.h"
+#include "asyncLog.hpp"
 #include "intentFactory.hpp"
 #include "clearanceTypes.hpp"
 
@@ -96,6 +97,10 @@ namespace world
             double m_verticalSpeedFpm = 0;
             double m_groundSpeedKt = 0;
             string m_squawk;
+            AircraftAttitude m_attitude = AircraftAttitude(0, 0, 0);
+            float m_gearState = 0;
+            float m_flapState = 0;
+            float m_spoilerState = 0;
         public:
             TestAIAircraft(
                 shared_ptr<HostServices> _host,
@@ -140,11 +145,19 @@ namespace world
             const string& squawk() const override { return m_squawk; }
             void setSquawk(const string& value) { m_squawk = value; }
 
-            const AircraftAttitude& attitude() const override { throw runtime_error("TestAIAircraft"); }
+            const AircraftAttitude& attitude() const override { return m_attitude; }
+            void setAttitude(const AircraftAttitude& _attitude) { m_attitude = _attitude; }
+
+            float gearState() const override { return m_gearState; }
+            void setGearState(float ratio) { m_gearState = ratio; }
+
+            float flapState() const override { return m_flapState; }
+            void setFlapState(float ratio) { m_flapState = ratio; }
+
+            float spoilerState() const override { return m_spoilerState; }
+            void setSpoilerState(float ratio) { m_spoilerState = ratio; }
+
             double track() const override { throw runtime_error("TestAIAircraft"); }
-            float gearState() const override { throw runtime_error("TestAIAircraft"); }
-            float flapState() const override { throw runtime_error("TestAIAircraft"); }
-            float spoilerState() const override { throw runtime_error("TestAIAircraft"); }
             bool justTouchedDown(chrono::microseconds timestamp) override { throw runtime_error("TestAIAircraft"); }
             void park(shared_ptr<ParkingStand> parkingStand) override { throw runtime_error("TestAIAircraft"); }
             void setOnFinal(const Runway::End& runwayEnd) override { throw runtime_error("TestAIAircraft"); }
@@ -179,6 +192,8 @@ namespace world
         {
         private:
             vector<shared_ptr<Transmission>> m_transmissionHistory;
+            vector<shared_ptr<Transmission>> m_preparedTransmissions;
+            vector<shared_ptr<Transmission>> m_discardedTransmissions;
             int m_callCount_clearAll = 0;
         public:
             QueryCompletion vocalizeTransmission(shared_ptr<Frequency> frequency, shared_ptr<Transmission> transmission) override
@@ -192,6 +207,14 @@ namespace world
             {
                 m_callCount_clearAll++;
             }
+            void prepareTransmission(shared_ptr<Frequency> frequency, shared_ptr<Transmission> transmission) override
+            {
+                m_preparedTransmissions.push_back(transmission);
+            }
+            void discardTransmission(shared_ptr<Transmission> transmission) override
+            {
+                m_discardedTransmissions.push_back(transmission);
+            }
         public:
             vector<shared_ptr<Transmission>> takeTransmissionHistory()
             {
@@ -201,6 +224,8 @@ namespace world
             }
         public:
             const vector<shared_ptr<Transmission>>& transmissionHistory() const { return m_transmissionHistory; }
+            const vector<shared_ptr<Transmission>>& preparedTransmissions() const { return m_preparedTransmissions; }
+            const vector<shared_ptr<Transmission>>& discardedTransmissions() const { return m_discardedTransmissions; }
             int callCount_clearAll() const { return m_callCount_clearAll; }
         };
     private:
@@ -217,6 +242,8 @@ namespace world
         bool m_quiet;
         chrono::milliseconds m_timeForLog;
         bool m_timeForLogWasSet;
+        string m_hostDirectory = "HOST_DIR";
+        vector<string> m_hostFileNames;
     public:
         TestHostServices() :
             TestHostServices(false)
@@ -230,6 +257,7 @@ namespace world
             m_timeForLogWasSet(false)
         {
             HostServices::initLogString();
+            AsyncLog::instance().setAllLevels(m_quiet ? AsyncLog::Level::Off : AsyncLog::Level::Info);
         }
     public:
         shared_ptr<World> getWorld() override
@@ -317,7 +345,7 @@ namespace world
         }
         string getHostFilePath(const vector<string>& relativePathParts) override
         {
-            string fullPath = "HOST_DIR";
+            string fullPath = m_hostDirectory;
             for (const string& part : relativePathParts)
             {
                 fullPath.append("/");
@@ -327,7 +355,7 @@ namespace world
         }
         vector<string> findFilesInHostDirectory(const vector<string>& relativePathParts) override
         {
-            return {};
+            return m_hostFileNames;
         }
         shared_ptr<istream> openFileForRead(const string& filePath) override
         {
@@ -337,6 +365,12 @@ namespace world
         {
         }
     public:
+        // getHostFilePath() will resolve into hostDirectory, and findFilesInHostDirectory() will return fileNames
+        void useHostFiles(const string& hostDirectory, const vector<string>& fileNames)
+        {
+            m_hostDirectory = hostDirectory;
+            m_hostFileNames = fileNames;
+        }
         void useWorld(shared_ptr<World> _world)
         {
             m_world = _world;
@@ -354,7 +388,7 @@ namespace world
         {
             shared_ptr<TestAIAircraft> aircraft = shared_ptr<TestAIAircraft>(new TestAIAircraft(
                 shared_from_this(),
-                12345,
+                flightNo,
                 typeIcao,
                 "TES",
                 to_string(flightNo),
@@ -409,6 +443,7 @@ namespace world
         void enableLogs(bool enable)
         {
             m_quiet = !enable;
+            AsyncLog::instance().setAllLevels(m_quiet ? AsyncLog::Level::Off : AsyncLog::Level::Info);
         }
         void setTimeForLog(chrono::milliseconds time)
         {
@@ -464,4 +499,62 @@ namespace world
             return local / 1000;
         }
     };
+
+    // Test airports whose taxi net is a grid of taxiways on flat ground, spacingMeters apart.
+    // Node ids are 1 + row * columns + column; the taxiways along the rows are named R<row>,
+    // and the taxiways along the columns are named C<column>.
+    class TestGridAirport
+    {
+    public:
+        static float groundElevation() { return 1000; }
+
+        static void buildTaxiNet(
+            shared_ptr<HostServices> host,
+            int rows,
+            int columns,
+            float spacingMeters,
+            vector<shared_ptr<TaxiNode>>& nodes,
+            vector<shared_ptr<TaxiEdge>>& edges,
+            bool withRowTaxiways = true,
+            bool withColumnTaxiways = true)
+        {
+            const auto getNodeId = [columns](int row, int column) { return 1 + row * columns + column; };
+
+            for (int row = 0 ; row < rows ; row++)
+            {
+                for (int column = 0 ; column < columns ; column++)
+                {
+                    int nodeId = getNodeId(row, column);
+                    nodes.push_back(shared_ptr<TaxiNode>(new TaxiNode(
+                        nodeId, UniPoint::fromLocal(host, { spacingMeters * column, groundElevation(), spacingMeters * row }))));
+                    if (withRowTaxiways && column > 0)
+                    {
+                        edges.push_back(shared_ptr<TaxiEdge>(new TaxiEdge(
+                            (int)edges.size() + 1, "R" + to_string(row), getNodeId(row, column - 1), nodeId)));
+                    }
+                    if (withColumnTaxiways && row > 0)
+                    {
+                        edges.push_back(shared_ptr<TaxiEdge>(new TaxiEdge(
+                            (int)edges.size() + 1, "C" + to_string(column), getNodeId(row - 1, column), nodeId)));
+                    }
+                }
+            }
+        }
+
+        static shared_ptr<Airport> create(
+            shared_ptr<HostServices> host,
+            const string& icao,
+            int rows,
+            int columns,
+            float spacingMeters,
+            const vector<shared_ptr<Runway>>& runways = {})
+        {
+            vector<shared_ptr<TaxiNode>> nodes;
+            vector<shared_ptr<TaxiEdge>> edges;
+            buildTaxiNet(host, rows, columns, spacingMeters, nodes, edges);
+
+            Airport::Header header(icao, "Test", GeoPoint(30, 45), 123);
+            return WorldBuilder::assembleAirport(host, header, runways, {}, nodes, edges);
+        }
+    };
 }
@@ -0,0 +1,166 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "lookaheadWorkerPool.hpp"
+
+using namespace world;
+
+typedef LookaheadWorkerPool<int, string> TestPool;
+
+static size_t sizeOfString(const string& s)
+{
+    return s.length();
+}
+
+static void waitUntil(function<bool()> condition)
+{
+    for (int i = 0 ; i < 2000 && !condition() ; i++)
+    {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+TEST(LookaheadWorkerPoolTest, take_returnsResultComputedInAdvance)
+{
+    TestPool pool(2, 10, 1000, sizeOfString);
+    atomic<int> runCount(0);
+
+    EXPECT_TRUE(pool.submit(1, [&runCount]() { runCount++; return make_shared<string>("one"); }));
+    EXPECT_TRUE(pool.submit(2, [&runCount]() { runCount++; return make_shared<string>("two"); }));
+    EXPECT_FALSE(pool.submit(1, [&runCount]() { runCount++; return make_shared<string>("dup"); }));
+
+    waitUntil([&pool]() { return pool.readyBytes() == 6; });
+    EXPECT_EQ(runCount, 2);
+    EXPECT_EQ(pool.queuedCount(), 0);
+
+    EXPECT_EQ(*pool.take(2), "two");
+    EXPECT_EQ(*pool.take(1), "one");
+    EXPECT_EQ(pool.take(1), nullptr);
+    EXPECT_EQ(pool.take(3), nullptr);
+    EXPECT_EQ(pool.readyBytes(), 0);
+}
+
+TEST(LookaheadWorkerPoolTest, take_waitsForRunningJob)
+{
+    TestPool pool(1, 10, 1000, sizeOfString);
+    promise<void> started;
+    promise<void> release;
+    auto releaseFuture = release.get_future().share();
+
+    pool.submit(1, [&started, releaseFuture]() {
+        started.set_value();
+        releaseFuture.wait();
+        return make_shared<string>("slow");
+    });
+    started.get_future().wait();
+
+    auto taken = async(launch::async, [&pool]() { return pool.take(1); });
+    EXPECT_EQ(taken.wait_for(chrono::milliseconds(50)), future_status::timeout);
+
+    release.set_value();
+    EXPECT_EQ(*taken.get(), "slow");
+}
+
+TEST(LookaheadWorkerPoolTest, take_runsQueuedJobOnCallingThread)
+{
+    promise<void> release;
+    auto releaseFuture = release.get_future().share();
+    TestPool pool(1, 10, 1000, sizeOfString);
+    thread::id jobThreadId;
+
+    pool.submit(1, [releaseFuture]() { releaseFuture.wait(); return make_shared<string>("blocker"); });
+    pool.submit(2, [&jobThreadId]() { jobThreadId = this_thread::get_id(); return make_shared<string>("two"); });
+    waitUntil([&pool]() { return pool.queuedCount() == 1; });
+
+    EXPECT_EQ(*pool.take(2), "two");
+    EXPECT_EQ(jobThreadId, this_thread::get_id());
+
+    release.set_value();
+    EXPECT_EQ(*pool.take(1), "blocker");
+}
+
+TEST(LookaheadWorkerPoolTest, takeIfStarted_removesQueuedJobWithoutRunning)
+{
+    promise<void> release;
+    auto releaseFuture = release.get_future().share();
+    TestPool pool(1, 10, 1000, sizeOfString);
+    atomic<int> runCount(0);
+
+    pool.submit(1, [releaseFuture]() { releaseFuture.wait(); return make_shared<string>("blocker"); });
+    pool.submit(2, [&runCount]() { runCount++; return make_shared<string>("two"); });
+    waitUntil([&pool]() { return pool.queuedCount() == 1; });
+
+    EXPECT_EQ(pool.takeIfStarted(2), nullptr);
+    EXPECT_EQ(pool.queuedCount(), 0);
+
+    release.set_value();
+    EXPECT_EQ(*pool.takeIfStarted(1), "blocker");
+    EXPECT_EQ(pool.takeIfStarted(2), nullptr);
+    EXPECT_EQ(runCount, 0);
+}
+
+TEST(LookaheadWorkerPoolTest, readyBytesLimit_pausesWorkers)
+{
+    TestPool pool(1, 10, 5, sizeOfString);
+
+    pool.submit(1, []() { return make_shared<string>("abcdef"); });
+    pool.submit(2, []() { return make_shared<string>("xyz"); });
+
+    waitUntil([&pool]() { return pool.readyBytes() == 6; });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    EXPECT_EQ(pool.queuedCount(), 1);
+
+    pool.discard(1);
+    waitUntil([&pool]() { return pool.readyBytes() == 3; });
+    EXPECT_EQ(pool.queuedCount(), 0);
+    EXPECT_EQ(*pool.take(2), "xyz");
+}
+
+TEST(LookaheadWorkerPoolTest, submit_queueFull_refused)
+{
+    promise<void> release;
+    auto releaseFuture = release.get_future().share();
+    TestPool pool(1, 2, 1000, sizeOfString);
+
+    pool.submit(1, [releaseFuture]() { releaseFuture.wait(); return make_shared<string>("1"); });
+    waitUntil([&pool]() { return pool.queuedCount() == 0; });
+
+    EXPECT_TRUE(pool.submit(2, []() { return make_shared<string>("2"); }));
+    EXPECT_TRUE(pool.submit(3, []() { return make_shared<string>("3"); }));
+    EXPECT_FALSE(pool.submit(4, []() { return make_shared<string>("4"); }));
+
+    pool.clear();
+    release.set_value();
+    pool.stop();
+
+    EXPECT_EQ(pool.take(1), nullptr);
+    EXPECT_EQ(pool.take(2), nullptr);
+    EXPECT_EQ(pool.readyBytes(), 0);
+}
+
+TEST(LookaheadWorkerPoolTest, failedJob_takeReturnsNull)
+{
+    bool workerStarted = false;
+    bool workerStopped = false;
+
+    {
+        TestPool hookedPool(
+            1, 10, 1000, sizeOfString,
+            [&workerStarted]() { workerStarted = true; return true; },
+            [&workerStopped]() { workerStopped = true; });
+
+        hookedPool.submit(1, []() -> shared_ptr<string> { throw runtime_error("synthesis failed"); });
+        waitUntil([&hookedPool]() { return hookedPool.queuedCount() == 0; });
+        EXPECT_EQ(hookedPool.take(1), nullptr);
+    }
+
+    EXPECT_TRUE(workerStarted);
+    EXPECT_TRUE(workerStopped);
+}
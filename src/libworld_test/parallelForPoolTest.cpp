@@ -0,0 +1,83 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "parallelForPool.hpp"
+
+using namespace world;
+
+TEST(ParallelForPoolTest, run_visitsEveryIndexOnce)
+{
+    ParallelForPool pool(3);
+
+    for (size_t count : { 0, 1, 2, 7, 1000 })
+    {
+        vector<atomic<int>> visitCount(count);
+        for (auto& visits : visitCount)
+        {
+            visits = 0;
+        }
+
+        pool.run(count, [&visitCount](int index) { visitCount[index]++; });
+
+        for (size_t i = 0 ; i < count ; i++)
+        {
+            EXPECT_EQ(visitCount[i].load(), 1) << "count " << count << " index " << i;
+        }
+    }
+}
+
+TEST(ParallelForPoolTest, run_completesWithoutWorkers)
+{
+    ParallelForPool pool(0);
+    atomic<int> sum(0);
+
+    pool.run(100, [&sum](int index) { sum += index; });
+
+    EXPECT_EQ(sum.load(), 4950);
+}
+
+TEST(ParallelForPoolTest, run_rethrowsAfterEveryIndexCompleted)
+{
+    ParallelForPool pool(2);
+    atomic<int> completedCount(0);
+
+    EXPECT_THROW(
+        pool.run(100, [&completedCount](int index) {
+            if (index == 10)
+            {
+                throw runtime_error("failed");
+            }
+            this_thread::sleep_for(chrono::microseconds(100));
+            completedCount++;
+        }),
+        runtime_error);
+
+    EXPECT_EQ(completedCount.load(), 99);
+}
+
+TEST(ParallelForPoolTest, run_concurrentCallersShareWorkers)
+{
+    ParallelForPool pool(2);
+    vector<future<long long>> sums;
+
+    for (int caller = 0 ; caller < 8 ; caller++)
+    {
+        sums.push_back(async(launch::async, [&pool]() {
+            atomic<long long> sum(0);
+            pool.run(1000, [&sum](int index) { sum += index; });
+            return sum.load();
+        }));
+    }
+
+    for (auto& sum : sums)
+    {
+        EXPECT_EQ(sum.get(), 499500);
+    }
+}
@@ -0,0 +1,125 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <string>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "simplePhraseologyService.hpp"
+#include "phraseologyTemplate.hpp"
+
+using namespace world;
+
+TEST(PhraseologyTemplateTest, render_sameAsUtteranceBuilder)
+{
+    UtteranceBuilder expected;
+    expected.addData(SimplePhraseologyService::spellCallsign("DAL123"));
+    expected.addPunctuation();
+    expected.addText("contact tower on");
+    expected.addData(SimplePhraseologyService::spellFrequency(118300), true);
+    expected.addFarewell("have a good one");
+
+    auto phrase = PhraseologyTemplate::compile("{0:callsign}, contact tower on {1:frequency|slow} {=have a good one|farewell}");
+    UtteranceBuilder actual;
+    phrase.render(actual, "DAL123", 118300);
+
+    auto expectedUtterance = expected.getUtterance();
+    auto actualUtterance = actual.getUtterance();
+
+    EXPECT_EQ(phrase.slotCount(), 2);
+    EXPECT_EQ(actualUtterance->plainText(), expectedUtterance->plainText());
+    ASSERT_EQ(actualUtterance->parts().size(), expectedUtterance->parts().size());
+    for (int i = 0 ; i < expectedUtterance->parts().size() ; i++)
+    {
+        EXPECT_EQ(actualUtterance->parts()[i].startIndex, expectedUtterance->parts()[i].startIndex);
+        EXPECT_EQ(actualUtterance->parts()[i].length, expectedUtterance->parts()[i].length);
+        EXPECT_EQ(actualUtterance->parts()[i].type, expectedUtterance->parts()[i].type);
+    }
+}
+
+TEST(PhraseologyTemplateTest, spellings_sameAsSimplePhraseologyService)
+{
+    const auto spell = [](PhraseologyTemplate::Spelling spelling, const PhraseologyTemplate::Argument& argument) {
+        UtteranceBuilder builder;
+        builder.beginPart(Utterance::PartType::Text);
+        PhraseologyTemplate::appendSpelled(builder, spelling, argument);
+        builder.endPart();
+        return builder.getUtterance()->plainText();
+    };
+
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Callsign, "N123AB"), SimplePhraseologyService::spellCallsign("N123AB"));
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Runway, "04L"), SimplePhraseologyService::spellRunway("04L"));
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Frequency, 121900), SimplePhraseologyService::spellFrequency(121900));
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Frequency, 118000), SimplePhraseologyService::spellFrequency(118000));
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Frequency, 132025), SimplePhraseologyService::spellFrequency(132025));
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Digits, "4521"), SimplePhraseologyService::spellSquawk("4521"));
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Number, 5000), "5000");
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Number, -12), "-12");
+    EXPECT_EQ(spell(PhraseologyTemplate::Spelling::Phonetic, "B4x"), "Bravo Fower X-ray");
+}
+
+TEST(PhraseologyTemplateTest, compile_literalsAndPunctuation)
+{
+    auto phrase = PhraseologyTemplate::compile("going around, {=hold your position, I'll be back} {0|text}");
+    UtteranceBuilder builder;
+    phrase.render(builder, "now");
+    auto utterance = builder.getUtterance();
+
+    EXPECT_EQ(utterance->plainText(), "going around, hold your position, I'll be back now");
+    ASSERT_EQ(utterance->parts().size(), 4);
+    EXPECT_EQ(utterance->parts()[0].type, Utterance::PartType::Text);
+    EXPECT_EQ(utterance->parts()[1].type, Utterance::PartType::Punctuation);
+    EXPECT_EQ(utterance->parts()[2].type, Utterance::PartType::Text);
+    EXPECT_EQ(utterance->parts()[3].type, Utterance::PartType::Text);
+}
+
+TEST(PhraseologyTemplateTest, compile_invalidPattern_throws)
+{
+    EXPECT_THROW(PhraseologyTemplate::compile("{0:callsign"), runtime_error);
+    EXPECT_THROW(PhraseologyTemplate::compile("{x}"), runtime_error);
+    EXPECT_THROW(PhraseologyTemplate::compile("{0:morse}"), runtime_error);
+    EXPECT_THROW(PhraseologyTemplate::compile("{0|loud}"), runtime_error);
+}
+
+TEST(PhraseologyTemplateTest, render_missingArguments_throws)
+{
+    auto phrase = PhraseologyTemplate::compile("{0:callsign} runway {1:runway}");
+    UtteranceBuilder builder;
+    EXPECT_THROW(phrase.render(builder, "DAL123"), runtime_error);
+}
+
+TEST(PhraseologyTemplateTest, builderClear_reusesBuffers)
+{
+    auto phrase = PhraseologyTemplate::compile("{0:callsign}, Go Around!");
+    UtteranceBuilder builder;
+
+    size_t initialCapacity = builder.textCapacity();
+
+    phrase.render(builder, "DAL123");
+    EXPECT_EQ(builder.getUtterance()->plainText(), "<rate speed='-1'>DAL 1 2 3</rate>, Go Around!");
+    EXPECT_EQ(builder.textCapacity(), initialCapacity);
+
+    builder.clear();
+    phrase.render(builder, "AAL9");
+    auto utterance = builder.getUtterance();
+    EXPECT_EQ(utterance->plainText(), "<rate speed='-1'>AAL 9</rate>, Go Around!");
+    EXPECT_EQ(utterance->parts().size(), 3);
+    EXPECT_EQ(utterance->parts()[0].startIndex, 0);
+    EXPECT_EQ(builder.textCapacity(), initialCapacity);
+    EXPECT_GE(initialCapacity, 512);
+}
+
+TEST(PhraseologyTemplateTest, getUtterance_leavesBuilderEmpty)
+{
+    auto phrase = PhraseologyTemplate::compile("{0:callsign}, Go Around!");
+    UtteranceBuilder builder;
+
+    phrase.render(builder, "DAL123");
+    auto first = builder.getUtterance();
+    auto second = builder.getUtterance();
+
+    EXPECT_EQ(first->plainText(), "<rate speed='-1'>DAL 1 2 3</rate>, Go Around!");
+    EXPECT_EQ(first->parts().size(), 3);
+    EXPECT_EQ(second->plainText(), "");
+    EXPECT_EQ(second->parts().size(), 0);
+}
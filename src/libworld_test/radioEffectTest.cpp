@@ -0,0 +1,131 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "radioEffect.hpp"
+
+using namespace world;
+
+static const int sampleRate = 22050;
+
+static vector<int16_t> makeSine(float frequency, float amplitude, size_t count)
+{
+    vector<int16_t> samples(count);
+    for (size_t i = 0 ; i < count ; i++)
+    {
+        samples[i] = (int16_t)lrintf(32767.0f * amplitude * sinf(2 * 3.14159265f * frequency * i / sampleRate));
+    }
+    return samples;
+}
+
+// skips the first samples, where the filters are still settling
+static double getRms(const vector<int16_t>& samples, size_t skip = 2048)
+{
+    double sum = 0;
+    for (size_t i = skip ; i < samples.size() ; i++)
+    {
+        sum += (double)samples[i] * samples[i];
+    }
+    return sqrt(sum / (samples.size() - skip));
+}
+
+static double getRmsAfterEffect(const RadioEffect::Settings& settings, float frequency)
+{
+    auto samples = makeSine(frequency, 0.25f, 16384);
+    RadioEffect effect(sampleRate, settings);
+    effect.processPcm16(samples.data(), samples.size());
+    return getRms(samples);
+}
+
+TEST(RadioEffectTest, bandPass_attenuatesOutsideOfBand)
+{
+    const RadioEffect::Settings settings = { 1000, 4000, 0, 0, 1.0f };
+    const double inputRms = getRms(makeSine(2000, 0.25f, 16384));
+
+    double inBandRms = getRmsAfterEffect(settings, 2000);
+    double belowBandRms = getRmsAfterEffect(settings, 150);
+    double aboveBandRms = getRmsAfterEffect(settings, 9000);
+
+    EXPECT_GT(inBandRms, inputRms * 0.7);
+    EXPECT_LT(belowBandRms, inputRms * 0.05);
+    EXPECT_LT(aboveBandRms, inputRms * 0.2);
+}
+
+TEST(RadioEffectTest, softClip_staysWithinFullScale)
+{
+    const RadioEffect::Settings settings = { 10, 0, 8.0f, 0, 1.0f };
+    auto samples = makeSine(1000, 1.0f, 4096);
+
+    RadioEffect effect(sampleRate, settings);
+    effect.processPcm16(samples.data(), samples.size());
+
+    int peak = 0;
+    for (int16_t sample : samples)
+    {
+        peak = max(peak, abs((int)sample));
+    }
+    EXPECT_LE(peak, 32767);
+    // driven hard, the wave flattens out near full scale
+    EXPECT_GT(peak, 32000);
+    EXPECT_GT(getRms(samples, 0), 32767 * 0.85);
+}
+
+TEST(RadioEffectTest, noise_isDeterministicPerSeed)
+{
+    const RadioEffect::Settings settings = { 300, 3000, 0, 0.05f, 1.0f };
+    vector<int16_t> first(1000, 0);
+    vector<int16_t> second(1000, 0);
+    vector<int16_t> otherSeed(1000, 0);
+
+    RadioEffect(sampleRate, settings, 7).processPcm16(first.data(), first.size());
+    RadioEffect(sampleRate, settings, 7).processPcm16(second.data(), second.size());
+    RadioEffect(sampleRate, settings, 8).processPcm16(otherSeed.data(), otherSeed.size());
+
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, otherSeed);
+    // uniform noise of 0.05 full scale has RMS of about 0.05 / sqrt(3)
+    EXPECT_NEAR(getRms(first, 0), 32767 * 0.05 / sqrt(3.0), 150);
+}
+
+TEST(RadioEffectTest, simdAndScalar_produceSameOutput)
+{
+    if (!RadioEffect::isSimdAvailable())
+    {
+        return;
+    }
+
+    auto settings = RadioEffect::getSettings(Actor::Nature::AI, Actor::Role::Controller, Actor::RadioQuality::Poor);
+    // an odd length, to go through the scalar tails as well
+    auto simdSamples = makeSine(1200, 0.5f, 5003);
+    auto scalarSamples = simdSamples;
+
+    RadioEffect(sampleRate, settings, 3, true).processPcm16(simdSamples.data(), simdSamples.size());
+    RadioEffect(sampleRate, settings, 3, false).processPcm16(scalarSamples.data(), scalarSamples.size());
+
+    for (size_t i = 0 ; i < simdSamples.size() ; i++)
+    {
+        ASSERT_LE(abs(simdSamples[i] - scalarSamples[i]), 1) << "at sample " << i;
+    }
+}
+
+TEST(RadioEffectTest, getSettings_followsRadioQuality)
+{
+    auto good = RadioEffect::getSettings(Actor::Nature::AI, Actor::Role::Controller, Actor::RadioQuality::Good);
+    auto poor = RadioEffect::getSettings(Actor::Nature::AI, Actor::Role::Controller, Actor::RadioQuality::Poor);
+    auto pilot = RadioEffect::getSettings(Actor::Nature::AI, Actor::Role::Pilot, Actor::RadioQuality::Good);
+    auto human = RadioEffect::getSettings(Actor::Nature::Human, Actor::Role::Pilot, Actor::RadioQuality::Poor);
+
+    EXPECT_GT(poor.noiseLevel, good.noiseLevel);
+    EXPECT_GT(poor.drive, good.drive);
+    EXPECT_LT(poor.lowPassHz - poor.highPassHz, good.lowPassHz - good.highPassHz);
+    EXPECT_FLOAT_EQ(pilot.highPassHz, good.highPassHz + 1000);
+
+    EXPECT_FLOAT_EQ(human.lowPassHz, 0);
+    EXPECT_FLOAT_EQ(human.drive, 0);
+    EXPECT_FLOAT_EQ(human.noiseLevel, 0);
+}
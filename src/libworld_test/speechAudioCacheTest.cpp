@@ -0,0 +1,215 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "speechAudioCache.hpp"
+
+using namespace world;
+
+typedef SpeechAudioCache::Key Key;
+typedef SpeechAudioCache::Clip Clip;
+
+static shared_ptr<const Clip> makeClip(const string& pcm, const string& platformVoiceId = "voice-1")
+{
+    auto clip = make_shared<Clip>();
+    clip->sampleRate = 1000;
+    clip->channelCount = 1;
+    clip->bitsPerSample = 16;
+    clip->pcm.assign(pcm.begin(), pcm.end());
+    clip->platformVoiceId = platformVoiceId;
+    return clip;
+}
+
+static string getSegmentText(const Utterance& utterance, const SpeechAudioCache::Segment& segment)
+{
+    return utterance.plainText().substr(segment.startIndex, segment.length);
+}
+
+TEST(SpeechAudioCacheTest, find_hitsOnlyExactKey)
+{
+    SpeechAudioCache cache(1024 * 1024);
+    cache.store({ "voice-1", 1, 2, "cleared for takeoff" }, makeClip("abcd"));
+
+    auto hit = cache.find({ "voice-1", 1, 2, "cleared for takeoff" });
+    ASSERT_TRUE(hit);
+    EXPECT_EQ(string(hit->pcm.begin(), hit->pcm.end()), "abcd");
+
+    EXPECT_FALSE(cache.find({ "voice-2", 1, 2, "cleared for takeoff" }));
+    EXPECT_FALSE(cache.find({ "voice-1", 0, 2, "cleared for takeoff" }));
+    EXPECT_FALSE(cache.find({ "voice-1", 1, 1, "cleared for takeoff" }));
+    EXPECT_FALSE(cache.find({ "voice-1", 1, 2, "cleared to land" }));
+
+    auto statistics = cache.getStatistics();
+    EXPECT_EQ(statistics.memoryHitCount, 1);
+    EXPECT_EQ(statistics.missCount, 4);
+    EXPECT_EQ(statistics.clipCount, 1);
+    EXPECT_DOUBLE_EQ(statistics.hitRate(), 0.2);
+    EXPECT_NE(cache.formatStatistics().find("hit-rate[20.0%]"), string::npos);
+}
+
+TEST(SpeechAudioCacheTest, store_evictsLeastRecentlyUsed)
+{
+    const size_t clipBytes = 1000 + sizeof(Clip);
+    SpeechAudioCache cache(clipBytes * 2);
+
+    cache.store({ "v", 0, 0, "one" }, makeClip(string(1000, '1')));
+    cache.store({ "v", 0, 0, "two" }, makeClip(string(1000, '2')));
+    EXPECT_TRUE(cache.find({ "v", 0, 0, "one" }));
+
+    cache.store({ "v", 0, 0, "three" }, makeClip(string(1000, '3')));
+
+    EXPECT_TRUE(cache.find({ "v", 0, 0, "one" }));
+    EXPECT_FALSE(cache.find({ "v", 0, 0, "two" }));
+    EXPECT_TRUE(cache.find({ "v", 0, 0, "three" }));
+    EXPECT_EQ(cache.getStatistics().memoryBytes, clipBytes * 2);
+    EXPECT_EQ(cache.getStatistics().clipCount, 2);
+}
+
+TEST(SpeechAudioCacheTest, store_countsPcmCapacity)
+{
+    auto clip = make_shared<Clip>();
+    clip->pcm.reserve(4000);
+    clip->pcm.assign(1000, 'x');
+    SpeechAudioCache cache(1024 * 1024);
+
+    cache.store({ "v", 0, 0, "one" }, clip);
+
+    EXPECT_EQ(cache.getStatistics().memoryBytes, clip->pcm.capacity() + sizeof(Clip));
+    EXPECT_GE(cache.getStatistics().memoryBytes, 4000);
+}
+
+TEST(SpeechAudioCacheTest, diskTier_survivesEvictionAndRestart)
+{
+    const string directory = testing::TempDir() + "atc-speech-cache-test";
+    const Key key = { "voice-1", 1, 2, "<rate speed='-1'>DAL 1 2 3</rate>" };
+    char fileName[32];
+    snprintf(fileName, sizeof(fileName), "%016llx.pcm", (unsigned long long)SpeechAudioCache::hashKey(key));
+    remove((directory + "/" + fileName).c_str());
+
+    {
+        SpeechAudioCache cache(1, directory);
+        cache.store(key, makeClip("first", "platform-voice"));
+        cache.store({ "voice-1", 1, 2, "evicts the first" }, makeClip("second"));
+        EXPECT_EQ(cache.getStatistics().clipCount, 1);
+
+        auto reloaded = cache.find(key);
+        ASSERT_TRUE(reloaded);
+        EXPECT_EQ(string(reloaded->pcm.begin(), reloaded->pcm.end()), "first");
+        EXPECT_EQ(cache.getStatistics().diskHitCount, 1);
+    }
+
+    SpeechAudioCache nextSession(1024 * 1024, directory);
+    auto clip = nextSession.find(key);
+    ASSERT_TRUE(clip);
+    EXPECT_EQ(clip->sampleRate, 1000);
+    EXPECT_EQ(clip->channelCount, 1);
+    EXPECT_EQ(clip->bitsPerSample, 16);
+    EXPECT_EQ(clip->platformVoiceId, "platform-voice");
+    EXPECT_EQ(string(clip->pcm.begin(), clip->pcm.end()), "first");
+    EXPECT_EQ(nextSession.getStatistics().diskHitCount, 1);
+
+    EXPECT_TRUE(nextSession.find(key));
+    EXPECT_EQ(nextSession.getStatistics().memoryHitCount, 1);
+}
+
+static bool fileExists(const string& filePath)
+{
+    FILE* file = fopen(filePath.c_str(), "rb");
+    if (file)
+    {
+        fclose(file);
+    }
+    return file != nullptr;
+}
+
+TEST(SpeechAudioCacheTest, diskTier_prunesLeastRecentlyUsedFiles)
+{
+    const string directory = testing::TempDir() + "atc-speech-cache-prune-test";
+    const Key keys[3] = { { "v", 0, 0, "clip-1" }, { "v", 0, 0, "clip-2" }, { "v", 0, 0, "clip-3" } };
+    string filePaths[3];
+    for (int i = 0 ; i < 3 ; i++)
+    {
+        char fileName[32];
+        snprintf(fileName, sizeof(fileName), "%016llx.pcm", (unsigned long long)SpeechAudioCache::hashKey(keys[i]));
+        filePaths[i] = directory + "/" + fileName;
+        remove(filePaths[i].c_str());
+    }
+
+    uint64_t fileBytes;
+    {
+        SpeechAudioCache cache(1, directory, 1024 * 1024);
+        cache.store(keys[0], makeClip(string(1000, '1')));
+        fileBytes = cache.getStatistics().diskBytes;
+        cache.store(keys[1], makeClip(string(1000, '2')));
+        EXPECT_EQ(cache.getStatistics().diskBytes, fileBytes * 2);
+    }
+
+    SpeechAudioCache cache(1, directory, fileBytes * 2);
+    EXPECT_EQ(cache.getStatistics().diskFileCount, 2);
+
+    EXPECT_TRUE(cache.find(keys[0]));
+    cache.store(keys[2], makeClip(string(1000, '3')));
+
+    EXPECT_EQ(cache.getStatistics().diskFileCount, 2);
+    EXPECT_EQ(cache.getStatistics().diskBytes, fileBytes * 2);
+    EXPECT_TRUE(fileExists(filePaths[0]));
+    EXPECT_FALSE(fileExists(filePaths[1]));
+    EXPECT_TRUE(fileExists(filePaths[2]));
+    EXPECT_FALSE(cache.find(keys[1]));
+
+    SpeechAudioCache smallerSession(1, directory, fileBytes);
+    EXPECT_EQ(smallerSession.getStatistics().diskFileCount, 1);
+    EXPECT_EQ(smallerSession.getStatistics().diskBytes, fileBytes);
+}
+
+TEST(SpeechAudioCacheTest, splitIntoSegments_atPunctuation)
+{
+    UtteranceBuilder builder;
+    builder.addData("DAL 1 2 3");
+    builder.addPunctuation();
+    builder.addText("runway");
+    builder.addData("2 2 Right");
+    builder.addText("cleared for takeoff");
+    auto utterance = builder.getUtterance();
+
+    auto segments = SpeechAudioCache::splitIntoSegments(*utterance);
+
+    ASSERT_EQ(segments.size(), 2);
+    EXPECT_EQ(getSegmentText(*utterance, segments[0]), "<rate speed='-1'>DAL 1 2 3</rate>");
+    EXPECT_EQ(getSegmentText(*utterance, segments[1]), "runway <rate speed='-1'>2 2 Right</rate> cleared for takeoff");
+}
+
+TEST(SpeechAudioCacheTest, splitIntoSegments_notAfterFarewell)
+{
+    UtteranceBuilder builder;
+    builder.addText("contact departure");
+    builder.addPunctuation();
+    builder.addFarewell("good day");
+    builder.addPunctuation();
+    builder.addData("DAL 1 2 3");
+    auto utterance = builder.getUtterance();
+
+    auto segments = SpeechAudioCache::splitIntoSegments(*utterance);
+
+    ASSERT_EQ(segments.size(), 2);
+    EXPECT_EQ(getSegmentText(*utterance, segments[0]), "contact departure");
+    EXPECT_EQ(getSegmentText(*utterance, segments[1]), "<pitch middle='1'/><rate speed='1'/>good day, <rate speed='-1'>DAL 1 2 3</rate>");
+}
+
+TEST(SpeechAudioCacheTest, concatenate_insertsSilence)
+{
+    auto joined = SpeechAudioCache::concatenate({ makeClip("ab"), makeClip("cdef") }, chrono::milliseconds(3));
+
+    EXPECT_EQ(joined->sampleRate, 1000);
+    EXPECT_EQ(joined->platformVoiceId, "voice-1");
+    EXPECT_EQ(string(joined->pcm.begin(), joined->pcm.end()), string("ab") + string(6, '\0') + "cdef");
+
+    auto differentFormat = make_shared<Clip>(*makeClip("x"));
+    differentFormat->sampleRate = 2000;
+    EXPECT_THROW(SpeechAudioCache::concatenate({ makeClip("ab"), differentFormat }, chrono::milliseconds(0)), runtime_error);
+}
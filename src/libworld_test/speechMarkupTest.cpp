@@ -0,0 +1,85 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "speechMarkup.hpp"
+
+using namespace world;
+
+TEST(SpeechMarkupTest, plainText_splitAfterPunctuation)
+{
+    auto phrases = SapiToSsmlTranslator::splitIntoPhrases("DAL 1 2 3, cleared for takeoff. 1.5 miles  ");
+
+    ASSERT_EQ(phrases.size(), 3);
+    EXPECT_EQ(phrases[0], "<speak>DAL 1 2 3,</speak>");
+    EXPECT_EQ(phrases[1], "<speak> cleared for takeoff.</speak>");
+    EXPECT_EQ(phrases[2], "<speak> 1.5 miles  </speak>");
+}
+
+TEST(SpeechMarkupTest, disfluency_translatedToSsml)
+{
+    auto phrases = SapiToSsmlTranslator::splitIntoPhrases(
+        "<rate speed='-7'><pitch middle='-1'><silence msec='1'/>uhm</pitch></rate> tower & ground");
+
+    ASSERT_EQ(phrases.size(), 1);
+    EXPECT_EQ(
+        phrases[0],
+        "<speak><prosody rate=\"46%\"><prosody pitch=\"-1st\"><break time=\"1ms\"/>uhm</prosody></prosody> tower &amp; ground</speak>");
+}
+
+TEST(SpeechMarkupTest, pairedTag_reopenedInNextPhrase)
+{
+    auto phrases = SapiToSsmlTranslator::splitIntoPhrases("<rate speed='-1'>DAL 1 2 3, cleared</rate> for takeoff.");
+
+    ASSERT_EQ(phrases.size(), 2);
+    EXPECT_EQ(phrases[0], "<speak><prosody rate=\"90%\">DAL 1 2 3,</prosody></speak>");
+    EXPECT_EQ(phrases[1], "<speak><prosody rate=\"90%\"> cleared</prosody> for takeoff.</speak>");
+}
+
+TEST(SpeechMarkupTest, emptyTag_appliesToRestOfText)
+{
+    auto phrases = SapiToSsmlTranslator::splitIntoPhrases("<rate speed='-1'>one <pitch middle='1'/>two</rate> three, good day");
+
+    ASSERT_EQ(phrases.size(), 2);
+    EXPECT_EQ(
+        phrases[0],
+        "<speak><prosody rate=\"90%\">one <prosody pitch=\"+1st\">two</prosody></prosody><prosody pitch=\"+1st\"> three,</prosody></speak>");
+    EXPECT_EQ(phrases[1], "<speak><prosody pitch=\"+1st\"> good day</prosody></speak>");
+}
+
+TEST(SpeechMarkupTest, unknownTags_dropped)
+{
+    auto phrases = SapiToSsmlTranslator::splitIntoPhrases("<emph>roger</emph> <rate>wilco</rate>");
+
+    ASSERT_EQ(phrases.size(), 1);
+    EXPECT_EQ(phrases[0], "<speak>roger wilco</speak>");
+}
+
+TEST(SpeechMarkupTest, utteranceMarkup_notLeftInText)
+{
+    UtteranceBuilder builder;
+    builder.addDisfluency("");
+    builder.addData("DAL 1 2 3");
+    builder.addPunctuation();
+    builder.addCorrection("runway 2 2 Right");
+    builder.addText("cleared to land", true);
+    builder.addFarewell("good day");
+    auto utterance = builder.getUtterance();
+
+    auto phrases = SapiToSsmlTranslator::splitIntoPhrases(utterance->plainText().c_str());
+
+    ASSERT_EQ(phrases.size(), 2);
+    for (const auto& phrase : phrases)
+    {
+        EXPECT_EQ(phrase.find("speed="), string::npos) << phrase;
+        EXPECT_EQ(phrase.find("middle="), string::npos) << phrase;
+        EXPECT_EQ(phrase.find("<silence"), string::npos) << phrase;
+        EXPECT_EQ(phrase.find("</rate>"), string::npos) << phrase;
+        EXPECT_EQ(phrase.find("</pitch>"), string::npos) << phrase;
+    }
+    EXPECT_NE(phrases[1].find("<prosody pitch=\"+1st\"><prosody rate=\"112%\">good day</prosody></prosody></speak>"), string::npos);
+}
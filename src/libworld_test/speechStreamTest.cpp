@@ -0,0 +1,119 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "speechStream.hpp"
+
+using namespace world;
+
+static const SpeechStream::Format mono16 = { 1000, 1, 16 };
+
+static string readAll(SpeechStream& stream, size_t maxLength = 1024)
+{
+    string result(maxLength, '\0');
+    result.resize(stream.read(&result[0], maxLength));
+    return result;
+}
+
+TEST(SpeechStreamTest, read_returnsChunksInOrder)
+{
+    SpeechStream stream;
+    EXPECT_TRUE(stream.append(mono16, "abcd", 4));
+    EXPECT_TRUE(stream.append(mono16, "efgh", 4));
+
+    EXPECT_EQ(readAll(stream, 6), "abcdef");
+    EXPECT_EQ(stream.availableBytes(), 2);
+    EXPECT_FALSE(stream.isEndOfStream());
+
+    EXPECT_EQ(readAll(stream), "gh");
+    EXPECT_FALSE(stream.isEndOfStream());
+
+    stream.finish();
+    EXPECT_TRUE(stream.isEndOfStream());
+    EXPECT_EQ(stream.state(), SpeechStream::State::Finished);
+}
+
+TEST(SpeechStreamTest, read_onlyWholeFrames)
+{
+    SpeechStream stream;
+    stream.append(mono16, "abc", 3);
+
+    EXPECT_EQ(readAll(stream, 3), "ab");
+    EXPECT_EQ(stream.availableBytes(), 0);
+
+    stream.append(mono16, "d", 1);
+    EXPECT_EQ(readAll(stream), "cd");
+
+    stream.append(mono16, "e", 1);
+    stream.finish();
+    // a partial frame at the end can't be played
+    EXPECT_TRUE(stream.isEndOfStream());
+}
+
+TEST(SpeechStreamTest, append_rejectsDifferentFormat)
+{
+    SpeechStream stream;
+    stream.append(mono16, "ab", 2);
+
+    SpeechStream::Format format;
+    ASSERT_TRUE(stream.tryGetFormat(format));
+    EXPECT_EQ(format, mono16);
+    EXPECT_THROW(stream.append({ 2000, 1, 16 }, "cd", 2), runtime_error);
+
+    stream.finish();
+    EXPECT_THROW(stream.append(mono16, "cd", 2), runtime_error);
+}
+
+TEST(SpeechStreamTest, cancel_stopsProducer)
+{
+    SpeechStream stream;
+    stream.append(mono16, "ab", 2);
+    stream.cancel();
+
+    EXPECT_FALSE(stream.append(mono16, "cd", 2));
+    EXPECT_TRUE(stream.isCancelled());
+    EXPECT_TRUE(stream.isEndOfStream());
+    EXPECT_EQ(stream.availableBytes(), 0);
+}
+
+TEST(SpeechStreamTest, waitForData_wakesOnFirstChunk)
+{
+    SpeechStream stream;
+    EXPECT_FALSE(stream.waitForData(chrono::milliseconds(1)));
+    EXPECT_EQ(stream.timeToFirstChunk().count(), 0);
+
+    thread producer([&stream] {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        stream.append(mono16, "abcd", 4);
+        this_thread::sleep_for(chrono::milliseconds(20));
+        stream.append(mono16, "efgh", 4);
+        stream.finish();
+    });
+
+    // playback can start long before the producer is done
+    ASSERT_TRUE(stream.waitForData(chrono::milliseconds(5000)));
+    EXPECT_EQ(readAll(stream), "abcd");
+    EXPECT_GE(stream.timeToFirstChunk().count(), 15);
+
+    producer.join();
+    EXPECT_EQ(readAll(stream), "efgh");
+    EXPECT_TRUE(stream.isEndOfStream());
+    EXPECT_EQ(stream.appendedDuration().count(), 4);
+}
+
+TEST(SpeechStreamTest, fail_endsStreamWithError)
+{
+    SpeechStream stream;
+    stream.append(mono16, "ab", 2);
+    stream.fail("synthesizer crashed");
+
+    EXPECT_TRUE(stream.waitForData(chrono::milliseconds(1)));
+    EXPECT_EQ(stream.state(), SpeechStream::State::Failed);
+    EXPECT_EQ(stream.error(), "synthesizer crashed");
+    EXPECT_FALSE(stream.isEndOfStream());
+    EXPECT_EQ(readAll(stream), "ab");
+    EXPECT_TRUE(stream.isEndOfStream());
+}
@@ -0,0 +1,78 @@
+// 
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+// 
+#include "gtest/gtest.h"
+#include "libworld.h"
+#include "libworld_test.h"
+
+using namespace world;
+
+TEST(SymbolTableTest, intern_sameStringSameSymbol)
+{
+    SymbolTable table;
+
+    Symbol a1 = table.intern("A");
+    Symbol b = table.intern("B");
+    Symbol a2 = table.intern(string("A"));
+
+    EXPECT_EQ(a1, a2);
+    EXPECT_NE(a1, b);
+    EXPECT_EQ(table.getString(a1), "A");
+    EXPECT_EQ(table.getString(b), "B");
+    EXPECT_EQ(table.size(), 3); // including the empty string
+}
+
+TEST(SymbolTableTest, intern_emptyString)
+{
+    SymbolTable table;
+
+    EXPECT_EQ(table.intern(""), SymbolTable::EmptySymbol);
+    EXPECT_EQ(table.getString(SymbolTable::EmptySymbol), "");
+}
+
+TEST(SymbolTableTest, tryFind)
+{
+    SymbolTable table;
+    Symbol rwy04L = table.intern("04L");
+
+    EXPECT_EQ(table.tryFind("04L"), rwy04L);
+    EXPECT_EQ(table.tryFind("04R"), SymbolTable::NotFound);
+}
+
+TEST(SymbolTableTest, intern_beyondOneChunk)
+{
+    SymbolTable table;
+    vector<Symbol> symbols;
+
+    for (int i = 0 ; i < 3000 ; i++)
+    {
+        symbols.push_back(table.intern("S" + to_string(i)));
+    }
+
+    const string& first = table.getString(symbols[0]);
+
+    for (int i = 0 ; i < 3000 ; i++)
+    {
+        EXPECT_EQ(table.getString(symbols[i]), "S" + to_string(i));
+    }
+    EXPECT_EQ(first, "S0"); // references stay valid as the table grows
+}
+
+TEST(SymbolTableTest, entitiesShareGlobalSymbols)
+{
+    auto host = TestHostServices::create();
+    auto e1 = shared_ptr<TaxiEdge>(new TaxiEdge(1, "A", 1, 2));
+    auto e2 = shared_ptr<TaxiEdge>(new TaxiEdge(2, "A", 2, 3));
+    auto stand = shared_ptr<ParkingStand>(new ParkingStand(
+        1, "A", ParkingStand::Type::Gate, UniPoint::fromLocal(host, {0, 0, 0}), 0, "E",
+        Aircraft::Category::Jet, Aircraft::OperationType::Airline, { "AAL", "SWA" }));
+
+    EXPECT_EQ(e1->nameSymbol(), e2->nameSymbol());
+    EXPECT_EQ(e1->nameSymbol(), stand->nameSymbol());
+    EXPECT_EQ(e1->name(), "A");
+    EXPECT_TRUE(stand->hasAirline(SymbolTable::internGlobal("SWA")));
+    EXPECT_FALSE(stand->hasAirline(SymbolTable::internGlobal("DAL")));
+    ASSERT_EQ(stand->airlines().size(), 2);
+    EXPECT_EQ(stand->airlines()[0], "AAL");
+}
@@ -509,6 +509,46 @@ TEST(TaxiPathTest, findPath_useCostFunction)
     assertTaxiPathEdgeNames("D2:3050->1010", {"L", "BB4", "A", "A", "A", "AA1"}, departurePath2);
 }
 
+TEST(TaxiPathTest, findMany_sameAsFindForEveryDestination)
+{
+    auto net = createMediumTestNet();
+
+    auto paths = TaxiPath::findMany(net, net->getNodeById(111), {
+        net->getNodeById(777),
+        net->getNodeById(222),
+        net->getNodeById(111),
+        net->getNodeById(777)
+    });
+
+    ASSERT_EQ(paths.size(), 4);
+    assertTaxiPath(net, "n1->n7", paths[0], {111,444,888,666,777});
+    assertTaxiPath(net, "n1->n2", paths[1], {111,222});
+    ASSERT_TRUE(paths[2]);
+    EXPECT_EQ(paths[2]->edges.size(), 0);
+    assertTaxiPath(net, "n1->n7 again", paths[3], {111,444,888,666,777});
+    EXPECT_NE(paths[0], paths[3]);
+}
+
+TEST(TaxiPathTest, findMany_nullIfUnreachable)
+{
+    auto host = TestHostServices::create();
+
+    auto n1 = shared_ptr<TaxiNode>(new TaxiNode(111, UniPoint::fromLocal(host, {10, GROUND, 10})));
+    auto n2 = shared_ptr<TaxiNode>(new TaxiNode(222, UniPoint::fromLocal(host, {10, GROUND, 20})));
+    auto n3 = shared_ptr<TaxiNode>(new TaxiNode(333, UniPoint::fromLocal(host, {20, GROUND, 20})));
+    auto e12 = shared_ptr<TaxiEdge>(new TaxiEdge(1001, "E12", 111, 222, TaxiEdge::Type::Taxiway));
+    auto e23 = shared_ptr<TaxiEdge>(new TaxiEdge(1002, "E23", 222, 333, TaxiEdge::Type::Groundway));
+
+    auto airport = WorldBuilder::assembleAirport(host, testHeader, {}, {}, { n1, n2, n3 }, { e12, e23 });
+    auto net = airport->taxiNet();
+
+    auto paths = TaxiPath::findMany(net, n1, { n3, n2 });
+
+    ASSERT_EQ(paths.size(), 2);
+    EXPECT_FALSE(paths[0]);
+    assertTaxiPath("n1->n2", { e12 }, paths[1]);
+}
+
 //TODO: extract into TaxiNetTest
 TEST(TaxiPathTest, taxiNetFindPaths_avoidArrivalDepartureConflict)
 {
@@ -2,8 +2,10 @@
 // This file is part of AT&C project which simulates virtual world of air traffic and ATC.
 // Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
 //
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 #include "gtest/gtest.h"
 #include "libworld.h"
 #include "libworld_test.h"
@@ -102,3 +104,63 @@ TEST(WorldTest, canClearAllWorkItems)
     ASSERT_EQ(workItemLog.size(), 1);
     EXPECT_EQ(workItemLog[0], "workItemA");
 }
+
+TEST(WorldTest, findAirportsInRadius)
+{
+    auto host = TestHostServices::create();
+    auto world = make_shared<World>(host, 0);
+    const auto addAirport = [&](const string& icao, double latitude, double longitude) {
+        world->addAirport(make_shared<Airport>(Airport::Header(icao, icao, GeoPoint(latitude, longitude), 0)));
+    };
+
+    addAirport("KJFK", 40.639, -73.778);
+    addAirport("KLGA", 40.777, -73.872);
+    addAirport("KEWR", 40.692, -74.168);
+    addAirport("KMIA", 25.793, -80.290);
+    addAirport("NZAA", -37.008, 174.791);
+    addAirport("NFFN", -17.755, 177.443);
+
+    vector<string> nearJfk;
+    for (const auto& airport : world->findAirportsInRadius(GeoPoint(40.639, -73.778), 30))
+    {
+        nearJfk.push_back(airport->header().icao());
+    }
+    sort(nearJfk.begin(), nearJfk.end());
+
+    EXPECT_EQ(nearJfk, vector<string>({ "KEWR", "KJFK", "KLGA" }));
+    EXPECT_EQ(world->findAirportsInRadius(GeoPoint(40.639, -73.778), 5).size(), 1);
+    EXPECT_EQ(world->findAirportsInRadius(GeoPoint(30, -40), 100).size(), 0);
+
+    auto acrossAntimeridian = world->findAirportsInRadius(GeoPoint(-17.7, -179.9), 200);
+    ASSERT_EQ(acrossAntimeridian.size(), 1);
+    EXPECT_EQ(acrossAntimeridian[0]->header().icao(), "NFFN");
+}
+
+TEST(WorldTest, tryFindAirport)
+{
+    auto host = TestHostServices::create();
+    auto world = make_shared<World>(host, 0);
+    world->addAirport(make_shared<Airport>(Airport::Header("KJFK", "JFK", GeoPoint(40.639, -73.778), 13)));
+
+    ASSERT_TRUE(world->tryFindAirport("KJFK") != nullptr);
+    EXPECT_EQ(world->tryFindAirport("KJFK")->header().name(), "JFK");
+    EXPECT_TRUE(world->tryFindAirport("KMIA") == nullptr);
+    EXPECT_EQ(world->airports().size(), 1);
+}
+
+TEST(WorldTest, airportsGeneration_changesOnlyWithAirports)
+{
+    auto host = TestHostServices::create();
+    auto world = make_shared<World>(host, 0);
+    const uint64_t initialGeneration = world->airportsGeneration();
+
+    world->addAirport(make_shared<Airport>(Airport::Header("KJFK", "JFK", GeoPoint(40.639, -73.778), 13)));
+    const uint64_t generation1 = world->airportsGeneration();
+    EXPECT_NE(generation1, initialGeneration);
+
+    world->progressTo(chrono::seconds(1));
+    EXPECT_EQ(world->airportsGeneration(), generation1);
+
+    world->addAirport(make_shared<Airport>(Airport::Header("KLGA", "LGA", GeoPoint(40.777, -73.872), 21)));
+    EXPECT_NE(world->airportsGeneration(), generation1);
+}
@@ -73,8 +73,6 @@ public:
 
     shared_ptr<Airport> airport() const { return m_airport; }
 
-private:
-
     string getUserAirportIcao()
     {
         char airportIcaoId[10] = { 0 };
@@ -98,6 +96,8 @@ private:
         return "KJFK";
     }
 
+private:
+
     void initDemoSchedules(float loadFactor, time_t firstDepartureTime, time_t firstArrivalTime)
     {
         unordered_map<string, string> callSignByAirline = {
@@ -130,8 +130,16 @@ private:
             flightPlan->setSid("GREKI 6");
             flightPlan->setSidTransition("YNKEE");
 
-            auto destinationAirport = m_host->getWorld()->getAirport(destination);
-            flightPlan->setArrivalRunway(destinationAirport->findLongestRunway()->end1().name());
+            // airports other than the user one may still be loading; the arrival runway is only needed at the destination
+            auto destinationAirport = m_world->tryFindAirport(destination);
+            if (destinationAirport)
+            {
+                flightPlan->setArrivalRunway(destinationAirport->findLongestRunway()->end1().name());
+            }
+            else
+            {
+                m_host->writeLog("SCHEDL|destination airport [%s] is still loading, arrival runway not assigned", destination.c_str());
+            }
 
             auto flight = shared_ptr<Flight>(new Flight(m_host, flightId, Flight::RulesType::IFR, airline, to_string(flightId), callSign + " " + to_string(flightId), flightPlan));
 
@@ -165,14 +173,15 @@ private:
             flight->setPilot(pilot);
             flight->setPhase(Flight::Phase::Arrival);
 
+            // the airport may be reloaded before the flight arrives, so it is looked up by ICAO code
             auto copyOfWorld = m_world;
-            auto copyOfAirport = m_airport;
-            m_world->deferUntil(
+            string airportIcao = m_airport->header().icao();
+            m_world->scheduleFlight(
                 "addInboundFlight/" + flight->callSign(),
+                flight,
                 arrivalTime,
-                [flight, copyOfWorld, copyOfAirport, arrivalRunway](){
-                    const auto& landingRunwayEnd = copyOfWorld->getRunwayEnd(copyOfAirport->header().icao(), arrivalRunway);
-                    copyOfWorld->addFlight(flight);
+                [flight, copyOfWorld, airportIcao, arrivalRunway](){
+                    const auto& landingRunwayEnd = copyOfWorld->getRunwayEnd(airportIcao, arrivalRunway);
                     flight->aircraft()->setOnFinal(landingRunwayEnd);
                 }
             );
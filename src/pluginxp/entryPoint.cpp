@@ -121,4 +121,7 @@ PLUGIN_API void	XPluginStop(void)
 {
     XPLMDebugString("ENTRYP|XPluginStop\n");
     Log() << Log::Info << "XPluginStop" << Log::endl;
+
+    // the background thread must not outlive the plugin DLL
+    AsyncLog::instance().stop();
 }
@@ -26,8 +26,13 @@
 #include "libworld.h"
 #include "stlhelpers.h"
 #include "utils.h"
+#include "lookaheadWorkerPool.hpp"
+#include "speechAudioCache.hpp"
+#include "radioEffect.hpp"
+#include "speechStream.hpp"
 #include "libspeech.h"
-#include "speechSoundBuffer.hpp"
+#include "soundFileReader.hpp"
+#include "streamingSpeechSource.hpp"
 
 #define CHECK_ERR() __CHECK_ERR(__FILE__,__LINE__)
 
@@ -64,25 +69,73 @@ private:
         shared_ptr<Transmission> transmission;
         RadioSpeechStyle radioStyle;
     };
+    // everything needed to synthesize a transmission, copied on the world thread
+    struct SpeechJob
+    {
+        uint64_t transmissionId;
+        vector<string> segments; // cached separately, see SpeechAudioCache
+        int gender;
+        int voice;
+        int rate;
+        int quality;
+        string platformVoiceId;
+        RadioEffect::Settings radioEffect;
+    };
+    // a transmission which is synthesized while it plays
+    struct StreamingJob
+    {
+        SpeechJob job;
+        shared_ptr<Actor> speaker;
+        shared_ptr<SpeechStream> stream;
+        bool terminate;
+    };
+    typedef SpeechAudioCache::Clip SynthesizedSpeech;
+    typedef LookaheadWorkerPool<uint64_t, SynthesizedSpeech> LookaheadPool;
+    // returns false to cancel the synthesis
+    typedef function<bool(const SpeechStream::Format& format, const char* data, size_t length)> SpeechChunkHandler;
+    struct SpeechChunkContext
+    {
+        const SpeechChunkHandler* onChunk;
+        SynthesizedSpeech* speech;
+        string error;
+    };
 private:
     shared_ptr<HostServices> m_host;
     DataRef<int> m_com1Power;
     DataRef<int> m_com1FrequencyKhz;
     moodycamel::BlockingConcurrentQueue<ThreadMessage> m_messageQueue;
     shared_ptr<thread> m_synthesizerThread;
-    shared_ptr<SpeechSoundBuffer> m_currentSpeech;
+    shared_ptr<StreamingSpeechSource> m_currentSpeech;
+    ThreadMessage m_currentMessage;
+    bool m_currentSpeechPlayRequested;
+    bool m_isPumpingCurrentSpeech;
     int m_nextRequestId;
     int m_activeRequestId;
     ALSoundBuffer m_radioStaticEdgeLong;
     ALSoundBuffer m_radioStaticEdgeMedium;
     ALSoundBuffer m_radioStaticEdgeShort;
     ALSoundBuffer m_radioStaticBackgroundLoop;
+    atomic<bool> m_inMemorySynthesisSupported;
+    atomic<bool> m_streamingSynthesisSupported;
+    // transmissions which weren't synthesized in advance are synthesized here, chunk by chunk, while they play
+    moodycamel::BlockingConcurrentQueue<StreamingJob> m_streamingQueue;
+    shared_ptr<thread> m_streamingThread;
+    SpeechAudioCache m_audioCache;
+    int m_handledRequestCount;
+    // transmissions are synthesized by these workers as soon as they are queued on the frequency
+    unique_ptr<LookaheadPool> m_lookahead;
     //string m_tempSpeechFilePath;
 public:
     NativeTextToSpeechService(shared_ptr<HostServices> _host) :
         m_host(_host),
         m_nextRequestId(1),
         m_activeRequestId(0),
+        m_currentSpeechPlayRequested(false),
+        m_isPumpingCurrentSpeech(false),
+        m_inMemorySynthesisSupported(true),
+        m_streamingSynthesisSupported(true),
+        m_audioCache(32 * 1024 * 1024, _host->getResourceFilePath({ "speech", "cache" })),
+        m_handledRequestCount(0),
         m_com1Power("sim/cockpit2/radios/actuators/com1_power", PPL::ReadOnly),
         m_com1FrequencyKhz("sim/cockpit2/radios/actuators/com1_frequency_hz_833", PPL::ReadOnly),
         m_radioStaticEdgeLong(_host->getResourceFilePath({ "sounds", "radio-static-edge-l.wav"})),
@@ -91,9 +144,19 @@ public:
         m_radioStaticBackgroundLoop(_host->getResourceFilePath({ "sounds", "radio-static-loop-1.wav"}))
     {
         m_radioStaticBackgroundLoop.setLoop(true);
+        m_lookahead.reset(new LookaheadPool(
+            2,
+            16,
+            16 * 1024 * 1024,
+            [](const SynthesizedSpeech& speech) { return SpeechAudioCache::getClipBytes(speech); },
+            [this]() { return initializeSynthesizerThread(); },
+            [this]() { finalizeSynthesizerThread(); }));
         m_synthesizerThread = shared_ptr<thread>(new thread([this](){ 
             runSynthesizerThread();
         }));
+        m_streamingThread = shared_ptr<thread>(new thread([this](){
+            runStreamingThread();
+        }));
         //m_tempSpeechFilePath = m_host->getResourceFilePath({ "speech", "tempgen.wav" });
     }
 
@@ -101,8 +164,19 @@ public:
     {
         m_host->writeLog("NATT2S|NativeTextToSpeechService::~ctor");
         
+        m_lookahead->stop();
         m_messageQueue.enqueue({ ThreadMessageType::TerminateThread });
         m_synthesizerThread->join();
+
+        if (m_currentSpeech)
+        {
+            // makes the streaming thread abandon the transmission it is synthesizing
+            m_currentSpeech->stream()->cancel();
+        }
+        StreamingJob terminateJob;
+        terminateJob.terminate = true;
+        m_streamingQueue.enqueue(terminateJob);
+        m_streamingThread->join();
     }
 public:
 
@@ -126,6 +200,11 @@ public:
             "NATT2S|vocalizeTransmission : com1Power=%d, com1FrequencyKhz=%d, isHeardByUser=%s",
             com1Power, com1FrequencyKhz, (isHeardByUser ? "Y" : "N"));
 
+        if (!isHeardByUser)
+        {
+            m_lookahead->discard(transmission->id());
+        }
+
         auto speaker = transmission->intent()->getSpeakingActor();
         if (!speaker)
         {
@@ -184,9 +263,41 @@ public:
     void clearAll() override
     {
         m_host->writeLog("NATT2S|clearing all transmissions");
+        m_lookahead->clear();
         m_messageQueue.enqueue({ ThreadMessageType::AbortTransmission, m_activeRequestId });
     }
 
+    void prepareTransmission(shared_ptr<Frequency> frequency, shared_ptr<Transmission> transmission) override
+    {
+        int com1Power = m_com1Power;
+        int com1FrequencyKhz = m_com1FrequencyKhz;
+        if (com1Power != 1 || com1FrequencyKhz != frequency->khz() || !transmission->verbalizedUtterance())
+        {
+            return;
+        }
+
+        auto speaker = transmission->intent()->getSpeakingActor();
+        if (!speaker)
+        {
+            return;
+        }
+
+        SpeechJob job = createSpeechJob(*transmission, *speaker);
+        bool submitted = m_lookahead->submit(transmission->id(), [this, job]() {
+            return synthesizeSpeechJob(job);
+        });
+
+        if (!submitted)
+        {
+            m_host->writeLog("NATT2S|lookahead queue full, transmission id[%llu] will be synthesized on demand", (unsigned long long)transmission->id());
+        }
+    }
+
+    void discardTransmission(shared_ptr<Transmission> transmission) override
+    {
+        m_lookahead->discard(transmission->id());
+    }
+
 private:
 
     void runSynthesizerThread()
@@ -199,10 +310,15 @@ private:
 
         while (true)
         {
-            m_host->writeLog("SPECHW|worker thread is waiting for a message");
+            // while speech is streaming, the loop wakes up often enough to keep the buffer ring full
+            bool isPumping = m_isPumpingCurrentSpeech;
+            if (!isPumping)
+            {
+                m_host->writeLog("SPECHW|worker thread is waiting for a message");
+            }
 
             ThreadMessage message;
-            if (m_messageQueue.wait_dequeue_timed(message, 5000000))
+            if (m_messageQueue.wait_dequeue_timed(message, isPumping ? 20000 : 5000000))
             {
                 m_host->writeLog(
                     "SPECHW|dequeued (type=%d, requestId=%d), m_activeRequestId=%d",
@@ -222,12 +338,53 @@ private:
                     m_host->writeLog("SPECHW|handleSynthesizerThreadMessage CRASHED!!! %s", e.what());
                 }
             }
+
+            pumpCurrentSpeech();
         }
 
         finalizeSynthesizerThread();
         m_host->writeLog("SPECHW|exiting worker thread");
     }
 
+    void runStreamingThread()
+    {
+        m_host->writeLog("SPECHS|entering streaming thread");
+        bool initialized = initializeSynthesizerThread();
+
+        while (true)
+        {
+            StreamingJob item;
+            m_streamingQueue.wait_dequeue(item);
+            if (item.terminate)
+            {
+                break;
+            }
+
+            if (!initialized)
+            {
+                // ends the transmission, rather than leaving it on the air forever
+                item.stream->fail("speech library failed to initialize");
+                continue;
+            }
+
+            try
+            {
+                streamSpeechJob(item);
+            }
+            catch (const exception& e)
+            {
+                m_host->writeLog("SPECHS|transmission id[%llu]: streaming synthesis failed: %s", (unsigned long long)item.job.transmissionId, e.what());
+                item.stream->fail(e.what());
+            }
+        }
+
+        if (initialized)
+        {
+            finalizeSynthesizerThread();
+        }
+        m_host->writeLog("SPECHS|exiting streaming thread");
+    }
+
     bool initializeSynthesizerThread()
     {
         try
@@ -265,6 +422,7 @@ private:
             {
                 m_host->writeLog("SPECHW|aborting current transmission request id[%d]", message.requestId);
                 stopAllSounds();
+                m_isPumpingCurrentSpeech = false;
             }
             else
             {
@@ -300,6 +458,7 @@ private:
                 float volumeBumpForHighPassFilter = message.radioStyle.highPassFrequency / 1000.0f;
                 m_host->writeLog("SPECHW|request id[%d], playing radio speech", message.requestId);
                 m_currentSpeech->play(1.0f + volumeBumpForHighPassFilter + message.radioStyle.staticVolume);
+                m_currentSpeechPlayRequested = true;
             }
             break;
         case ThreadMessageType::PlayRadioStaticPttOff:
@@ -324,45 +483,377 @@ private:
             "SPECHW|synthesizing speech request id[%d][speaker=%p]: %s",
             message.requestId, message.speaker.get(),  message.transmission->verbalizedUtterance()->plainText().c_str());
 
-        string speechFilePath = m_host->getResourceFilePath({ "speech", "temp.wav" });
+        auto stream = make_shared<SpeechStream>();
+        shared_ptr<SynthesizedSpeech> speech = m_lookahead->takeIfStarted(message.transmission->id());
+        if (speech)
+        {
+            m_host->writeLog("SPECHW|request id[%d]: speech was synthesized in advance", message.requestId);
+            stream->append(getFormat(*speech), speech->pcm.data(), speech->pcm.size());
+            stream->finish();
+            assignPlatformVoice(message.speaker, speech->platformVoiceId);
+        }
+        else
+        {
+            m_host->writeLog("SPECHW|request id[%d]: speech will be synthesized while it plays", message.requestId);
+            StreamingJob streamingJob = { createSpeechJob(*message.transmission, *message.speaker), message.speaker, stream, false };
+            m_streamingQueue.enqueue(streamingJob);
+        }
+
+        if (++m_handledRequestCount % 10 == 0)
+        {
+            m_host->writeLog("SPECHW|audio cache: %s", m_audioCache.formatStatistics().c_str());
+        }
+
+        stopAllSounds();
+        m_activeRequestId = message.requestId;
+        m_currentMessage = message;
+        m_currentSpeechPlayRequested = false;
+        m_isPumpingCurrentSpeech = true;
+        m_currentSpeech = make_shared<StreamingSpeechSource>("request-" + to_string(message.requestId), stream);
+
+        playRadioSpeech(message);
+    }
+
+    // called by the synthesizer thread loop; once the speech has been played through, schedules PTT release
+    void pumpCurrentSpeech()
+    {
+        if (!m_isPumpingCurrentSpeech || !m_currentSpeech)
+        {
+            return;
+        }
+
+        try
+        {
+            m_currentSpeech->pump();
+        }
+        catch (const exception& e)
+        {
+            m_host->writeLog("SPECHW|request id[%d]: playback failed: %s", m_activeRequestId, e.what());
+            m_currentSpeech->stop();
+        }
+
+        if (!m_currentSpeechPlayRequested || !m_currentSpeech->isDrained())
+        {
+            return;
+        }
+
+        m_isPumpingCurrentSpeech = false;
+        const auto& stream = *m_currentSpeech->stream();
+        m_host->writeLog(
+            "SPECHW|request id[%d]: speech played, duration[%lld ms] first-chunk[%lld ms] first-audio[%lld ms] underruns[%d] error[%s]",
+            m_activeRequestId,
+            (long long)stream.appendedDuration().count(),
+            (long long)stream.timeToFirstChunk().count(),
+            (long long)m_currentSpeech->timeToFirstAudio().count(),
+            m_currentSpeech->underrunCount(),
+            stream.error().c_str());
+
+        int requestIdCopy = m_activeRequestId;
+        ThreadMessage message = m_currentMessage;
+        m_host->getWorld()->deferBy("SYNTH/pttoff/reqid=" + to_string(requestIdCopy), message.radioStyle.delayAfterSpeech, [=](){
+            m_host->writeLog("SPECHW|m_messageQueue.enqueue(PlayRadioStaticPttOff, requestId=%d)", requestIdCopy);
+            m_messageQueue.enqueue({
+                ThreadMessageType::PlayRadioStaticPttOff, requestIdCopy, message.frequency, message.speaker, message.transmission, message.radioStyle
+            });
+        });
+    }
+
+    void assignPlatformVoice(shared_ptr<Actor> speaker, const string& platformVoiceId)
+    {
+        if (speaker && speaker->speechStyle().platformVoiceId.length() == 0 && !platformVoiceId.empty())
+        {
+            m_host->writeLog("SPECHW|actor [%d] assigned platform voice id [%s]", speaker->id(), platformVoiceId.c_str());
+            speaker->setPlatformVoiceId(platformVoiceId);
+        }
+    }
+
+    // runs on a lookahead worker, or on the synthesizer thread if the speech wasn't prepared in advance
+    shared_ptr<SynthesizedSpeech> synthesizeSpeechJob(const SpeechJob& job)
+    {
+        const string voiceKey = getVoiceKey(job);
+        vector<shared_ptr<const SpeechAudioCache::Clip>> clips;
+        clips.reserve(job.segments.size());
+
+        for (const auto& segment : job.segments)
+        {
+            SpeechAudioCache::Key key = { voiceKey, job.rate, job.quality, segment };
+            shared_ptr<const SpeechAudioCache::Clip> clip = m_audioCache.find(key);
+            if (!clip)
+            {
+                clip = synthesizeClip(job, segment);
+                m_audioCache.store(key, clip);
+            }
+            clips.push_back(clip);
+        }
+
+        // segments are split at commas, which the synthesizer would render as a short pause
+        auto speech = SpeechAudioCache::concatenate(clips, chrono::milliseconds(200));
+        applyRadioEffect(job, *speech);
+        return speech;
+    }
+
+    // runs on the streaming thread; every chunk goes through the radio effect and into the stream as soon as
+    // it is synthesized, so playback of a long clearance starts with its first words
+    void streamSpeechJob(const StreamingJob& item)
+    {
+        const SpeechJob& job = item.job;
+        SpeechStream& stream = *item.stream;
+        const string voiceKey = getVoiceKey(job);
+        unique_ptr<RadioEffect> effect;
+        vector<char> processed;
+        shared_ptr<const SynthesizedSpeech> previousClip;
+        string platformVoiceId;
+
+        SpeechChunkHandler emitChunk = [&](const SpeechStream::Format& format, const char* data, size_t length) {
+            if (!effect && format.channelCount == 1 && format.bitsPerSample == 16)
+            {
+                effect.reset(new RadioEffect(format.sampleRate, job.radioEffect, (uint32_t)job.transmissionId));
+            }
+            processed.assign(data, data + length);
+            if (effect)
+            {
+                effect->processPcm16((int16_t*)processed.data(), processed.size() / sizeof(int16_t));
+            }
+            return stream.append(format, processed.data(), processed.size());
+        };
 
+        for (const auto& segment : job.segments)
+        {
+            if (previousClip)
+            {
+                // same pause as SpeechAudioCache::concatenate() puts between segments
+                auto format = getFormat(*previousClip);
+                size_t gapBytes = (size_t)format.bytesPerFrame() * (format.sampleRate * 200 / 1000);
+                vector<char> silence(gapBytes, format.bitsPerSample == 8 ? (char)0x80 : 0);
+                if (!emitChunk(format, silence.data(), silence.size()))
+                {
+                    return;
+                }
+            }
+
+            SpeechAudioCache::Key key = { voiceKey, job.rate, job.quality, segment };
+            shared_ptr<const SynthesizedSpeech> clip = m_audioCache.find(key);
+            if (clip)
+            {
+                if (!emitChunk(getFormat(*clip), clip->pcm.data(), clip->pcm.size()))
+                {
+                    return;
+                }
+            }
+            else
+            {
+                clip = synthesizeClip(job, segment, &emitChunk);
+                if (!clip)
+                {
+                    m_host->writeLog("SPECHS|transmission id[%llu]: streaming cancelled", (unsigned long long)job.transmissionId);
+                    return;
+                }
+                m_audioCache.store(key, clip);
+            }
+
+            if (platformVoiceId.empty())
+            {
+                platformVoiceId = clip->platformVoiceId;
+            }
+            previousClip = clip;
+        }
+
+        stream.finish();
+        if (job.platformVoiceId.empty())
+        {
+            assignPlatformVoice(item.speaker, platformVoiceId);
+        }
+    }
+
+    // the cache keeps clean speech, because the effect depends on the speaker's role as well;
+    // the effect is applied once per utterance, so that the filters run across segment boundaries
+    void applyRadioEffect(const SpeechJob& job, SynthesizedSpeech& speech)
+    {
+        if (speech.channelCount != 1 || speech.bitsPerSample != 16)
+        {
+            m_host->writeLog(
+                "SPECHW|transmission id[%llu]: radio effect skipped, unsupported format channels[%d] bits[%d]",
+                (unsigned long long)job.transmissionId, speech.channelCount, speech.bitsPerSample);
+            return;
+        }
+
+        RadioEffect effect(speech.sampleRate, job.radioEffect, (uint32_t)job.transmissionId);
+        effect.processPcm16((int16_t*)speech.pcm.data(), speech.pcm.size() / sizeof(int16_t));
+    }
+
+    // with onChunk, PCM is passed to it as soon as it is synthesized; returns nullptr if onChunk cancelled the synthesis
+    shared_ptr<SynthesizedSpeech> synthesizeClip(const SpeechJob& job, const string& text, const SpeechChunkHandler* onChunk = nullptr)
+    {
         SpeechSynthesisRequest request;
         request.size = sizeof(request);
-        request.text = message.transmission->verbalizedUtterance()->plainText().c_str();
-        request.outputFilePath = speechFilePath.c_str();
-        
-        const auto& style = message.speaker->speechStyle();
-
-        request.gender = (int)style.gender;
-        request.voice = (int)style.voice;
-        request.rate = (int)style.rate;
-        request.quality = (int)style.radioQuality;
-        request.platformVoiceId = style.platformVoiceId.c_str();
+        request.text = text.c_str();
+        request.outputFilePath = nullptr;
+        request.gender = job.gender;
+        request.voice = job.voice;
+        request.rate = job.rate;
+        request.quality = job.quality;
+        request.platformVoiceId = job.platformVoiceId.c_str();
         m_host->writeLog(
-            "SPECHW|request id[%d]: request prepared, speech style> gender[%d] voice[%d] rate[%d] quality[%d] platformVoiceId[%s]",
-            message.requestId, request.gender, request.voice, request.rate, request.quality, request.platformVoiceId);
+            "SPECHW|transmission id[%llu]: request prepared, speech style> gender[%d] voice[%d] rate[%d] quality[%d] platformVoiceId[%s]",
+            (unsigned long long)job.transmissionId, request.gender, request.voice, request.rate, request.quality, request.platformVoiceId);
+
+        if (onChunk && m_streamingSynthesisSupported)
+        {
+            auto speech = make_shared<SynthesizedSpeech>();
+            SpeechChunkContext context = { onChunk, speech.get(), "" };
+            SpeechSynthesisReply reply = { sizeof(reply), ERROR_CODE_UNSPECIFIED, nullptr };
+
+            bool success = synthesizeSpeechStreaming(&logSpeechLibraryMessage, &request, &reply, &receiveSpeechChunk, &context);
+            if (!context.error.empty())
+            {
+                throw runtime_error(context.error);
+            }
+            if (success)
+            {
+                speech->platformVoiceId = reply.platformVoiceId ? reply.platformVoiceId : "";
+                // chunks were appended as they came; the cached clip shouldn't keep the growth slack
+                speech->pcm.shrink_to_fit();
+                m_host->writeLog("SPECHS|transmission id[%llu]: streamed [%llu] bytes", (unsigned long long)job.transmissionId, (unsigned long long)speech->pcm.size());
+                return speech;
+            }
+            if (reply.errorCode == ERROR_CODE_CANCELLED)
+            {
+                return nullptr;
+            }
+            if (reply.errorCode != ERROR_CODE_NOT_SUPPORTED)
+            {
+                throw runtime_error("failed to stream speech, error code [" + to_string(reply.errorCode) + "]");
+            }
+
+            m_host->writeLog("SPECHS|streaming synthesis not supported, falling back to whole clips");
+            m_streamingSynthesisSupported = false;
+        }
+
+        auto speech = synthesizeWholeClip(job, request);
+        if (onChunk && !(*onChunk)(getFormat(*speech), speech->pcm.data(), speech->pcm.size()))
+        {
+            return nullptr;
+        }
+        return speech;
+    }
+
+    shared_ptr<SynthesizedSpeech> synthesizeWholeClip(const SpeechJob& job, SpeechSynthesisRequest request)
+    {
         SpeechSynthesisReply reply = { sizeof(reply), ERROR_CODE_UNSPECIFIED, nullptr };
 
-        bool result = synthesizeSpeech(&logSpeechLibraryMessage, &request, &reply);
-        if (!result)
+        auto speech = make_shared<SynthesizedSpeech>();
+        if (m_inMemorySynthesisSupported)
         {
-            m_host->writeLog("SPECHW|FAILED to synthesize speech, error code [%d]", reply.errorCode);
-            return;
+            // the library synthesizes into a scratch buffer reused by this thread; the clip
+            // gets an exactly sized copy, because it is retained by the lookahead and the cache
+            thread_local vector<char> scratch(256 * 1024);
+            SpeechPcmBuffer output = { sizeof(output), scratch.data(), scratch.size(), 0, 0, 0, 0, 0 };
+
+            if (synthesizeSpeechToBuffer(&logSpeechLibraryMessage, &request, &reply, &output))
+            {
+                speech->pcm.assign(output.data, output.data + output.length);
+                if (output.ownedByLibrary)
+                {
+                    freeSpeechBuffer(&output);
+                }
+                speech->sampleRate = output.sampleRate;
+                speech->channelCount = output.channelCount;
+                speech->bitsPerSample = output.bitsPerSample;
+                speech->platformVoiceId = reply.platformVoiceId ? reply.platformVoiceId : "";
+
+                m_host->writeLog("SPECHW|transmission id[%llu]: synthesized [%llu] bytes in memory", (unsigned long long)job.transmissionId, (unsigned long long)speech->pcm.size());
+                return speech;
+            }
+
+            if (reply.errorCode != ERROR_CODE_NOT_SUPPORTED)
+            {
+                throw runtime_error("failed to synthesize speech, error code [" + to_string(reply.errorCode) + "]");
+            }
+
+            m_host->writeLog("SPECHW|in-memory synthesis not supported, falling back to temp files");
+            m_inMemorySynthesisSupported = false;
         }
 
-        m_host->writeLog("SPECHW|successfully synthesized speech");
-        this_thread::sleep_for(chrono::milliseconds(500));
+        // every transmission gets its own file, because several workers synthesize at the same time
+        string speechFilePath = m_host->getResourceFilePath({ "speech", "temp-" + to_string(job.transmissionId) + ".wav" });
+        request.outputFilePath = speechFilePath.c_str();
 
-        m_activeRequestId = message.requestId;
-        m_currentSpeech = make_shared<SpeechSoundBuffer>(speechFilePath, true, message.radioStyle.highPassFrequency);
+        if (!synthesizeSpeech(&logSpeechLibraryMessage, &request, &reply))
+        {
+            throw runtime_error("failed to synthesize speech, error code [" + to_string(reply.errorCode) + "]");
+        }
 
-        if (message.speaker && style.platformVoiceId.length() == 0 && reply.platformVoiceId)
+        // every speech library synthesizes synchronously, the file is complete once synthesizeSpeech() returns
         {
-            m_host->writeLog("SPECHW|actor [%d] assigned platform voice id [%s]", message.speaker->id(), reply.platformVoiceId);
-            message.speaker->setPlatformVoiceId(reply.platformVoiceId);
+            auto reader = SoundFileReaderFactory::createReader(speechFilePath);
+            reader->readHeader();
+            reader->readSound(speech->pcm);
+
+            const auto& header = reader->header();
+            speech->sampleRate = header.frequency;
+            speech->channelCount = header.channelCount;
+            speech->bitsPerSample = header.bytesPerSample * 8;
+            speech->platformVoiceId = reply.platformVoiceId ? reply.platformVoiceId : "";
         }
-        
-        playRadioSpeech(message);
+        remove(speechFilePath.c_str());
+
+        m_host->writeLog("SPECHW|transmission id[%llu]: synthesized speech into [%s]", (unsigned long long)job.transmissionId, speechFilePath.c_str());
+        return speech;
+    }
+
+    // called by the speech library on the thread which synthesizes; must not throw
+    static bool receiveSpeechChunk(void* context, const SpeechPcmBuffer* chunk)
+    {
+        auto chunkContext = (SpeechChunkContext*)context;
+        SynthesizedSpeech& speech = *chunkContext->speech;
+        try
+        {
+            speech.sampleRate = chunk->sampleRate;
+            speech.channelCount = chunk->channelCount;
+            speech.bitsPerSample = chunk->bitsPerSample;
+            speech.pcm.insert(speech.pcm.end(), chunk->data, chunk->data + chunk->length);
+            return (*chunkContext->onChunk)({ chunk->sampleRate, chunk->channelCount, chunk->bitsPerSample }, chunk->data, chunk->length);
+        }
+        catch (const exception& e)
+        {
+            chunkContext->error = e.what();
+            return false;
+        }
+    }
+
+    static SpeechStream::Format getFormat(const SynthesizedSpeech& speech)
+    {
+        return { speech.sampleRate, speech.channelCount, speech.bitsPerSample };
+    }
+
+    // pitch markup depends on the voice, and voices are picked by gender until a platform voice is assigned
+    static string getVoiceKey(const SpeechJob& job)
+    {
+        return
+            (job.platformVoiceId.empty() ? "gender-" + to_string(job.gender) : job.platformVoiceId) +
+            "/voice-" + to_string(job.voice);
+    }
+
+    static SpeechJob createSpeechJob(const Transmission& transmission, const Actor& speaker)
+    {
+        const auto& utterance = *transmission.verbalizedUtterance();
+        vector<string> segments;
+        for (const auto& segment : SpeechAudioCache::splitIntoSegments(utterance))
+        {
+            segments.push_back(utterance.plainText().substr(segment.startIndex, segment.length));
+        }
+
+        const auto& style = speaker.speechStyle();
+        return {
+            transmission.id(),
+            segments,
+            (int)style.gender,
+            (int)style.voice,
+            (int)style.rate,
+            (int)style.radioQuality,
+            style.platformVoiceId,
+            RadioEffect::getSettings(speaker.nature(), speaker.role(), style.radioQuality)
+        };
     }
 
     void playRegularSpeech(const ThreadMessage& message)
@@ -370,24 +861,14 @@ private:
         m_currentSpeech->play(1.0f);
     }
 
+    // the sounds of the previous transmission are stopped by handleSynthesizeSpeechRequest()
     void playRadioSpeech(const ThreadMessage& message)
     {
-        stopAllSounds();
-//        m_radioStaticEdgeMedium.stop();
-//        m_radioStaticEdgeMedium.rewind();
-//        m_radioStaticEdgeShort.stop();
-//        m_radioStaticEdgeShort.rewind();
-//        m_radioStaticEdgeLong.stop();
-//        m_radioStaticEdgeLong.rewind();
-
-        auto speechPlaybackTime = m_currentSpeech->playbackTime() - chrono::milliseconds(100);
-        m_host->writeLog("SPECHW|speech playback time, ms: %lld", speechPlaybackTime.count());
-
         int requestIdCopy = m_activeRequestId;
         const auto& radioStyle = message.radioStyle;
         chrono::milliseconds timePttAt = radioStyle.delayBeforePtt;
         chrono::milliseconds timeSpeakAt = timePttAt + radioStyle.delayAfterPtt;
-        chrono::milliseconds timePttOffAt = timeSpeakAt + speechPlaybackTime + radioStyle.delayAfterSpeech;
+        // PTT is released once the speech is played through, see pumpCurrentSpeech()
 
         m_host->writeLog(
             "SPECHW|radio style: beforeptt=%d, afterptt=%d, afterspch=%d static=%f highpass=%f",
@@ -405,12 +886,6 @@ private:
                 ThreadMessageType::PlayRadioSpeech, requestIdCopy, message.frequency, message.speaker, message.transmission, radioStyle 
             });
         });
-        m_host->getWorld()->deferBy("SYNTH/pttoff/reqid=" + to_string(requestIdCopy), timePttOffAt, [=](){
-            m_host->writeLog("SPECHW|m_messageQueue.enqueue(PlayRadioStaticPttOff, requestId=%d)", requestIdCopy);
-            m_messageQueue.enqueue({ 
-                ThreadMessageType::PlayRadioStaticPttOff, requestIdCopy, message.frequency, message.speaker, message.transmission, radioStyle 
-            });
-        });
     }
 
     bool isReqeustStillActive(int requestId)
@@ -443,7 +918,7 @@ private:
         radioStyle.delayAfterPtt = chrono::milliseconds(500);
         radioStyle.delayAfterSpeech = chrono::milliseconds(500);
         radioStyle.staticVolume = 0.1f;
-        radioStyle.highPassFrequency = 250;
+        radioStyle.highPassFrequency = RadioEffect::getSettings(actor.nature(), role, actor.speechStyle().radioQuality).highPassHz;
     }
 
     void setRadioRenderSpeechStyle(
@@ -473,26 +948,21 @@ private:
         {
         case Actor::RadioQuality::Good:
             radioStyle.staticVolume = 0.25f;
-            radioStyle.highPassFrequency = 2500;
             break;
         case Actor::RadioQuality::Poor:
             radioStyle.staticVolume = 0.35f;
-            radioStyle.highPassFrequency = 1500;
             break;
         default:
             radioStyle.staticVolume = 0.30f;
-            radioStyle.highPassFrequency = 2000;
         }
 
-        if (role == Actor::Role::Pilot)
-        {
-            radioStyle.highPassFrequency += 500;
-        }
-        else
+        if (role != Actor::Role::Pilot)
         {
             radioStyle.staticVolume -= 0.1f;
-            radioStyle.highPassFrequency -= 500;
         }
+
+        // the filtering itself is done by RadioEffect on the synthesis worker
+        radioStyle.highPassFrequency = RadioEffect::getSettings(actor.nature(), role, regularStyle.radioQuality).highPassHz;
     }
 
     void stopAllSounds()
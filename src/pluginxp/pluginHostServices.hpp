@@ -13,6 +13,7 @@
 #include <chrono>
 #include <random>
 #include <iomanip>
+#include <mutex>
 
 // SDK
 #include "XPLMUtilities.h"
@@ -26,6 +27,8 @@
 // tnc
 #include "utils.h"
 #include "libworld.h"
+#include "libdataxp.h"
+#include "asyncLog.hpp"
 #include "intentFactory.hpp"
 #include "clearanceFactory.hpp"
 
@@ -44,6 +47,8 @@ private:
     XPLMProbeRef m_hTerrainProbe;
     shared_ptr<World> m_world;
     shared_ptr<MessageWindow> m_messageBox;
+    shared_ptr<Doc8643Index> m_aircraftTypeIndex;
+    mutex m_logLock;
 public:
 
     PluginHostServices() :
@@ -53,6 +58,11 @@ public:
         m_directorySeparator = XPLMGetDirectorySeparator();
         m_pluginDirectory = getPluginDirectory();
         m_randomGenerator = mt19937(m_randomDevice());
+
+        // lines formatted by the background thread of AsyncLog go to Log.txt, same as writeLog()
+        AsyncLog::instance().setSink([](const char* line, size_t length) {
+            XPLMDebugString(line);
+        });
     }
 
 public:
@@ -255,6 +265,8 @@ public:
         stringstream s;
         s << "AT&C [+" << setw(10) << elapsedMilliseconds.count() << "] " << buffer << endl;
 
+        // airports are assembled on several threads of the world load pipeline, which all log
+        lock_guard<mutex> lock(m_logLock);
         XPLMDebugString(s.str().c_str());
     }
 
@@ -266,5 +278,32 @@ public:
         _world->onQueryTerrainElevation([this](const GeoPoint& location){
             return queryTerrainElevationAt(location);
         });
+
+        if (!m_aircraftTypeIndex)
+        {
+            loadAircraftTypeIndex();
+        }
+        _world->onQueryAircraftType([this](const string& typeIcao, AircraftTypeInfo& info){
+            return m_aircraftTypeIndex && m_aircraftTypeIndex->tryFind(typeIcao, info);
+        });
+    }
+
+private:
+
+    void loadAircraftTypeIndex()
+    {
+        // the index is converted from Doc8643.txt on first run, and memory-mapped afterwards
+        string textFilePath = getResourceFilePath({ "Resources", "Doc8643.txt" });
+        string indexFilePath = getResourceFilePath({ "Resources", "Doc8643.idx" });
+
+        try
+        {
+            m_aircraftTypeIndex = Doc8643Index::openOrConvert(textFilePath, indexFilePath);
+            writeLog("HOSTSV|loaded [%d] aircraft types from [%s]", m_aircraftTypeIndex->size(), indexFilePath.c_str());
+        }
+        catch (const exception& e)
+        {
+            writeLog("HOSTSV|FAILED to load aircraft types from [%s]: %s", textFilePath.c_str(), e.what());
+        }
     }
 };
@@ -138,23 +138,24 @@ private:
     {
     private:
         shared_ptr<PluginHostServices> m_host;
-        future<shared_ptr<World>> m_worldFuture;
-        atomic<bool> m_done;
+        shared_ptr<PluginWorldLoader> m_loader;
+        string m_userAirportIcao;
         PluginMenu::Item m_assemblingItem;
         function<void(shared_ptr<World> world)> m_onAssembled;
         function<void()> m_onFailed;
     public:
         WorldAssemblingState(
             shared_ptr<PluginHostServices> _host,
+            shared_ptr<PluginWorldLoader> _loader,
             PluginMenu& _menu,
             function<void(shared_ptr<World> world)> _onAssembled,
             function<void()> _onFailed
         ) : PluginState(PluginStateId::WorldAssembling, "WORLD-ASSEMBLING"),
             m_host(std::move(_host)),
+            m_loader(std::move(_loader)),
             m_assemblingItem(_menu, "World is being assembled, please wait...", [](){}),
             m_onAssembled(std::move(_onAssembled)),
-            m_onFailed(std::move(_onFailed)),
-            m_done(false)
+            m_onFailed(std::move(_onFailed))
         {
         }
 
@@ -162,74 +163,57 @@ private:
 
         void enter() override
         {
-            m_worldFuture = std::async(std::launch::async, [this] {
-                try
-                {
-                    auto world = assembleWorld();
-                    if (world)
-                    {
-                        m_host->useWorld(world);
-                        startServer();
-                    }
-                    return world;
-                }
-                catch (const exception& e)
-                {
-                    m_host->writeLog("PLUGIN|WorldAssemblingState background task CRASHED!!! %s", e.what());
-                    return shared_ptr<World>();
-                }
-            });
+            try
+            {
+                m_loader->beginLoadWorld();
+                m_host->useWorld(m_loader->getWorld());
+
+                DemoScheduleLoader userAirportLookup(m_host, m_loader->getWorld());
+                m_userAirportIcao = userAirportLookup.getUserAirportIcao();
+            }
+            catch (const exception& e)
+            {
+                m_host->writeLog("PLUGIN|WorldAssemblingState::enter CRASHED!!! %s", e.what());
+            }
         }
 
         void exit() override
         {
-            if (!m_done && m_worldFuture.wait_for(chrono::milliseconds(0)) != future_status::ready)
+            if (m_loader->isLoading())
             {
-                m_host->writeLog("PLUGIN|WARNING: leaving WORLD-ASSEMBLING state while the assembly is still in progress!");
+                m_host->writeLog("PLUGIN|leaving WORLD-ASSEMBLING state, airports continue loading in background");
             }
         }
 
         void ping() override
         {
-            if (m_worldFuture.wait_for(chrono::milliseconds(0)) != future_status::ready)
+            auto world = m_loader->getWorld();
+            if (!world)
             {
-                m_host->writeLog("PLUGIN|ping WORLD-ASSEMBLING: in progress");
+                m_host->writeLog("PLUGIN|ERROR: world was not assembled - plugin will not function (see previous errors).");
+                m_onFailed();
+                return;
             }
-            else if (m_worldFuture.valid())
-            {
-                m_host->writeLog("PLUGIN|ping WORLD-ASSEMBLING: done");
-                auto world = m_worldFuture.get();
-                m_done = true;
 
-                if (world)
-                {
-                    m_onAssembled(world);
-                }
-                else
-                {
-                    m_host->writeLog("PLUGIN|ERROR: world was not assembled - plugin will not function (see previous errors).");
-                    m_onFailed();
-                }
+            // the world is usable as soon as the user airport is indexed; the loader keeps draining
+            // the rest on every tick, so lookups of other airports must tolerate ones still loading
+            if (!world->tryFindAirport(m_userAirportIcao) && m_loader->isLoading())
+            {
+                return;
             }
-        }
 
-    private:
+            m_host->writeLog(
+                "PLUGIN|ping WORLD-ASSEMBLING: done, [%d] airports in the world so far, user airport [%s] %s",
+                world->airports().size(),
+                m_userAirportIcao.c_str(),
+                world->tryFindAirport(m_userAirportIcao) ? "loaded" : "NOT FOUND");
 
-        shared_ptr<World> assembleWorld()
-        {
-            try
-            {
-                PluginWorldLoader loader(m_host);
-                loader.loadWorld();
-                return loader.getWorld();
-            }
-            catch (const exception& e)
-            {
-                m_host->writeLog("PLUGIN|assembleWorld CRASHED!!! %s", e.what());
-                return shared_ptr<World>();
-            }
+            startServer();
+            m_onAssembled(world);
         }
 
+    private:
+
         void startServer()
         {
 #if IBM
@@ -384,6 +368,9 @@ private:
         PluginMenu::Item m_restartSchedules100Item;
         PluginMenu::Item m_restartSchedules70Item;
         PluginMenu::Item m_restartSchedules50Item;
+        PluginMenu::Item m_reloadUserAirportItem;
+        future<shared_ptr<Airport::Structure>> m_reloadedAirportFuture;
+        bool m_userAirportReloadPending;
         DataRef<int> m_com1FrequencyKhz;
         DataRef<int> m_simSpeed;
     public:
@@ -412,6 +399,8 @@ private:
             m_restartSchedules100Item(_menu, "Restart schedules with 100% load", [=]{_onRestartSchedules(1.0f);}),
             m_restartSchedules70Item(_menu, "Restart schedules with 70% load", [=]{_onRestartSchedules(0.7f);}),
             m_restartSchedules50Item(_menu, "Restart schedules with 50% load", [=]{_onRestartSchedules(0.5f);}),
+            m_reloadUserAirportItem(_menu, "Reload " + _userAirport->header().icao() + " from apt.dat", [this] { beginReloadUserAirport(); }),
+            m_userAirportReloadPending(false),
             m_com1FrequencyKhz("sim/cockpit2/radios/actuators/com1_frequency_hz_833", PPL::ReadWrite),
             m_simSpeed("sim/time/sim_speed", PPL::ReadWrite)
         {
@@ -438,6 +427,8 @@ private:
                 return;
             }
 
+            completeReloadUserAirport();
+
             m_world->progressTo(newWorldTimestamp);
             auto changeSet = m_world->hasChanges()
                 ? m_world->takeChanges()
@@ -447,6 +438,15 @@ private:
             {
                 processWorldChanges(changeSet);
             }
+            publishWorldChanges(changeSet);
+
+            if (m_userAirportReloadPending)
+            {
+                // the reloaded airport was swapped in during this tick
+                m_userAirportReloadPending = false;
+                m_userAirport = m_world->getAirport(m_userAirport->header().icao());
+                WorldBuilder::tidyAirportElevations(m_host, m_userAirport);
+            }
         }
 
         void exit() override
@@ -463,6 +463,61 @@ private:
             m_aircraftObjectService->processEvents(changeSet);
         }
 
+        // the server batches changes of several ticks into one frame, so it is called on every tick
+        void publishWorldChanges(shared_ptr<World::ChangeSet> changeSet)
+        {
+#if IBM
+            m_host->services().get<server::ServerControllerInterface>()->publishWorldChanges(changeSet);
+#endif
+        }
+
+        void beginReloadUserAirport()
+        {
+            if (m_reloadedAirportFuture.valid())
+            {
+                m_host->writeLog("PLUGIN|reload of user airport is already in progress");
+                return;
+            }
+
+            auto host = m_host;
+            string icao = m_userAirport->header().icao();
+            m_reloadedAirportFuture = std::async(std::launch::async, [host, icao] {
+                return PluginWorldLoader::readAirportStructure(host, icao);
+            });
+        }
+
+        void completeReloadUserAirport()
+        {
+            if (!m_reloadedAirportFuture.valid() ||
+                m_reloadedAirportFuture.wait_for(chrono::milliseconds(0)) != future_status::ready)
+            {
+                return;
+            }
+
+            try
+            {
+                auto structure = m_reloadedAirportFuture.get();
+                if (!structure)
+                {
+                    throw runtime_error("airport not found in apt.dat");
+                }
+
+                m_world->reloadAirport(
+                    m_userAirport->header().icao(),
+                    [this, structure](const string& icao, shared_ptr<ControlledAirspace> airspace) {
+                        return WorldBuilder::assembleAirport(m_host, *structure, airspace);
+                    });
+                m_userAirportReloadPending = true;
+            }
+            catch (const exception& e)
+            {
+                m_host->writeLog(
+                    "PLUGIN|reload of user airport [%s] FAILED: %s",
+                    m_userAirport->header().icao().c_str(),
+                    e.what());
+            }
+        }
+
         void tuneToClearance()
         {
             auto clearance = m_userAirport->clearanceDeliveryAt(m_userAirport->header().datum());
@@ -558,6 +613,7 @@ private:
     PluginMenu m_menu;
     shared_ptr<PluginState> m_currentState;
     shared_ptr<PluginHostServices> m_hostServices;
+    shared_ptr<PluginWorldLoader> m_worldLoader;
     shared_ptr<World> m_world;
     float m_schedulesLoadFactor;
     DataRef<double> m_userAircraftLatitude;
@@ -585,6 +641,11 @@ public:
         {
             transitionToState([this]() { return createStoppedState(); });
         }
+
+        // records still queued are written to Log.txt while the sink can call XPLM;
+        // the consumer thread of AsyncLog is joined in XPluginStop
+        AsyncLog::instance().flush();
+        AsyncLog::instance().setSink(nullptr);
     }
 
 public:
@@ -694,6 +755,7 @@ private:
 
     shared_ptr<PluginState> createWorldAssemblingState()
     {
+        m_worldLoader = make_shared<PluginWorldLoader>(m_hostServices);
         const auto onAssembled = [this](shared_ptr<World> world) {
             m_hostServices->writeLog("PLUGIN|createWorldAssemblingState");
             m_world = world;
@@ -708,7 +770,7 @@ private:
             });
         };
 
-        return make_shared<WorldAssemblingState>(m_hostServices, m_menu, onAssembled, onFailed);
+        return make_shared<WorldAssemblingState>(m_hostServices, m_worldLoader, m_menu, onAssembled, onFailed);
     }
 
     shared_ptr<PluginState> createWorldAssembledState()
@@ -779,6 +841,10 @@ private:
 
         try
         {
+            if (m_worldLoader)
+            {
+                m_worldLoader->ping();
+            }
             m_currentState->ping();
         }
         catch(const exception& e)
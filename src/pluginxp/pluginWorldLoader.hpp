@@ -7,6 +7,7 @@
 #include <string>
 #include <chrono>
 #include <queue>
+#include <thread>
 #include <vector>
 
 // SDK
@@ -19,6 +20,7 @@
 // tnc
 #include "utils.h"
 #include "libworld.h"
+#include "worldLoadPipeline.hpp"
 #include "intentFactory.hpp"
 #include "libdataxp.h"
 #include "libai.hpp"
@@ -37,106 +39,97 @@ class PluginWorldLoader
 private:
     shared_ptr<HostServices> m_host;
     shared_ptr<World> m_world;
+    shared_ptr<WorldLoadPipeline> m_pipeline;
+    chrono::steady_clock::time_point m_lastProgressLogTime;
 public:
     PluginWorldLoader(shared_ptr<HostServices> _host) :
         m_host(_host)
     {
     }
 public:
-    void loadWorld()
+    // creates an empty world and starts loading airports in the background;
+    // airports become available in the world as they pass through the pipeline
+    void beginLoadWorld()
     {
-        vector<shared_ptr<Airport>> airports;
-        loadAirports(airports);
-
-        m_world = WorldBuilder::assembleSampleWorld(m_host, airports);
+        m_world = WorldBuilder::assembleSampleWorld(m_host, {});
         m_host->writeLog("World initialized");
 
-#if 0
-        for (const auto& airport : airports)
+        m_pipeline = make_shared<WorldLoadPipeline>(
+            m_host,
+            [this](const WorldLoadPipeline::EmitAirportCallback& emit) { parseAirports(emit); },
+            WorldBuilder::assembleSampleAirportControlZone,
+            max(1, (int)thread::hardware_concurrency() - 2));
+
+        m_host->writeLog("LWORLD|--- begin load airports ---");
+        m_lastProgressLogTime = chrono::steady_clock::now();
+        m_pipeline->start();
+    }
+
+    // must be called on the simulation thread
+    void ping()
+    {
+        if (!m_pipeline)
         {
-            try
-            {
-                //auto runway = airport->findLongestRunway();
-//                if (runway->lengthMeters() >= 2000 && !airport->hasParallelRunways() && (
-//                    airport->header().icao().at(0) == 'K' ||
-//                    airport->header().icao().at(0) == 'Y' ||
-//                    airport->header().icao().substr(0, 2) == "EG"))
-                {
-                    m_host->writeLog("LWORLD|ENUMAPT %s", airport->header().icao().c_str());
-
-                    //                    m_host->writeLog(
-//                        "LWORLD|FOUNDAPT [%s] rwys[%d] gates[%d] longest-rwy[%d]m name[%s]",
-//                        airport->header().icao().c_str(),
-//                        airport->runways().size(),
-//                        airport->parkingStands().size(),
-//                        (int) runway->lengthMeters(),
-//                        runway->name().c_str()
-//                    );
-                }
-            }
-            catch(const exception& e)
-            {
-                m_host->writeLog("LWORLD|FOUNDAPT FAILED on [%s]: %s", airport->header().icao().c_str(), e.what());
-            }
+            return;
         }
-#endif
 
-        m_host->writeLog(
-            "LWORLD|Assembled world with [%d] airports, [%d] airspaces, [%d] control facilities",
-            m_world->airports().size(),
-            0, //TODO
-            m_world->controlFacilities().size());
+        m_pipeline->drainInto(m_world);
+
+        auto now = chrono::steady_clock::now();
+        if (m_pipeline->finished() || now - m_lastProgressLogTime >= chrono::seconds(5))
+        {
+            m_pipeline->logProgress();
+            m_lastProgressLogTime = now;
+        }
+
+        if (m_pipeline->finished())
+        {
+            m_pipeline.reset();
+            m_host->writeLog("LWORLD|--- end load airports ---");
+            m_host->writeLog(
+                "LWORLD|Assembled world with [%d] airports, [%d] airspaces, [%d] control facilities",
+                m_world->airports().size(),
+                m_world->airspaces().size(),
+                m_world->controlFacilities().size());
+        }
     }
 
     shared_ptr<World> getWorld() const { return m_world; }
-//    void stop() override
-//    {
-//        m_host->writeLog("Stopping POC # 1");
-//
-//        XPLMUnregisterFlightLoopCallback(&worldFlightLoopCallback, this);
-//        m_host->writeLog("Unregistered flight loop callback");
-//
-//        m_world.reset();
-//        m_host->writeLog("World shut down");
-//    }
-//    void setTimeFactor(uint64_t factor) override
-//    {
-//        m_timeFactor = factor;
-//    }
-private:
-    void loadAirports(vector<shared_ptr<Airport>>& airports)
+    bool isLoading() const { return !!m_pipeline; }
+public:
+    static string getGlobalAptDatFilePath(shared_ptr<HostServices> host)
     {
         // X-Plane 11\Resources\default scenery\default apt dat\Earth nav data\apt.dat
-        string globalAptDatFilePath = m_host->getHostFilePath({
+        return host->getHostFilePath({
             "Resources", "default scenery", "default apt dat", "Earth nav data", "apt.dat"
             //TODO: what about this one? "Custom Scenery", "Global Airports", "Earth nav data", "apt.dat"
         });
+    }
+
+    static shared_ptr<Airport::Structure> readAirportStructure(shared_ptr<HostServices> host, const string& icao)
+    {
+        string globalAptDatFilePath = getGlobalAptDatFilePath(host);
+        host->writeLog("LWORLD|reading airport [%s] from [%s]", icao.c_str(), globalAptDatFilePath.c_str());
+
+        shared_ptr<istream> aptDatFile = host->openFileForRead(globalAptDatFilePath);
+        XPAptDatReader aptDatReader(host);
+        return aptDatReader.readAirportStructure(*aptDatFile, icao);
+    }
+private:
+    void parseAirports(const WorldLoadPipeline::EmitAirportCallback& emit)
+    {
+        string globalAptDatFilePath = getGlobalAptDatFilePath(m_host);
         m_host->writeLog("LWORLD|global apt.dat file path [%s]", globalAptDatFilePath.c_str());
 
         shared_ptr<istream> aptDatFile = m_host->openFileForRead(globalAptDatFilePath);
         XPAptDatReader aptDatReader(m_host);
 
-        m_host->writeLog("LWORLD|--- begin load airports ---");
-
-        aptDatReader.readAptDat(
+        aptDatReader.readAirportStructures(
             *aptDatFile,
-            WorldBuilder::assembleSampleAirportControlZone,
             [&](const Airport::Header header) {
                 return true;
-//                return (header.icao() != "LCLK");
-//                return (
-//                    header.icao() == "KJFK" ||
-//                    header.icao() == "KMIA" ||
-//                    header.icao() == "KORD" ||
-//                    header.icao() == "YBBN"
-//                );
             },
-            [this, &airports](shared_ptr<Airport> airport) {
-                //m_host->writeLog("LWORLD|LOADAPT %s", airport->header().icao().c_str());
-                airports.push_back(airport);
-            }
+            emit
         );
-
-        m_host->writeLog("LWORLD|--- end load airports ---");
     }
 };
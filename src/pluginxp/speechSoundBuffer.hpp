@@ -12,6 +12,7 @@
 #include <chrono>
 #include "alsoundbuffer.h"
 #include "soundFileReader.hpp"
+#include "radioEffect.hpp"
 
 using namespace std;
 using namespace PPL;
@@ -27,13 +28,48 @@ private:
 public:
     SpeechSoundBuffer(const std::string& filename, bool isRadio, float radioHighPassFrequency) :
         m_name(filename)
+    {
+        // Clear present errors
+        alGetError();
+        initialize(loadSoundFile(filename, isRadio, radioHighPassFrequency, m_playbackTime));
+    }
+
+    // plays PCM synthesized in memory; the radio filter is applied to the data in place
+    SpeechSoundBuffer(
+        const std::string& name,
+        char* data,
+        size_t length,
+        int sampleRate,
+        int channelCount,
+        int bitsPerSample,
+        bool isRadio,
+        float radioHighPassFrequency
+    ) :
+        m_name(name)
+    {
+        alGetError();
+        initialize(loadSoundData(
+            data, length, sampleRate, channelCount, bitsPerSample,
+            isRadio, radioHighPassFrequency, m_playbackTime));
+    }
+
+    ~SpeechSoundBuffer()
+    {
+        alDeleteSources(1, &m_source);
+        alDeleteBuffers(1, &m_buffer);
+    }
+
+    SpeechSoundBuffer(const ALSoundBuffer&) = delete;
+    SpeechSoundBuffer& operator=(const ALSoundBuffer&) = delete;
+
+private:
+
+    void initialize(ALuint buffer)
     {
         ALfloat source_position[] = { 0.0, 0.0, 0.0 };
         ALfloat source_velocity[] = { 0.0, 0.0, 0.0 };
         m_loop = AL_FALSE;
-        // Clear present errors
-        alGetError();
-        m_buffer = loadSoundFile(filename, isRadio, radioHighPassFrequency, m_playbackTime);
+        m_buffer = buffer;
 
         if( m_buffer == AL_NONE)
         {
@@ -66,14 +102,7 @@ public:
         }
     }
 
-    ~SpeechSoundBuffer()
-    {
-        alDeleteSources(1, &m_source);
-        alDeleteBuffers(1, &m_buffer);
-    }
-
-    SpeechSoundBuffer(const ALSoundBuffer&) = delete;
-    SpeechSoundBuffer& operator=(const ALSoundBuffer&) = delete;
+public:
 
     bool play(float volume)
     {
@@ -159,7 +188,6 @@ private:
         ALenum format;
         ALsizei freq;
         ALuint buffer = AL_NONE;
-        ALenum error;
 
         alGetError();
 
@@ -181,9 +209,9 @@ private:
 
             if (shouldApplyRadioFilter)
             {
-                HighPassFilter radioFilter(header.frequency, header.bytesPerSample * 8, radioFilterCutffFrequency, 1.0f);
+                world::RadioEffect radioFilter = createRadioFilter(header.frequency, header.bytesPerSample * 8, radioFilterCutffFrequency);
                 reader->readSound(data, [&](char *buffer, size_t bufferSize) {
-                    radioFilter.processBuffer(buffer, bufferSize);
+                    radioFilter.processPcm16((int16_t*)buffer, bufferSize / sizeof(int16_t));
                 });
             }
             else
@@ -191,17 +219,7 @@ private:
                 reader->readSound(data);
             }
 
-            alGenBuffers(1, &buffer);
-            
-            if((error = alGetError()) != AL_NO_ERROR)
-                throw ALSoundBuffer::SoundBufferError("LoadWav: Could not generate buffer: error=" + to_string(error));
-            if(AL_NONE == buffer)
-                throw ALSoundBuffer::SoundBufferError("LoadWav: Could not generate buffer: AL_NONE");
-
-            alBufferData(buffer, format, &data[0], data.size(), freq);
-            if((error = alGetError()) != AL_NO_ERROR)
-                throw ALSoundBuffer::SoundBufferError("LoadWav: Could not load buffer data: error=" + to_string(error));
-
+            buffer = createBuffer(format, data.data(), data.size(), freq);
             outPlaybackTime = chrono::milliseconds((1000 * header.soundByteCount) / (header.bytesPerFrame * header.frequency) - 500);
             return buffer;
         }
@@ -213,80 +231,68 @@ private:
         }
     }
 
-private:
-
-    //reference: https://stackoverflow.com/a/29561548/4544845
-    class HighPassFilter
+    static ALuint loadSoundData(
+        char* data,
+        size_t length,
+        int sampleRate,
+        int channelCount,
+        int bitsPerSample,
+        bool shouldApplyRadioFilter,
+        float radioFilterCutffFrequency,
+        chrono::milliseconds& outPlaybackTime)
     {
-    private:
-        float resonance;
-        float frequency;
-        uint32_t sampleRate;
-        uint16_t bitsPerSample;
-        float c, a1, a2, a3, b1, b2;
-        float inputHistory[2] = { 0 };
-        float outputHistory[3] = { 0 };
-    public:
-        HighPassFilter(uint32_t _sampleRate, uint16_t _bitsPerSample, float _frequency, float _resonance) :
-            sampleRate(_sampleRate), 
-            bitsPerSample(_bitsPerSample), 
-            frequency(_frequency), 
-            resonance(_resonance)
+        const int bytesPerFrame = channelCount * bitsPerSample / 8;
+        if (length == 0 || sampleRate <= 0 || bytesPerFrame <= 0)
+            throw ALSoundBuffer::SoundBufferError("LoadPcm: empty or malformed sound data");
+
+        ALenum format = channelCount == 1
+            ? (bitsPerSample == 8 ? AL_FORMAT_MONO8 : AL_FORMAT_MONO16)
+            : (bitsPerSample == 8 ? AL_FORMAT_STEREO8 : AL_FORMAT_STEREO16);
+
+        if (shouldApplyRadioFilter)
         {
-            c = (float)tan(M_PI * frequency / sampleRate);
-            a1 = 1.0f / (1.0f + resonance * c + c * c);
-            a2 = -2.0f * a1;
-            a3 = a1;
-            b1 = 2.0f * (c * c - 1.0f) * a1;
-            b2 = (1.0f - resonance * c + c * c) * a1;
+            world::RadioEffect radioFilter = createRadioFilter(sampleRate, bitsPerSample, radioFilterCutffFrequency);
+            radioFilter.processPcm16((int16_t*)data, length / sizeof(int16_t));
         }
-    public:
-        void processBuffer(char *buffer, size_t size)
-        {
-            float inputSample = 0;
-            float outputSample = 0;
 
-            for (int i = 0 ; i < size ; )
-            {
-                switch (bitsPerSample)
-                {
-                // case 8:
-                //     inputSample = (float)*((int8_t*)(buffer + i));
-                //     outputSample = processNextSample(inputSample);
-                //     *((int8_t*)(buffer + i)) = (int8_t)outputSample;
-                //     i += 1;
-                //     break;
-                case 16:
-                    inputSample = (float)*((int16_t*)(buffer + i));
-                    outputSample = processNextSample(inputSample);
-                    *((int16_t*)(buffer + i)) = (int16_t)outputSample;
-                    i += 2;
-                    break;
-                default:
-                    stringstream error;
-                    error << "Unsupported bps: " << bitsPerSample;
-                    throw ALSoundBuffer::SoundBufferError(error.str());
-                }
-            }
-        }
-    private:
-        float processNextSample(float newSample)
+        ALuint buffer = createBuffer(format, data, length, sampleRate);
+        outPlaybackTime = chrono::milliseconds((1000 * (long long)length) / (bytesPerFrame * sampleRate) - 500);
+        return buffer;
+    }
+
+    static ALuint createBuffer(ALenum format, const char* data, size_t size, ALsizei freq)
+    {
+        ALuint buffer = AL_NONE;
+        ALenum error;
+
+        alGenBuffers(1, &buffer);
+
+        if((error = alGetError()) != AL_NO_ERROR)
+            throw ALSoundBuffer::SoundBufferError("LoadWav: Could not generate buffer: error=" + to_string(error));
+        if(AL_NONE == buffer)
+            throw ALSoundBuffer::SoundBufferError("LoadWav: Could not generate buffer: AL_NONE");
+
+        alBufferData(buffer, format, data, (ALsizei)size, freq);
+        if((error = alGetError()) != AL_NO_ERROR)
         {
-            float newOutput = 
-                a1 * newSample + 
-                a2 * inputHistory[0] + 
-                a3 * inputHistory[1] - 
-                b1 * outputHistory[0] - 
-                b2 * outputHistory[1];
+            alDeleteBuffers(1, &buffer);
+            throw ALSoundBuffer::SoundBufferError("LoadWav: Could not load buffer data: error=" + to_string(error));
+        }
 
-            inputHistory[1] = inputHistory[0];
-            inputHistory[0] = newSample;
+        return buffer;
+    }
 
-            outputHistory[2] = outputHistory[1];
-            outputHistory[1] = outputHistory[0];
-            outputHistory[0] = newOutput;
+private:
 
-            return outputHistory[0] * 1.1;
+    static world::RadioEffect createRadioFilter(int sampleRate, int bitsPerSample, float cutoffFrequency)
+    {
+        if (bitsPerSample != 16)
+        {
+            stringstream error;
+            error << "Unsupported bps: " << bitsPerSample;
+            throw ALSoundBuffer::SoundBufferError(error.str());
         }
-    };
+        // high-pass only, with the same gain as the filter this replaces
+        return world::RadioEffect(sampleRate, { cutoffFrequency, 0, 0, 0, 1.1f });
+    }
 };
@@ -0,0 +1,232 @@
+//
+// This file is part of AT&C project which simulates virtual world of air traffic and ATC.
+// Code licensing terms are available at https://github.com/felix-b/atc/blob/master/LICENSE
+//
+#pragma once
+
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include "alsoundbuffer.h"
+#include "speechStream.hpp"
+
+using namespace std;
+using namespace PPL;
+
+// Plays a SpeechStream while it is being synthesized, through a ring of OpenAL buffers queued on one source.
+// pump() must be called periodically (every few tens of milliseconds): it reclaims the buffers
+// which were played, refills them from the stream, and restarts the source if it ran dry before the
+// synthesizer caught up. Playback starts as soon as the first chunk arrives, rather than when synthesis is done.
+class StreamingSpeechSource
+{
+private:
+    enum { BufferCount = 6 };
+    // each buffer holds this much, so that the ring covers more than the synthesizer's usual hiccups
+    static const int bufferDurationMs = 100;
+private:
+    string m_name;
+    shared_ptr<world::SpeechStream> m_stream;
+    ALuint m_source;
+    ALuint m_buffers[BufferCount];
+    vector<ALuint> m_freeBuffers;
+    vector<char> m_staging;
+    world::SpeechStream::Format m_format;
+    ALenum m_alFormat;
+    bool m_hasFormat;
+    bool m_playRequested;
+    int m_underrunCount;
+    chrono::steady_clock::time_point m_playRequestedAt;
+    chrono::milliseconds m_timeToFirstAudio;
+public:
+    StreamingSpeechSource(const string& _name, shared_ptr<world::SpeechStream> _stream) :
+        m_name(_name),
+        m_stream(_stream),
+        m_source(0),
+        m_format({ 0, 0, 0 }),
+        m_alFormat(AL_FORMAT_MONO16),
+        m_hasFormat(false),
+        m_playRequested(false),
+        m_underrunCount(0),
+        m_timeToFirstAudio(-1)
+    {
+        alGetError();
+        alGenSources(1, &m_source);
+        if (alGetError() != AL_NO_ERROR)
+        {
+            throw ALSoundBuffer::SoundSourceError("Error in creating source for " + m_name);
+        }
+
+        alGenBuffers(BufferCount, m_buffers);
+        if (alGetError() != AL_NO_ERROR)
+        {
+            alDeleteSources(1, &m_source);
+            throw ALSoundBuffer::SoundBufferError("Error in creating buffers for " + m_name);
+        }
+
+        ALfloat source_position[] = { 0.0, 0.0, 0.0 };
+        ALfloat source_velocity[] = { 0.0, 0.0, 0.0 };
+        alSourcef (m_source, AL_PITCH,    1.0      );
+        alSourcef (m_source, AL_GAIN,     1.0      );
+        alSourcefv(m_source, AL_POSITION, source_position);
+        alSourcefv(m_source, AL_VELOCITY, source_velocity);
+        alSourcei (m_source, AL_LOOPING,  AL_FALSE );
+
+        m_freeBuffers.assign(m_buffers, m_buffers + BufferCount);
+    }
+
+    ~StreamingSpeechSource()
+    {
+        // buffers can only be deleted once they are detached from the source
+        alSourceStop(m_source);
+        alSourcei(m_source, AL_BUFFER, 0);
+        alDeleteSources(1, &m_source);
+        alDeleteBuffers(BufferCount, m_buffers);
+        m_stream->cancel();
+    }
+
+    StreamingSpeechSource(const StreamingSpeechSource&) = delete;
+    StreamingSpeechSource& operator=(const StreamingSpeechSource&) = delete;
+
+public:
+
+    // starts playback as soon as there is something to play
+    void play(float volume)
+    {
+        ALfloat listener_position[]= { 0.0, 0.0, 0.0 };
+        ALfloat listener_velocity[] = { 0.0, 0.0, 0.0 };
+        ALfloat listener_orientation[] = { 0.0, 0.0, -1.0,  0.0, 1.0, 0.0 };
+        alListenerfv(AL_POSITION,    listener_position);
+        alListenerfv(AL_VELOCITY,    listener_velocity);
+        alListenerfv(AL_ORIENTATION, listener_orientation);
+        alSourcef(m_source, AL_GAIN, volume);
+        if (alGetError() != AL_NO_ERROR)
+        {
+            throw ALSoundBuffer::SoundPlayingError("Error cannot play " + m_name + ". Setup of source and listener failed");
+        }
+
+        m_playRequested = true;
+        m_playRequestedAt = chrono::steady_clock::now();
+        pump();
+    }
+
+    void stop()
+    {
+        m_playRequested = false;
+        alSourceStop(m_source);
+        m_stream->cancel();
+    }
+
+    void pump()
+    {
+        reclaimPlayedBuffers();
+
+        if (!m_hasFormat && m_stream->tryGetFormat(m_format))
+        {
+            m_hasFormat = true;
+            m_alFormat = m_format.channelCount == 1
+                ? (m_format.bitsPerSample == 8 ? AL_FORMAT_MONO8 : AL_FORMAT_MONO16)
+                : (m_format.bitsPerSample == 8 ? AL_FORMAT_STEREO8 : AL_FORMAT_STEREO16);
+            size_t framesPerBuffer = (size_t)(m_format.sampleRate * bufferDurationMs / 1000);
+            m_staging.resize(framesPerBuffer * m_format.bytesPerFrame());
+        }
+
+        if (m_hasFormat)
+        {
+            queueAvailableChunks();
+        }
+
+        if (m_playRequested && m_freeBuffers.size() < BufferCount && !isSourcePlaying())
+        {
+            if (m_timeToFirstAudio.count() < 0)
+            {
+                m_timeToFirstAudio = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - m_playRequestedAt);
+            }
+            else
+            {
+                // the source played everything queued before the next chunk arrived
+                m_underrunCount++;
+            }
+            alSourcePlay(m_source);
+        }
+    }
+
+    // everything was synthesized and played (or the stream was cancelled or failed)
+    bool isDrained()
+    {
+        reclaimPlayedBuffers();
+        return m_stream->isEndOfStream() && m_freeBuffers.size() == BufferCount;
+    }
+
+    bool hasStartedPlaying() const
+    {
+        return m_timeToFirstAudio.count() >= 0;
+    }
+
+    chrono::milliseconds timeToFirstAudio() const
+    {
+        return m_timeToFirstAudio;
+    }
+
+    int underrunCount() const
+    {
+        return m_underrunCount;
+    }
+
+    const shared_ptr<world::SpeechStream>& stream() const
+    {
+        return m_stream;
+    }
+
+private:
+
+    void reclaimPlayedBuffers()
+    {
+        ALint processedCount = 0;
+        alGetSourcei(m_source, AL_BUFFERS_PROCESSED, &processedCount);
+        while (processedCount-- > 0)
+        {
+            ALuint buffer = 0;
+            alSourceUnqueueBuffers(m_source, 1, &buffer);
+            m_freeBuffers.push_back(buffer);
+        }
+    }
+
+    void queueAvailableChunks()
+    {
+        while (!m_freeBuffers.empty())
+        {
+            size_t available = m_stream->availableBytes();
+            bool isPlaybackStarved = (BufferCount - m_freeBuffers.size() < 2);
+            bool isStreamOver = (m_stream->state() != world::SpeechStream::State::Streaming);
+
+            // partial buffers are only queued when the source is about to run out of what to play
+            if (available == 0 || (available < m_staging.size() && !isPlaybackStarved && !isStreamOver))
+            {
+                return;
+            }
+
+            size_t length = m_stream->read(m_staging.data(), m_staging.size());
+            if (length == 0)
+            {
+                return;
+            }
+
+            ALuint buffer = m_freeBuffers.back();
+            alBufferData(buffer, m_alFormat, m_staging.data(), (ALsizei)length, m_format.sampleRate);
+            alSourceQueueBuffers(m_source, 1, &buffer);
+            if (alGetError() != AL_NO_ERROR)
+            {
+                throw ALSoundBuffer::SoundBufferError("Could not queue a buffer of " + m_name);
+            }
+            m_freeBuffers.pop_back();
+        }
+    }
+
+    bool isSourcePlaying()
+    {
+        ALint state;
+        alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+        return (state == AL_PLAYING);
+    }
+};
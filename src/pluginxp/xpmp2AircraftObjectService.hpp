@@ -4,6 +4,7 @@
 // 
 #pragma once
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -128,6 +129,8 @@ public:
         m_onQueryChanges = callback;
     }
 
+    shared_ptr<Flight> flight() const { return m_flight; }
+
 private:
 
     void safeUpdatePosition()
@@ -342,6 +345,15 @@ public:
 
             m_simAircraft.push_back(newSimAircraft);
         }
+
+        for (const auto& removedFlight : m_lastChangeSet->flights().removed())
+        {
+            m_simAircraft.erase(
+                remove_if(m_simAircraft.begin(), m_simAircraft.end(), [&removedFlight](const shared_ptr<Xpmp2AircraftObject>& simAircraft) {
+                    return simAircraft->flight() == removedFlight;
+                }),
+                m_simAircraft.end());
+        }
     }
 
     void clearAll() override